@@ -0,0 +1,194 @@
+#!/bin/sh
+#
+# End-to-end benchmark script for the self-certification suite.
+#
+# Copyright © 2024 by the IEEE-ISTO Printer Working Group.
+#
+# Licensed under Apache License v2.0.  See the file "LICENSE" for more
+# information.
+#
+# Usage:
+#
+#   ./benchbuild.sh [--baseline]
+#
+# Runs the DNS-SD, IPP, and Document tests and ippevesubmit against
+# ippeveprinter BENCH_RUNS times (default 3) and records the wall time, CPU
+# time, and peak RSS of each phase.  The medians are written to
+# "bench-e2e.json" and compared against "bench-e2e-baseline.json", failing when
+# a phase is more than BENCH_TOLERANCE percent (default 25) slower or larger
+# than the baseline.  The comparison is skipped when there is no baseline.
+# "--baseline" saves the results as the new baseline.
+#
+# The CPU time and peak RSS include the ipptool processes run by ippeverun.
+# Differences under 0.1 seconds or 1 MB are ignored since the short phases
+# vary more than that from run to run.
+#
+
+top="`pwd`"
+runs="${BENCH_RUNS:-3}"
+tolerance="${BENCH_TOLERANCE:-25}"
+report="bench-e2e.json"
+baseline="bench-e2e-baseline.json"
+
+if test ! -x selfcert/ippeverun -o ! -x selfcert/ippevesubmit; then
+	echo "Build selfcert/ippeverun and selfcert/ippevesubmit first."
+	exit 1
+fi
+
+# Use GNU or BSD time, macOS reports the peak RSS in bytes and FreeBSD in
+# kilobytes...
+rssdiv=1
+
+if test ! -x /usr/bin/time; then
+	echo "The benchmarks need /usr/bin/time."
+	exit 1
+elif /usr/bin/time -f "%e" true >/dev/null 2>&1; then
+	timeopts="-f %e@%U@%S@%M"
+else
+	timeopts="-l -p"
+
+	if test "`uname`" = Darwin; then
+		rssdiv=1024
+	fi
+fi
+
+# bench_phase name command ...
+#
+# Run a command and append "name wall cpu rss" to bench.samples, with the times
+# in seconds and the peak RSS in kilobytes.
+bench_phase() {
+	phase="$1"
+	shift
+
+	if /usr/bin/time $timeopts sh -c 'exec "$@" >>"$0" 2>&1' "$top/bench-$phase.log" "$@" 2>"$top/bench.time"; then
+		status=0
+	else
+		status=1
+	fi
+
+	awk -v phase="$phase" -v rssdiv="$rssdiv" '
+		/@/ { split($0, v, "@"); wall = v[1]; cpu = v[2] + v[3]; rss = v[4]; }
+		$1 == "real" { wall = $2; }
+		$1 == "user" || $1 == "sys" { cpu += $2; }
+		/maximum resident set size/ { rss = int($1 / rssdiv); }
+		END { printf("%s %.3f %.3f %d\n", phase, wall, cpu, rss); }' "$top/bench.time" >>"$top/bench.samples"
+	rm -f "$top/bench.time"
+
+	return $status
+}
+
+# Run ippeveprinter in the background...
+libcups/tools/ippeveprinter -vvv -f image/jpeg,image/pwg-raster,application/pdf -s 10,5 "Test" >test.log 2>&1 &
+pid=$!
+
+# Run the tests for a print server...
+IPP_EVERYWHERE_SERVER=1; export IPP_EVERYWHERE_SERVER
+PATH="`pwd`/libcups/tools:$PATH"; export PATH
+
+echo "Test Printer 1000" >/tmp/test-models.txt
+echo "Test Printer 2000" >>/tmp/test-models.txt
+echo "Test Printer 3000" >>/tmp/test-models.txt
+
+rm -f bench.samples bench-*.log
+
+# Give ippeveprinter time to register its services...
+sleep 2
+
+failed=0
+run=1
+while test $run -le $runs; do
+	echo "Run $run of $runs:"
+
+	cd tests
+	for suite in dnssd ipp document; do
+		bench_phase $suite ../selfcert/ippeverun "Test" $suite || failed=1
+		tail -1 "$top/bench.samples" | awk '{ printf("    %-10s %8.3fs wall %8.3fs CPU %8d KB\n", $1, $2, $3, $4); }'
+	done
+
+	bench_phase submit ../selfcert/ippevesubmit -f standard -m /tmp/test-models.txt -p "Test Product Family" -t server -u "https://www.pwg.org/" -y "Test" || failed=1
+	tail -1 "$top/bench.samples" | awk '{ printf("    %-10s %8.3fs wall %8.3fs CPU %8d KB\n", $1, $2, $3, $4); }'
+	cd ..
+
+	run=`expr $run + 1`
+done
+
+# Stop ippeveprinter...
+kill $pid
+
+if test $failed = 1; then
+	echo "Some phases failed, see the bench-*.log files."
+	rm -f bench.samples
+	exit 1
+fi
+
+# Write the median of each phase...
+awk -v runs="$runs" '
+	function median(list, n,    i, j, t, a) {
+		n = split(list, a, " ");
+		for (i = 2; i <= n; i ++) {
+			for (j = i; j > 1 && a[j - 1] + 0 > a[j] + 0; j --) {
+				t = a[j]; a[j] = a[j - 1]; a[j - 1] = t;
+			}
+		}
+		return (n % 2 ? a[(n + 1) / 2] : (a[n / 2] + a[n / 2 + 1]) / 2);
+	}
+	!($1 in wall) { order[++ count] = $1; }
+	{ wall[$1] = wall[$1] " " $2; cpu[$1] = cpu[$1] " " $3; rss[$1] = rss[$1] " " $4; }
+	END {
+		printf("{\n  \"runs\": %d,\n  \"phases\": {\n", runs);
+		for (i = 1; i <= count; i ++) {
+			p = order[i];
+			printf("    \"%s\": { \"wall\": %.3f, \"cpu\": %.3f, \"rss\": %d }%s\n", p, median(wall[p]), median(cpu[p]), median(rss[p]), i < count ? "," : "");
+		}
+		printf("  }\n}\n");
+	}' bench.samples >"$report"
+rm -f bench.samples
+
+echo ""
+echo "Wrote \"$report\"."
+
+if test "x$1" = x--baseline; then
+	cp "$report" "$baseline"
+	echo "Saved \"$baseline\"."
+	exit 0
+fi
+
+if test ! -f "$baseline"; then
+	echo ""
+	echo "SKIP: No \"$baseline\" to compare against, run"
+	echo "\"make bench-e2e-baseline\" on the reference system to save one and"
+	echo "commit it."
+	exit 0
+fi
+
+# Compare against the baseline...
+echo ""
+awk -v tolerance="$tolerance" '
+	/"wall":/ {
+		gsub(/[":{},]/, " ");
+		key = $1;
+		if (FILENAME == ARGV[1]) {
+			base[key "wall"] = $3; base[key "cpu"] = $5; base[key "rss"] = $7;
+			next;
+		}
+		printf("%-10s", key);
+		for (i = 3; i <= 7; i += 2) {
+			metric = $(i - 1); value = $i; old = base[key metric];
+			if (old == "") {
+				printf(" %s %s (new)", metric, value);
+			} else if (value > old * (1 + tolerance / 100) && value - old > (metric == "rss" ? 1024 : 0.1)) {
+				printf(" %s %s (was %s, REGRESSED)", metric, value, old);
+				regressed = 1;
+			} else {
+				printf(" %s %s (was %s)", metric, value, old);
+			}
+		}
+		printf("\n");
+	}
+	END {
+		if (regressed) {
+			printf("\nFAIL: Slower or larger than the baseline by more than %d%%.\n", tolerance);
+			exit 1;
+		}
+		printf("\nPASS: Within %d%% of the baseline.\n", tolerance);
+	}' "$baseline" "$report"
@@ -14,6 +14,7 @@ import 'package:flutter/cupertino.dart';
 import "IppPrinter.dart";
 import "IppAttributesPage.dart";
 import "PrintFilePage.dart";
+import "SelfCertPage.dart";
 import "TxtRecordPage.dart";
 import "ipptool.dart";
 import "util.dart";
@@ -143,11 +144,16 @@ class _IppPrinterPageState extends State<IppPrinterPage> {
                             leadingSize: 0,
                             leadingToTitle: 0,
                         ),
-                        const CupertinoListTile(
-                            title: Text("Run Self-Certification Tests"),
-                            trailing: CupertinoListTileChevron(),
+                        CupertinoListTile(
+                            title: const Text("Run Self-Certification Tests"),
+                            trailing: const CupertinoListTileChevron(),
                             leadingSize: 0,
                             leadingToTitle: 0,
+                            onTap: () => Navigator.of(context).push(CupertinoPageRoute<void>(
+                                builder: (BuildContext context) {
+                                    return SelfCertPage(printer: widget.printer);
+                                },
+                            )),
                         ),
                     ],
                 ),
@@ -0,0 +1,152 @@
+//
+// IPP Everywhere Tool (ippevetool) self-certification tests page.
+//
+// Copyright © 2024 by the IEEE-ISTO Printer Working Group.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+// ignore_for_file: file_names
+//
+
+import 'dart:async';
+import 'dart:core';
+import 'package:flutter/cupertino.dart';
+import "IppPrinter.dart";
+import "ippeverun.dart";
+import "util.dart";
+
+
+// Test shown on the page...
+class SelfCertTest {
+    SelfCertTest(this.suite, this.name);
+
+    final String suite;
+    final String name;
+    String status = "";
+    double duration = 0.0;
+    int requests = 1;
+    List<String> errors = [];
+}
+
+
+// Self-certification tests page
+class SelfCertPage extends StatefulWidget {
+    const SelfCertPage({super.key, required this.printer});
+
+    final IppPrinter printer;
+
+    @override
+    State<SelfCertPage> createState() => _SelfCertPageState();
+}
+
+
+// State for the self-certification tests page...
+class _SelfCertPageState extends State<SelfCertPage> {
+    StreamSubscription<Map<String,dynamic>>? subscription;
+    List<SelfCertTest> tests = [];
+    Map<String,SelfCertTest> running = {};
+    Map<String,String> suites = {};
+    String status = "Starting tests...";
+
+    @override
+    void initState() {
+        super.initState();
+
+        subscription = ippeverunRunTests(printerName:widget.printer.dnssdName).listen(handleEvent);
+    }
+
+    @override
+    void dispose() {
+        subscription?.cancel();
+
+        super.dispose();
+    }
+
+    @override
+    Widget build(BuildContext context) {
+        return CupertinoPageScaffold(
+            navigationBar: const CupertinoNavigationBar(
+                middle: Text("Self-Certification Tests"),
+            ),
+            child: SingleChildScrollView(
+                child: CupertinoListSection(
+                    header: Text(status),
+                    children: _buildList(),
+                ),
+            ),
+        );
+    }
+
+    // Update the tests from an ippeverun event
+    void handleEvent(Map<String,dynamic> event) {
+        String suite = event["suite"] ?? "";
+        String key = "$suite/${event["index"]}";   // Test names are not unique
+
+        setState(() {
+            switch (event["event"]) {
+                case "suite-start" :
+                    suites[suite] = "${event["title"]} running";
+                    break;
+
+                case "test-start" :
+                    var test = SelfCertTest(suite, event["test"]);
+                    running[key] = test;
+                    tests.add(test);
+                    break;
+
+                case "test-repeat" :
+                    running[key]?.requests = event["requests"];
+                    break;
+
+                case "test-end" :
+                    var test = running.remove(key);
+                    if (test != null) {
+                        test.status = event["status"];
+                        test.duration = (event["duration"] as num).toDouble();
+                        test.requests = event["requests"];
+                        test.errors = List<String>.from(event["errors"]);
+                    }
+                    break;
+
+                case "suite-end" :
+                    suites[suite] = "${event["passed"]} passed, ${event["failed"]} failed, ${event["skipped"]} skipped${event["complete"] ? "" : ", not complete"}";
+                    break;
+
+                case "exit" :
+                    suites["exit"] = event["status"] == 0 ? "Done" : "Done, not all tests could be run";
+                    break;
+            }
+
+            status = suites.values.join("; ");
+        });
+    }
+
+    // Build the rows of tests
+    List<CupertinoListTile> _buildList() {
+        var list = <CupertinoListTile>[ ];
+
+        for (var test in tests) {
+            var details = test.status == "" ? "Running" : "${test.duration.toStringAsFixed(3)}s";
+
+            if (test.requests > 1) {
+                details = "$details, ${test.requests} requests";
+            }
+
+            if (test.errors.isNotEmpty) {
+                details = "$details\n${test.errors.join("\n")}";
+            }
+
+            list.add(CupertinoListTile(
+                title: Text(test.name),
+                subtitle: Text(details),
+                additionalInfo: Text(test.status),
+                leadingSize: 0,
+                leadingToTitle: 0,
+                onTap: () => tapValue(context, details),
+            ));
+        }
+
+        return (list);
+    }
+}
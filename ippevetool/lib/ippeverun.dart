@@ -0,0 +1,46 @@
+//
+// IPP Everywhere Tool (ippevetool) self-certification test runner support.
+//
+// Copyright © 2024 by the IEEE-ISTO Printer Working Group.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+import 'dart:async';
+import 'dart:io';
+import 'dart:convert';
+import 'dart:developer' as developer;
+
+
+// Run the self-certification tests and return the progress events as they
+// happen.  Each event is the JSON object from "ippeverun --json", followed by
+// an "exit" event with the exit status when ippeverun is done.  Canceling the
+// stream stops the tests.
+Stream<Map<String,dynamic>> ippeverunRunTests({required String printerName, List<String>? suites}) async* {
+    List<String> args = ["--json", printerName];   // Command-line arguments
+
+    if (suites != null) {
+        args.addAll(suites);
+    }
+
+    developer.log("Starting ippeverun $args", name:"ippeverun");
+
+    var process = await Process.start("ippeverun", args);
+    process.stderr.pipe(stderr);
+
+    try {
+        await for (var line in process.stdout.transform(const Utf8Decoder(allowMalformed: true)).transform(const LineSplitter())) {
+            if (line.startsWith("{")) {
+                yield (jsonDecode(line) as Map<String,dynamic>);
+            } else if (line != "") {
+                // Command-line errors are not JSON...
+                yield ({"event":"message", "text":line});
+            }
+        }
+
+        yield ({"event":"exit", "status":await process.exitCode});
+    } finally {
+        process.kill();
+    }
+}
@@ -68,7 +68,7 @@ cp tests/*.sh $pkgdir
 chmod +x $pkgdir/*.sh
 cp tests/*.test $pkgdir
 
-TOOLS="ippeveprinter ippevesubmit ippfind ipptool"
+TOOLS="ippeveprinter ippeverun ippevesubmit ippfind ipptool"
 for tool in $TOOLS; do
 	cp tools/$tool $pkgdir;
 done
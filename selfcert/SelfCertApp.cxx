@@ -17,6 +17,13 @@ void SelfCertApp::cb_resultsSubmit(Fl_Button* o, void* v) {
   ((SelfCertApp*)(o->parent()->parent()->user_data()))->cb_resultsSubmit_i(o,v);
 }
 
+void SelfCertApp::cb_resultsCancel_i(Fl_Button*, void*) {
+  cancel();
+}
+void SelfCertApp::cb_resultsCancel(Fl_Button* o, void* v) {
+  ((SelfCertApp*)(o->parent()->parent()->user_data()))->cb_resultsCancel_i(o,v);
+}
+
 void SelfCertApp::cb_Cancel_i(Fl_Button*, void*) {
   submissionForm->hide();
 }
@@ -38,7 +45,11 @@ SelfCertApp::SelfCertApp() {
         browser->box(FL_DOWN_BOX);
         browser->callback((Fl_Callback*)cb_browser);
       } // Fl_Browser* browser
-      { output = new Fl_Text_Display(0, 100, 800, 455);
+      { tests = new TestTable(0, 100, 800, 200);
+        tests->box(FL_DOWN_BOX);
+        tests->end();
+      } // TestTable* tests
+      { output = new Fl_Text_Display(0, 300, 800, 255);
         output->box(FL_DOWN_BOX);
         output->color((Fl_Color)34);
         output->textfont(4);
@@ -48,6 +59,9 @@ SelfCertApp::SelfCertApp() {
       tile->end();
     } // Fl_Tile* tile
     { results = new Fl_Group(0, 555, 800, 45);
+      { resultsStatus = new Fl_Box(10, 565, 630, 25);
+        resultsStatus->align(Fl_Align(FL_ALIGN_LEFT|FL_ALIGN_INSIDE));
+      } // Fl_Box* resultsStatus
       { resultsSubmit = new Fl_Button(650, 565, 65, 25, "Submit");
         resultsSubmit->down_box(FL_DOWN_BOX);
         resultsSubmit->callback((Fl_Callback*)cb_resultsSubmit);
@@ -55,6 +69,8 @@ SelfCertApp::SelfCertApp() {
       } // Fl_Button* resultsSubmit
       { resultsCancel = new Fl_Button(725, 565, 65, 25, "Cancel");
         resultsCancel->down_box(FL_DOWN_BOX);
+        resultsCancel->callback((Fl_Callback*)cb_resultsCancel);
+        resultsCancel->deactivate();
       } // Fl_Button* resultsCancel
       results->end();
     } // Fl_Group* results
@@ -100,13 +116,19 @@ SelfCertApp::SelfCertApp() {
     submissionForm->set_modal();
     submissionForm->end();
   } // Fl_Double_Window* submissionForm
-  browser->add("Test Printer");
-
   buffer = new Fl_Text_Buffer();
   output->buffer(buffer);
+
+  cupsMutexInit(&testMutex);
+  testRunning  = false;
+  testCanceled = false;
+  testRing     = NULL;
+
+  dnssd_browse_start((dnssd_browse_cb_t)browseEvent, this);
 }
 
 SelfCertApp::~SelfCertApp() {
+  dnssd_browse_stop();
   delete window;
 }
 
@@ -3,11 +3,18 @@
 #ifndef SelfCertApp_h
 #define SelfCertApp_h
 #include <FL/Fl.H>
+#include "selfcert.h"
+#include <cups/thread.h>
+#include "TestTable.h"
+typedef struct _app_printer_s _app_printer_t;
+typedef struct _app_ring_s _app_ring_t;
 #include <FL/Fl_Double_Window.H>
 #include <FL/Fl_Tile.H>
 #include <FL/Fl_Browser.H>
+#include <FL/Fl_Table.H>
 #include <FL/Fl_Text_Display.H>
 #include <FL/Fl_Group.H>
+#include <FL/Fl_Box.H>
 #include <FL/Fl_Button.H>
 #include <FL/Fl_Check_Button.H>
 #include <FL/Fl_Input.H>
@@ -17,6 +24,15 @@
 */
 class SelfCertApp {
   Fl_Text_Buffer *buffer;
+  cups_mutex_t testMutex;
+  cups_thread_t testThread;
+  bool testRunning;
+  bool testCanceled;
+  bool testPrintServer;
+  bool testValid;
+  _app_ring_t *testRing;
+  char testPrinter[256];
+  char testResults[3][1024];
 public:
   SelfCertApp();
 private:
@@ -25,12 +41,16 @@ private:
   Fl_Browser *browser;
   inline void cb_browser_i(Fl_Browser*, void*);
   static void cb_browser(Fl_Browser*, void*);
+  TestTable *tests;
   Fl_Text_Display *output;
   Fl_Group *results;
+  Fl_Box *resultsStatus;
   Fl_Button *resultsSubmit;
   inline void cb_resultsSubmit_i(Fl_Button*, void*);
   static void cb_resultsSubmit(Fl_Button*, void*);
   Fl_Button *resultsCancel;
+  inline void cb_resultsCancel_i(Fl_Button*, void*);
+  static void cb_resultsCancel(Fl_Button*, void*);
   Fl_Double_Window *submissionForm;
   Fl_Check_Button *usedPWGTools;
   Fl_Check_Button *usedProductionReadyCode;
@@ -46,6 +66,17 @@ private:
 public:
   ~SelfCertApp();
   void show(int argc, char *argv[]);
+private:
+  static void browseAwake(_app_printer_t *printer);
+  static void browseEvent(SelfCertApp *app, dnssd_event_t event, const char *name);
+public:
+  void cancel();
   bool test(const char *name);
+private:
+  static void testAwake(SelfCertApp *app);
+  void testDrain();
+  static bool testEvent(SelfCertApp *app, selfcert_suite_t suite, runner_event_t event, const runner_test_t *test, const char *message);
+  static void *testRun(SelfCertApp *app);
+  static void testTimer(SelfCertApp *app);
 };
 #endif
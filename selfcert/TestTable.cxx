@@ -0,0 +1,512 @@
+//
+// Test results table for the IPP Everywhere Printer Self-Certification
+// application.
+//
+// Copyright © 2024 by the IEEE-ISTO Printer Working Group.
+//
+// Licensed under Apache License v2.0.	See the file "LICENSE" for more
+// information.
+//
+// The table shows the suite, name, state, duration, and number of requests
+// of each test as it runs.  The test threads update their own copy of the
+// tests under a mutex, and the UI thread copies the changed tests once per
+// frame so that drawing never waits for the test threads.
+//
+// The time left is estimated from the durations of the same tests in the
+// previous results files for the printer.  The DNS-SD tests run at the same
+// time as the IPP tests and the Document tests run after them, so the
+// estimate is the longer of the DNS-SD and IPP time left plus the Document
+// time left.
+//
+
+#include "TestTable.h"
+#include <FL/fl_draw.H>
+
+
+//
+// 'TestTable::TestTable()' - Create a test results table.
+//
+
+TestTable::TestTable(int        X,	// I - X position
+                     int        Y,	// I - Y position
+                     int        W,	// I - Width
+                     int        H,	// I - Height
+                     const char *L)	// I - Label, if any
+  : Fl_Table(X, Y, W, H, L)
+{
+  cupsMutexInit(&mutex);
+
+  num_tests   = 0;
+  alloc_tests = 0;
+  tests       = NULL;
+  num_history = 0;
+  history     = NULL;
+  num_shown   = 0;
+  alloc_shown = 0;
+  shown       = NULL;
+
+  memset(remaining, 0, sizeof(remaining));
+  running[0] = running[1] = running[2] = -1;
+
+  rows(0);
+  row_height_all(20);
+  cols(5);
+  col_header(1);
+  col_header_height(20);
+  col_resize(1);
+  col_width(0, 80);
+  col_width(1, W - 340);
+  col_width(2, 60);
+  col_width(3, 90);
+  col_width(4, 90);
+  end();
+}
+
+
+//
+// 'TestTable::~TestTable()' - Delete a test results table.
+//
+
+TestTable::~TestTable()
+{
+  free(tests);
+  free(history);
+  free(shown);
+
+  cupsMutexDestroy(&mutex);
+}
+
+
+//
+// 'TestTable::addEvent()' - Add a test event.
+//
+// This is called on the test threads.
+//
+
+void
+TestTable::addEvent(
+    selfcert_suite_t    suite,		// I - Test suite
+    runner_event_t      event,		// I - Event
+    const runner_test_t *test)		// I - Test, if any
+{
+  _test_t	*t;			// Current test
+  _history_t	*h;			// Previous duration
+
+
+  cupsMutexLock(&mutex);
+
+  if (event == RUNNER_EVENT_SUITE_END)
+  {
+    // Nothing left to do for this suite...
+    remaining[suite] = 0.0;
+    running[suite]   = -1;
+  }
+  else if (test && (event == RUNNER_EVENT_TEST_START || event == RUNNER_EVENT_TEST_REPEAT || event == RUNNER_EVENT_TEST_END))
+  {
+    if (event == RUNNER_EVENT_TEST_START || running[suite] < 0)
+    {
+      // Add a new test...
+      if (num_tests >= alloc_tests)
+      {
+	if ((t = (_test_t *)realloc(tests, (alloc_tests + 64) * sizeof(_test_t))) == NULL)
+	{
+	  cupsMutexUnlock(&mutex);
+	  return;
+	}
+
+	tests       = t;
+	alloc_tests += 64;
+      }
+
+      t = tests + num_tests;
+      running[suite] = (int)num_tests;
+      num_tests ++;
+
+      memset(t, 0, sizeof(_test_t));
+      t->suite = suite;
+      t->start = test->start;
+      cupsCopyString(t->name, test->name, sizeof(t->name));
+    }
+
+    t                 = tests + running[suite];
+    t->num_iterations = test->num_iterations;
+    t->changed        = true;
+
+    if (event == RUNNER_EVENT_TEST_END)
+    {
+      cupsCopyString(t->status, test->status, sizeof(t->status));
+      t->end         = test->end;
+      running[suite] = -1;
+
+      if ((h = findHistory(suite, t->name)) != NULL && !h->done)
+      {
+        h->done          = true;
+        remaining[suite] -= h->duration;
+      }
+    }
+  }
+
+  cupsMutexUnlock(&mutex);
+}
+
+
+//
+// 'TestTable::loadHistory()' - Load the test durations from the previous
+//                              results files for a printer.
+//
+// This is called on the test thread before the tests are run, since the
+// results files are replaced by the new results.
+//
+
+void
+TestTable::loadHistory(
+    const char *printer)		// I - Printer name
+{
+  int		suite;			// Current test suite
+  char		filename[1024];		// Results filename
+  plist_t	*results,		// Results plist
+		*list,			// Tests array
+		*test,			// Current test
+		*name,			// Test name
+		*start,			// Start time
+		*end;			// End time
+  size_t	count = 0,		// Number of durations
+		alloc = 0;		// Allocated durations
+  _history_t	*durations = NULL,	// Durations
+		*h;			// Current duration
+  double	totals[3] = { 0.0, 0.0, 0.0 };
+					// Total duration for each suite
+  static const char * const suites[] =	// Test suite names
+  {
+    "DNS-SD",
+    "IPP",
+    "Document"
+  };
+
+
+  // Read the previous results without holding the mutex...
+  for (suite = SELFCERT_SUITE_DNSSD; suite <= SELFCERT_SUITE_DOCUMENT; suite ++)
+  {
+    snprintf(filename, sizeof(filename), "%s %s Results.plist", printer, suites[suite]);
+
+    if ((results = plist_read(NULL, filename, NULL, NULL)) == NULL)
+      continue;
+
+    if ((list = plist_find(results, "Tests")) != NULL)
+    {
+      for (test = list->first_child; test; test = test->next_sibling)
+      {
+        name  = plist_find(test, "Name");
+        start = plist_find(test, "StartTime");
+        end   = plist_find(test, "EndTime");
+
+        if (!name || name->type != PLIST_TYPE_STRING || !start || start->type != PLIST_TYPE_INTEGER || !end || end->type != PLIST_TYPE_INTEGER)
+          continue;
+
+        if (count >= alloc)
+        {
+          if ((h = (_history_t *)realloc(durations, (alloc + 64) * sizeof(_history_t))) == NULL)
+            break;
+
+          durations = h;
+          alloc     += 64;
+        }
+
+        h = durations + count;
+        count ++;
+
+        memset(h, 0, sizeof(_history_t));
+        h->suite    = (selfcert_suite_t)suite;
+        h->duration = 0.001 * (strtod(end->value, NULL) - strtod(start->value, NULL));
+        cupsCopyString(h->name, name->value, sizeof(h->name));
+
+        totals[suite] += h->duration;
+      }
+    }
+
+    plist_delete(results);
+  }
+
+  // Then replace the old durations...
+  cupsMutexLock(&mutex);
+
+  free(history);
+
+  history     = durations;
+  num_history = count;
+
+  memcpy(remaining, totals, sizeof(remaining));
+
+  cupsMutexUnlock(&mutex);
+}
+
+
+//
+// 'TestTable::reset()' - Clear the tests before a new run.
+//
+
+void
+TestTable::reset()
+{
+  cupsMutexLock(&mutex);
+
+  num_tests = 0;
+  running[0] = running[1] = running[2] = -1;
+
+  free(history);
+  history     = NULL;
+  num_history = 0;
+
+  memset(remaining, 0, sizeof(remaining));
+
+  cupsMutexUnlock(&mutex);
+
+  num_shown = 0;
+
+  rows(0);
+  redraw();
+}
+
+
+//
+// 'TestTable::update()' - Show the changed tests and get the status.
+//
+// This is called on the UI thread once per frame.  Only the changed tests and
+// the durations of the running tests are redrawn, and the table scrolls to
+// the last test unless the user has scrolled away from it.
+//
+
+void
+TestTable::update(bool   active,	// I - Are the tests running?
+                  char   *status,	// I - Status buffer
+                  size_t statussize)	// I - Size of status buffer
+{
+  size_t	i,			// Looping var
+		old_shown = num_shown,	// Previous number of shown tests
+		num_pass = 0,		// Number of passed tests
+		num_fail = 0,		// Number of failed tests
+		num_skip = 0;		// Number of skipped tests
+  int		suite,			// Current test suite
+		visible,		// Number of visible rows
+		seconds;		// Seconds left
+  _test_t	*t;			// Current test
+  _history_t	*h;			// Previous duration
+  double	now,			// Current time
+		left[3],		// Time left for each suite
+		eta;			// Time left for all suites
+  bool		have_history;		// Are there previous durations?
+
+
+  now = runner_get_time();
+
+  cupsMutexLock(&mutex);
+
+  // Copy the changed tests...
+  if (num_tests > alloc_shown)
+  {
+    if ((t = (_test_t *)realloc(shown, num_tests * sizeof(_test_t))) == NULL)
+    {
+      cupsMutexUnlock(&mutex);
+      return;
+    }
+
+    shown       = t;
+    alloc_shown = num_tests;
+  }
+
+  for (i = 0; i < num_tests; i ++)
+  {
+    if (tests[i].changed)
+    {
+      shown[i]         = tests[i];
+      tests[i].changed = false;
+
+      if (i < old_shown)
+        redraw_range((int)i, (int)i, 0, 4);
+    }
+  }
+
+  num_shown = num_tests;
+
+  // Estimate the time left, counting the time the running tests have taken
+  // so far...
+  for (suite = SELFCERT_SUITE_DNSSD; suite <= SELFCERT_SUITE_DOCUMENT; suite ++)
+  {
+    left[suite] = remaining[suite];
+
+    if (running[suite] >= 0 && (h = findHistory((selfcert_suite_t)suite, tests[running[suite]].name)) != NULL && !h->done)
+      left[suite] -= now - tests[running[suite]].start < h->duration ? now - tests[running[suite]].start : h->duration;
+  }
+
+  have_history = num_history > 0;
+
+  cupsMutexUnlock(&mutex);
+
+  eta     = (left[SELFCERT_SUITE_DNSSD] > left[SELFCERT_SUITE_IPP] ? left[SELFCERT_SUITE_DNSSD] : left[SELFCERT_SUITE_IPP]) + left[SELFCERT_SUITE_DOCUMENT];
+  seconds = (int)(eta + 0.5);
+
+  // Count the results and redraw the durations of the running tests...
+  for (i = 0, t = shown; i < num_shown; i ++, t ++)
+  {
+    if (!strcmp(t->status, "PASS"))
+      num_pass ++;
+    else if (!strcmp(t->status, "FAIL"))
+      num_fail ++;
+    else if (!strcmp(t->status, "SKIP"))
+      num_skip ++;
+    else if (active && i < old_shown)
+      redraw_range((int)i, (int)i, 3, 3);
+  }
+
+  if (num_shown != old_shown)
+  {
+    // Show the new tests, following the last test if it was visible...
+    rows((int)num_shown);
+
+    visible = tih / row_height(0);
+
+    if ((old_shown == 0 || botrow >= (int)old_shown - 1) && (int)num_shown > visible)
+      row_position((int)num_shown - visible);
+  }
+
+  if (active && have_history && seconds > 0)
+    snprintf(status, statussize, "%u tests, %u passed, %u failed, %u skipped, about %d:%02d left", (unsigned)num_shown, (unsigned)num_pass, (unsigned)num_fail, (unsigned)num_skip, seconds / 60, seconds % 60);
+  else
+    snprintf(status, statussize, "%u tests, %u passed, %u failed, %u skipped", (unsigned)num_shown, (unsigned)num_pass, (unsigned)num_fail, (unsigned)num_skip);
+}
+
+
+//
+// 'TestTable::draw_cell()' - Draw a cell of the table.
+//
+
+void
+TestTable::draw_cell(
+    TableContext context,		// I - What to draw
+    int          R,			// I - Row
+    int          C,			// I - Column
+    int          X,			// I - X position
+    int          Y,			// I - Y position
+    int          W,			// I - Width
+    int          H)			// I - Height
+{
+  _test_t	*t;			// Current test
+  char		text[256];		// Cell text
+  const char	*s = text;		// String to draw
+  Fl_Color	color = FL_FOREGROUND_COLOR;
+					// Text color
+  static const char * const headings[] =// Column headings
+  {
+    "Suite",
+    "Test",
+    "State",
+    "Time",
+    "Requests"
+  };
+  static const char * const suites[] =	// Test suite names
+  {
+    "DNS-SD",
+    "IPP",
+    "Document"
+  };
+
+
+  switch (context)
+  {
+    case CONTEXT_STARTPAGE :
+        fl_font(FL_HELVETICA, 12);
+        break;
+
+    case CONTEXT_COL_HEADER :
+        fl_push_clip(X, Y, W, H);
+        fl_draw_box(FL_THIN_UP_BOX, X, Y, W, H, col_header_color());
+        fl_color(FL_FOREGROUND_COLOR);
+        fl_draw(headings[C], X + 4, Y, W - 8, H, C >= 3 ? FL_ALIGN_RIGHT : FL_ALIGN_LEFT);
+        fl_pop_clip();
+        break;
+
+    case CONTEXT_CELL :
+        if (R < 0 || (size_t)R >= num_shown)
+          break;
+
+        t       = shown + R;
+        text[0] = '\0';
+
+        switch (C)
+        {
+          case 0 :
+              s = suites[t->suite];
+              break;
+
+          case 1 :
+              s = t->name;
+              break;
+
+          case 2 :
+              if (!t->status[0])
+              {
+                s     = "RUN";
+                color = FL_DARK_BLUE;
+              }
+              else
+              {
+                s = t->status;
+
+                if (!strcmp(s, "PASS"))
+                  color = FL_DARK_GREEN;
+                else if (!strcmp(s, "FAIL"))
+                  color = FL_RED;
+                else
+                  color = FL_DARK3;
+              }
+              break;
+
+          case 3 :
+              snprintf(text, sizeof(text), "%.3fs", (t->status[0] ? t->end : runner_get_time()) - t->start);
+              break;
+
+          case 4 :
+              if (t->num_iterations > 1)
+                snprintf(text, sizeof(text), "%u", (unsigned)t->num_iterations);
+              break;
+        }
+
+        fl_push_clip(X, Y, W, H);
+        fl_color(FL_BACKGROUND2_COLOR);
+        fl_rectf(X, Y, W, H);
+        fl_color(color);
+        fl_draw(s, X + 4, Y, W - 8, H, C >= 3 ? FL_ALIGN_RIGHT : FL_ALIGN_LEFT);
+        fl_color(FL_LIGHT2);
+        fl_rect(X, Y, W, H);
+        fl_pop_clip();
+        break;
+
+    default :
+        break;
+  }
+}
+
+
+//
+// 'TestTable::findHistory()' - Find the previous duration of a test.
+//
+// The caller must hold the mutex.
+//
+
+TestTable::_history_t *			// O - Previous duration or `NULL` if none
+TestTable::findHistory(
+    selfcert_suite_t suite,		// I - Test suite
+    const char       *name)		// I - Test name
+{
+  size_t	i;			// Looping var
+  _history_t	*h;			// Current duration
+
+
+  for (i = num_history, h = history; i > 0; i --, h ++)
+  {
+    if (h->suite == suite && !h->done && !strcmp(h->name, name))
+      return (h);
+  }
+
+  return (NULL);
+}
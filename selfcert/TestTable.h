@@ -0,0 +1,82 @@
+//
+// Test results table header file for the IPP Everywhere Printer
+// Self-Certification application.
+//
+// Copyright © 2024 by the IEEE-ISTO Printer Working Group.
+//
+// Licensed under Apache License v2.0.	See the file "LICENSE" for more
+// information.
+//
+
+#ifndef TESTTABLE_H
+#  define TESTTABLE_H
+#  include <FL/Fl_Table.H>
+#  include "selfcert.h"
+#  include <cups/thread.h>
+
+
+//
+// Test results table widget...
+//
+// The test threads add events with addEvent() and the UI thread shows them
+// with update().  Only the visible rows are drawn, so a full run with hundreds
+// of tests costs no more to show than a screenful.
+//
+
+class TestTable : public Fl_Table
+{
+  private:
+
+  // Test row...
+  typedef struct _test_s
+  {
+    selfcert_suite_t suite;		// Test suite
+    char	name[256],		// Test name
+		status[8];		// "PASS", "FAIL", "SKIP", or "" when running
+    double	start,			// Start time in seconds
+		end;			// End time in seconds
+    size_t	num_iterations;		// Number of requests
+    bool	changed;		// Changed since the last update?
+  } _test_t;
+
+  // Test duration from the previous results...
+  typedef struct _history_s
+  {
+    selfcert_suite_t suite;		// Test suite
+    char	name[256];		// Test name
+    double	duration;		// Duration in seconds
+    bool	done;			// Done in this run?
+  } _history_t;
+
+  public:
+
+  TestTable(int X, int Y, int W, int H, const char *L = NULL);
+  ~TestTable();
+
+  void		addEvent(selfcert_suite_t suite, runner_event_t event, const runner_test_t *test);
+  void		loadHistory(const char *printer);
+  void		reset();
+  void		update(bool active, char *status, size_t statussize);
+
+  protected:
+
+  void		draw_cell(TableContext context, int R = 0, int C = 0, int X = 0, int Y = 0, int W = 0, int H = 0);
+
+  private:
+
+  cups_mutex_t	mutex;			// Mutex for the test thread data
+  size_t	num_tests,		// Number of tests (test threads)
+		alloc_tests;		// Allocated tests (test threads)
+  _test_t	*tests;			// Tests (test threads)
+  size_t	num_history;		// Number of previous durations
+  _history_t	*history;		// Previous durations
+  double	remaining[3];		// Expected time left for each suite
+  int		running[3];		// Running test for each suite or -1 for none
+  size_t	num_shown,		// Number of shown tests (UI thread)
+		alloc_shown;		// Allocated shown tests (UI thread)
+  _test_t	*shown;			// Shown tests (UI thread)
+
+  _history_t	*findHistory(selfcert_suite_t suite, const char *name);
+};
+
+#endif // !TESTTABLE_H
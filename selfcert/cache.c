@@ -0,0 +1,395 @@
+//
+// Selfcert validation cache for the IPP Everywhere Printer Self-Certification
+// application.
+//
+// Copyright © 2024 by the IEEE-ISTO Printer Working Group.
+//
+// Licensed under Apache License v2.0.	See the file "LICENSE" for more
+// information.
+//
+// Each results file gets a cache entry (a plist file) in the cache directory
+// that records the file's identity (path, size, modification time, and content
+// hash) along with the validation verdict, errors, and submission facts.  An
+// entry is only used when all of the identity values still match.
+//
+
+#include "selfcert.h"
+#if _WIN32
+#  include <direct.h>
+#  define mkdir(d,m) _mkdir(d)
+#endif // _WIN32
+
+
+// Local types...
+typedef struct _cache_key_s		// Results file identity
+{
+  char		path[1024];		// Absolute path
+  long long	size,			// Size in bytes
+		mtime;			// Modification time
+  char		hash[17];		// FNV-1a hash of content
+} _cache_key_t;
+
+
+// Local functions...
+static bool	cache_filename(_cache_key_t *key, char *buffer, size_t bufsize);
+static bool	cache_key(const char *filename, _cache_key_t *key);
+static void	hash_string(unsigned long long hash, char *buffer, size_t bufsize);
+static bool	make_dirs(char *path);
+
+
+//
+// 'cache_get()' - Get the cached summary for a results file.
+//
+
+bool					// O - `true` if found, `false` otherwise
+cache_get(const char       *filename,	// I - Results filename
+          selfcert_suite_t suite,	// I - Test suite
+          summary_t        *summary)	// O - Results summary
+{
+  _cache_key_t	key;			// Results file identity
+  char		cachefile[1024];	// Cache entry filename
+  plist_t	*entry,			// Cache entry
+		*value;			// Value in cache entry
+  bool		ret = false;		// Return value
+  char		*errptr;		// Pointer into errors
+
+
+  memset(summary, 0, sizeof(summary_t));
+
+  if (!cache_key(filename, &key) || !cache_filename(&key, cachefile, sizeof(cachefile)))
+    return (false);
+
+  if ((entry = plist_read(NULL, cachefile, NULL, NULL)) == NULL)
+    return (false);
+
+  // Make sure the entry matches the current file...
+  if ((value = plist_find(entry, "Version")) == NULL || value->type != PLIST_TYPE_STRING || strcmp(value->value, IPPEVESELFCERT_SWVERSION))
+    goto done;
+  if ((value = plist_find(entry, "Path")) == NULL || value->type != PLIST_TYPE_STRING || strcmp(value->value, key.path))
+    goto done;
+  if ((value = plist_find(entry, "Hash")) == NULL || value->type != PLIST_TYPE_STRING || strcmp(value->value, key.hash))
+    goto done;
+  if ((value = plist_find(entry, "Size")) == NULL || value->type != PLIST_TYPE_INTEGER || strtoll(value->value, NULL, 10) != key.size)
+    goto done;
+  if ((value = plist_find(entry, "ModTime")) == NULL || value->type != PLIST_TYPE_INTEGER || strtoll(value->value, NULL, 10) != key.mtime)
+    goto done;
+  if ((value = plist_find(entry, "Suite")) == NULL || value->type != PLIST_TYPE_INTEGER || atoi(value->value) != (int)suite)
+    goto done;
+
+  // Copy the verdict, errors, and facts...
+  summary->valid      = (value = plist_find(entry, "Valid")) != NULL && value->type == PLIST_TYPE_TRUE;
+  summary->color      = (value = plist_find(entry, "Facts/color")) != NULL && value->type == PLIST_TYPE_TRUE;
+  summary->duplex     = (value = plist_find(entry, "Facts/duplex")) != NULL && value->type == PLIST_TYPE_TRUE;
+  summary->finishings = (value = plist_find(entry, "Facts/finishings")) != NULL && value->type == PLIST_TYPE_TRUE;
+  summary->fin_fold   = (value = plist_find(entry, "Facts/fin_fold")) != NULL && value->type == PLIST_TYPE_TRUE;
+  summary->fin_punch  = (value = plist_find(entry, "Facts/fin_punch")) != NULL && value->type == PLIST_TYPE_TRUE;
+  summary->fin_staple = (value = plist_find(entry, "Facts/fin_staple")) != NULL && value->type == PLIST_TYPE_TRUE;
+  summary->fin_trim   = (value = plist_find(entry, "Facts/fin_trim")) != NULL && value->type == PLIST_TYPE_TRUE;
+  summary->ipps       = (value = plist_find(entry, "Facts/ipps")) != NULL && value->type == PLIST_TYPE_TRUE;
+
+  if ((value = plist_find(entry, "Facts/media")) != NULL && value->type == PLIST_TYPE_INTEGER)
+    summary->media = (summary_media_t)atoi(value->value);
+
+  if ((value = plist_find(entry, "Facts/version")) != NULL && value->type == PLIST_TYPE_STRING)
+    cupsCopyString(summary->version, value->value, sizeof(summary->version));
+
+  if ((value = plist_find(entry, "Errors")) != NULL && value->type == PLIST_TYPE_ARRAY)
+  {
+    for (value = value->first_child, errptr = summary->errors; value; value = value->next_sibling)
+    {
+      if (value->type != PLIST_TYPE_STRING)
+        continue;
+
+      snprintf(errptr, sizeof(summary->errors) - (size_t)(errptr - summary->errors), "%s\n", value->value);
+      errptr += strlen(errptr);
+    }
+  }
+
+  ret = true;
+
+  done:
+
+  plist_delete(entry);
+
+  return (ret);
+}
+
+
+//
+// 'cache_put()' - Save the summary for a results file.
+//
+
+bool					// O - `true` on success, `false` on error
+cache_put(const char       *filename,	// I - Results filename
+          selfcert_suite_t suite,	// I - Test suite
+          const summary_t  *summary)	// I - Results summary
+{
+  _cache_key_t	key;			// Results file identity
+  char		cachefile[1024],	// Cache entry filename
+		tempfile[1040],		// Temporary filename
+		temp[256],		// Temporary string
+		*errors,		// Copy of errors
+		*errptr,		// Pointer into errors
+		*errnext;		// Next line in errors
+  plist_t	*plist,			// Cache entry plist
+		*entry,			// Cache entry dictionary
+		*facts,			// Facts dictionary
+		*array;			// Errors array
+  bool		ret;			// Return value
+
+
+  if (!cache_key(filename, &key) || !cache_filename(&key, cachefile, sizeof(cachefile)))
+    return (false);
+
+  // Build the cache entry...
+  plist = plist_new();
+  entry = plist_add(plist, PLIST_TYPE_DICT, NULL);
+
+  plist_add(entry, PLIST_TYPE_KEY, "Version");
+  plist_add(entry, PLIST_TYPE_STRING, IPPEVESELFCERT_SWVERSION);
+
+  plist_add(entry, PLIST_TYPE_KEY, "Path");
+  plist_add(entry, PLIST_TYPE_STRING, key.path);
+
+  plist_add(entry, PLIST_TYPE_KEY, "Size");
+  snprintf(temp, sizeof(temp), "%lld", key.size);
+  plist_add(entry, PLIST_TYPE_INTEGER, temp);
+
+  plist_add(entry, PLIST_TYPE_KEY, "ModTime");
+  snprintf(temp, sizeof(temp), "%lld", key.mtime);
+  plist_add(entry, PLIST_TYPE_INTEGER, temp);
+
+  plist_add(entry, PLIST_TYPE_KEY, "Hash");
+  plist_add(entry, PLIST_TYPE_STRING, key.hash);
+
+  plist_add(entry, PLIST_TYPE_KEY, "Suite");
+  snprintf(temp, sizeof(temp), "%d", (int)suite);
+  plist_add(entry, PLIST_TYPE_INTEGER, temp);
+
+  plist_add(entry, PLIST_TYPE_KEY, "Valid");
+  plist_add(entry, summary->valid ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL);
+
+  // Errors are stored one line per string since XML text loses trailing
+  // whitespace...
+  plist_add(entry, PLIST_TYPE_KEY, "Errors");
+  array = plist_add(entry, PLIST_TYPE_ARRAY, NULL);
+
+  if (summary->errors[0] && (errors = strdup(summary->errors)) != NULL)
+  {
+    for (errptr = errors; *errptr; errptr = errnext)
+    {
+      if ((errnext = strchr(errptr, '\n')) != NULL)
+        *errnext++ = '\0';
+      else
+        errnext = errptr + strlen(errptr);
+
+      plist_add(array, PLIST_TYPE_STRING, errptr);
+    }
+
+    free(errors);
+  }
+
+  plist_add(entry, PLIST_TYPE_KEY, "Facts");
+  facts = plist_add(entry, PLIST_TYPE_DICT, NULL);
+
+  plist_add(facts, PLIST_TYPE_KEY, "color");
+  plist_add(facts, summary->color ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL);
+  plist_add(facts, PLIST_TYPE_KEY, "duplex");
+  plist_add(facts, summary->duplex ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL);
+  plist_add(facts, PLIST_TYPE_KEY, "finishings");
+  plist_add(facts, summary->finishings ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL);
+  plist_add(facts, PLIST_TYPE_KEY, "fin_fold");
+  plist_add(facts, summary->fin_fold ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL);
+  plist_add(facts, PLIST_TYPE_KEY, "fin_punch");
+  plist_add(facts, summary->fin_punch ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL);
+  plist_add(facts, PLIST_TYPE_KEY, "fin_staple");
+  plist_add(facts, summary->fin_staple ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL);
+  plist_add(facts, PLIST_TYPE_KEY, "fin_trim");
+  plist_add(facts, summary->fin_trim ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL);
+  plist_add(facts, PLIST_TYPE_KEY, "ipps");
+  plist_add(facts, summary->ipps ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL);
+  plist_add(facts, PLIST_TYPE_KEY, "media");
+  snprintf(temp, sizeof(temp), "%d", (int)summary->media);
+  plist_add(facts, PLIST_TYPE_INTEGER, temp);
+  plist_add(facts, PLIST_TYPE_KEY, "version");
+  plist_add(facts, PLIST_TYPE_STRING, summary->version);
+
+  // Write to a temporary file and then rename so that concurrent readers never
+  // see a partial entry...
+  snprintf(tempfile, sizeof(tempfile), "%s.%d", cachefile, (int)getpid());
+
+  if ((ret = plist_write(NULL, tempfile, plist, NULL, NULL)) == true)
+  {
+#if _WIN32
+    unlink(cachefile);
+#endif // _WIN32
+
+    if (rename(tempfile, cachefile))
+    {
+      unlink(tempfile);
+      ret = false;
+    }
+  }
+
+  plist_delete(plist);
+
+  return (ret);
+}
+
+
+//
+// 'cache_filename()' - Get the cache entry filename for a results file.
+//
+// The cache directory is "$IPPEVESELFCERT_CACHE" if set, otherwise the
+// platform's per-user cache directory.  The entry filename is derived from
+// the absolute path of the results file.
+//
+
+static bool				// O - `true` on success, `false` on error
+cache_filename(_cache_key_t *key,	// I - Results file identity
+               char         *buffer,	// I - Filename buffer
+               size_t       bufsize)	// I - Size of filename buffer
+{
+  const char		*dir;		// Cache directory
+  char			dirname[1024],	// Cache directory name
+			name[17];	// Entry name
+  unsigned long long	hash;		// Hash of path
+  const char		*ptr;		// Pointer into path
+
+
+  if ((dir = getenv("IPPEVESELFCERT_CACHE")) != NULL && *dir)
+    cupsCopyString(dirname, dir, sizeof(dirname));
+#if _WIN32
+  else if ((dir = getenv("LOCALAPPDATA")) != NULL)
+    snprintf(dirname, sizeof(dirname), "%s/ippeveselfcert", dir);
+#else
+  else if ((dir = getenv("XDG_CACHE_HOME")) != NULL && *dir == '/')
+    snprintf(dirname, sizeof(dirname), "%s/ippeveselfcert", dir);
+#  ifdef __APPLE__
+  else if ((dir = getenv("HOME")) != NULL)
+    snprintf(dirname, sizeof(dirname), "%s/Library/Caches/ippeveselfcert", dir);
+#  else
+  else if ((dir = getenv("HOME")) != NULL)
+    snprintf(dirname, sizeof(dirname), "%s/.cache/ippeveselfcert", dir);
+#  endif // __APPLE__
+#endif // _WIN32
+  else
+    return (false);
+
+  if (!make_dirs(dirname))
+    return (false);
+
+  for (hash = 0xcbf29ce484222325ULL, ptr = key->path; *ptr; ptr ++)
+    hash = (hash ^ (unsigned char)*ptr) * 0x100000001b3ULL;
+
+  hash_string(hash, name, sizeof(name));
+  snprintf(buffer, bufsize, "%s/%s.plist", dirname, name);
+
+  return (true);
+}
+
+
+//
+// 'cache_key()' - Get the identity of a results file.
+//
+
+static bool				// O - `true` on success, `false` on error
+cache_key(const char   *filename,	// I - Results filename
+          _cache_key_t *key)		// O - Results file identity
+{
+  struct stat		fileinfo;	// File information
+  FILE			*fp;		// Results file
+  unsigned char		buffer[65536],	// Read buffer
+			*bufptr,	// Pointer into buffer
+			*bufend;	// End of buffer
+  size_t		bytes;		// Bytes read
+  unsigned long long	hash;		// FNV-1a hash
+
+
+  memset(key, 0, sizeof(_cache_key_t));
+
+#if _WIN32
+  if (!_fullpath(key->path, filename, sizeof(key->path)))
+    return (false);
+#else
+  char	*path;				// Absolute path
+
+  if ((path = realpath(filename, NULL)) == NULL)
+    return (false);
+
+  cupsCopyString(key->path, path, sizeof(key->path));
+  free(path);
+#endif // _WIN32
+
+  if ((fp = fopen(key->path, "rb")) == NULL)
+    return (false);
+
+  if (fstat(fileno(fp), &fileinfo))
+  {
+    fclose(fp);
+    return (false);
+  }
+
+  key->size  = (long long)fileinfo.st_size;
+  key->mtime = (long long)fileinfo.st_mtime;
+
+  // Hash the content using 64-bit FNV-1a, which is plenty to detect edits that
+  // preserve the size and modification time...
+  hash = 0xcbf29ce484222325ULL;
+
+  while ((bytes = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+  {
+    for (bufptr = buffer, bufend = buffer + bytes; bufptr < bufend; bufptr ++)
+      hash = (hash ^ *bufptr) * 0x100000001b3ULL;
+  }
+
+  fclose(fp);
+
+  hash_string(hash, key->hash, sizeof(key->hash));
+
+  return (true);
+}
+
+
+//
+// 'hash_string()' - Convert a hash to a hex string.
+//
+
+static void
+hash_string(unsigned long long hash,	// I - Hash value
+            char               *buffer,	// I - String buffer
+            size_t             bufsize)	// I - Size of string buffer
+{
+  snprintf(buffer, bufsize, "%016llx", hash);
+}
+
+
+//
+// 'make_dirs()' - Make a directory and any missing parent directories.
+//
+
+static bool				// O - `true` on success, `false` on error
+make_dirs(char *path)			// I - Directory path
+{
+  char		*ptr;			// Pointer into path
+  struct stat	fileinfo;		// Directory information
+
+
+  if (!stat(path, &fileinfo))
+    return (true);
+
+  for (ptr = strchr(path + 1, '/'); ptr; ptr = strchr(ptr + 1, '/'))
+  {
+    *ptr = '\0';
+
+    if (stat(path, &fileinfo) && mkdir(path, 0700) && errno != EEXIST)
+    {
+      *ptr = '/';
+      return (false);
+    }
+
+    *ptr = '/';
+  }
+
+  return (!mkdir(path, 0700) || errno == EEXIST);
+}
@@ -0,0 +1,241 @@
+//
+// Printer connection pool for the IPP Everywhere Printer Self-Certification
+// application.
+//
+// Copyright © 2024 by the IEEE-ISTO Printer Working Group.
+//
+// Licensed under Apache License v2.0.	See the file "LICENSE" for more
+// information.
+//
+// The DNS-SD tests, job notifications, and stress test each send their own
+// requests to the printer from this process.  Rather than opening a new
+// connection (and doing a new TLS handshake for "ipps" printers) every time,
+// connections are kept open and handed out again to the next request for the
+// same host, port, and encryption for the whole run.  libcups reconnects
+// automatically when the printer has closed an idle connection.
+//
+// Only keep-alive connections are reused; TLS sessions are not resumed, so
+// every new connection, including a reconnect, does a full handshake.  The
+// connections made by ipptool for the IPP and Document tests are not pooled
+// and not counted in the statistics.  The B-5.1 HTTP Upgrade test needs a
+// connection that has never been encrypted, so it does not use the pool
+// either.
+//
+
+#include "selfcert.h"
+#include <cups/thread.h>
+
+
+// Local constants...
+#define CONNPOOL_MAX_IDLE	2	// Maximum idle connections per host and port
+
+
+// Local types...
+typedef struct _connpool_conn_s		// Pooled connection
+{
+  char		host[256];		// Hostname
+  int		port;			// Port number
+  http_encryption_t encryption;		// Encryption
+  http_t	*http;			// Connection
+  bool		busy;			// Is the connection in use?
+} _connpool_conn_t;
+
+
+// Local globals...
+static cups_mutex_t	connpool_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for pool
+static size_t		connpool_num_conns = 0,
+					// Number of connections
+			connpool_alloc_conns = 0;
+					// Allocated connections
+static _connpool_conn_t	*connpool_conns = NULL;
+					// Connections
+static connpool_stats_t	connpool_stats = { 0, 0, 0, 0 };
+					// Statistics
+
+
+//
+// 'connpool_close()' - Close all idle connections.
+//
+
+void
+connpool_close(void)
+{
+  size_t	i,			// Looping var
+		j;			// Looping var
+
+
+  cupsMutexLock(&connpool_mutex);
+
+  for (i = 0, j = 0; i < connpool_num_conns; i ++)
+  {
+    if (connpool_conns[i].busy)
+      connpool_conns[j ++] = connpool_conns[i];
+    else
+      httpClose(connpool_conns[i].http);
+  }
+
+  connpool_num_conns = j;
+
+  cupsMutexUnlock(&connpool_mutex);
+}
+
+
+//
+// 'connpool_get()' - Get a connection to a printer.
+//
+// An idle connection to the same host and port with the same encryption is
+// reused when available, otherwise a new connection is opened.  Return the
+// connection with connpool_put() when done with it.
+//
+
+http_t *				// O - Connection or `NULL` on error
+connpool_get(
+    const char        *host,		// I - Hostname
+    int               port,		// I - Port number
+    http_encryption_t encryption)	// I - Encryption
+{
+  size_t		i;		// Looping var
+  _connpool_conn_t	*conn;		// Current connection
+  http_t		*http;		// Connection
+
+
+  if (!host)
+    return (NULL);
+
+  cupsMutexLock(&connpool_mutex);
+
+  for (i = connpool_num_conns; i > 0; i --)
+  {
+    conn = connpool_conns + i - 1;
+
+    if (!conn->busy && conn->port == port && conn->encryption == encryption && !strcasecmp(conn->host, host))
+    {
+      // Reuse the most recently used idle connection...
+      conn->busy = true;
+      http       = conn->http;
+
+      connpool_stats.reused ++;
+      if (httpIsEncrypted(http))
+        connpool_stats.tls_reused ++;
+
+      cupsMutexUnlock(&connpool_mutex);
+
+      return (http);
+    }
+  }
+
+  cupsMutexUnlock(&connpool_mutex);
+
+  // Open a new connection without holding the mutex...
+  if ((http = httpConnect(host, port, NULL, AF_UNSPEC, encryption, true, 30000, NULL)) == NULL)
+    return (NULL);
+
+  cupsMutexLock(&connpool_mutex);
+
+  connpool_stats.opened ++;
+  if (httpIsEncrypted(http))
+    connpool_stats.tls_opened ++;
+
+  if (connpool_num_conns >= connpool_alloc_conns)
+  {
+    if ((conn = (_connpool_conn_t *)realloc(connpool_conns, (connpool_alloc_conns + 16) * sizeof(_connpool_conn_t))) == NULL)
+    {
+      // Can't track the connection, connpool_put() will close it...
+      cupsMutexUnlock(&connpool_mutex);
+      return (http);
+    }
+
+    connpool_conns       = conn;
+    connpool_alloc_conns += 16;
+  }
+
+  conn = connpool_conns + connpool_num_conns;
+  connpool_num_conns ++;
+
+  cupsCopyString(conn->host, host, sizeof(conn->host));
+  conn->port       = port;
+  conn->encryption = encryption;
+  conn->http       = http;
+  conn->busy       = true;
+
+  cupsMutexUnlock(&connpool_mutex);
+
+  return (http);
+}
+
+
+//
+// 'connpool_get_stats()' - Get the connection statistics.
+//
+
+void
+connpool_get_stats(
+    connpool_stats_t *stats)		// O - Statistics
+{
+  if (!stats)
+    return;
+
+  cupsMutexLock(&connpool_mutex);
+  *stats = connpool_stats;
+  cupsMutexUnlock(&connpool_mutex);
+}
+
+
+//
+// 'connpool_put()' - Return a connection to the pool.
+//
+// The connection is closed if it was upgraded to TLS after it was opened,
+// since the next user expects an unencrypted connection, or if there are
+// already enough idle connections to the printer.
+//
+
+void
+connpool_put(http_t *http)		// I - Connection
+{
+  size_t		i,		// Looping var
+			num_idle;	// Number of idle connections
+  _connpool_conn_t	*conn,		// Current connection
+			*match = NULL;	// Matching connection
+
+
+  if (!http)
+    return;
+
+  cupsMutexLock(&connpool_mutex);
+
+  for (i = 0, conn = connpool_conns; i < connpool_num_conns; i ++, conn ++)
+  {
+    if (conn->http == http)
+    {
+      match = conn;
+      break;
+    }
+  }
+
+  if (match)
+  {
+    for (i = 0, num_idle = 0, conn = connpool_conns; i < connpool_num_conns; i ++, conn ++)
+    {
+      if (!conn->busy && conn->port == match->port && !strcasecmp(conn->host, match->host))
+        num_idle ++;
+    }
+
+    if (num_idle < CONNPOOL_MAX_IDLE && (match->encryption == HTTP_ENCRYPTION_ALWAYS || !httpIsEncrypted(http)))
+    {
+      // Keep the connection open for the next user...
+      match->busy = false;
+      cupsMutexUnlock(&connpool_mutex);
+      return;
+    }
+
+    // Remove the connection from the pool...
+    connpool_num_conns --;
+    if ((i = (size_t)(match - connpool_conns)) < connpool_num_conns)
+      memmove(match, match + 1, (connpool_num_conns - i) * sizeof(_connpool_conn_t));
+  }
+
+  cupsMutexUnlock(&connpool_mutex);
+
+  httpClose(http);
+}
@@ -0,0 +1,1542 @@
+//
+// DNS-SD tests for the IPP Everywhere Printer Self-Certification application.
+//
+// Copyright © 2024 by the IEEE-ISTO Printer Working Group.
+//
+// Licensed under Apache License v2.0.	See the file "LICENSE" for more
+// information.
+//
+// The DNS-SD tests (section 5 of the self-certification manual) browse for
+// the printer's "_ipp._tcp" and "_ipps._tcp" services, with and without the
+// "_print" subtype, in a single DNS-SD session and resolve each service once.
+// All of the TXT record checks are then done against that snapshot, and the
+// TXT values are compared against a single Get-Printer-Attributes response
+// for each service.
+//
+// The GUI application also browses for printers the whole time it runs (see
+// dnssd_browse_start()) and keeps the resolved host, port, and TXT record of
+// each printer's IPP and IPPS services up to date.  When a printer is in that
+// cache, the tests and the dnssd_get_ functions use it instead of browsing for
+// and resolving the printer again.
+//
+
+#include "selfcert.h"
+#include <cups/dnssd.h>
+#include <cups/thread.h>
+#include <stdarg.h>
+
+
+// Local constants...
+#define DNSSD_FILEID	"org.pwg.ippeveselfcert11.dnssd"
+					// FileId for the results
+#define DNSSD_TIMEOUT	5.0		// Browse/resolve timeout in seconds
+
+
+// Local types...
+typedef enum _dnssd_type_e		// Service types
+{
+  _DNSSD_TYPE_IPP,			// _ipp._tcp
+  _DNSSD_TYPE_IPPS,			// _ipps._tcp
+  _DNSSD_TYPE_IPP_PRINT,		// _ipp._tcp,_print
+  _DNSSD_TYPE_IPPS_PRINT,		// _ipps._tcp,_print
+  _DNSSD_TYPE_MAX			// Number of service types
+} _dnssd_type_t;
+
+typedef struct _dnssd_s _dnssd_t;	// DNS-SD test data
+
+typedef struct _dnssd_cache_s _dnssd_cache_t;
+					// Cached printer services
+
+typedef struct _dnssd_service_s		// Printer service
+{
+  _dnssd_t	*data;			// DNS-SD test data
+  _dnssd_cache_t *cache;		// Cached printer, if any
+  _dnssd_type_t	type;			// Service type
+  bool		found,			// Was the service found?
+		resolved;		// Was the service resolved?
+  uint32_t	if_index;		// Interface index
+  char		domain[256],		// Domain name
+		host[256];		// Resolved hostname
+  int		port;			// Resolved port number
+  size_t	num_txt;		// Number of TXT key/value pairs
+  cups_option_t	*txt;			// TXT key/value pairs
+  char		uri[1024],		// Printer URI
+		resource[256];		// Resource path
+  ipp_t		*response;		// Get-Printer-Attributes response
+  char		error[1280];		// Get-Printer-Attributes error, if any
+} _dnssd_service_t;
+
+struct _dnssd_s				// DNS-SD test data
+{
+  const char	*printer;		// Printer service instance name
+  cups_mutex_t	mutex;			// Mutex for services
+  cups_cond_t	cond;			// Condition for services
+  _dnssd_service_t services[_DNSSD_TYPE_MAX];
+					// Printer services
+  char		error[256];		// DNS-SD error, if any
+  runner_cb_t	cb;			// Event callback
+  void		*cb_data;		// Event callback data
+  bool		canceled;		// Were the tests canceled?
+  plist_t	*tests,			// Tests array
+		*test,			// Current test dictionary
+		*errors;		// Current test errors
+  runner_test_t	current;		// Current test
+  size_t	num_failed;		// Number of failed tests
+};
+
+struct _dnssd_cache_s			// Cached printer services
+{
+  char		name[256];		// Service instance name
+  double	first;			// Time when the printer was first found
+  bool		added,			// Was the printer reported?
+		changed;		// Did the services change since then?
+  _dnssd_service_t services[_DNSSD_TYPE_MAX];
+					// Printer services
+  cups_dnssd_resolve_t *resolves[_DNSSD_TYPE_IPPS + 1];
+					// IPP and IPPS resolve requests
+};
+
+
+// Local globals...
+static const char * const dnssd_types[] =
+{					// Service types to browse
+  "_ipp._tcp",
+  "_ipps._tcp",
+  "_ipp._tcp,_print",
+  "_ipps._tcp,_print"
+};
+
+static cups_mutex_t	dnssd_cache_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for printer cache
+static cups_cond_t	dnssd_cache_cond = CUPS_COND_INITIALIZER;
+					// Condition for printer cache changes
+static cups_dnssd_t	*dnssd_cache_dnssd = NULL;
+					// DNS-SD session for printer browser
+static cups_thread_t	dnssd_cache_thread = CUPS_THREAD_INVALID;
+					// Printer browser thread
+static bool		dnssd_cache_pending = false,
+					// Are there changes to look at?
+			dnssd_cache_stop = false;
+					// Stop the printer browser?
+static dnssd_browse_cb_t dnssd_cache_cb = NULL;
+					// Printer browser callback
+static void		*dnssd_cache_cb_data = NULL;
+					// Printer browser callback data
+static size_t		dnssd_cache_num_printers = 0,
+					// Number of cached printers
+			dnssd_cache_alloc_printers = 0;
+					// Allocated cached printers
+static _dnssd_cache_t	**dnssd_cache_printers = NULL;
+					// Cached printers
+
+
+// Local functions...
+static void	dnssd_browse_cb(cups_dnssd_browse_t *browse, _dnssd_service_t *service, cups_dnssd_flags_t flags, uint32_t if_index, const char *name, const char *regtype, const char *domain);
+static void	dnssd_cache_browse_cb(cups_dnssd_browse_t *browse, const char * const *type, cups_dnssd_flags_t flags, uint32_t if_index, const char *name, const char *regtype, const char *domain);
+static _dnssd_cache_t *dnssd_cache_find(const char *printer);
+static bool	dnssd_cache_get(const char *printer, _dnssd_service_t *services);
+static void	dnssd_cache_resolve_cb(cups_dnssd_resolve_t *res, _dnssd_service_t *service, cups_dnssd_flags_t flags, uint32_t if_index, const char *fullname, const char *host, uint16_t port, size_t num_txt, cups_option_t *txt);
+static void	*dnssd_cache_run(void *data);
+static bool	dnssd_check_keys(_dnssd_t *data, _dnssd_service_t *service, bool report);
+static bool	dnssd_check_values(_dnssd_t *data, _dnssd_service_t *service, bool color, bool report);
+static bool	dnssd_end_test(_dnssd_t *data, const char *status);
+static void	dnssd_error(_dnssd_t *data, const char *message, ...) SELFCERT_FORMAT(2,3);
+static void	dnssd_error_cb(_dnssd_t *data, const char *message);
+static bool	dnssd_expect(_dnssd_t *data, ipp_t *response, const char *name, const char *value, bool report);
+static ipp_t	*dnssd_get_attributes(_dnssd_service_t *service, http_t *http);
+static bool	dnssd_is_adminurl(const char *value);
+static bool	dnssd_is_tls(const char *value);
+static bool	dnssd_is_uuid(const char *value);
+static bool	dnssd_resolve(const char *printer, _dnssd_type_t type, char *host, size_t hostsize, int *port, char *uri, size_t urisize, size_t *num_txt, cups_option_t **txt);
+static void	dnssd_resolve_cb(cups_dnssd_resolve_t *res, _dnssd_service_t *service, cups_dnssd_flags_t flags, uint32_t if_index, const char *fullname, const char *host, uint16_t port, size_t num_txt, cups_option_t *txt);
+static bool	dnssd_start_test(_dnssd_t *data, const char *name);
+static bool	dnssd_tests(_dnssd_t *data, bool color, bool tls);
+static void	dnssd_wait(_dnssd_t *data, bool resolve);
+
+
+//
+// 'dnssd_browse_start()' - Start browsing for printers.
+//
+// The printers are browsed for and resolved in the background until
+// dnssd_browse_stop() is called.  The callback is called from the browser
+// thread with `DNSSD_EVENT_ADD` when a printer is found, `DNSSD_EVENT_UPDATE`
+// when its services are resolved or change, and `DNSSD_EVENT_REMOVE` when all
+// of its services are gone.
+//
+
+bool					// O - `true` on success, `false` on error
+dnssd_browse_start(
+    dnssd_browse_cb_t cb,		// I - Printer callback or `NULL` for none
+    void              *cb_data)		// I - Printer callback data
+{
+  int		i;			// Looping var
+
+
+  if (dnssd_cache_dnssd)
+    return (false);
+
+  dnssd_cache_cb      = cb;
+  dnssd_cache_cb_data = cb_data;
+  dnssd_cache_pending = false;
+  dnssd_cache_stop    = false;
+
+  if ((dnssd_cache_dnssd = cupsDNSSDNew(NULL, NULL)) == NULL)
+    return (false);
+
+  for (i = 0; i < _DNSSD_TYPE_MAX; i ++)
+  {
+    if (!cupsDNSSDBrowseNew(dnssd_cache_dnssd, CUPS_DNSSD_IF_INDEX_ANY, dnssd_types[i], NULL, (cups_dnssd_browse_cb_t)dnssd_cache_browse_cb, (void *)(dnssd_types + i)))
+      break;
+  }
+
+  if (i < _DNSSD_TYPE_MAX || (dnssd_cache_thread = cupsThreadCreate((cups_thread_func_t)dnssd_cache_run, NULL)) == CUPS_THREAD_INVALID)
+  {
+    cupsDNSSDDelete(dnssd_cache_dnssd);
+    dnssd_cache_dnssd = NULL;
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'dnssd_browse_stop()' - Stop browsing for printers and clear the cache.
+//
+
+void
+dnssd_browse_stop(void)
+{
+  size_t	i;			// Looping var
+  int		j;			// Looping var
+
+
+  if (!dnssd_cache_dnssd)
+    return;
+
+  cupsMutexLock(&dnssd_cache_mutex);
+  dnssd_cache_stop = true;
+  cupsCondBroadcast(&dnssd_cache_cond);
+  cupsMutexUnlock(&dnssd_cache_mutex);
+
+  cupsThreadWait(dnssd_cache_thread);
+
+  // Deleting the session stops all browsing and resolving...
+  cupsDNSSDDelete(dnssd_cache_dnssd);
+
+  dnssd_cache_dnssd  = NULL;
+  dnssd_cache_thread = CUPS_THREAD_INVALID;
+
+  cupsMutexLock(&dnssd_cache_mutex);
+
+  for (i = 0; i < dnssd_cache_num_printers; i ++)
+  {
+    for (j = 0; j < _DNSSD_TYPE_MAX; j ++)
+      cupsFreeOptions(dnssd_cache_printers[i]->services[j].num_txt, dnssd_cache_printers[i]->services[j].txt);
+
+    free(dnssd_cache_printers[i]);
+  }
+
+  free(dnssd_cache_printers);
+
+  dnssd_cache_printers       = NULL;
+  dnssd_cache_num_printers   = 0;
+  dnssd_cache_alloc_printers = 0;
+
+  cupsMutexUnlock(&dnssd_cache_mutex);
+}
+
+
+//
+// 'dnssd_get_cached_uri()' - Get the "ipp" URI for a printer from the printer
+//                            browser.
+//
+// Unlike dnssd_get_uri(), the printer is not resolved when it has not been
+// found by the printer browser.
+//
+
+bool					// O - `true` on success, `false` if not cached
+dnssd_get_cached_uri(
+    const char *printer,		// I - Printer service instance name
+    char       *uri,			// I - URI buffer
+    size_t     urisize)			// I - Size of URI buffer
+{
+  _dnssd_cache_t *cache;		// Cached printer
+  bool		ret = false;		// Return value
+
+
+  *uri = '\0';
+
+  if (!printer)
+    return (false);
+
+  cupsMutexLock(&dnssd_cache_mutex);
+
+  if ((cache = dnssd_cache_find(printer)) != NULL && cache->services[_DNSSD_TYPE_IPP].resolved)
+  {
+    cupsCopyString(uri, cache->services[_DNSSD_TYPE_IPP].uri, urisize);
+    ret = true;
+  }
+
+  cupsMutexUnlock(&dnssd_cache_mutex);
+
+  return (ret);
+}
+
+
+//
+// 'dnssd_get_host()' - Get the hostname for a printer service instance name.
+//
+
+bool					// O - `true` on success, `false` if not found
+dnssd_get_host(const char *printer,	// I - Printer service instance name
+               char       *host,	// I - Hostname buffer
+               size_t     hostsize)	// I - Size of hostname buffer
+{
+  return (dnssd_resolve(printer, _DNSSD_TYPE_IPP, host, hostsize, NULL, NULL, 0, NULL, NULL));
+}
+
+
+//
+// 'dnssd_get_service()' - Get the hostname, port, and TXT record for a printer
+//                         service instance name.
+//
+// The TXT key/value pairs must be freed with `cupsFreeOptions`.
+//
+
+bool					// O - `true` on success, `false` if not found
+dnssd_get_service(
+    const char    *printer,		// I - Printer service instance name
+    bool          ipps,			// I - `true` for "_ipps._tcp", `false` for "_ipp._tcp"
+    char          *host,		// I - Hostname buffer
+    size_t        hostsize,		// I - Size of hostname buffer
+    int           *port,		// O - Port number
+    size_t        *num_txt,		// O - Number of TXT key/value pairs
+    cups_option_t **txt)		// O - TXT key/value pairs
+{
+  return (dnssd_resolve(printer, ipps ? _DNSSD_TYPE_IPPS : _DNSSD_TYPE_IPP, host, hostsize, port, NULL, 0, num_txt, txt));
+}
+
+
+//
+// 'dnssd_get_uri()' - Get the "ipp" URI for a printer service instance name.
+//
+
+bool					// O - `true` on success, `false` if not found
+dnssd_get_uri(const char *printer,	// I - Printer service instance name
+              char       *uri,		// I - URI buffer
+              size_t     urisize)	// I - Size of URI buffer
+{
+  return (dnssd_resolve(printer, _DNSSD_TYPE_IPP, NULL, 0, NULL, uri, urisize, NULL, NULL));
+}
+
+
+//
+// 'dnssd_run()' - Run the DNS-SD tests and write the results.
+//
+// The callback gets the `RUNNER_EVENT_TEST_START`, `RUNNER_EVENT_TEST_END`,
+// and `RUNNER_EVENT_MESSAGE` events for the tests.  The errors for a test are
+// sent as messages after its `RUNNER_EVENT_TEST_END` event.  Returning `false`
+// from the callback cancels the tests.
+//
+
+bool					// O - `true` if the tests ran, `false` on error or cancel
+dnssd_run(const char  *printer,		// I - Printer service instance name
+          const char  *filename,	// I - Results plist filename
+          runner_cb_t cb,		// I - Event callback or `NULL` for none
+          void        *cb_data)		// I - Event callback data
+{
+  _dnssd_t	data;			// DNS-SD test data
+  cups_dnssd_t	*dnssd;			// DNS-SD session
+  _dnssd_service_t *ipp,		// IPP service
+		*ipps;			// IPPS service
+  int		i;			// Looping var
+  http_t	*http,			// Connection to IPP service
+		*https;			// Connection to IPPS service
+  plist_t	*results,		// Results plist
+		*dict;			// Results dictionary
+  const char	*value;			// TXT value
+  bool		browsing = false,	// Did browsing start?
+		ipp_found,		// Was the IPP service found?
+		ipps_found,		// Was the IPPS service found?
+		color,			// Color printer?
+		tls,			// TLS supported?
+		ret = false;		// Return value
+
+
+  if (!printer || !filename)
+    return (false);
+
+  memset(&data, 0, sizeof(data));
+
+  data.printer = printer;
+  data.cb      = cb;
+  data.cb_data = cb_data;
+
+  cupsMutexInit(&data.mutex);
+  cupsCondInit(&data.cond);
+
+  for (i = 0; i < _DNSSD_TYPE_MAX; i ++)
+  {
+    data.services[i].data = &data;
+    data.services[i].type = (_dnssd_type_t)i;
+  }
+
+  ipp  = data.services + _DNSSD_TYPE_IPP;
+  ipps = data.services + _DNSSD_TYPE_IPPS;
+
+  // Use the services from the printer browser, if any, or browse for all of
+  // the services and then resolve the IPP and IPPS services...
+  if (dnssd_cache_get(printer, data.services))
+  {
+    browsing = true;
+
+    if (cb)
+      (cb)(cb_data, RUNNER_EVENT_MESSAGE, NULL, "Using the services found by the printer browser.");
+  }
+  else if ((dnssd = cupsDNSSDNew((cups_dnssd_error_cb_t)dnssd_error_cb, &data)) == NULL)
+  {
+    if (cb)
+      (cb)(cb_data, RUNNER_EVENT_MESSAGE, NULL, "Unable to start DNS-SD session.");
+  }
+  else
+  {
+    for (i = 0; i < _DNSSD_TYPE_MAX; i ++)
+    {
+      if (!cupsDNSSDBrowseNew(dnssd, CUPS_DNSSD_IF_INDEX_ANY, dnssd_types[i], NULL, (cups_dnssd_browse_cb_t)dnssd_browse_cb, data.services + i))
+        break;
+    }
+
+    if (i < _DNSSD_TYPE_MAX)
+    {
+      if (cb)
+	(cb)(cb_data, RUNNER_EVENT_MESSAGE, NULL, data.error[0] ? data.error : "Unable to browse for printers.");
+    }
+    else
+    {
+      browsing = true;
+
+      dnssd_wait(&data, false);
+
+      cupsMutexLock(&data.mutex);
+      ipp_found  = ipp->found;
+      ipps_found = ipps->found;
+      cupsMutexUnlock(&data.mutex);
+
+      if (ipp_found)
+	cupsDNSSDResolveNew(dnssd, ipp->if_index, printer, dnssd_types[_DNSSD_TYPE_IPP], ipp->domain, (cups_dnssd_resolve_cb_t)dnssd_resolve_cb, ipp);
+      if (ipps_found)
+	cupsDNSSDResolveNew(dnssd, ipps->if_index, printer, dnssd_types[_DNSSD_TYPE_IPPS], ipps->domain, (cups_dnssd_resolve_cb_t)dnssd_resolve_cb, ipps);
+
+      dnssd_wait(&data, true);
+    }
+
+    // Stop browsing and resolving so the snapshot doesn't change...
+    cupsDNSSDDelete(dnssd);
+  }
+
+  if (browsing)
+  {
+    color = (value = cupsGetOption("Color", ipp->num_txt, ipp->txt)) != NULL && strchr(value, 'T') != NULL;
+    tls   = (value = cupsGetOption("TLS", ipp->num_txt, ipp->txt)) != NULL && dnssd_is_tls(value);
+
+    // Query the printer over a single connection for each service...
+    if (ipp->resolved && (http = connpool_get(ipp->host, ipp->port, HTTP_ENCRYPTION_IF_REQUESTED)) != NULL)
+    {
+      ipp->response = dnssd_get_attributes(ipp, http);
+      connpool_put(http);
+    }
+    else if (ipp->resolved)
+      snprintf(ipp->error, sizeof(ipp->error), "%s: %s", ipp->uri, cupsGetErrorString());
+
+    if (tls && ipps->resolved)
+    {
+      if ((https = connpool_get(ipps->host, ipps->port, HTTP_ENCRYPTION_ALWAYS)) != NULL)
+      {
+	ipps->response = dnssd_get_attributes(ipps, https);
+	connpool_put(https);
+      }
+      else
+      {
+	snprintf(ipps->error, sizeof(ipps->error), "%s: %s", ipps->uri, cupsGetErrorString());
+      }
+    }
+
+    // Run the tests and write the results...
+    results = plist_new();
+    dict    = plist_add(results, PLIST_TYPE_DICT, NULL);
+
+    plist_add(dict, PLIST_TYPE_KEY, "Tests");
+    data.tests = plist_add(dict, PLIST_TYPE_ARRAY, NULL);
+
+    if (dnssd_tests(&data, color, tls))
+    {
+      plist_add(dict, PLIST_TYPE_KEY, "Successful");
+      plist_add(dict, data.num_failed ? PLIST_TYPE_FALSE : PLIST_TYPE_TRUE, NULL);
+
+      if (plist_write(NULL, filename, results, (plist_error_cb_t)dnssd_error_cb, &data))
+        ret = true;
+      else if (cb)
+	(cb)(cb_data, RUNNER_EVENT_MESSAGE, NULL, data.error);
+    }
+
+    plist_delete(results);
+  }
+
+  // Clean up...
+  for (i = 0; i < _DNSSD_TYPE_MAX; i ++)
+  {
+    cupsFreeOptions(data.services[i].num_txt, data.services[i].txt);
+    ippDelete(data.services[i].response);
+  }
+
+  cupsCondDestroy(&data.cond);
+  cupsMutexDestroy(&data.mutex);
+
+  return (ret);
+}
+
+
+//
+// 'dnssd_browse_cb()' - Record a printer service that was found.
+//
+
+static void
+dnssd_browse_cb(
+    cups_dnssd_browse_t *browse,	// I - Browse request
+    _dnssd_service_t    *service,	// I - Printer service
+    cups_dnssd_flags_t  flags,		// I - Flags
+    uint32_t            if_index,	// I - Interface index
+    const char          *name,		// I - Service instance name
+    const char          *regtype,	// I - Service type
+    const char          *domain)	// I - Domain name
+{
+  (void)browse;
+  (void)regtype;
+
+  if (!(flags & CUPS_DNSSD_FLAGS_ADD) || strcmp(name, service->data->printer))
+    return;
+
+  cupsMutexLock(&service->data->mutex);
+
+  if (!service->found)
+  {
+    service->found    = true;
+    service->if_index = if_index;
+    cupsCopyString(service->domain, domain, sizeof(service->domain));
+
+    cupsCondBroadcast(&service->data->cond);
+  }
+
+  cupsMutexUnlock(&service->data->mutex);
+}
+
+
+//
+// 'dnssd_cache_browse_cb()' - Record a printer service that was found or
+//                             removed by the printer browser.
+//
+
+static void
+dnssd_cache_browse_cb(
+    cups_dnssd_browse_t *browse,	// I - Browse request
+    const char * const  *type,		// I - Service type in `dnssd_types`
+    cups_dnssd_flags_t  flags,		// I - Flags
+    uint32_t            if_index,	// I - Interface index
+    const char          *name,		// I - Service instance name
+    const char          *regtype,	// I - Service type
+    const char          *domain)	// I - Domain name
+{
+  _dnssd_cache_t	*cache;		// Cached printer
+  _dnssd_service_t	*service;	// Printer service
+  int			i;		// Looping var
+
+
+  (void)browse;
+  (void)regtype;
+
+  cupsMutexLock(&dnssd_cache_mutex);
+
+  if ((cache = dnssd_cache_find(name)) == NULL && (flags & CUPS_DNSSD_FLAGS_ADD))
+  {
+    // Add a new printer...
+    if (dnssd_cache_num_printers >= dnssd_cache_alloc_printers)
+    {
+      _dnssd_cache_t **printers;	// New cached printers
+
+      if ((printers = (_dnssd_cache_t **)realloc(dnssd_cache_printers, (dnssd_cache_alloc_printers + 16) * sizeof(_dnssd_cache_t *))) == NULL)
+      {
+        cupsMutexUnlock(&dnssd_cache_mutex);
+        return;
+      }
+
+      dnssd_cache_printers       = printers;
+      dnssd_cache_alloc_printers += 16;
+    }
+
+    if ((cache = (_dnssd_cache_t *)calloc(1, sizeof(_dnssd_cache_t))) == NULL)
+    {
+      cupsMutexUnlock(&dnssd_cache_mutex);
+      return;
+    }
+
+    cupsCopyString(cache->name, name, sizeof(cache->name));
+    cache->first = cupsGetClock();
+
+    for (i = 0; i < _DNSSD_TYPE_MAX; i ++)
+    {
+      cache->services[i].cache = cache;
+      cache->services[i].type  = (_dnssd_type_t)i;
+    }
+
+    dnssd_cache_printers[dnssd_cache_num_printers ++] = cache;
+  }
+
+  if (cache)
+  {
+    service = cache->services + (type - dnssd_types);
+
+    if ((flags & CUPS_DNSSD_FLAGS_ADD) && !service->found)
+    {
+      service->found    = true;
+      service->if_index = if_index;
+      cupsCopyString(service->domain, domain, sizeof(service->domain));
+    }
+    else if (!(flags & CUPS_DNSSD_FLAGS_ADD) && service->found)
+    {
+      service->found = false;
+    }
+
+    cache->changed      = true;
+    dnssd_cache_pending = true;
+
+    cupsCondBroadcast(&dnssd_cache_cond);
+  }
+
+  cupsMutexUnlock(&dnssd_cache_mutex);
+}
+
+
+//
+// 'dnssd_cache_find()' - Find a printer in the printer browser's cache.
+//
+// The caller must hold the `dnssd_cache_mutex`.
+//
+
+static _dnssd_cache_t *			// O - Cached printer or `NULL` if not found
+dnssd_cache_find(const char *printer)	// I - Printer service instance name
+{
+  size_t	i;			// Looping var
+
+
+  for (i = 0; i < dnssd_cache_num_printers; i ++)
+  {
+    if (!strcmp(dnssd_cache_printers[i]->name, printer))
+      return (dnssd_cache_printers[i]);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'dnssd_cache_get()' - Copy the services of a printer from the printer
+//                       browser's cache.
+//
+// The services are only copied once the IPP service and, if found, the IPPS
+// service are resolved, and either all of the service types have been found
+// or the printer was found longer ago than the browse timeout.  The copied TXT
+// key/value pairs must be freed with `cupsFreeOptions`.
+//
+
+static bool				// O - `true` if copied, `false` otherwise
+dnssd_cache_get(
+    const char       *printer,		// I - Printer service instance name
+    _dnssd_service_t *services)		// I - Printer services
+{
+  _dnssd_cache_t	*cache;		// Cached printer
+  _dnssd_service_t	*service;	// Cached printer service
+  int			i;		// Looping var
+  size_t		j;		// Looping var
+  bool			ret = false;	// Return value
+
+
+  cupsMutexLock(&dnssd_cache_mutex);
+
+  if ((cache = dnssd_cache_find(printer)) != NULL && cache->services[_DNSSD_TYPE_IPP].resolved && (!cache->services[_DNSSD_TYPE_IPPS].found || cache->services[_DNSSD_TYPE_IPPS].resolved))
+  {
+    for (i = 0; i < _DNSSD_TYPE_MAX; i ++)
+    {
+      if (!cache->services[i].found)
+        break;
+    }
+
+    if (i >= _DNSSD_TYPE_MAX || (cupsGetClock() - cache->first) >= DNSSD_TIMEOUT)
+    {
+      for (i = 0, service = cache->services; i < _DNSSD_TYPE_MAX; i ++, service ++)
+      {
+	services[i].found    = service->found;
+	services[i].resolved = service->resolved;
+	services[i].if_index = service->if_index;
+	services[i].port     = service->port;
+
+	cupsCopyString(services[i].domain, service->domain, sizeof(services[i].domain));
+	cupsCopyString(services[i].host, service->host, sizeof(services[i].host));
+	cupsCopyString(services[i].uri, service->uri, sizeof(services[i].uri));
+	cupsCopyString(services[i].resource, service->resource, sizeof(services[i].resource));
+
+	for (j = 0; j < service->num_txt; j ++)
+	  services[i].num_txt = cupsAddOption(service->txt[j].name, service->txt[j].value, services[i].num_txt, &services[i].txt);
+      }
+
+      ret = true;
+    }
+  }
+
+  cupsMutexUnlock(&dnssd_cache_mutex);
+
+  return (ret);
+}
+
+
+//
+// 'dnssd_cache_resolve_cb()' - Record the resolved host, port, and TXT record
+//                              in the printer browser's cache.
+//
+// Unlike dnssd_resolve_cb(), later changes to the TXT record replace the
+// cached values.
+//
+
+static void
+dnssd_cache_resolve_cb(
+    cups_dnssd_resolve_t *res,		// I - Resolve request
+    _dnssd_service_t     *service,	// I - Printer service
+    cups_dnssd_flags_t   flags,		// I - Flags
+    uint32_t             if_index,	// I - Interface index
+    const char           *fullname,	// I - Full service name
+    const char           *host,		// I - Hostname
+    uint16_t             port,		// I - Port number
+    size_t               num_txt,	// I - Number of TXT key/value pairs
+    cups_option_t        *txt)		// I - TXT key/value pairs
+{
+  size_t	i;			// Looping var
+  const char	*rp;			// "rp" value
+
+
+  (void)res;
+  (void)if_index;
+  (void)fullname;
+
+  if (flags & CUPS_DNSSD_FLAGS_ERROR)
+    return;
+
+  cupsMutexLock(&dnssd_cache_mutex);
+
+  cupsFreeOptions(service->num_txt, service->txt);
+
+  service->resolved = true;
+  service->port     = port;
+  service->num_txt  = 0;
+  service->txt      = NULL;
+  cupsCopyString(service->host, host, sizeof(service->host));
+
+  for (i = 0; i < num_txt; i ++)
+    service->num_txt = cupsAddOption(txt[i].name, txt[i].value, service->num_txt, &service->txt);
+
+  if ((rp = cupsGetOption("rp", service->num_txt, service->txt)) != NULL)
+    snprintf(service->resource, sizeof(service->resource), "/%s", rp);
+  else
+    cupsCopyString(service->resource, "/", sizeof(service->resource));
+
+  httpAssembleURI(HTTP_URI_CODING_ALL, service->uri, sizeof(service->uri), service->type == _DNSSD_TYPE_IPPS ? "ipps" : "ipp", NULL, host, port, service->resource);
+
+  service->cache->changed = true;
+  dnssd_cache_pending     = true;
+
+  cupsCondBroadcast(&dnssd_cache_cond);
+  cupsMutexUnlock(&dnssd_cache_mutex);
+}
+
+
+//
+// 'dnssd_cache_run()' - Resolve and report the printers found by the printer
+//                       browser.
+//
+// The IPP and IPPS services are resolved and the callback is called from this
+// thread rather than the DNS-SD callbacks, since libcups does not allow new
+// DNS-SD requests from its callbacks.  The mutex is released while calling
+// libcups and the callback, and only this thread removes printers from the
+// cache, so the cached printers stay valid.
+//
+
+static void *				// O - Thread exit status
+dnssd_cache_run(void *data)		// I - Unused
+{
+  size_t		i;		// Looping var
+  int			type;		// Service type
+  _dnssd_cache_t	*cache;		// Cached printer
+  _dnssd_service_t	*service;	// Printer service
+  cups_dnssd_resolve_t	*res;		// Resolve request
+  uint32_t		if_index;	// Interface index
+  char			name[256],	// Service instance name
+			domain[256];	// Domain name
+  dnssd_event_t		event;		// Printer event
+  bool			report,		// Report the printer?
+			retry;		// Retry a resolve later?
+
+
+  (void)data;
+
+  cupsMutexLock(&dnssd_cache_mutex);
+
+  while (!dnssd_cache_stop)
+  {
+    dnssd_cache_pending = false;
+    retry               = false;
+
+    for (i = 0; i < dnssd_cache_num_printers && !dnssd_cache_stop;)
+    {
+      cache = dnssd_cache_printers[i];
+
+      // Start or stop resolving the IPP and IPPS services as they come and
+      // go...
+      for (type = _DNSSD_TYPE_IPP; type <= _DNSSD_TYPE_IPPS; type ++)
+      {
+        service = cache->services + type;
+
+        if (service->found && !cache->resolves[type])
+        {
+          if_index = service->if_index;
+          cupsCopyString(domain, service->domain, sizeof(domain));
+
+          cupsMutexUnlock(&dnssd_cache_mutex);
+          res = cupsDNSSDResolveNew(dnssd_cache_dnssd, if_index, cache->name, dnssd_types[type], domain, (cups_dnssd_resolve_cb_t)dnssd_cache_resolve_cb, service);
+          cupsMutexLock(&dnssd_cache_mutex);
+
+          if (res)
+            cache->resolves[type] = res;
+          else
+            retry = true;
+        }
+        else if (!service->found && cache->resolves[type])
+        {
+          res                   = cache->resolves[type];
+          cache->resolves[type] = NULL;
+
+          cupsMutexUnlock(&dnssd_cache_mutex);
+          cupsDNSSDResolveDelete(res);
+          cupsMutexLock(&dnssd_cache_mutex);
+
+          cupsFreeOptions(service->num_txt, service->txt);
+
+          service->resolved = false;
+          service->num_txt  = 0;
+          service->txt      = NULL;
+        }
+      }
+
+      // Then remove printers that are gone and report changes...
+      for (type = 0; type < _DNSSD_TYPE_MAX; type ++)
+      {
+        if (cache->services[type].found || (type <= _DNSSD_TYPE_IPPS && cache->resolves[type]))
+          break;
+      }
+
+      cupsCopyString(name, cache->name, sizeof(name));
+
+      if (type >= _DNSSD_TYPE_MAX)
+      {
+        event  = DNSSD_EVENT_REMOVE;
+        report = cache->added;
+
+        free(cache);
+
+        dnssd_cache_num_printers --;
+        if (i < dnssd_cache_num_printers)
+          memmove(dnssd_cache_printers + i, dnssd_cache_printers + i + 1, (dnssd_cache_num_printers - i) * sizeof(_dnssd_cache_t *));
+      }
+      else
+      {
+        event          = cache->added ? DNSSD_EVENT_UPDATE : DNSSD_EVENT_ADD;
+        report         = cache->changed;
+        cache->added   = true;
+        cache->changed = false;
+
+        i ++;
+      }
+
+      if (report && dnssd_cache_cb)
+      {
+        cupsMutexUnlock(&dnssd_cache_mutex);
+        (dnssd_cache_cb)(dnssd_cache_cb_data, event, name);
+        cupsMutexLock(&dnssd_cache_mutex);
+      }
+    }
+
+    // Wait for more changes, retrying failed resolves every second...
+    while (!dnssd_cache_pending && !dnssd_cache_stop)
+    {
+      cupsCondWait(&dnssd_cache_cond, &dnssd_cache_mutex, retry ? 1.0 : -1.0);
+
+      if (retry)
+        break;
+    }
+  }
+
+  cupsMutexUnlock(&dnssd_cache_mutex);
+
+  return (NULL);
+}
+
+
+//
+// 'dnssd_check_keys()' - Check that the required TXT keys are present.
+//
+
+static bool				// O - `true` if present, `false` otherwise
+dnssd_check_keys(
+    _dnssd_t         *data,		// I - DNS-SD test data
+    _dnssd_service_t *service,		// I - Printer service
+    bool             report)		// I - Report missing keys?
+{
+  size_t	i;			// Looping var
+  bool		ret = true;		// Return value
+  static const char * const keys[] =	// Required keys
+  {
+    "adminurl",
+    "pdl",
+    "rp",
+    "UUID",
+    "TLS"
+  };
+
+
+  for (i = 0; i < (sizeof(keys) / sizeof(keys[0])); i ++)
+  {
+    // "TLS" is only required for IPPS...
+    if (i == 4 && service->type != _DNSSD_TYPE_IPPS)
+      break;
+
+    if (!cupsGetOption(keys[i], service->num_txt, service->txt))
+    {
+      ret = false;
+
+      if (report)
+        dnssd_error(data, "%s is not set.", keys[i]);
+    }
+  }
+
+  return (ret);
+}
+
+
+//
+// 'dnssd_check_values()' - Check the TXT values against the printer attributes.
+//
+
+static bool				// O - `true` if valid, `false` otherwise
+dnssd_check_values(
+    _dnssd_t         *data,		// I - DNS-SD test data
+    _dnssd_service_t *service,		// I - Printer service
+    bool             color,		// I - Color printer?
+    bool             report)		// I - Report errors?
+{
+  const char	*adminurl,		// "adminurl" value
+		*pdl,			// "pdl" value
+		*rp,			// "rp" value
+		*uuid;			// "UUID" value
+  char		urn[256];		// printer-uuid value
+  bool		ret;			// Return value
+
+
+  adminurl = cupsGetOption("adminurl", service->num_txt, service->txt);
+  pdl      = cupsGetOption("pdl", service->num_txt, service->txt);
+  rp       = cupsGetOption("rp", service->num_txt, service->txt);
+  uuid     = cupsGetOption("UUID", service->num_txt, service->txt);
+
+  snprintf(urn, sizeof(urn), "urn:uuid:%s", uuid ? uuid : "");
+
+  ret = adminurl && dnssd_is_adminurl(adminurl) && pdl && strstr(pdl, "image/pwg-raster") && (!color || strstr(pdl, "image/jpeg")) && uuid && dnssd_is_uuid(uuid) && service->response && dnssd_expect(data, service->response, "printer-more-info", adminurl, false) && dnssd_expect(data, service->response, "printer-uuid", urn, false);
+
+  if (ret || !report)
+    return (ret);
+
+  // Report all of the problems...
+  if (!adminurl)
+    dnssd_error(data, "adminurl is not set.");
+  else if (!dnssd_is_adminurl(adminurl))
+    dnssd_error(data, "adminurl has bad value '%s'.", adminurl);
+
+  if (!pdl)
+  {
+    dnssd_error(data, "pdl is not set.");
+  }
+  else
+  {
+    if (color && !strstr(pdl, "image/jpeg"))
+      dnssd_error(data, "pdl is missing image/jpeg: '%s'.", pdl);
+    if (!strstr(pdl, "image/pwg-raster"))
+      dnssd_error(data, "pdl is missing image/pwg-raster: '%s'.", pdl);
+  }
+
+  if (!rp)
+    dnssd_error(data, "rp is not set.");
+  else if (strcmp(rp, "ipp/print") && strncmp(rp, "ipp/print/", 10))
+    dnssd_error(data, "rp has bad value '%s'.", rp);
+
+  if (!uuid)
+    dnssd_error(data, "UUID is not set.");
+  else if (!dnssd_is_uuid(uuid))
+    dnssd_error(data, "UUID has bad value '%s'.", uuid);
+
+  if (!service->response)
+  {
+    dnssd_error(data, "%s", service->resolved ? service->error : "Unable to resolve service.");
+  }
+  else
+  {
+    dnssd_expect(data, service->response, "printer-more-info", adminurl, true);
+    dnssd_expect(data, service->response, "printer-uuid", urn, true);
+  }
+
+  return (false);
+}
+
+
+//
+// 'dnssd_end_test()' - Finish the current test.
+//
+
+static bool				// O - `true` to continue, `false` to cancel
+dnssd_end_test(_dnssd_t   *data,	// I - DNS-SD test data
+               const char *status)	// I - "PASS", "FAIL", or "SKIP"
+{
+  plist_t	*error;			// Current error
+  char		message[2048];		// Error message
+
+
+  plist_add(data->test, PLIST_TYPE_KEY, "Successful");
+  plist_add(data->test, strcmp(status, "FAIL") ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL);
+
+  if (!strcmp(status, "SKIP"))
+  {
+    plist_add(data->test, PLIST_TYPE_KEY, "Skipped");
+    plist_add(data->test, PLIST_TYPE_TRUE, NULL);
+  }
+  else if (!strcmp(status, "FAIL"))
+  {
+    data->num_failed ++;
+  }
+
+  cupsCopyString(data->current.status, status, sizeof(data->current.status));
+  data->current.end = runner_get_time();
+
+  if (data->cb && !(data->cb)(data->cb_data, RUNNER_EVENT_TEST_END, &data->current, NULL))
+    data->canceled = true;
+
+  // Show any errors after the test, like ipptool does...
+  for (error = data->errors ? data->errors->first_child : NULL; error && !data->canceled; error = error->next_sibling)
+  {
+    snprintf(message, sizeof(message), "        %s", error->value);
+
+    if (data->cb && !(data->cb)(data->cb_data, RUNNER_EVENT_MESSAGE, NULL, message))
+      data->canceled = true;
+  }
+
+  return (!data->canceled);
+}
+
+
+//
+// 'dnssd_error()' - Add an error message to the current test.
+//
+// The errors are shown when the test is finished.
+//
+
+static void
+dnssd_error(_dnssd_t   *data,		// I - DNS-SD test data
+            const char *message,	// I - Printf-style message
+            ...)			// I - Additional arguments
+{
+  va_list	ap;			// Pointer to arguments
+  char		buffer[2048];		// Message buffer
+
+
+  va_start(ap, message);
+  vsnprintf(buffer, sizeof(buffer), message, ap);
+  va_end(ap);
+
+  if (!data->errors)
+  {
+    plist_add(data->test, PLIST_TYPE_KEY, "Errors");
+    data->errors = plist_add(data->test, PLIST_TYPE_ARRAY, NULL);
+  }
+
+  plist_add(data->errors, PLIST_TYPE_STRING, buffer);
+}
+
+
+//
+// 'dnssd_error_cb()' - Record a DNS-SD or plist error.
+//
+
+static void
+dnssd_error_cb(_dnssd_t   *data,	// I - DNS-SD test data
+               const char *message)	// I - Error message
+{
+  cupsMutexLock(&data->mutex);
+  cupsCopyString(data->error, message, sizeof(data->error));
+  cupsMutexUnlock(&data->mutex);
+}
+
+
+//
+// 'dnssd_expect()' - Compare a printer attribute with a TXT value.
+//
+// Like the ipptool EXPECT directive, the attribute must be a single "uri"
+// value in the printer group that matches the TXT value.
+//
+
+static bool				// O - `true` if it matches, `false` otherwise
+dnssd_expect(_dnssd_t   *data,		// I - DNS-SD test data
+             ipp_t      *response,	// I - Get-Printer-Attributes response
+             const char *name,		// I - Attribute name
+             const char *value,		// I - Expected value
+             bool       report)		// I - Report mismatches?
+{
+  ipp_attribute_t *attr;		// Attribute
+  const char	*avalue;		// Attribute value
+
+
+  if ((attr = ippFindAttribute(response, name, IPP_TAG_ZERO)) == NULL)
+  {
+    if (report)
+      dnssd_error(data, "EXPECTED: %s", name);
+
+    return (false);
+  }
+
+  if (ippGetValueTag(attr) != IPP_TAG_URI || ippGetGroupTag(attr) != IPP_TAG_PRINTER || ippGetCount(attr) != 1 || (avalue = ippGetString(attr, 0, NULL)) == NULL || !value || strcmp(avalue, value))
+  {
+    if (report)
+    {
+      char	temp[1024];		// Attribute value(s)
+
+      ippAttributeString(attr, temp, sizeof(temp));
+
+      dnssd_error(data, "EXPECTED: %s OF-TYPE uri IN-GROUP printer-attributes-tag COUNT 1 WITH-VALUE \"%s\"", name, value ? value : "");
+      dnssd_error(data, "GOT: %s (%s) %s=%s", name, ippTagString(ippGetValueTag(attr)), ippTagString(ippGetGroupTag(attr)), temp);
+    }
+
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'dnssd_get_attributes()' - Send a Get-Printer-Attributes request.
+//
+
+static ipp_t *				// O - Response or `NULL` on error
+dnssd_get_attributes(
+    _dnssd_service_t *service,		// I - Printer service
+    http_t           *http)		// I - Connection to printer
+{
+  ipp_t		*request,		// Get-Printer-Attributes request
+		*response;		// Response
+  static const char * const pattrs[] =	// Requested attributes
+  {
+    "printer-more-info",
+    "printer-state",
+    "printer-uuid"
+  };
+
+
+  request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, service->uri);
+  ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(pattrs) / sizeof(pattrs[0]), NULL, pattrs);
+
+  response = cupsDoRequest(http, request, service->resource);
+
+  if (cupsGetError() != IPP_STATUS_OK)
+  {
+    snprintf(service->error, sizeof(service->error), "%s: %s", service->uri, cupsGetErrorString());
+    ippDelete(response);
+    response = NULL;
+  }
+
+  return (response);
+}
+
+
+//
+// 'dnssd_is_adminurl()' - Check an "adminurl" TXT value.
+//
+
+static bool				// O - `true` if "http:" or "https:" URL
+dnssd_is_adminurl(const char *value)	// I - TXT value
+{
+  return (!strncmp(value, "http://", 7) || !strncmp(value, "https://", 8));
+}
+
+
+//
+// 'dnssd_is_tls()' - Check a "TLS" TXT value.
+//
+
+static bool				// O - `true` if a TLS version of 1.0 or later
+dnssd_is_tls(const char *value)		// I - TXT value
+{
+  return (value[0] >= '1' && value[0] <= '9' && value[1] == '.' && isdigit(value[2] & 255));
+}
+
+
+//
+// 'dnssd_is_uuid()' - Check a "UUID" TXT value.
+//
+
+static bool				// O - `true` if "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx"
+dnssd_is_uuid(const char *value)	// I - TXT value
+{
+  int	i;				// Looping var
+
+
+  for (i = 0; i < 36; i ++)
+  {
+    if (i == 8 || i == 13 || i == 18 || i == 23)
+    {
+      if (value[i] != '-')
+        return (false);
+    }
+    else if (!isxdigit(value[i] & 255))
+    {
+      return (false);
+    }
+  }
+
+  return (value[i] == '\0');
+}
+
+
+//
+// 'dnssd_resolve()' - Resolve the "_ipp._tcp" or "_ipps._tcp" service for a
+//                     printer.
+//
+// The service is resolved in the "local." domain without browsing first.
+//
+
+static bool				// O - `true` on success, `false` if not found
+dnssd_resolve(
+    const char    *printer,		// I - Printer service instance name
+    _dnssd_type_t type,			// I - Service type
+    char          *host,		// I - Hostname buffer or `NULL`
+    size_t        hostsize,		// I - Size of hostname buffer
+    int           *port,		// O - Port number or `NULL`
+    char          *uri,			// I - URI buffer or `NULL`
+    size_t        urisize,		// I - Size of URI buffer
+    size_t        *num_txt,		// O - Number of TXT key/value pairs or `NULL`
+    cups_option_t **txt)		// O - TXT key/value pairs or `NULL`
+{
+  _dnssd_t	data;			// DNS-SD data
+  cups_dnssd_t	*dnssd;			// DNS-SD session
+  _dnssd_service_t *ipp;		// IPP or IPPS service
+  int		i;			// Looping var
+  bool		ret = false;		// Return value
+
+
+  if (!printer)
+    return (false);
+
+  if (host)
+    *host = '\0';
+  if (port)
+    *port = 0;
+  if (uri)
+    *uri = '\0';
+  if (num_txt)
+    *num_txt = 0;
+  if (txt)
+    *txt = NULL;
+
+  memset(&data, 0, sizeof(data));
+
+  data.printer = printer;
+
+  cupsMutexInit(&data.mutex);
+  cupsCondInit(&data.cond);
+
+  ipp = data.services + type;
+
+  if (!dnssd_cache_get(printer, data.services) || !ipp->resolved)
+  {
+    // Not in the printer browser's cache, resolve it...
+    for (i = 0; i < _DNSSD_TYPE_MAX; i ++)
+      cupsFreeOptions(data.services[i].num_txt, data.services[i].txt);
+
+    memset(data.services, 0, sizeof(data.services));
+
+    ipp->data  = &data;
+    ipp->type  = type;
+    ipp->found = true;
+  }
+
+  if (!ipp->resolved && (dnssd = cupsDNSSDNew((cups_dnssd_error_cb_t)dnssd_error_cb, &data)) != NULL)
+  {
+    if (cupsDNSSDResolveNew(dnssd, CUPS_DNSSD_IF_INDEX_ANY, printer, dnssd_types[type], "local.", (cups_dnssd_resolve_cb_t)dnssd_resolve_cb, ipp))
+      dnssd_wait(&data, true);
+
+    cupsDNSSDDelete(dnssd);
+  }
+
+  if (ipp->resolved)
+  {
+    if (host)
+      cupsCopyString(host, ipp->host, hostsize);
+    if (port)
+      *port = ipp->port;
+    if (uri)
+      cupsCopyString(uri, ipp->uri, urisize);
+
+    if (num_txt && txt)
+    {
+      // Return the TXT record to the caller...
+      *num_txt     = ipp->num_txt;
+      *txt         = ipp->txt;
+      ipp->num_txt = 0;
+      ipp->txt     = NULL;
+    }
+
+    ret = true;
+  }
+
+  for (i = 0; i < _DNSSD_TYPE_MAX; i ++)
+    cupsFreeOptions(data.services[i].num_txt, data.services[i].txt);
+
+  cupsCondDestroy(&data.cond);
+  cupsMutexDestroy(&data.mutex);
+
+  return (ret);
+}
+
+
+//
+// 'dnssd_resolve_cb()' - Record the resolved host, port, and TXT record.
+//
+
+static void
+dnssd_resolve_cb(
+    cups_dnssd_resolve_t *res,		// I - Resolve request
+    _dnssd_service_t     *service,	// I - Printer service
+    cups_dnssd_flags_t   flags,		// I - Flags
+    uint32_t             if_index,	// I - Interface index
+    const char           *fullname,	// I - Full service name
+    const char           *host,		// I - Hostname
+    uint16_t             port,		// I - Port number
+    size_t               num_txt,	// I - Number of TXT key/value pairs
+    cups_option_t        *txt)		// I - TXT key/value pairs
+{
+  size_t	i;			// Looping var
+  const char	*rp;			// "rp" value
+
+
+  (void)res;
+  (void)if_index;
+  (void)fullname;
+
+  cupsMutexLock(&service->data->mutex);
+
+  if (!service->resolved && !(flags & CUPS_DNSSD_FLAGS_ERROR))
+  {
+    service->resolved = true;
+    service->port     = port;
+    cupsCopyString(service->host, host, sizeof(service->host));
+
+    for (i = 0; i < num_txt; i ++)
+      service->num_txt = cupsAddOption(txt[i].name, txt[i].value, service->num_txt, &service->txt);
+
+    if ((rp = cupsGetOption("rp", service->num_txt, service->txt)) != NULL)
+      snprintf(service->resource, sizeof(service->resource), "/%s", rp);
+    else
+      cupsCopyString(service->resource, "/", sizeof(service->resource));
+
+    httpAssembleURI(HTTP_URI_CODING_ALL, service->uri, sizeof(service->uri), service->type == _DNSSD_TYPE_IPPS ? "ipps" : "ipp", NULL, host, port, service->resource);
+  }
+
+  cupsCondBroadcast(&service->data->cond);
+  cupsMutexUnlock(&service->data->mutex);
+}
+
+
+//
+// 'dnssd_start_test()' - Start a test.
+//
+
+static bool				// O - `true` to continue, `false` to cancel
+dnssd_start_test(_dnssd_t   *data,	// I - DNS-SD test data
+                 const char *name)	// I - Test name
+{
+  data->test   = plist_add(data->tests, PLIST_TYPE_DICT, NULL);
+  data->errors = NULL;
+
+  plist_add(data->test, PLIST_TYPE_KEY, "Name");
+  plist_add(data->test, PLIST_TYPE_STRING, name);
+  plist_add(data->test, PLIST_TYPE_KEY, "FileId");
+  plist_add(data->test, PLIST_TYPE_STRING, DNSSD_FILEID);
+
+  memset(&data->current, 0, sizeof(data->current));
+  cupsCopyString(data->current.name, name, sizeof(data->current.name));
+  data->current.start = runner_get_time();
+
+  if (data->cb && !(data->cb)(data->cb_data, RUNNER_EVENT_TEST_START, &data->current, NULL))
+    data->canceled = true;
+
+  return (!data->canceled);
+}
+
+
+//
+// 'dnssd_tests()' - Run the tests against the snapshot of the services.
+//
+
+static bool				// O - `true` if the tests ran, `false` if canceled
+dnssd_tests(_dnssd_t *data,		// I - DNS-SD test data
+            bool     color,		// I - Color printer?
+            bool     tls)		// I - TLS supported?
+{
+  _dnssd_service_t *ipp = data->services + _DNSSD_TYPE_IPP,
+					// IPP service
+		*ipps = data->services + _DNSSD_TYPE_IPPS;
+					// IPPS service
+  http_t	*http;			// Connection for upgrade
+  ipp_t		*response = NULL;	// Response after upgrade
+
+
+  // B-1. IPP Browse test: Printers appear in a search for "_ipp._tcp,_print"
+  // services?
+  if (!dnssd_start_test(data, "B-1. IPP Browse test") || !dnssd_end_test(data, data->services[_DNSSD_TYPE_IPP_PRINT].found ? "PASS" : "FAIL"))
+    return (false);
+
+  // B-2. IPP TXT keys test: The IPP TXT record contains all required keys.
+  if (!dnssd_start_test(data, "B-2. IPP TXT keys test") || !dnssd_end_test(data, dnssd_check_keys(data, ipp, true) ? "PASS" : "FAIL"))
+    return (false);
+
+  // B-3. IPP Resolve test: Printer responds to an IPP Get-Printer-Attributes
+  // request using the resolved hostname, port, and resource path.
+  if (!dnssd_start_test(data, "B-3. IPP Resolve test"))
+    return (false);
+
+  if (!ipp->response)
+    dnssd_error(data, "%s", ipp->resolved ? ipp->error : "Unable to resolve IPP service.");
+
+  if (!dnssd_end_test(data, ipp->response ? "PASS" : "FAIL"))
+    return (false);
+
+  // B-4. IPP TXT values test: The IPP TXT record values match the reported
+  // IPP attribute values.
+  if (!dnssd_start_test(data, "B-4. IPP TXT values test") || !dnssd_end_test(data, dnssd_check_values(data, ipp, color, true) ? "PASS" : "FAIL"))
+    return (false);
+
+  // B-5. TLS tests: Performed only if TLS is supported
+  if (!dnssd_start_test(data, "B-5. TLS tests") || !dnssd_end_test(data, tls ? "PASS" : "SKIP"))
+    return (false);
+
+  // B-5.1 HTTP Upgrade test: Printer responds to an IPP Get-Printer-Attributes
+  // request after doing an HTTP Upgrade to TLS on the same connection.
+  if (!dnssd_start_test(data, "B-5.1 HTTP Upgrade test"))
+    return (false);
+
+  if (tls)
+  {
+    // Use a new connection rather than a pooled one, which might already be
+    // encrypted...
+    if (!ipp->resolved)
+    {
+      dnssd_error(data, "Unable to resolve IPP service.");
+    }
+    else if ((http = httpConnect(ipp->host, ipp->port, NULL, AF_UNSPEC, HTTP_ENCRYPTION_IF_REQUESTED, true, 30000, NULL)) == NULL)
+    {
+      dnssd_error(data, "%s: %s", ipp->uri, cupsGetErrorString());
+    }
+    else
+    {
+      if (!httpSetEncryption(http, HTTP_ENCRYPTION_REQUIRED))
+        dnssd_error(data, "%s: %s", ipp->uri, cupsGetErrorString());
+      else if ((response = dnssd_get_attributes(ipp, http)) == NULL)
+        dnssd_error(data, "%s", ipp->error);
+
+      httpClose(http);
+    }
+  }
+
+  ippDelete(response);
+
+  if (!dnssd_end_test(data, !tls ? "SKIP" : response ? "PASS" : "FAIL"))
+    return (false);
+
+  // B-5.2 IPPS Browse test: Printer appears in a search for "_ipps._tcp,_print"
+  // services.
+  if (!dnssd_start_test(data, "B-5.2 IPPS Browse test") || !dnssd_end_test(data, !tls ? "SKIP" : data->services[_DNSSD_TYPE_IPPS_PRINT].found ? "PASS" : "FAIL"))
+    return (false);
+
+  // B-5.3 IPPS TXT keys test: The TXT record for IPPS contains all required
+  // keys
+  if (!dnssd_start_test(data, "B-5.3 IPPS TXT keys test") || !dnssd_end_test(data, !tls ? "SKIP" : dnssd_check_keys(data, ipps, true) ? "PASS" : "FAIL"))
+    return (false);
+
+  // B-5.4 IPPS Resolve test: Printer responds to an IPPS Get-Printer-Attributes
+  // request using the resolved hostname, port, and resource path.
+  if (!dnssd_start_test(data, "B-5.4 IPPS Resolve test"))
+    return (false);
+
+  if (tls && !ipps->response)
+    dnssd_error(data, "%s", ipps->resolved ? ipps->error : "Unable to resolve IPPS service.");
+
+  if (!dnssd_end_test(data, !tls ? "SKIP" : ipps->response ? "PASS" : "FAIL"))
+    return (false);
+
+  // B-5.5 IPPS TXT values test: The TXT record values for IPPS match the
+  // reported IPPS attribute values.
+  if (!dnssd_start_test(data, "B-5.5 IPPS TXT values test") || !dnssd_end_test(data, !tls ? "SKIP" : dnssd_check_values(data, ipps, color, true) ? "PASS" : "FAIL"))
+    return (false);
+
+  return (true);
+}
+
+
+//
+// 'dnssd_wait()' - Wait for the printer services to be found or resolved.
+//
+
+static void
+dnssd_wait(_dnssd_t *data,		// I - DNS-SD test data
+           bool     resolve)		// I - Wait for resolve (`true`) or browse (`false`)?
+{
+  int		i;			// Looping var
+  double	now,			// Current time
+		end;			// End time
+
+
+  end = cupsGetClock() + DNSSD_TIMEOUT;
+
+  cupsMutexLock(&data->mutex);
+
+  while ((now = cupsGetClock()) < end)
+  {
+    for (i = 0; i < _DNSSD_TYPE_MAX; i ++)
+    {
+      if (resolve && i <= _DNSSD_TYPE_IPPS && data->services[i].found && !data->services[i].resolved)
+        break;
+      else if (!resolve && !data->services[i].found)
+        break;
+    }
+
+    if (i >= _DNSSD_TYPE_MAX)
+      break;
+
+    cupsCondWait(&data->cond, &data->mutex, end - now);
+  }
+
+  cupsMutexUnlock(&data->mutex);
+}
@@ -0,0 +1,1365 @@
+//
+// Selfcert test runner tool for the IPP Everywhere Printer Self-Certification
+// application.
+//
+// Copyright © 2024 by the IEEE-ISTO Printer Working Group.
+//
+// Licensed under Apache License v2.0.	See the file "LICENSE" for more
+// information.
+//
+// Usage:
+//
+//   ippeverun [options] "Printer Name" [{dnssd|ipp|document} ...]
+//   ippeverun [options] -f printers.txt [{dnssd|ipp|document} ...]
+//
+// Options:
+//
+//    --duration SECONDS       Run the stress test for SECONDS (default 60).
+//    --failed                 Re-run the tests that failed in the previous
+//                             results.
+//    --help                   Show help.
+//    --host-limit N           Test at most N printers on the same host at once
+//                             (default 1).
+//    --json                   Show the progress as JSON events, one per line.
+//    --resume                 Resume interrupted tests from their checkpoint.
+//    --retries N              Retry a printer N times when its tests cannot
+//                             be run (default 2).
+//    --sequential             Run the test suites one at a time.
+//    --stress N               Run the stress test with N concurrent clients
+//                             instead of the test suites.
+//    -f printers.txt          Test each printer listed in the file.
+//    -j N                     Test at most N printers at once (default 4).
+//    -n "Name"                Name the results files, otherwise the service
+//                             instance name or URI hostname is used.
+//    -o DIRECTORY             Write the results for each printer listed with
+//                             "-f" to a subdirectory of DIRECTORY (default
+//                             is the current directory).
+//
+// The printer can be a DNS-SD service instance name or an "ipp" or "ipps" URI.
+// The DNS-SD tests require a service instance name.  All three test suites are
+// run when none are specified.  Multiple test suites run concurrently, with
+// the IPP tests that create jobs waiting for the Document tests so that only
+// one suite prints at a time, unless "--sequential" is specified.
+//
+// The IPP and Document tests write a checkpoint after each test.  With
+// "--resume", tests that completed before a run was interrupted are not run
+// again and their results are restored from the checkpoint.  With "--failed",
+// only the tests that failed in the previous results files are run again along
+// with the tests they depend on, and the results of the other tests are kept.
+// The DNS-SD tests are always run in full.
+//
+// The requests that ippeverun sends itself for the DNS-SD tests, job
+// notifications, and stress test share keep-alive connections to each printer
+// for the whole run, and the number of times they were reused is shown at the
+// end.  ipptool keeps its own connection for each test file, which is not
+// pooled or included in these numbers.
+//
+// With "--stress", N clients repeat the Get-Printer-Attributes, Validate-Job,
+// Print-Job, Get-Jobs, and Cancel-Job operations for the duration.  The
+// throughput, latency percentiles, and rate of "server-error-busy" responses
+// are shown for each operation and written to "Name Stress Results.plist",
+// which can be replayed with "ippevesubmit -r stress".
+//
+// With "--json", the progress is written to the standard output as one JSON
+// object per line, so that front-ends can show each test as it happens without
+// parsing the text output.  The "event" member is one of "suite-start",
+// "test-start", "test-repeat", "test-end", "message", or "suite-end", and the
+// "suite" member is "dnssd", "ipp", or "document".  The test events have an
+// "index" member that numbers the tests in each suite from 1, since test names
+// are not unique.  The "test-end" events include the status, start and end
+// times, number of requests, and the errors reported for the test, and the
+// "suite-end" events include the number of tests that passed, failed, and were
+// skipped.  A "suite-end" event with a "complete" value of `false` is sent for
+// suites that could not finish.
+//
+// The "-f" file lists one printer per line.  Blank lines and lines starting
+// with "#" are ignored.  Each printer's results files and a log of its tests
+// go in a subdirectory named after the printer, and "Fleet Summary.plist"
+// records the outcome for each printer.  Retries resume from the checkpoint of
+// the previous attempt unless "--failed" is specified.
+//
+
+#include "selfcert.h"
+#include <cups/thread.h>
+#if _WIN32
+#  include <direct.h>
+#  define mkdir(d,m) _mkdir(d)
+#endif // _WIN32
+
+
+// Local constants...
+#define FARM_RETRY_DELAY	30.0	// Delay before retrying a printer in seconds
+
+
+// Local types...
+typedef enum _farm_state_e		// Printer state
+{
+  _FARM_STATE_WAITING,			// Waiting to be tested
+  _FARM_STATE_RESOLVING,		// Finding the host
+  _FARM_STATE_RUNNING,			// Being tested
+  _FARM_STATE_DONE			// Done
+} _farm_state_t;
+
+typedef struct _farm_s _farm_t;		// Printer farm
+
+typedef struct _farm_printer_s		// Farm printer
+{
+  _farm_t	*farm;			// Printer farm
+  char		printer[256],		// Printer name or URI
+		host[256],		// Printer host
+		name[256],		// Name for results files
+		directory[1024],	// Results directory
+		resultsname[1024];	// Directory and name for results files
+  _farm_state_t	state;			// Printer state
+  int		attempts;		// Number of attempts
+  double	not_before,		// Earliest time for the next attempt
+		start,			// Start time
+		end;			// End time
+  size_t	num_tests,		// Number of tests run
+		num_failed;		// Number of tests that failed
+  bool		ran;			// Did all of the tests run?
+  FILE		*log;			// Log file
+} _farm_printer_t;
+
+typedef struct _json_suite_s		// JSON progress for a test suite
+{
+  bool		started,		// Has the suite started?
+		ended,			// Has the suite ended?
+		pending;		// Is a test end waiting for its errors?
+  char		file[1024];		// Results file
+  double	start;			// Start time
+  size_t	num_tests,		// Number of tests started
+		num_passed,		// Number of tests that passed
+		num_failed,		// Number of tests that failed
+		num_skipped;		// Number of tests that were skipped
+  runner_test_t	test;			// Last test that ended
+  char		errors[16384];		// JSON-encoded errors for the last test
+} _json_suite_t;
+
+struct _farm_s				// Printer farm
+{
+  cups_mutex_t	mutex;			// Mutex for printers
+  cups_cond_t	cond;			// Condition for printer changes
+  size_t	num_printers,		// Number of printers
+		alloc_printers;		// Allocated printers
+  _farm_printer_t *printers;		// Printers
+  size_t	num_suites;		// Number of test suites
+  selfcert_suite_t suites[3];		// Test suites
+  int		host_limit,		// Maximum printers per host
+		retries;		// Maximum retries per printer
+  bool		sequential;		// Run the suites one at a time?
+  runner_mode_t	mode;			// Test runner mode
+  size_t	num_waiting,		// Number of printers waiting
+		num_running,		// Number of printers being tested
+		num_done,		// Number of printers done
+		num_passed,		// Number of printers that passed
+		num_tests,		// Number of tests run
+		num_failed;		// Number of tests that failed
+};
+
+
+// Local functions...
+static int	do_farm(const char *filename, const char *directory, int num_workers, int host_limit, int retries, bool sequential, runner_mode_t mode, size_t num_suites, const selfcert_suite_t *suites);
+static bool	event_cb(void *cb_data, runner_event_t event, const runner_test_t *test, const char *message);
+static _farm_printer_t *farm_add(_farm_t *farm, const char *printer, const char *directory);
+static bool	farm_cb(_farm_printer_t *printer, selfcert_suite_t suite, runner_event_t event, const runner_test_t *test, const char *message);
+static _farm_printer_t *farm_next(_farm_t *farm);
+static void	*farm_run(_farm_t *farm);
+static void	farm_status(_farm_t *farm, _farm_printer_t *printer, const char *message);
+static bool	farm_write_summary(_farm_t *farm, const char *directory);
+static bool	json_cb(_json_suite_t *json, selfcert_suite_t suite, runner_event_t event, const runner_test_t *test, const char *message);
+static void	json_finish(_json_suite_t *json);
+static void	json_test_end(_json_suite_t *json, selfcert_suite_t suite);
+static void	show_connections(void);
+static bool	suites_cb(void *cb_data, selfcert_suite_t suite, runner_event_t event, const runner_test_t *test, const char *message);
+static void	usage(void);
+
+
+// Local globals...
+static const char * const suite_ids[] =
+{					// Test suite command-line names
+  "dnssd",
+  "ipp",
+  "document"
+};
+static const char * const suite_names[] =
+{					// Test suite headings
+  "DNS-SD Tests",
+  "IPP Tests",
+  "Document Tests"
+};
+
+
+//
+// 'main()' - Main entry for test runner tool.
+//
+
+int					// O - Exit status
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  int		i;			// Looping var
+  const char	*printer = NULL,	// Printer being tested
+		*name = NULL,		// Name for results files
+		*farm = NULL,		// Printer list file
+		*directory = ".";	// Output directory for printer list
+  char		host[256],		// Hostname from URI
+		*hostptr;		// Pointer into hostname
+  selfcert_suite_t suites[3];		// Test suites to run
+  size_t	s,			// Current suite
+		count,			// Number of suites to keep
+		num_suites = 0;		// Number of test suites
+  runner_t	*runner;		// Test runner
+  bool		ok = true,		// Did all of the suites run?
+		sequential = false,	// Run the suites one at a time?
+		json = false;		// Show the progress as JSON events?
+  _json_suite_t	json_suites[3];		// JSON progress for each suite
+  runner_mode_t	mode = RUNNER_MODE_ALL;	// Test runner mode
+  int		num_workers = 4,	// Number of printers to test at once
+		host_limit = 1,		// Number of printers per host
+		retries = 2,		// Number of retries per printer
+		stress = 0,		// Number of stress test clients
+		duration = 60;		// Duration of stress test in seconds
+  char		filename[1024];		// Stress test results filename
+
+
+  // Parse command-line...
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--failed"))
+    {
+      mode = RUNNER_MODE_FAILED;
+    }
+    else if (!strcmp(argv[i], "--duration"))
+    {
+      i ++;
+      if (i >= argc || (duration = atoi(argv[i])) < 1)
+      {
+        puts("ippeverun: Expected number of seconds after '--duration'.");
+        usage();
+        return (1);
+      }
+    }
+    else if (!strcmp(argv[i], "--help"))
+    {
+      usage();
+      return (0);
+    }
+    else if (!strcmp(argv[i], "--host-limit"))
+    {
+      i ++;
+      if (i >= argc || (host_limit = atoi(argv[i])) < 1)
+      {
+        puts("ippeverun: Expected number of printers after '--host-limit'.");
+        usage();
+        return (1);
+      }
+    }
+    else if (!strcmp(argv[i], "--json"))
+    {
+      json = true;
+    }
+    else if (!strcmp(argv[i], "--resume"))
+    {
+      mode = RUNNER_MODE_RESUME;
+    }
+    else if (!strcmp(argv[i], "--retries"))
+    {
+      i ++;
+      if (i >= argc || (retries = atoi(argv[i])) < 0)
+      {
+        puts("ippeverun: Expected number of retries after '--retries'.");
+        usage();
+        return (1);
+      }
+    }
+    else if (!strcmp(argv[i], "--sequential"))
+    {
+      sequential = true;
+    }
+    else if (!strcmp(argv[i], "--stress"))
+    {
+      i ++;
+      if (i >= argc || (stress = atoi(argv[i])) < 1)
+      {
+        puts("ippeverun: Expected number of clients after '--stress'.");
+        usage();
+        return (1);
+      }
+    }
+    else if (!strcmp(argv[i], "-f"))
+    {
+      i ++;
+      if (i >= argc)
+      {
+        puts("ippeverun: Expected filename after '-f'.");
+        usage();
+        return (1);
+      }
+
+      farm = argv[i];
+    }
+    else if (!strcmp(argv[i], "-j"))
+    {
+      i ++;
+      if (i >= argc || (num_workers = atoi(argv[i])) < 1)
+      {
+        puts("ippeverun: Expected number of printers after '-j'.");
+        usage();
+        return (1);
+      }
+    }
+    else if (!strcmp(argv[i], "-o"))
+    {
+      i ++;
+      if (i >= argc)
+      {
+        puts("ippeverun: Expected directory after '-o'.");
+        usage();
+        return (1);
+      }
+
+      directory = argv[i];
+    }
+    else if (!strcmp(argv[i], "-n"))
+    {
+      i ++;
+      if (i >= argc)
+      {
+        puts("ippeverun: Expected name after '-n'.");
+        usage();
+        return (1);
+      }
+
+      name = argv[i];
+    }
+    else if (argv[i][0] == '-')
+    {
+      printf("ippeverun: Unknown option '%s'.\n", argv[i]);
+      usage();
+      return (1);
+    }
+    else if (!printer && !farm)
+    {
+      printer = argv[i];
+    }
+    else if (num_suites >= (sizeof(suites) / sizeof(suites[0])))
+    {
+      printf("ippeverun: Unknown argument '%s'.\n", argv[i]);
+      usage();
+      return (1);
+    }
+    else if (!strcmp(argv[i], "dnssd"))
+    {
+      suites[num_suites ++] = SELFCERT_SUITE_DNSSD;
+    }
+    else if (!strcmp(argv[i], "ipp"))
+    {
+      suites[num_suites ++] = SELFCERT_SUITE_IPP;
+    }
+    else if (!strcmp(argv[i], "document"))
+    {
+      suites[num_suites ++] = SELFCERT_SUITE_DOCUMENT;
+    }
+    else
+    {
+      printf("ippeverun: Unknown test suite '%s'.\n", argv[i]);
+      usage();
+      return (1);
+    }
+  }
+
+  if (stress && (farm || num_suites > 0))
+  {
+    puts("ippeverun: Cannot use test suites or '-f' with '--stress'.");
+    return (1);
+  }
+
+  if (json && (farm || stress))
+  {
+    puts("ippeverun: Cannot use '--json' with '-f' or '--stress'.");
+    return (1);
+  }
+
+  if (num_suites == 0)
+  {
+    suites[0]  = SELFCERT_SUITE_DNSSD;
+    suites[1]  = SELFCERT_SUITE_IPP;
+    suites[2]  = SELFCERT_SUITE_DOCUMENT;
+    num_suites = 3;
+  }
+
+  if (farm)
+  {
+    if (printer || name)
+    {
+      puts("ippeverun: Cannot use a printer name or '-n' with '-f'.");
+      return (1);
+    }
+
+    return (do_farm(farm, directory, num_workers, host_limit, retries, sequential, mode, num_suites, suites));
+  }
+
+  if (!printer)
+  {
+    usage();
+    return (1);
+  }
+
+  if (!name && (hostptr = strstr(printer, "://")) != NULL)
+  {
+    // Use the hostname from the URI...
+    cupsCopyString(host, hostptr + 3, sizeof(host));
+    if ((hostptr = strpbrk(host, ":/")) != NULL)
+      *hostptr = '\0';
+
+    name = host;
+  }
+
+  if (stress)
+  {
+    // Run the stress test instead of the test suites...
+    snprintf(filename, sizeof(filename), "%s Stress Results.plist", name ? name : printer);
+
+    printf("Stress Test (%d clients for %d seconds):\n", stress, duration);
+
+    if (stress_run(printer, filename, stress, duration, event_cb, NULL))
+      printf("Wrote \"%s\".\n\n", filename);
+    else
+      ok = false;
+
+    show_connections();
+
+    return (ok ? 0 : 1);
+  }
+
+  // Clear the JSON progress...
+  memset(json_suites, 0, sizeof(json_suites));
+
+  // The DNS-SD tests need a service instance name...
+  if (!strncmp(printer, "ipp://", 6) || !strncmp(printer, "ipps://", 7))
+  {
+    for (s = 0, count = 0; s < num_suites; s ++)
+    {
+      if (suites[s] != SELFCERT_SUITE_DNSSD)
+        suites[count ++] = suites[s];
+    }
+
+    if (count < num_suites)
+    {
+      if (json)
+        json_cb(json_suites, SELFCERT_SUITE_DNSSD, RUNNER_EVENT_MESSAGE, NULL, "The DNS-SD tests require a service instance name.");
+      else
+        puts("ippeverun: The DNS-SD tests require a service instance name.");
+
+      ok         = false;
+      num_suites = count;
+    }
+
+    if (num_suites == 0)
+      return (1);
+  }
+
+  // Run the tests...
+  if (json)
+  {
+    // Send the progress as JSON events, one suite at a time if needed...
+    if (sequential)
+    {
+      for (s = 0; s < num_suites; s ++)
+      {
+        if (!runner_run_suites(printer, name, mode, 1, suites + s, (runner_suites_cb_t)json_cb, json_suites))
+          ok = false;
+      }
+    }
+    else if (!runner_run_suites(printer, name, mode, num_suites, suites, (runner_suites_cb_t)json_cb, json_suites))
+    {
+      ok = false;
+    }
+
+    json_finish(json_suites);
+
+    return (ok ? 0 : 1);
+  }
+  else if (num_suites > 1 && !sequential)
+  {
+    for (s = 0; s < num_suites; s ++)
+      printf("%s%s", s ? ", " : "Running ", suite_names[suites[s]]);
+    puts(":");
+
+    if (!runner_run_suites(printer, name, mode, num_suites, suites, suites_cb, NULL))
+      ok = false;
+  }
+  else
+  {
+    for (s = 0; s < num_suites; s ++)
+    {
+      printf("%s:\n", suite_names[suites[s]]);
+
+      if ((runner = runner_new(printer, name, suites[s], mode, event_cb, NULL)) == NULL)
+      {
+        printf("ippeverun: Unable to create test runner: %s\n", strerror(errno));
+        return (1);
+      }
+
+      if (!runner_run(runner))
+        ok = false;
+
+      runner_delete(runner);
+    }
+  }
+
+  show_connections();
+
+  return (ok ? 0 : 1);
+}
+
+
+//
+// 'do_farm()' - Test a list of printers.
+//
+
+static int				// O - Exit status
+do_farm(
+    const char             *filename,	// I - Printer list file
+    const char             *directory,	// I - Output directory
+    int                    num_workers,	// I - Number of printers to test at once
+    int                    host_limit,	// I - Number of printers per host
+    int                    retries,	// I - Number of retries per printer
+    bool                   sequential,	// I - Run the suites one at a time?
+    runner_mode_t          mode,	// I - Test runner mode
+    size_t                 num_suites,	// I - Number of test suites
+    const selfcert_suite_t *suites)	// I - Test suites
+{
+  _farm_t		farm;		// Printer farm
+  _farm_printer_t	*printer;	// Current printer
+  FILE			*fp;		// Printer list file
+  char			line[1024],	// Line from file
+			*ptr;		// Pointer into line
+  size_t		i;		// Looping var
+  int			j;		// Looping var
+  cups_thread_t		*workers;	// Worker threads
+  double		start;		// Start time
+
+
+  // Read the list of printers...
+  memset(&farm, 0, sizeof(farm));
+
+  if ((fp = fopen(filename, "r")) == NULL)
+  {
+    printf("ippeverun: Unable to open '%s': %s\n", filename, strerror(errno));
+    return (1);
+  }
+
+  while (fgets(line, sizeof(line), fp))
+  {
+    if ((ptr = line + strlen(line) - 1) >= line && *ptr == '\n')
+      *ptr = '\0';
+    if ((ptr = line + strlen(line) - 1) >= line && *ptr == '\r')
+      *ptr = '\0';
+
+    if (!line[0] || line[0] == '#')
+      continue;
+
+    if (!farm_add(&farm, line, directory))
+    {
+      printf("ippeverun: Unable to add \"%s\": %s\n", line, strerror(errno));
+      fclose(fp);
+      free(farm.printers);
+      return (1);
+    }
+  }
+
+  fclose(fp);
+
+  if (farm.num_printers == 0)
+  {
+    printf("ippeverun: No printers in '%s'.\n", filename);
+    return (1);
+  }
+
+  if (mkdir(directory, 0777) && errno != EEXIST)
+  {
+    printf("ippeverun: Unable to create '%s': %s\n", directory, strerror(errno));
+    free(farm.printers);
+    return (1);
+  }
+
+  cupsMutexInit(&farm.mutex);
+  cupsCondInit(&farm.cond);
+
+  memcpy(farm.suites, suites, num_suites * sizeof(selfcert_suite_t));
+  farm.num_suites  = num_suites;
+  farm.host_limit  = host_limit;
+  farm.retries     = retries;
+  farm.sequential  = sequential;
+  farm.mode        = mode;
+  farm.num_waiting = farm.num_printers;
+
+  // Test the printers using the worker pool...
+  if ((size_t)num_workers > farm.num_printers)
+    num_workers = (int)farm.num_printers;
+
+  start = runner_get_time();
+
+  if ((workers = (cups_thread_t *)calloc((size_t)num_workers, sizeof(cups_thread_t))) == NULL)
+  {
+    printf("ippeverun: Unable to allocate workers: %s\n", strerror(errno));
+    free(farm.printers);
+    return (1);
+  }
+
+  // Hold the mutex so that the workers don't show their status before the
+  // number of workers that were started...
+  cupsMutexLock(&farm.mutex);
+
+  for (j = 0; j < num_workers; j ++)
+  {
+    if ((workers[j] = cupsThreadCreate((cups_thread_func_t)farm_run, &farm)) == CUPS_THREAD_INVALID)
+      break;
+  }
+
+  if (j > 0)
+    printf("Testing %u printers using %d workers:\n", (unsigned)farm.num_printers, j);
+  else
+    printf("Testing %u printers without workers:\n", (unsigned)farm.num_printers);
+
+  cupsMutexUnlock(&farm.mutex);
+
+  if (j == 0)
+  {
+    // Fall back to testing the printers on this thread...
+    farm_run(&farm);
+  }
+
+  while (j > 0)
+    cupsThreadWait(workers[-- j]);
+
+  free(workers);
+
+  // Show and save the fleet summary...
+  printf("\n%-40s %-8s %5s %6s %-6s %9s\n", "Printer", "Attempts", "Tests", "Failed", "Result", "Time");
+  printf("%-40s %-8s %5s %6s %-6s %9s\n", "----------------------------------------", "--------", "-----", "------", "------", "---------");
+
+  for (i = farm.num_printers, printer = farm.printers; i > 0; i --, printer ++)
+    printf("%-40.40s %8d %5u %6u %-6s %8.1fs\n", printer->printer, printer->attempts, (unsigned)printer->num_tests, (unsigned)printer->num_failed, !printer->ran ? "ERROR" : printer->num_failed ? "FAIL" : "PASS", printer->end - printer->start);
+
+  printf("\n%u printers, %u passed, %u failed in %.1fs.\n", (unsigned)farm.num_printers, (unsigned)farm.num_passed, (unsigned)(farm.num_printers - farm.num_passed), runner_get_time() - start);
+
+  show_connections();
+
+  if (!farm_write_summary(&farm, directory))
+    printf("ippeverun: Unable to write fleet summary: %s\n", strerror(errno));
+
+  cupsCondDestroy(&farm.cond);
+  cupsMutexDestroy(&farm.mutex);
+
+  free(farm.printers);
+
+  return (farm.num_passed == farm.num_printers ? 0 : 1);
+}
+
+
+//
+// 'event_cb()' - Show progress from the test runner.
+//
+
+static bool				// O - `true` to continue
+event_cb(void                *cb_data,	// I - Callback data (unused)
+         runner_event_t      event,	// I - Event
+         const runner_test_t *test,	// I - Test, if any
+         const char          *message)	// I - Message, if any
+{
+  (void)cb_data;
+
+  switch (event)
+  {
+    case RUNNER_EVENT_SUITE_START :
+        break;
+
+    case RUNNER_EVENT_TEST_START :
+        printf("    %-60.60s [", test->name);
+        fflush(stdout);
+        break;
+
+    case RUNNER_EVENT_TEST_REPEAT :
+        break;
+
+    case RUNNER_EVENT_TEST_END :
+        if (test->num_iterations > 1)
+          printf("%s] %8.3fs (%u requests)\n", test->status, test->end - test->start, (unsigned)test->num_iterations);
+        else
+          printf("%s] %8.3fs\n", test->status, test->end - test->start);
+        break;
+
+    case RUNNER_EVENT_SUITE_END :
+        printf("Wrote \"%s\".\n\n", message);
+        break;
+
+    case RUNNER_EVENT_MESSAGE :
+        puts(message);
+        break;
+  }
+
+  return (true);
+}
+
+
+//
+// 'farm_add()' - Add a printer to the farm.
+//
+
+static _farm_printer_t *		// O - New printer or `NULL` on error
+farm_add(_farm_t    *farm,		// I - Printer farm
+         const char *printer,		// I - Printer name or URI
+         const char *directory)		// I - Output directory
+{
+  _farm_printer_t	*temp;		// New printer
+  char			*ptr;		// Pointer into name
+
+
+  if (farm->num_printers >= farm->alloc_printers)
+  {
+    if ((temp = (_farm_printer_t *)realloc(farm->printers, (farm->alloc_printers + 16) * sizeof(_farm_printer_t))) == NULL)
+      return (NULL);
+
+    farm->printers       = temp;
+    farm->alloc_printers += 16;
+  }
+
+  temp = farm->printers + farm->num_printers;
+  farm->num_printers ++;
+
+  memset(temp, 0, sizeof(_farm_printer_t));
+
+  temp->farm = farm;
+  cupsCopyString(temp->printer, printer, sizeof(temp->printer));
+
+  if ((ptr = strstr(printer, "://")) != NULL)
+  {
+    // Use the hostname from the URI...
+    cupsCopyString(temp->host, ptr + 3, sizeof(temp->host));
+    if ((ptr = strpbrk(temp->host, ":/")) != NULL)
+      *ptr = '\0';
+
+    cupsCopyString(temp->name, temp->host, sizeof(temp->name));
+  }
+  else
+  {
+    cupsCopyString(temp->name, printer, sizeof(temp->name));
+  }
+
+  // Don't allow directory separators in the results names...
+  for (ptr = temp->name; *ptr; ptr ++)
+  {
+    if (*ptr == '/' || *ptr == '\\' || *ptr == ':')
+      *ptr = '_';
+  }
+
+  snprintf(temp->directory, sizeof(temp->directory), "%s/%s", directory, temp->name);
+  snprintf(temp->resultsname, sizeof(temp->resultsname), "%s/%s", temp->directory, temp->name);
+
+  return (temp);
+}
+
+
+//
+// 'farm_cb()' - Log progress from a printer's test suites.
+//
+
+static bool				// O - `true` to continue
+farm_cb(_farm_printer_t     *printer,	// I - Farm printer
+        selfcert_suite_t    suite,	// I - Test suite
+        runner_event_t      event,	// I - Event
+        const runner_test_t *test,	// I - Test, if any
+        const char          *message)	// I - Message, if any
+{
+  _farm_t	*farm = printer->farm;	// Printer farm
+
+
+  switch (event)
+  {
+    case RUNNER_EVENT_SUITE_START :
+        if (printer->log)
+          fprintf(printer->log, "Started %s.\n", suite_names[suite]);
+        break;
+
+    case RUNNER_EVENT_TEST_START :
+    case RUNNER_EVENT_TEST_REPEAT :
+        break;
+
+    case RUNNER_EVENT_TEST_END :
+        if (printer->log)
+          fprintf(printer->log, "%-60.60s [%s] %8.3fs\n", test->name, test->status, test->end - test->start);
+
+        cupsMutexLock(&farm->mutex);
+        printer->num_tests ++;
+        farm->num_tests ++;
+        if (!strcmp(test->status, "FAIL"))
+        {
+          printer->num_failed ++;
+          farm->num_failed ++;
+        }
+        cupsMutexUnlock(&farm->mutex);
+        break;
+
+    case RUNNER_EVENT_SUITE_END :
+        if (printer->log)
+          fprintf(printer->log, "Wrote \"%s\".\n", message);
+        break;
+
+    case RUNNER_EVENT_MESSAGE :
+        if (printer->log)
+          fprintf(printer->log, "%s\n", message);
+        break;
+  }
+
+  return (true);
+}
+
+
+//
+// 'farm_next()' - Get the next printer to test.
+//
+// The farm mutex must be held.  A printer is ready once its retry delay has
+// passed and its host is below the per-host limit.  Printers without a host
+// are returned right away so that the worker can find the host.  `NULL` is
+// returned once all of the printers are done.
+//
+
+static _farm_printer_t *		// O - Next printer or `NULL` if done
+farm_next(_farm_t *farm)		// I - Printer farm
+{
+  _farm_printer_t	*printer,	// Current printer
+			*other;		// Other printer
+  size_t		i,		// Looping var
+			j;		// Looping var
+  int			count;		// Number of printers on host
+  double		now,		// Current time
+			retry;		// Time of next retry
+
+
+  while (farm->num_waiting > 0)
+  {
+    now   = runner_get_time();
+    retry = 0.0;
+
+    for (i = farm->num_printers, printer = farm->printers; i > 0; i --, printer ++)
+    {
+      if (printer->state != _FARM_STATE_WAITING)
+        continue;
+
+      if (printer->not_before > now)
+      {
+        if (retry == 0.0 || printer->not_before < retry)
+          retry = printer->not_before;
+        continue;
+      }
+
+      if (!printer->host[0])
+        return (printer);
+
+      for (j = farm->num_printers, other = farm->printers, count = 0; j > 0; j --, other ++)
+      {
+        if (other->state == _FARM_STATE_RUNNING && !strcasecmp(other->host, printer->host))
+          count ++;
+      }
+
+      if (count < farm->host_limit)
+        return (printer);
+    }
+
+    // Wait for a printer to finish or a retry delay to pass...
+    cupsCondWait(&farm->cond, &farm->mutex, retry > 0.0 ? retry - now : -1.0);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'farm_run()' - Test printers until all of them are done.
+//
+
+static void *				// O - Thread exit status
+farm_run(_farm_t *farm)			// I - Printer farm
+{
+  _farm_printer_t	*printer;	// Current printer
+  selfcert_suite_t	suites[3];	// Test suites
+  size_t		s,		// Current suite
+			num_suites;	// Number of test suites
+  runner_mode_t		mode;		// Test runner mode
+  char			filename[1024],	// Log filename
+			host[256],	// Printer host
+			message[256];	// Status message
+  bool			ran;		// Did all of the tests run?
+
+
+  for (;;)
+  {
+    // Get the next printer...
+    cupsMutexLock(&farm->mutex);
+
+    if ((printer = farm_next(farm)) != NULL && !printer->host[0])
+    {
+      // Find the host for the per-host limit without holding the mutex, since
+      // it can take several seconds for a missing printer...
+      printer->state = _FARM_STATE_RESOLVING;
+      cupsMutexUnlock(&farm->mutex);
+
+      if (!dnssd_get_host(printer->printer, host, sizeof(host)))
+      {
+        // Use the service name, the tests will report the problem...
+        cupsCopyString(host, printer->printer, sizeof(host));
+      }
+
+      cupsMutexLock(&farm->mutex);
+      cupsCopyString(printer->host, host, sizeof(printer->host));
+      printer->state = _FARM_STATE_WAITING;
+      cupsCondBroadcast(&farm->cond);
+      cupsMutexUnlock(&farm->mutex);
+      continue;
+    }
+    else if (printer)
+    {
+      printer->state      = _FARM_STATE_RUNNING;
+      printer->num_tests  = 0;
+      printer->num_failed = 0;
+      printer->attempts ++;
+
+      farm->num_waiting --;
+      farm->num_running ++;
+
+      if (printer->attempts == 1)
+        printer->start = runner_get_time();
+
+      snprintf(message, sizeof(message), "Started attempt %d, host %s", printer->attempts, printer->host);
+      farm_status(farm, printer, message);
+    }
+
+    cupsMutexUnlock(&farm->mutex);
+
+    if (!printer)
+      break;
+
+    // The DNS-SD tests need a service instance name...
+    for (s = 0, num_suites = 0; s < farm->num_suites; s ++)
+    {
+      if (farm->suites[s] != SELFCERT_SUITE_DNSSD || !strstr(printer->printer, "://"))
+        suites[num_suites ++] = farm->suites[s];
+    }
+
+    // Get the printer attributes again in case the printer has changed since
+    // the last attempt...
+    snapshot_clear(printer->printer);
+
+    // Run the tests, logging to the printer's directory, and resume where the
+    // previous attempt stopped...
+    ran  = true;
+    mode = printer->attempts > 1 && farm->mode != RUNNER_MODE_FAILED ? RUNNER_MODE_RESUME : farm->mode;
+
+    if (mkdir(printer->directory, 0777) && errno != EEXIST)
+    {
+      ran = false;
+    }
+    else
+    {
+      snprintf(filename, sizeof(filename), "%s/ippeverun.log", printer->directory);
+      printer->log = fopen(filename, "a");
+
+      if (printer->log)
+        fprintf(printer->log, "Attempt %d on %s:\n", printer->attempts, printer->host);
+
+      if (farm->sequential)
+      {
+        for (s = 0; s < num_suites; s ++)
+        {
+          if (!runner_run_suites(printer->printer, printer->resultsname, mode, 1, suites + s, (runner_suites_cb_t)farm_cb, printer))
+            ran = false;
+        }
+      }
+      else if (!runner_run_suites(printer->printer, printer->resultsname, mode, num_suites, suites, (runner_suites_cb_t)farm_cb, printer))
+      {
+        ran = false;
+      }
+
+      if (printer->log)
+      {
+        fclose(printer->log);
+        printer->log = NULL;
+      }
+    }
+
+    // Update the printer state, retrying if the tests could not be run...
+    cupsMutexLock(&farm->mutex);
+
+    farm->num_running --;
+
+    if (!ran && printer->attempts <= farm->retries)
+    {
+      // Don't count the tests from the failed attempt...
+      farm->num_tests  -= printer->num_tests;
+      farm->num_failed -= printer->num_failed;
+
+      printer->state      = _FARM_STATE_WAITING;
+      printer->not_before = runner_get_time() + FARM_RETRY_DELAY * printer->attempts;
+
+      farm->num_waiting ++;
+
+      snprintf(message, sizeof(message), "Unable to run tests, retrying in %.0fs.", FARM_RETRY_DELAY * printer->attempts);
+    }
+    else
+    {
+      printer->state = _FARM_STATE_DONE;
+      printer->ran   = ran;
+      printer->end   = runner_get_time();
+
+      farm->num_done ++;
+
+      if (ran && printer->num_failed == 0)
+      {
+        farm->num_passed ++;
+        snprintf(message, sizeof(message), "PASS, %u tests in %.1fs.", (unsigned)printer->num_tests, printer->end - printer->start);
+      }
+      else if (ran)
+      {
+        snprintf(message, sizeof(message), "FAIL, %u of %u tests failed in %.1fs.", (unsigned)printer->num_failed, (unsigned)printer->num_tests, printer->end - printer->start);
+      }
+      else
+      {
+        snprintf(message, sizeof(message), "ERROR, unable to run tests after %d attempts.", printer->attempts);
+      }
+    }
+
+    farm_status(farm, printer, message);
+
+    cupsCondBroadcast(&farm->cond);
+    cupsMutexUnlock(&farm->mutex);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'farm_status()' - Show a printer message with the farm status.
+//
+// The farm mutex must be held.
+//
+
+static void
+farm_status(_farm_t         *farm,	// I - Printer farm
+            _farm_printer_t *printer,	// I - Farm printer
+            const char      *message)	// I - Message
+{
+  printf("[%u waiting, %u running, %u/%u done, %u passed, %u tests, %u failed] %s: %s\n", (unsigned)farm->num_waiting, (unsigned)farm->num_running, (unsigned)farm->num_done, (unsigned)farm->num_printers, (unsigned)farm->num_passed, (unsigned)farm->num_tests, (unsigned)farm->num_failed, printer->printer, message);
+  fflush(stdout);
+}
+
+
+//
+// 'farm_write_summary()' - Write the fleet summary.
+//
+
+static bool				// O - `true` on success, `false` on error
+farm_write_summary(
+    _farm_t    *farm,			// I - Printer farm
+    const char *directory)		// I - Output directory
+{
+  plist_t		*summary,	// Fleet summary
+			*dict,		// Summary dictionary
+			*printers,	// Printers array
+			*pdict;		// Printer dictionary
+  _farm_printer_t	*printer;	// Current printer
+  size_t		i;		// Looping var
+  char			filename[1024],	// Summary filename
+			temp[256];	// Temporary string
+  bool			ret;		// Return value
+
+
+  summary = plist_new();
+  dict    = plist_add(summary, PLIST_TYPE_DICT, NULL);
+
+  plist_add(dict, PLIST_TYPE_KEY, "Printers");
+  printers = plist_add(dict, PLIST_TYPE_ARRAY, NULL);
+
+  for (i = farm->num_printers, printer = farm->printers; i > 0; i --, printer ++)
+  {
+    pdict = plist_add(printers, PLIST_TYPE_DICT, NULL);
+
+    plist_add(pdict, PLIST_TYPE_KEY, "Printer");
+    plist_add(pdict, PLIST_TYPE_STRING, printer->printer);
+    plist_add(pdict, PLIST_TYPE_KEY, "Host");
+    plist_add(pdict, PLIST_TYPE_STRING, printer->host);
+    plist_add(pdict, PLIST_TYPE_KEY, "Directory");
+    plist_add(pdict, PLIST_TYPE_STRING, printer->name);
+
+    plist_add(pdict, PLIST_TYPE_KEY, "Attempts");
+    snprintf(temp, sizeof(temp), "%d", printer->attempts);
+    plist_add(pdict, PLIST_TYPE_INTEGER, temp);
+
+    plist_add(pdict, PLIST_TYPE_KEY, "StartTime");
+    snprintf(temp, sizeof(temp), "%.0f", printer->start * 1000.0);
+    plist_add(pdict, PLIST_TYPE_INTEGER, temp);
+
+    plist_add(pdict, PLIST_TYPE_KEY, "EndTime");
+    snprintf(temp, sizeof(temp), "%.0f", printer->end * 1000.0);
+    plist_add(pdict, PLIST_TYPE_INTEGER, temp);
+
+    plist_add(pdict, PLIST_TYPE_KEY, "NumberOfTests");
+    snprintf(temp, sizeof(temp), "%u", (unsigned)printer->num_tests);
+    plist_add(pdict, PLIST_TYPE_INTEGER, temp);
+
+    plist_add(pdict, PLIST_TYPE_KEY, "NumberOfFailures");
+    snprintf(temp, sizeof(temp), "%u", (unsigned)printer->num_failed);
+    plist_add(pdict, PLIST_TYPE_INTEGER, temp);
+
+    plist_add(pdict, PLIST_TYPE_KEY, "Successful");
+    plist_add(pdict, printer->ran && printer->num_failed == 0 ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL);
+  }
+
+  plist_add(dict, PLIST_TYPE_KEY, "Successful");
+  plist_add(dict, farm->num_passed == farm->num_printers ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL);
+
+  snprintf(filename, sizeof(filename), "%s/Fleet Summary.plist", directory);
+  ret = plist_write(NULL, filename, summary, NULL, NULL);
+
+  plist_delete(summary);
+
+  return (ret);
+}
+
+
+//
+// 'json_cb()' - Send the progress from the test suites as JSON events.
+//
+// The errors for a test follow its end event as indented messages, so the
+// "test-end" event is held back until the next event for the suite.
+//
+
+static bool				// O - `true` to continue
+json_cb(_json_suite_t       *json,	// I - JSON progress for each suite
+        selfcert_suite_t    suite,	// I - Test suite
+        runner_event_t      event,	// I - Event
+        const runner_test_t *test,	// I - Test, if any
+        const char          *message)	// I - Message, if any
+{
+  _json_suite_t	*js = json + suite;	// JSON progress for this suite
+  char		name[1024],		// Encoded test name
+		text[2048];		// Encoded message
+  size_t	len;			// Length of errors
+
+
+  if (event == RUNNER_EVENT_MESSAGE && js->pending && !strncmp(message, "        ", 8) && message[8] && message[8] != ' ')
+  {
+    // Error for the test that just ended...
+    plist_json_string(text, sizeof(text), message + 8);
+
+    if ((len = strlen(js->errors)) + strlen(text) + 2 < sizeof(js->errors))
+      snprintf(js->errors + len, sizeof(js->errors) - len, "%s%s", len ? "," : "", text);
+
+    return (true);
+  }
+
+  if (js->pending)
+    json_test_end(json, suite);
+
+  switch (event)
+  {
+    case RUNNER_EVENT_SUITE_START :
+        js->started = true;
+        js->start   = runner_get_time();
+        cupsCopyString(js->file, message, sizeof(js->file));
+
+        printf("{\"event\":\"suite-start\",\"suite\":\"%s\",\"title\":\"%s\",\"file\":%s,\"time\":%.3f}\n", suite_ids[suite], suite_names[suite], plist_json_string(text, sizeof(text), message), js->start);
+        break;
+
+    case RUNNER_EVENT_TEST_START :
+        js->num_tests ++;
+
+        printf("{\"event\":\"test-start\",\"suite\":\"%s\",\"index\":%u,\"test\":%s,\"start\":%.3f}\n", suite_ids[suite], (unsigned)js->num_tests, plist_json_string(name, sizeof(name), test->name), test->start);
+        break;
+
+    case RUNNER_EVENT_TEST_REPEAT :
+        printf("{\"event\":\"test-repeat\",\"suite\":\"%s\",\"index\":%u,\"test\":%s,\"requests\":%u}\n", suite_ids[suite], (unsigned)js->num_tests, plist_json_string(name, sizeof(name), test->name), (unsigned)test->num_iterations);
+        break;
+
+    case RUNNER_EVENT_TEST_END :
+        js->test            = *test;
+        js->test.iterations = NULL;
+        js->errors[0]       = '\0';
+        js->pending         = true;
+
+        if (!strcmp(test->status, "PASS"))
+          js->num_passed ++;
+        else if (!strcmp(test->status, "SKIP"))
+          js->num_skipped ++;
+        else
+          js->num_failed ++;
+        return (true);
+
+    case RUNNER_EVENT_SUITE_END :
+        js->ended = true;
+
+        printf("{\"event\":\"suite-end\",\"suite\":\"%s\",\"file\":%s,\"complete\":true,\"passed\":%u,\"failed\":%u,\"skipped\":%u,\"duration\":%.3f}\n", suite_ids[suite], plist_json_string(text, sizeof(text), message), (unsigned)js->num_passed, (unsigned)js->num_failed, (unsigned)js->num_skipped, runner_get_time() - js->start);
+        break;
+
+    case RUNNER_EVENT_MESSAGE :
+        if (test)
+          printf("{\"event\":\"message\",\"suite\":\"%s\",\"index\":%u,\"test\":%s,\"text\":%s}\n", suite_ids[suite], (unsigned)js->num_tests, plist_json_string(name, sizeof(name), test->name), plist_json_string(text, sizeof(text), message));
+        else
+          printf("{\"event\":\"message\",\"suite\":\"%s\",\"text\":%s}\n", suite_ids[suite], plist_json_string(text, sizeof(text), message));
+        break;
+  }
+
+  fflush(stdout);
+
+  return (true);
+}
+
+
+//
+// 'json_finish()' - Send the end events for the suites that did not finish.
+//
+
+static void
+json_finish(_json_suite_t *json)	// I - JSON progress for each suite
+{
+  selfcert_suite_t	suite;		// Current suite
+  _json_suite_t		*js;		// JSON progress for this suite
+  char			text[2048];	// Encoded results file
+
+
+  for (suite = SELFCERT_SUITE_DNSSD, js = json; suite <= SELFCERT_SUITE_DOCUMENT; suite ++, js ++)
+  {
+    if (js->pending)
+      json_test_end(json, suite);
+
+    if (js->started && !js->ended)
+      printf("{\"event\":\"suite-end\",\"suite\":\"%s\",\"file\":%s,\"complete\":false,\"passed\":%u,\"failed\":%u,\"skipped\":%u,\"duration\":%.3f}\n", suite_ids[suite], plist_json_string(text, sizeof(text), js->file), (unsigned)js->num_passed, (unsigned)js->num_failed, (unsigned)js->num_skipped, runner_get_time() - js->start);
+  }
+
+  fflush(stdout);
+}
+
+
+//
+// 'json_test_end()' - Send the held back end event for a test.
+//
+
+static void
+json_test_end(_json_suite_t    *json,	// I - JSON progress for each suite
+              selfcert_suite_t suite)	// I - Test suite
+{
+  _json_suite_t	*js = json + suite;	// JSON progress for this suite
+  char		name[1024];		// Encoded test name
+
+
+  printf("{\"event\":\"test-end\",\"suite\":\"%s\",\"index\":%u,\"test\":%s,\"status\":\"%s\",\"start\":%.3f,\"end\":%.3f,\"duration\":%.3f,\"requests\":%u,\"errors\":[%s]}\n", suite_ids[suite], (unsigned)js->num_tests, plist_json_string(name, sizeof(name), js->test.name), js->test.status, js->test.start, js->test.end, js->test.end - js->test.start, (unsigned)js->test.num_iterations, js->errors);
+
+  js->pending = false;
+
+  fflush(stdout);
+}
+
+
+//
+// 'show_connections()' - Show how often printer connections were reused and
+//                        close them.
+//
+
+static void
+show_connections(void)
+{
+  connpool_stats_t	stats;		// Connection statistics
+
+
+  connpool_get_stats(&stats);
+  connpool_close();
+
+  if (stats.opened > 0)
+    printf("Opened %u printer connections and reused them %u times, %u of them encrypted (ippeverun's own requests only, not ipptool's).\n", (unsigned)stats.opened, (unsigned)stats.reused, (unsigned)stats.tls_reused);
+}
+
+
+//
+// 'suites_cb()' - Show merged progress from concurrent test suites.
+//
+// Since the suites run at the same time, each test is shown on a single line
+// once it is done.
+//
+
+static bool				// O - `true` to continue
+suites_cb(void                *cb_data,	// I - Callback data (unused)
+          selfcert_suite_t    suite,	// I - Test suite
+          runner_event_t      event,	// I - Event
+          const runner_test_t *test,	// I - Test, if any
+          const char          *message)	// I - Message, if any
+{
+  static const char * const prefixes[] =
+  {					// Test suite prefixes
+    "DNS-SD",
+    "IPP",
+    "Document"
+  };
+
+
+  (void)cb_data;
+
+  switch (event)
+  {
+    case RUNNER_EVENT_SUITE_START :
+        printf("%-8s Started %s.\n", prefixes[suite], suite_names[suite]);
+        break;
+
+    case RUNNER_EVENT_TEST_START :
+    case RUNNER_EVENT_TEST_REPEAT :
+        break;
+
+    case RUNNER_EVENT_TEST_END :
+        if (test->num_iterations > 1)
+          printf("%-8s %-60.60s [%s] %8.3fs (%u requests)\n", prefixes[suite], test->name, test->status, test->end - test->start, (unsigned)test->num_iterations);
+        else
+          printf("%-8s %-60.60s [%s] %8.3fs\n", prefixes[suite], test->name, test->status, test->end - test->start);
+        break;
+
+    case RUNNER_EVENT_SUITE_END :
+        printf("%-8s Wrote \"%s\".\n", prefixes[suite], message);
+        break;
+
+    case RUNNER_EVENT_MESSAGE :
+        printf("%-8s %s\n", prefixes[suite], message);
+        break;
+  }
+
+  fflush(stdout);
+
+  return (true);
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static void
+usage(void)
+{
+  puts("Usage: ippeverun [options] \"Printer Name\" [{dnssd|ipp|document} ...]");
+  puts("       ippeverun [options] -f printers.txt [{dnssd|ipp|document} ...]");
+  puts("");
+  puts("Options:");
+  puts("  --duration SECONDS       Run the stress test for SECONDS.");
+  puts("  --failed                 Re-run the tests that failed in the previous results.");
+  puts("  --help                   Show help.");
+  puts("  --host-limit N           Test at most N printers on the same host at once.");
+  puts("  --json                   Show the progress as JSON events, one per line.");
+  puts("  --resume                 Resume interrupted tests from their checkpoint.");
+  puts("  --retries N              Retry a printer N times when its tests cannot run.");
+  puts("  --sequential             Run the test suites one at a time.");
+  puts("  --stress N               Run the stress test with N concurrent clients.");
+  puts("  -f printers.txt          Test each printer listed in the file.");
+  puts("  -j N                     Test at most N printers at once.");
+  puts("  -n \"Name\"                Name the results files.");
+  puts("  -o DIRECTORY             Write results for '-f' printers to DIRECTORY.");
+}
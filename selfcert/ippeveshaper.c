@@ -0,0 +1,1163 @@
+//
+// Network shaping proxy for benchmarking the IPP Everywhere Printer
+// Self-Certification tools.
+//
+// Copyright © 2024 by the IEEE-ISTO Printer Working Group.
+//
+// Licensed under Apache License v2.0.	See the file "LICENSE" for more
+// information.
+//
+// Usage:
+//
+//   ippeveshaper [options] {"Printer Name"|host:port}
+//
+// Options:
+//
+//    --bandwidth KBITS        Limit each direction to KBITS kilobits per
+//                             second.
+//    --drop PERCENT           Drop PERCENT of the connections at the start of
+//                             a request.
+//    --help                   Show help.
+//    --jitter MS              Vary the latency by up to MS milliseconds.
+//    --latency MS             Add MS milliseconds of round-trip latency.
+//    --profile NAME           Use the "lan", "lab", "wan", or "lossy" network
+//                             profile.
+//    -n "Name"                Advertise the proxy as a DNS-SD printer.
+//    -p PORT                  Listen on PORT (default 8631).
+//    -v                       Show each request.
+//
+// The proxy accepts connections on the listen port and relays them to the
+// printer, which is a DNS-SD service instance name or a hostname and port.
+// Data in each direction is held back for half of the round-trip latency plus
+// a random jitter and sent no faster than the bandwidth limit, so the tools
+// can be benchmarked against "ippeveprinter" as if the printer was on a real
+// network.
+//
+// With "-n", the printer's "_ipp._tcp" and "_ipps._tcp" services are
+// advertised under the new name with the proxy's port and the printer's TXT
+// records, so all three test suites can be run through the proxy.
+//
+// The HTTP messages are followed well enough to find the IPP operation and
+// status of each request, and the number of requests, the bytes sent and
+// received, and the average and maximum time from the first byte of the
+// request to the last byte of the response are shown for each operation when
+// the proxy is stopped with SIGINT or SIGTERM.  Connections that use TLS are
+// only counted as a whole.
+//
+
+#include "selfcert.h"
+#include <cups/dnssd.h>
+#include <cups/thread.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+
+
+// Local constants...
+#define SHAPER_MAX_PENDING	16	// Maximum pending requests per connection
+#define SHAPER_MAX_QUEUED	1048576	// Maximum queued bytes per direction
+
+
+// Local types...
+typedef struct _shaper_chunk_s		// Queued data
+{
+  struct _shaper_chunk_s *next;		// Next chunk
+  double	deliver;		// Delivery time
+  size_t	length,			// Length of data
+		offset;			// Offset of unsent data
+  unsigned char	data[65536];		// Data
+} _shaper_chunk_t;
+
+typedef enum _shaper_state_e		// HTTP message state
+{
+  _SHAPER_STATE_HEADER,			// Reading header lines
+  _SHAPER_STATE_LENGTH,			// Reading Content-Length body
+  _SHAPER_STATE_CHUNK_SIZE,		// Reading chunk size line
+  _SHAPER_STATE_CHUNK_DATA,		// Reading chunk data
+  _SHAPER_STATE_CHUNK_END,		// Reading CR LF after chunk data
+  _SHAPER_STATE_TRAILER,		// Reading trailer lines
+  _SHAPER_STATE_OPAQUE			// Encrypted or upgraded data
+} _shaper_state_t;
+
+typedef struct _shaper_dir_s		// One direction of a connection
+{
+  int		in,			// Socket to read from
+		out;			// Socket to write to
+  bool		request,		// Client to printer?
+		eof,			// Has the reading side closed?
+		shut;			// Has the writing side been shut down?
+  _shaper_chunk_t *first,		// First queued chunk
+		*last;			// Last queued chunk
+  size_t	queued;			// Number of queued bytes
+  double	link_free,		// Time when the link is free again
+		last_deliver;		// Last delivery time
+  _shaper_state_t state;		// HTTP message state
+  bool		active,			// In a message?
+		first_line;		// Reading the first line?
+  char		line[1024],		// Current line
+		method[32];		// Request method
+  size_t	linelen,		// Length of current line
+		remaining,		// Remaining body or chunk bytes
+		bytes;			// Bytes in current message
+  long		content_length;		// Content-Length value or -1
+  bool		chunked;		// Chunked transfer encoding?
+  int		status;			// HTTP status
+  unsigned char	ipp[8];			// Start of IPP message
+  size_t	ipplen;			// Number of bytes in ipp
+  double	start;			// Start of current message
+} _shaper_dir_t;
+
+typedef struct _shaper_request_s	// Request waiting for a response
+{
+  char		name[64];		// Operation or method name
+  bool		ipp;			// IPP request?
+  size_t	bytes;			// Request bytes
+  double	start;			// Time of first request byte
+} _shaper_request_t;
+
+typedef struct _shaper_conn_s		// Proxied connection
+{
+  int		number;			// Connection number
+  _shaper_dir_t	dirs[2];		// Client to printer and printer to client
+  size_t	num_pending,		// Number of pending requests
+		first_pending;		// First pending request
+  _shaper_request_t pending[SHAPER_MAX_PENDING];
+					// Pending requests
+  double	opaque_start;		// Start of encrypted data
+} _shaper_conn_t;
+
+typedef struct _shaper_op_s		// Operation statistics
+{
+  char		name[64];		// Operation or method name
+  size_t	count,			// Number of requests
+		sent,			// Bytes sent to the printer
+		received;		// Bytes received from the printer
+  double	total,			// Total time
+		maximum;		// Maximum time
+} _shaper_op_t;
+
+typedef struct _shaper_profile_s	// Network profile
+{
+  const char	*name;			// Profile name
+  double	latency,		// Round-trip latency in milliseconds
+		jitter;			// Jitter in milliseconds
+  int		bandwidth;		// Bandwidth in kilobits per second
+  double	drop;			// Dropped connections in percent
+} _shaper_profile_t;
+
+
+// Local globals...
+static const char	*shaper_host = NULL;
+					// Printer hostname
+static int		shaper_port = 0;// Printer port number
+static double		shaper_latency = 0.0,
+					// One-way latency in seconds
+			shaper_jitter = 0.0,
+					// One-way jitter in seconds
+			shaper_bandwidth = 0.0,
+					// Bandwidth in bytes per second
+			shaper_drop = 0.0;
+					// Probability of dropping a connection
+static bool		shaper_verbose = false;
+					// Show each request?
+static volatile bool	shaper_stop = false;
+					// Stop the proxy?
+static cups_mutex_t	shaper_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for statistics
+static int		shaper_num_conns = 0,
+					// Number of connections
+			shaper_num_dropped = 0;
+					// Number of dropped connections
+static size_t		shaper_num_ops = 0;
+					// Number of operations
+static _shaper_op_t	shaper_ops[256];
+					// Operation statistics
+static const _shaper_profile_t shaper_profiles[] =
+{					// Network profiles
+  { "lan",	1.0,	0.0,	100000,	0.0 },
+  { "lab",	20.0,	2.0,	10000,	0.0 },
+  { "wan",	80.0,	10.0,	2000,	0.0 },
+  { "lossy",	20.0,	5.0,	10000,	1.0 }
+};
+
+
+// Local functions...
+static int	shaper_connect(void);
+static void	shaper_done(_shaper_conn_t *conn, _shaper_dir_t *dir, double deliver);
+static void	shaper_line(_shaper_conn_t *conn, _shaper_dir_t *dir, double deliver);
+static int	shaper_listen(int port);
+static bool	shaper_parse(_shaper_conn_t *conn, _shaper_dir_t *dir, const unsigned char *data, size_t length, double deliver);
+static void	shaper_record(const char *name, size_t sent, size_t received, double elapsed);
+static void	*shaper_run(_shaper_conn_t *conn);
+static void	shaper_service_cb(cups_dnssd_service_t *service, void *cb_data, cups_dnssd_flags_t flags);
+static void	shaper_signal(int sig);
+static void	shaper_summary(void);
+static void	usage(void);
+
+
+//
+// 'main()' - Main entry for the network shaping proxy.
+//
+
+int					// O - Exit status
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  int		i;			// Looping var
+  size_t	j;			// Looping var
+  const char	*printer = NULL,	// Printer name or host:port
+		*name = NULL;		// DNS-SD name to advertise
+  char		host[256],		// Printer hostname
+		*ptr;			// Pointer into hostname
+  int		port = 8631,		// Listen port
+		lfd,			// Listen socket
+		fd;			// Client socket
+  size_t	num_txt = 0,		// Number of IPP TXT key/value pairs
+		num_ipps_txt = 0;	// Number of IPPS TXT key/value pairs
+  cups_option_t	*txt = NULL,		// IPP TXT key/value pairs
+		*ipps_txt = NULL;	// IPPS TXT key/value pairs
+  char		ipps_host[256],		// IPPS hostname
+		bandwidth[32];		// Bandwidth string
+  int		ipps_port;		// IPPS port number
+  bool		ipps = false;		// Advertise IPPS?
+  cups_dnssd_t	*dnssd = NULL;		// DNS-SD session
+  cups_dnssd_service_t *service = NULL;	// Advertised service
+  _shaper_conn_t *conn;			// New connection
+  struct pollfd	pfd;			// Listen socket poll data
+
+
+  // Parse command-line...
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--bandwidth"))
+    {
+      i ++;
+      if (i >= argc || atoi(argv[i]) < 0)
+      {
+        puts("ippeveshaper: Expected kilobits per second after '--bandwidth'.");
+        usage();
+        return (1);
+      }
+
+      shaper_bandwidth = atoi(argv[i]) * 125.0;
+    }
+    else if (!strcmp(argv[i], "--drop"))
+    {
+      i ++;
+      if (i >= argc || atof(argv[i]) < 0.0 || atof(argv[i]) > 100.0)
+      {
+        puts("ippeveshaper: Expected percentage after '--drop'.");
+        usage();
+        return (1);
+      }
+
+      shaper_drop = atof(argv[i]) / 100.0;
+    }
+    else if (!strcmp(argv[i], "--help"))
+    {
+      usage();
+      return (0);
+    }
+    else if (!strcmp(argv[i], "--jitter"))
+    {
+      i ++;
+      if (i >= argc || atof(argv[i]) < 0.0)
+      {
+        puts("ippeveshaper: Expected milliseconds after '--jitter'.");
+        usage();
+        return (1);
+      }
+
+      shaper_jitter = atof(argv[i]) / 2000.0;
+    }
+    else if (!strcmp(argv[i], "--latency"))
+    {
+      i ++;
+      if (i >= argc || atof(argv[i]) < 0.0)
+      {
+        puts("ippeveshaper: Expected milliseconds after '--latency'.");
+        usage();
+        return (1);
+      }
+
+      shaper_latency = atof(argv[i]) / 2000.0;
+    }
+    else if (!strcmp(argv[i], "--profile"))
+    {
+      i ++;
+      if (i >= argc)
+      {
+        puts("ippeveshaper: Expected profile name after '--profile'.");
+        usage();
+        return (1);
+      }
+
+      for (j = 0; j < (sizeof(shaper_profiles) / sizeof(shaper_profiles[0])); j ++)
+      {
+        if (!strcmp(argv[i], shaper_profiles[j].name))
+          break;
+      }
+
+      if (j >= (sizeof(shaper_profiles) / sizeof(shaper_profiles[0])))
+      {
+        printf("ippeveshaper: Unknown profile '%s'.\n", argv[i]);
+        usage();
+        return (1);
+      }
+
+      shaper_latency   = shaper_profiles[j].latency / 2000.0;
+      shaper_jitter    = shaper_profiles[j].jitter / 2000.0;
+      shaper_bandwidth = shaper_profiles[j].bandwidth * 125.0;
+      shaper_drop      = shaper_profiles[j].drop / 100.0;
+    }
+    else if (!strcmp(argv[i], "-n"))
+    {
+      i ++;
+      if (i >= argc)
+      {
+        puts("ippeveshaper: Expected name after '-n'.");
+        usage();
+        return (1);
+      }
+
+      name = argv[i];
+    }
+    else if (!strcmp(argv[i], "-p"))
+    {
+      i ++;
+      if (i >= argc || (port = atoi(argv[i])) < 1 || port > 65535)
+      {
+        puts("ippeveshaper: Expected port number after '-p'.");
+        usage();
+        return (1);
+      }
+    }
+    else if (!strcmp(argv[i], "-v"))
+    {
+      shaper_verbose = true;
+    }
+    else if (argv[i][0] == '-')
+    {
+      printf("ippeveshaper: Unknown option '%s'.\n", argv[i]);
+      usage();
+      return (1);
+    }
+    else if (!printer)
+    {
+      printer = argv[i];
+    }
+    else
+    {
+      printf("ippeveshaper: Unknown argument '%s'.\n", argv[i]);
+      usage();
+      return (1);
+    }
+  }
+
+  if (!printer)
+  {
+    usage();
+    return (1);
+  }
+
+  // Find the printer...
+  cupsCopyString(host, printer, sizeof(host));
+
+  if ((ptr = strrchr(host, ':')) != NULL && ptr[1] && strspn(ptr + 1, "0123456789") == strlen(ptr + 1))
+  {
+    // host:port or [address]:port...
+    *ptr++      = '\0';
+    shaper_port = atoi(ptr);
+
+    if (host[0] == '[' && (ptr = strchr(host, ']')) != NULL)
+    {
+      *ptr = '\0';
+      memmove(host, host + 1, strlen(host));
+    }
+
+    if (name)
+    {
+      puts("ippeveshaper: Cannot advertise a printer with '-n' without its DNS-SD name.");
+      return (1);
+    }
+  }
+  else if (!dnssd_get_service(printer, false, host, sizeof(host), &shaper_port, &num_txt, &txt))
+  {
+    printf("ippeveshaper: Unable to find printer '%s'.\n", printer);
+    return (1);
+  }
+  else if (name)
+  {
+    ipps = dnssd_get_service(printer, true, ipps_host, sizeof(ipps_host), &ipps_port, &num_ipps_txt, &ipps_txt);
+  }
+
+  shaper_host = host;
+
+  // Listen for connections...
+  if ((lfd = shaper_listen(port)) < 0)
+  {
+    printf("ippeveshaper: Unable to listen on port %d: %s\n", port, strerror(errno));
+    cupsFreeOptions(num_txt, txt);
+    cupsFreeOptions(num_ipps_txt, ipps_txt);
+    return (1);
+  }
+
+  if (name)
+  {
+    // Advertise the proxy in place of the printer...
+    if ((dnssd = cupsDNSSDNew(NULL, NULL)) == NULL || (service = cupsDNSSDServiceNew(dnssd, CUPS_DNSSD_IF_INDEX_ANY, name, shaper_service_cb, NULL)) == NULL || !cupsDNSSDServiceAdd(service, "_ipp._tcp,_print", NULL, NULL, (uint16_t)port, num_txt, txt) || (ipps && !cupsDNSSDServiceAdd(service, "_ipps._tcp,_print", NULL, NULL, (uint16_t)port, num_ipps_txt, ipps_txt)) || !cupsDNSSDServicePublish(service))
+    {
+      printf("ippeveshaper: Unable to advertise '%s'.\n", name);
+      cupsDNSSDDelete(dnssd);
+      cupsFreeOptions(num_txt, txt);
+      cupsFreeOptions(num_ipps_txt, ipps_txt);
+      close(lfd);
+      return (1);
+    }
+  }
+
+  cupsFreeOptions(num_txt, txt);
+  cupsFreeOptions(num_ipps_txt, ipps_txt);
+
+  if (shaper_bandwidth > 0.0)
+    snprintf(bandwidth, sizeof(bandwidth), "%.0f kbit/s", shaper_bandwidth / 125.0);
+  else
+    cupsCopyString(bandwidth, "unlimited bandwidth", sizeof(bandwidth));
+
+  printf("Relaying port %d to %s:%d with %.0fms latency, %.0fms jitter, %s, and %.1f%% dropped connections.\n", port, shaper_host, shaper_port, shaper_latency * 2000.0, shaper_jitter * 2000.0, bandwidth, shaper_drop * 100.0);
+  fflush(stdout);
+
+  signal(SIGINT, shaper_signal);
+  signal(SIGTERM, shaper_signal);
+  signal(SIGPIPE, SIG_IGN);
+
+  srandom((unsigned)time(NULL));
+
+  // Accept connections until stopped...
+  pfd.fd     = lfd;
+  pfd.events = POLLIN;
+
+  while (!shaper_stop)
+  {
+    if (poll(&pfd, 1, 1000) <= 0)
+      continue;
+
+    if ((fd = accept(lfd, NULL, NULL)) < 0)
+      continue;
+
+    if ((conn = (_shaper_conn_t *)calloc(1, sizeof(_shaper_conn_t))) == NULL)
+    {
+      close(fd);
+      continue;
+    }
+
+    conn->dirs[0].in      = fd;
+    conn->dirs[0].request = true;
+    conn->dirs[1].out     = fd;
+
+    if ((conn->dirs[0].out = conn->dirs[1].in = shaper_connect()) < 0)
+    {
+      printf("ippeveshaper: Unable to connect to %s:%d: %s\n", shaper_host, shaper_port, strerror(errno));
+      close(fd);
+      free(conn);
+      continue;
+    }
+
+    cupsMutexLock(&shaper_mutex);
+    conn->number = ++ shaper_num_conns;
+    cupsMutexUnlock(&shaper_mutex);
+
+    cupsThreadDetach(cupsThreadCreate((cups_thread_func_t)shaper_run, conn));
+  }
+
+  close(lfd);
+
+  if (dnssd)
+    cupsDNSSDDelete(dnssd);
+
+  shaper_summary();
+
+  return (0);
+}
+
+
+//
+// 'shaper_connect()' - Connect to the printer.
+//
+
+static int				// O - Socket or `-1` on error
+shaper_connect(void)
+{
+  char		service[32];		// Port number string
+  struct addrinfo hints,		// Address hints
+		*addrs,			// Addresses
+		*addr;			// Current address
+  int		fd = -1,		// Socket
+		val = 1;		// Option value
+
+
+  snprintf(service, sizeof(service), "%d", shaper_port);
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family   = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  if (getaddrinfo(shaper_host, service, &hints, &addrs))
+    return (-1);
+
+  for (addr = addrs; addr; addr = addr->ai_next)
+  {
+    if ((fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol)) < 0)
+      continue;
+
+    if (!connect(fd, addr->ai_addr, addr->ai_addrlen))
+      break;
+
+    close(fd);
+    fd = -1;
+  }
+
+  freeaddrinfo(addrs);
+
+  // Only the simulated latency should delay small messages...
+  if (fd >= 0)
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &val, sizeof(val));
+
+  return (fd);
+}
+
+
+//
+// 'shaper_done()' - Finish an HTTP message.
+//
+// Requests are queued until their response is done and then recorded.
+//
+
+static void
+shaper_done(_shaper_conn_t *conn,	// I - Connection
+            _shaper_dir_t  *dir,	// I - Direction
+            double         deliver)	// I - Delivery time of the last byte
+{
+  _shaper_request_t *request;		// Request
+  int		op;			// IPP operation
+  bool		ipp;			// IPP response?
+  ipp_status_t	status;			// IPP status
+
+
+  if (dir->request)
+  {
+    if (conn->num_pending < SHAPER_MAX_PENDING)
+    {
+      request = conn->pending + (conn->first_pending + conn->num_pending) % SHAPER_MAX_PENDING;
+      conn->num_pending ++;
+
+      request->ipp = dir->ipplen >= 4 && !strcmp(dir->method, "POST");
+
+      if (request->ipp)
+      {
+        op = (dir->ipp[2] << 8) | dir->ipp[3];
+        cupsCopyString(request->name, ippOpString((ipp_op_t)op), sizeof(request->name));
+      }
+      else
+      {
+        cupsCopyString(request->name, dir->method, sizeof(request->name));
+      }
+
+      request->bytes = dir->bytes;
+      request->start = dir->start;
+    }
+  }
+  else if (conn->num_pending > 0)
+  {
+    request = conn->pending + conn->first_pending;
+    conn->first_pending = (conn->first_pending + 1) % SHAPER_MAX_PENDING;
+    conn->num_pending --;
+
+    shaper_record(request->name, request->bytes, dir->bytes, deliver - request->start);
+
+    if (shaper_verbose)
+    {
+      ipp    = request->ipp && dir->ipplen >= 4;
+      status = ipp ? (ipp_status_t)((dir->ipp[2] << 8) | dir->ipp[3]) : IPP_STATUS_OK;
+
+      cupsMutexLock(&shaper_mutex);
+      printf("[%d] %s: sent %u bytes, received %u bytes (HTTP %d%s%s) in %.1fms\n", conn->number, request->name, (unsigned)request->bytes, (unsigned)dir->bytes, dir->status, ipp ? ", " : "", ipp ? ippErrorString(status) : "", 1000.0 * (deliver - request->start));
+      fflush(stdout);
+      cupsMutexUnlock(&shaper_mutex);
+    }
+  }
+
+  dir->active = false;
+  dir->bytes  = 0;
+
+  if (dir->state != _SHAPER_STATE_OPAQUE)
+    dir->state = _SHAPER_STATE_HEADER;
+}
+
+
+//
+// 'shaper_line()' - Process a complete line of an HTTP message.
+//
+
+static void
+shaper_line(_shaper_conn_t *conn,	// I - Connection
+            _shaper_dir_t  *dir,	// I - Direction
+            double         deliver)	// I - Delivery time
+{
+  char	*ptr;				// Pointer into line
+
+
+  // Strip the trailing CR...
+  if (dir->linelen > 0 && dir->line[dir->linelen - 1] == '\r')
+    dir->linelen --;
+
+  dir->line[dir->linelen] = '\0';
+  dir->linelen            = 0;
+
+  switch (dir->state)
+  {
+    case _SHAPER_STATE_HEADER :
+        if (dir->line[0])
+        {
+          if (dir->first_line)
+          {
+            // Request or status line...
+            dir->first_line = false;
+
+            if (dir->request)
+            {
+              cupsCopyString(dir->method, dir->line, sizeof(dir->method));
+              if ((ptr = strchr(dir->method, ' ')) != NULL)
+                *ptr = '\0';
+            }
+            else if ((ptr = strchr(dir->line, ' ')) != NULL)
+            {
+              dir->status = atoi(ptr + 1);
+            }
+          }
+          else if (!strncasecmp(dir->line, "Content-Length:", 15))
+          {
+            dir->content_length = strtol(dir->line + 15, NULL, 10);
+          }
+          else if (!strncasecmp(dir->line, "Transfer-Encoding:", 18) && strstr(dir->line + 18, "chunked"))
+          {
+            dir->chunked = true;
+          }
+        }
+        else if (!dir->request && dir->status == 101)
+        {
+          // Upgraded to TLS, nothing more can be followed...
+          shaper_done(conn, dir, deliver);
+
+          conn->dirs[0].state = _SHAPER_STATE_OPAQUE;
+          conn->dirs[1].state = _SHAPER_STATE_OPAQUE;
+          conn->opaque_start  = deliver;
+        }
+        else if (!dir->request && dir->status >= 100 && dir->status < 200)
+        {
+          // Interim response like "100 Continue", the final response follows...
+          dir->first_line     = true;
+          dir->chunked        = false;
+          dir->content_length = -1;
+        }
+        else if (dir->chunked)
+        {
+          dir->state = _SHAPER_STATE_CHUNK_SIZE;
+        }
+        else if (dir->content_length > 0)
+        {
+          dir->state     = _SHAPER_STATE_LENGTH;
+          dir->remaining = (size_t)dir->content_length;
+        }
+        else
+        {
+          shaper_done(conn, dir, deliver);
+        }
+        break;
+
+    case _SHAPER_STATE_CHUNK_SIZE :
+        if ((dir->remaining = (size_t)strtoul(dir->line, NULL, 16)) > 0)
+          dir->state = _SHAPER_STATE_CHUNK_DATA;
+        else
+          dir->state = _SHAPER_STATE_TRAILER;
+        break;
+
+    case _SHAPER_STATE_CHUNK_END :
+        dir->state = _SHAPER_STATE_CHUNK_SIZE;
+        break;
+
+    case _SHAPER_STATE_TRAILER :
+        if (!dir->line[0])
+          shaper_done(conn, dir, deliver);
+        break;
+
+    default :
+        break;
+  }
+}
+
+
+//
+// 'shaper_listen()' - Listen for connections on all addresses.
+//
+
+static int				// O - Socket or `-1` on error
+shaper_listen(int port)			// I - Port number
+{
+  int			fd,		// Socket
+			val = 1;	// Option value
+  struct sockaddr_in6	addr6;		// IPv6 address
+  struct sockaddr_in	addr4;		// IPv4 address
+
+
+  // Try IPv6 first, which also accepts IPv4 connections...
+  if ((fd = socket(AF_INET6, SOCK_STREAM, 0)) >= 0)
+  {
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(val));
+    val = 0;
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &val, sizeof(val));
+
+    memset(&addr6, 0, sizeof(addr6));
+    addr6.sin6_family = AF_INET6;
+    addr6.sin6_addr   = in6addr_any;
+    addr6.sin6_port   = htons((uint16_t)port);
+
+    if (!bind(fd, (struct sockaddr *)&addr6, sizeof(addr6)) && !listen(fd, 128))
+      return (fd);
+
+    close(fd);
+  }
+
+  if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+    return (-1);
+
+  val = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(val));
+
+  memset(&addr4, 0, sizeof(addr4));
+  addr4.sin_family      = AF_INET;
+  addr4.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr4.sin_port        = htons((uint16_t)port);
+
+  if (!bind(fd, (struct sockaddr *)&addr4, sizeof(addr4)) && !listen(fd, 128))
+    return (fd);
+
+  close(fd);
+
+  return (-1);
+}
+
+
+//
+// 'shaper_parse()' - Follow the HTTP messages in the data read.
+//
+// Returns `false` when the connection should be dropped.
+//
+
+static bool				// O - `true` to relay, `false` to drop
+shaper_parse(_shaper_conn_t      *conn,	// I - Connection
+             _shaper_dir_t       *dir,	// I - Direction
+             const unsigned char *data,	// I - Data
+             size_t              length,// I - Length of data
+             double              deliver)
+					// I - Delivery time
+{
+  const unsigned char	*ptr,		// Pointer into data
+			*end;		// End of data
+  size_t		count,		// Number of bytes
+			ippcount;	// Number of IPP bytes to keep
+
+
+  for (ptr = data, end = data + length; ptr < end;)
+  {
+    if (dir->state == _SHAPER_STATE_OPAQUE)
+    {
+      dir->bytes += (size_t)(end - ptr);
+      break;
+    }
+
+    if (!dir->active)
+    {
+      // Start of a new message...
+      if (dir->request)
+      {
+        if (*ptr == 0x16)
+        {
+          // TLS handshake on an "ipps" connection...
+          conn->dirs[0].state = _SHAPER_STATE_OPAQUE;
+          conn->dirs[1].state = _SHAPER_STATE_OPAQUE;
+          conn->opaque_start  = runner_get_time();
+          continue;
+        }
+
+        if (shaper_drop > 0.0 && random() < shaper_drop * RAND_MAX)
+          return (false);
+      }
+
+      dir->active         = true;
+      dir->first_line     = true;
+      dir->chunked        = false;
+      dir->content_length = -1;
+      dir->status         = 0;
+      dir->ipplen         = 0;
+      dir->method[0]      = '\0';
+      dir->start          = runner_get_time();
+    }
+
+    switch (dir->state)
+    {
+      case _SHAPER_STATE_LENGTH :
+      case _SHAPER_STATE_CHUNK_DATA :
+          if ((count = (size_t)(end - ptr)) > dir->remaining)
+            count = dir->remaining;
+
+          if (dir->ipplen < sizeof(dir->ipp))
+          {
+            // Keep the start of the IPP message for the operation or status...
+            if ((ippcount = sizeof(dir->ipp) - dir->ipplen) > count)
+              ippcount = count;
+
+            memcpy(dir->ipp + dir->ipplen, ptr, ippcount);
+            dir->ipplen += ippcount;
+          }
+
+          ptr            += count;
+          dir->bytes     += count;
+          dir->remaining -= count;
+
+          if (dir->remaining == 0)
+          {
+            if (dir->state == _SHAPER_STATE_LENGTH)
+              shaper_done(conn, dir, deliver);
+            else
+              dir->state = _SHAPER_STATE_CHUNK_END;
+          }
+          break;
+
+      default :
+          // Line-oriented states...
+          dir->bytes ++;
+
+          if (*ptr == '\n')
+            shaper_line(conn, dir, deliver);
+          else if (dir->linelen < (sizeof(dir->line) - 1))
+            dir->line[dir->linelen ++] = (char)*ptr;
+
+          ptr ++;
+          break;
+    }
+  }
+
+  return (true);
+}
+
+
+//
+// 'shaper_record()' - Record the statistics for a request.
+//
+
+static void
+shaper_record(const char *name,		// I - Operation or method name
+              size_t     sent,		// I - Bytes sent to the printer
+              size_t     received,	// I - Bytes received from the printer
+              double     elapsed)	// I - Elapsed time in seconds
+{
+  size_t	i;			// Looping var
+  _shaper_op_t	*op;			// Operation statistics
+
+
+  cupsMutexLock(&shaper_mutex);
+
+  for (i = 0, op = shaper_ops; i < shaper_num_ops; i ++, op ++)
+  {
+    if (!strcmp(op->name, name))
+      break;
+  }
+
+  if (i >= shaper_num_ops)
+  {
+    if (shaper_num_ops >= (sizeof(shaper_ops) / sizeof(shaper_ops[0])))
+    {
+      cupsMutexUnlock(&shaper_mutex);
+      return;
+    }
+
+    op = shaper_ops + shaper_num_ops;
+    shaper_num_ops ++;
+
+    cupsCopyString(op->name, name, sizeof(op->name));
+  }
+
+  op->count ++;
+  op->sent     += sent;
+  op->received += received;
+  op->total    += elapsed;
+
+  if (elapsed > op->maximum)
+    op->maximum = elapsed;
+
+  cupsMutexUnlock(&shaper_mutex);
+}
+
+
+//
+// 'shaper_run()' - Relay a connection.
+//
+
+static void *				// O - Thread exit status
+shaper_run(_shaper_conn_t *conn)	// I - Connection
+{
+  size_t	i;			// Looping var
+  _shaper_dir_t	*dir;			// Current direction
+  _shaper_chunk_t *chunk;		// Current chunk
+  struct pollfd	pfds[2];		// Poll data
+  _shaper_dir_t	*pdirs[2];		// Direction for each poll entry
+  int		num_pfds,		// Number of poll entries
+		timeout;		// Poll timeout in milliseconds
+  ssize_t	bytes;			// Bytes read or written
+  double	now,			// Current time
+		next,			// Next delivery time
+		start,			// Start of transmission
+		deliver;		// Delivery time
+  bool		dropped = false;	// Was the connection dropped?
+
+
+  for (;;)
+  {
+    // Send the data that is due...
+    now  = runner_get_time();
+    next = 0.0;
+
+    for (i = 0; i < 2; i ++)
+    {
+      dir = conn->dirs + i;
+
+      while ((chunk = dir->first) != NULL && chunk->deliver <= now)
+      {
+        if ((bytes = write(dir->out, chunk->data + chunk->offset, chunk->length - chunk->offset)) < 0)
+        {
+          if (errno == EINTR || errno == EAGAIN)
+            continue;
+
+          dropped = true;
+          break;
+        }
+
+        if ((chunk->offset += (size_t)bytes) < chunk->length)
+          continue;
+
+        dir->queued -= chunk->length;
+        if ((dir->first = chunk->next) == NULL)
+          dir->last = NULL;
+
+        free(chunk);
+      }
+
+      if (dir->first && (next == 0.0 || dir->first->deliver < next))
+        next = dir->first->deliver;
+
+      if (dir->eof && !dir->first && !dir->shut)
+      {
+        // Pass on the end of the data...
+        shutdown(dir->out, SHUT_WR);
+        dir->shut = true;
+      }
+    }
+
+    if (dropped || (conn->dirs[0].shut && conn->dirs[1].shut))
+      break;
+
+    // Wait for data or the next delivery...
+    for (i = 0, num_pfds = 0; i < 2; i ++)
+    {
+      dir = conn->dirs + i;
+
+      if (!dir->eof && dir->queued < SHAPER_MAX_QUEUED)
+      {
+        pfds[num_pfds].fd     = dir->in;
+        pfds[num_pfds].events = POLLIN;
+        pdirs[num_pfds ++]    = dir;
+      }
+    }
+
+    if (next > 0.0)
+      timeout = (int)(1000.0 * (next - now)) + 1;
+    else
+      timeout = 1000;
+
+    if (poll(pfds, (nfds_t)num_pfds, timeout) <= 0)
+      continue;
+
+    for (i = 0; i < (size_t)num_pfds; i ++)
+    {
+      if (!pfds[i].revents)
+        continue;
+
+      dir = pdirs[i];
+
+      if ((chunk = (_shaper_chunk_t *)malloc(sizeof(_shaper_chunk_t))) == NULL)
+      {
+        dropped = true;
+        break;
+      }
+
+      if ((bytes = read(dir->in, chunk->data, sizeof(chunk->data))) <= 0)
+      {
+        free(chunk);
+
+        if (bytes < 0 && (errno == EINTR || errno == EAGAIN))
+          continue;
+
+        dir->eof = true;
+        continue;
+      }
+
+      // Hold the data back for the transmission time, latency, and jitter...
+      now   = runner_get_time();
+      start = dir->link_free > now ? dir->link_free : now;
+
+      dir->link_free = start + (shaper_bandwidth > 0.0 ? bytes / shaper_bandwidth : 0.0);
+      deliver        = dir->link_free + shaper_latency + shaper_jitter * (2.0 * random() / RAND_MAX - 1.0);
+
+      if (deliver < dir->link_free)
+        deliver = dir->link_free;
+      if (deliver < dir->last_deliver)
+        deliver = dir->last_deliver;	// Keep the data in order
+
+      dir->last_deliver = deliver;
+
+      chunk->next    = NULL;
+      chunk->deliver = deliver;
+      chunk->length  = (size_t)bytes;
+      chunk->offset  = 0;
+
+      if (!shaper_parse(conn, dir, chunk->data, chunk->length, deliver))
+      {
+        // Drop the connection without relaying the request...
+        free(chunk);
+
+        cupsMutexLock(&shaper_mutex);
+        shaper_num_dropped ++;
+        if (shaper_verbose)
+          printf("[%d] Dropped connection.\n", conn->number);
+        cupsMutexUnlock(&shaper_mutex);
+
+        dropped = true;
+        break;
+      }
+
+      if (dir->last)
+        dir->last->next = chunk;
+      else
+        dir->first = chunk;
+
+      dir->last   = chunk;
+      dir->queued += chunk->length;
+    }
+
+    if (dropped)
+      break;
+  }
+
+  if (conn->dirs[0].state == _SHAPER_STATE_OPAQUE)
+    shaper_record("(encrypted)", conn->dirs[0].bytes, conn->dirs[1].bytes, conn->dirs[1].last_deliver > conn->opaque_start ? conn->dirs[1].last_deliver - conn->opaque_start : 0.0);
+
+  for (i = 0; i < 2; i ++)
+  {
+    dir = conn->dirs + i;
+
+    while ((chunk = dir->first) != NULL)
+    {
+      dir->first = chunk->next;
+      free(chunk);
+    }
+  }
+
+  close(conn->dirs[0].in);
+  close(conn->dirs[0].out);
+  free(conn);
+
+  return (NULL);
+}
+
+
+//
+// 'shaper_service_cb()' - Report DNS-SD service registration problems.
+//
+
+static void
+shaper_service_cb(
+    cups_dnssd_service_t *service,	// I - Service
+    void                 *cb_data,	// I - Callback data (unused)
+    cups_dnssd_flags_t   flags)		// I - Flags
+{
+  (void)service;
+  (void)cb_data;
+
+  if (flags & CUPS_DNSSD_FLAGS_COLLISION)
+    puts("ippeveshaper: DNS-SD name collision, use a different name with '-n'.");
+  else if (flags & CUPS_DNSSD_FLAGS_ERROR)
+    puts("ippeveshaper: Unable to register DNS-SD service.");
+}
+
+
+//
+// 'shaper_signal()' - Stop the proxy.
+//
+
+static void
+shaper_signal(int sig)			// I - Signal
+{
+  (void)sig;
+
+  shaper_stop = true;
+}
+
+
+//
+// 'shaper_summary()' - Show the statistics for each operation.
+//
+
+static void
+shaper_summary(void)
+{
+  size_t	i;			// Looping var
+  _shaper_op_t	*op;			// Operation statistics
+
+
+  cupsMutexLock(&shaper_mutex);
+
+  printf("\n%-32s %7s %12s %12s %10s %10s\n", "Operation", "Count", "Sent KB", "Received KB", "Avg ms", "Max ms");
+
+  for (i = 0, op = shaper_ops; i < shaper_num_ops; i ++, op ++)
+    printf("%-32s %7u %12.1f %12.1f %10.1f %10.1f\n", op->name, (unsigned)op->count, op->sent / 1024.0, op->received / 1024.0, 1000.0 * op->total / op->count, 1000.0 * op->maximum);
+
+  printf("\nRelayed %d connections, dropped %d.\n", shaper_num_conns, shaper_num_dropped);
+
+  cupsMutexUnlock(&shaper_mutex);
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static void
+usage(void)
+{
+  puts("Usage: ippeveshaper [options] {\"Printer Name\"|host:port}");
+  puts("");
+  puts("Options:");
+  puts("  --bandwidth KBITS        Limit each direction to KBITS kilobits per second.");
+  puts("  --drop PERCENT           Drop PERCENT of the connections at the start of a request.");
+  puts("  --help                   Show help.");
+  puts("  --jitter MS              Vary the latency by up to MS milliseconds.");
+  puts("  --latency MS             Add MS milliseconds of round-trip latency.");
+  puts("  --profile NAME           Use the lan, lab, wan, or lossy network profile.");
+  puts("  -n \"Name\"                Advertise the proxy as a DNS-SD printer.");
+  puts("  -p PORT                  Listen on PORT (default 8631).");
+  puts("  -v                       Show each request.");
+}
@@ -10,44 +10,205 @@
 // Usage:
 //
 //   ippevesubmit [options] "Printer Name"
+//   ippevesubmit [options] -b {manifest.txt|directory}
 //
 // Options:
 //
+//    --fail-fast              Stop validating at the first failure.
 //    --help		       Show help.
+//    --no-cache               Do not use or update the validation cache.
 //    --override               Override test results for granted exception.
+//    --split                  Write one JSON file per printer in batch mode.
+//    --validate               Only validate the test results.
+//    -b manifest.txt          Submit the printers listed in the manifest.
+//    -b directory             Submit the printers with results in the
+//                             directory.
 //    -f standard              The standard firmware includes IPP Everywhere
 //                             support.
 //    -f update                A firmware update may be needed.
+//    -j workers               Number of batch workers (default 4).
 //    -m models.txt	       Specify list of models, one per line.
 //    -o filename.json	       Specify the JSON output file, otherwise JSON is
-//			       sent to 'printer name.json'.
+//			       sent to 'printer name.json' or 'Batch.json'.
 //    -p "product family"      Specify the product family.
-//    -r {dnssd|document|ipp}  Replay the results of the specified tests.
+//    -r {dnssd|document|ipp|stress}
+//                             Replay the results of the specified tests.
 //    -t {printer|server}      Submit for a printer or print server.
 //    -u URL		       Specify the product family web page.
 //    -y		       Answer yes to the checklist questions.
 //
 
 #include "selfcert.h"
+#include <cups/dir.h>
+#include <cups/thread.h>
+#include <stdarg.h>
 
 
 // Local types...
-typedef enum media_format_e		// Media Format
+typedef struct _batch_printer_s		// Batch printer
 {
-  MEDIA_FORMAT_SMALL,			// Small media (<A3/Tabloid)
-  MEDIA_FORMAT_MEDIUM,			// Medium media (<A1/D)
-  MEDIA_FORMAT_LARGE			// Large media (A1/D and larger)
-} media_format_t;
+  char		name[256],		// Printer name
+		family[256],		// Product family name
+		webpage[1024],		// Product family web page
+		models[1024];		// Models file, if any
+  summary_t	dnssd,			// DNS-SD test results summary
+		ipp,			// IPP test results summary
+		document;		// Document test results summary
+  time_t	mtime;			// Newest results modification time
+  bool		ok;			// Are test results OK?
+  double	elapsed;		// Processing time in seconds
+} _batch_printer_t;
+
+typedef struct _batch_s			// Batch of printers
+{
+  cups_mutex_t	mutex;			// Mutex for next printer
+  char		directory[1024];	// Results directory
+  size_t	num_printers,		// Number of printers
+		alloc_printers,		// Allocated printers
+		next_printer;		// Next printer to process
+  _batch_printer_t *printers;		// Printers
+  int		print_server;		// Product is a print server
+  bool		use_cache;		// Use the validation cache?
+} _batch_t;
+
+typedef enum _fin_e			// Finishing classes
+{
+  _FIN_NONE = 0x00,			// Not a summarized finisher
+  _FIN_FOLD = 0x01,			// fold-xxx
+  _FIN_PUNCH = 0x02,			// punch-xxx
+  _FIN_STAPLE = 0x04,			// staple-xxx
+  _FIN_TRIM = 0x08			// trim-xxx
+} _fin_t;
+
+typedef struct _replay_latency_s	// Request latencies for an operation
+{
+  char		operation[64];		// Operation name
+  size_t	num_values,		// Number of latencies
+		alloc_values;		// Allocated latencies
+  double	*values;		// Latencies in seconds
+} _replay_latency_t;
+
+typedef struct _replay_throughput_s	// Job throughput for a document format
+{
+  char		format[128];		// Document format and compression
+  size_t	num_jobs;		// Number of jobs
+  long		impressions;		// Impressions completed
+  double	size,			// Bytes sent
+		rate_time,		// Seconds waiting for responses at "ResponseRate"
+		response_time,		// Seconds waiting for Print-Job responses
+		job_time;		// Seconds from Print-Job to job completion
+} _replay_throughput_t;
+
+typedef struct _submission_s		// Streaming JSON submission writer
+{
+  FILE		*fp;			// Output file
+  char		filename[1024],		// JSON filename
+		tempfile[1024];		// Temporary filename
+  size_t	num_models;		// Number of models written
+  char		*prefix,		// Shared fields before the model name
+		*suffix;		// Shared fields after the model name
+  bool		error;			// Did an allocation fail?
+} _submission_t;
+
+typedef enum _supported_e		// Summarized supported attributes
+{
+  _SUPPORTED_NONE,			// Not summarized
+  _SUPPORTED_COLOR,			// color-supported
+  _SUPPORTED_FINISHINGS,		// finishings-supported
+  _SUPPORTED_MEDIA,			// media-supported
+  _SUPPORTED_SIDES			// sides-supported
+} _supported_t;
+
+typedef struct _supported_hash_s	// Supported attribute hash entry
+{
+  const char	*name;			// Attribute name
+  _supported_t	attr;			// Summarized attribute
+} _supported_hash_t;
 
 
 // Local functions...
+static _batch_printer_t *batch_add(_batch_t *batch, const char *name, const char *family, const char *webpage, const char *models);
+static int	batch_compare(_batch_printer_t *a, _batch_printer_t *b);
+static void	batch_errors(FILE *fp, _batch_printer_t *printer);
+static bool	batch_load(_batch_t *batch, const char *path, const char *family, const char *webpage, const char *models);
+static void	*batch_run(_batch_t *batch);
+static int	compare_latency(double *a, double *b);
+static int	do_batch(const char *path, int num_workers, bool split, const char *json, const char *family, const char *webpage, const char *models, int print_server, int firmware_update, bool use_cache, bool override_tests);
 static void	error_cb(void *data, const char *message);
+static char	*format_date(time_t t, char *buffer, size_t bufsize);
+static bool	load_results(const char *directory, const char *printer, selfcert_suite_t suite, int print_server, bool use_cache, summary_t *summary, time_t *mtime);
+static const char *normalize_url(const char *url, char *buffer, size_t bufsize);
 static bool	read_boolean(const char *prompt);
 static char	*read_string(const char *prompt, FILE *fp, char *buffer, size_t bufsize);
+static _replay_latency_t *replay_latency(_replay_latency_t *latencies, size_t *num_latencies, _replay_latency_t *all, const char *operation, double value);
+static double	replay_percentile(_replay_latency_t *latency, int percent);
 static void	replay_results(const char *filename, plist_t *results);
+static _replay_throughput_t *replay_throughput(_replay_throughput_t *throughputs, size_t *num_throughputs, plist_t *test);
+static bool	replay_time(plist_t *dict, double *start, double *end);
+static bool	submission_finish(_submission_t *submission);
+static char	*submission_format(const char *format, ...) SELFCERT_FORMAT(1,2);
+static bool	submission_init(_submission_t *submission, const char *filename);
+static void	submission_model(_submission_t *submission, const char *model);
+static void	submission_printer(_submission_t *submission, const char *family, const char *webpage, int firmware_update, const summary_t *dnssd_summary, const summary_t *ipp_summary, const char *date);
+static char	*submission_string(const char *s);
+static summary_media_t summarize_media(const char *media);
+static void	summarize_supported(plist_t *supported, summary_t *summary);
 static void	usage(void);
 
 
+// Local globals...
+static const char * const suite_names[] =
+{					// Test suite names
+  "DNS-SD",
+  "IPP",
+  "Document"
+};
+
+#define SUPPORTED_HASH(name)	((unsigned char)(name)[0] % 9)
+					// Perfect hash for supported_hash[]
+static const _supported_hash_t supported_hash[9] =
+{					// Summarized attributes by hash
+  { "color-supported", _SUPPORTED_COLOR },
+					// 'c' % 9 = 0
+  { "media-supported", _SUPPORTED_MEDIA },
+					// 'm' % 9 = 1
+  { NULL, _SUPPORTED_NONE },
+  { "finishings-supported", _SUPPORTED_FINISHINGS },
+					// 'f' % 9 = 3
+  { NULL, _SUPPORTED_NONE },
+  { NULL, _SUPPORTED_NONE },
+  { NULL, _SUPPORTED_NONE },
+  { "sides-supported", _SUPPORTED_SIDES },
+					// 's' % 9 = 7
+  { NULL, _SUPPORTED_NONE }
+};
+
+static const unsigned char finishings_classes[102] =
+{					// Finishing classes for enum values 0 to 101
+  _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_STAPLE,	// 0-4
+  _FIN_PUNCH,  _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,	// 5-9
+  _FIN_FOLD,   _FIN_TRIM,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,	// 10-14
+  _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,	// 15-19
+  _FIN_STAPLE, _FIN_STAPLE, _FIN_STAPLE, _FIN_STAPLE, _FIN_NONE,	// 20-24
+  _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_STAPLE, _FIN_STAPLE,	// 25-29
+  _FIN_STAPLE, _FIN_STAPLE, _FIN_STAPLE, _FIN_STAPLE, _FIN_STAPLE,	// 30-34
+  _FIN_STAPLE, _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,	// 35-39
+  _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,	// 40-44
+  _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,	// 45-49
+  _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,	// 50-54
+  _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,	// 55-59
+  _FIN_TRIM,   _FIN_TRIM,   _FIN_TRIM,   _FIN_TRIM,   _FIN_NONE,	// 60-64
+  _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,   _FIN_NONE,	// 65-69
+  _FIN_PUNCH,  _FIN_PUNCH,  _FIN_PUNCH,  _FIN_PUNCH,  _FIN_PUNCH,	// 70-74
+  _FIN_PUNCH,  _FIN_PUNCH,  _FIN_PUNCH,  _FIN_PUNCH,  _FIN_PUNCH,	// 75-79
+  _FIN_PUNCH,  _FIN_PUNCH,  _FIN_PUNCH,  _FIN_PUNCH,  _FIN_PUNCH,	// 80-84
+  _FIN_PUNCH,  _FIN_PUNCH,  _FIN_PUNCH,  _FIN_PUNCH,  _FIN_PUNCH,	// 85-89
+  _FIN_FOLD,   _FIN_FOLD,   _FIN_FOLD,   _FIN_FOLD,   _FIN_FOLD,	// 90-94
+  _FIN_FOLD,   _FIN_FOLD,   _FIN_FOLD,   _FIN_FOLD,   _FIN_FOLD,	// 95-99
+  _FIN_FOLD,   _FIN_FOLD						// 100-101
+};
+
+
 //
 // 'main()' - Main entry for submission tool.
 //
@@ -64,48 +225,29 @@ main(int  argc,				// I - Number of command-line arguments
 		*printer = NULL,	// Printer being tested
 		*replay = NULL,		// Replay results
 		*webpage = NULL;	// Product family web page
+  const char	*batch = NULL;		// Batch manifest or directory
+  int		num_workers = 4;	// Number of batch workers
+  bool		fail_fast = false,	// Stop validating at the first failure?
+		split = false,		// Write one JSON file per printer?
+		use_cache = true,	// Use the validation cache?
+		validate = false;	// Only validate the test results?
   int		override_tests = 0,	// Test results were overridden
 		print_server = -1,	// Product is a print server
 		firmware_update = -1,	// Is a firmware update needed?
 		yes_to_all = 0;		// Answer "yes" to all checklist questions
   char		filename[1024];		// plist filename
   bool		ok = true;		// Are test results OK?
-  plist_t	*dnssd_results,		// DNS-SD test results
-		*ipp_results,		// IPP test results
-		*document_results,	// Document test results
-		*submission = NULL;	// Submission data
-  char		dnssd_errors[1024],	// DNS-SD tests that failed, if any
-		ipp_errors[1024],	// IPP tests that failed, if any
-		document_errors[1024];	// Document tests that failed, if any
-  char		response[1024];		// Response from user
+  summary_t	dnssd_summary,		// DNS-SD test results summary
+		ipp_summary,		// IPP test results summary
+		document_summary;	// Document test results summary
+  _submission_t	submission;		// Submission writer
+  char		response[1024],		// Response from user
+		url[1024];		// Product family web page URL
   FILE		*models_fp;		// Models file
   const char	*models_prompt;		// Prompt for models
-  plist_t	*fileid,		// FileId from the first test
-		*supported,		// Supported attributes
-		*color_supported,	// color-supported value
-		*finishings_supported,	// finishings-supported values
-		*ipps_supported,	// Is IPPS supported?
-		*media_supported,	// media-supported values
-		*sides_supported,	// sides-supported values
-		*value;			// Value from attributes
-  int		finishings_fold = 0,	// Folding?
-		finishings_punch = 0,	// Punching?
-		finishings_staple = 0,	// Stapling?
-		finishings_trim = 0;	// Trimming/cutting?
-  struct stat	fileinfo;		// PLIST file information
   time_t	submission_time;	// Date/time of submission (seconds)
-  struct tm	submission_tm;		// Date/time of submission (tm data)
-  char		submission_date[32],	// Date/time of submission (string)
-		submission_version[4];	// Version of the cert tools
-  media_format_t media_format = MEDIA_FORMAT_SMALL;
-					// Size class
+  char		submission_date[32];	// Date/time of submission (string)
   FILE		*fp;			// Output file
-  static const char * const media_formats[] =
-  {					// Size classes
-    "Small",
-    "Medium",
-    "Large"
-  };
 
 
 #if _WIN32
@@ -123,15 +265,31 @@ main(int  argc,				// I - Number of command-line arguments
   // Parse command-line...
   for (i = 1; i < argc; i ++)
   {
-    if (!strcmp(argv[i], "--help"))
+    if (!strcmp(argv[i], "--fail-fast"))
+    {
+      fail_fast = true;
+    }
+    else if (!strcmp(argv[i], "--help"))
     {
       usage();
       return (0);
     }
+    else if (!strcmp(argv[i], "--no-cache"))
+    {
+      use_cache = false;
+    }
     else if (!strcmp(argv[i], "--override"))
     {
       override_tests = 1;
     }
+    else if (!strcmp(argv[i], "--split"))
+    {
+      split = true;
+    }
+    else if (!strcmp(argv[i], "--validate"))
+    {
+      validate = true;
+    }
     else if (!strncmp(argv[i], "--", 2))
     {
       printf("ippevesubmit: Unknown option '%s'.\n", argv[i]);
@@ -144,6 +302,18 @@ main(int  argc,				// I - Number of command-line arguments
       {
 	switch (*opt)
 	{
+	  case 'b' : // -b {manifest.txt|directory}
+	      i ++;
+	      if (i >= argc)
+	      {
+		puts("ippevesubmit: Expected manifest or directory after '-b'.");
+		usage();
+		return (1);
+	      }
+
+	      batch = argv[i];
+	      break;
+
 	  case 'f' : // -f {standard|update}
 	      i ++;
 	      if (i >= argc || (strcmp(argv[i], "standard") && strcmp(argv[i], "update")))
@@ -156,6 +326,16 @@ main(int  argc,				// I - Number of command-line arguments
 	      firmware_update = !strcmp(argv[i], "update");
 	      break;
 
+	  case 'j' : // -j workers
+	      i ++;
+	      if (i >= argc || (num_workers = atoi(argv[i])) < 1)
+	      {
+		puts("ippevesubmit: Expected number of workers after '-j'.");
+		usage();
+		return (1);
+	      }
+	      break;
+
 	  case 'm' : // -m models.txt
 	      i ++;
 	      if (i >= argc)
@@ -198,11 +378,11 @@ main(int  argc,				// I - Number of command-line arguments
 	      family = argv[i];
 	      break;
 
-          case 'r' : // -r {dnssd|ipp|document}
+          case 'r' : // -r {dnssd|ipp|document|stress}
               i ++;
-              if (i >= argc || (strcmp(argv[i], "dnssd") && strcmp(argv[i], "document") && strcmp(argv[i], "ipp")))
+              if (i >= argc || (strcmp(argv[i], "dnssd") && strcmp(argv[i], "document") && strcmp(argv[i], "ipp") && strcmp(argv[i], "stress")))
               {
-                puts("ippevesubmit: Expected 'dnssd', 'document', or 'ipp' after '-r'.");
+                puts("ippevesubmit: Expected 'dnssd', 'document', 'ipp', or 'stress' after '-r'.");
                 usage();
                 return (1);
               }
@@ -257,6 +437,23 @@ main(int  argc,				// I - Number of command-line arguments
     }
   }
 
+  if (batch)
+  {
+    // Batch mode is not interactive...
+    if (printer || replay || validate)
+    {
+      puts("ippevesubmit: Cannot use '-b' with a printer name, '-r', or '--validate'.");
+      return (1);
+    }
+    else if (firmware_update < 0 || print_server < 0 || !yes_to_all)
+    {
+      puts("ippevesubmit: Batch mode requires '-f', '-t', and '-y'.");
+      return (1);
+    }
+
+    return (do_batch(batch, num_workers, split, json, family, webpage, models, print_server, firmware_update, use_cache, override_tests != 0));
+  }
+
   if (!printer)
   {
     usage();
@@ -272,6 +469,8 @@ main(int  argc,				// I - Number of command-line arguments
       snprintf(filename, sizeof(filename), "%s DNS-SD Results.plist", printer);
     else if (!strcmp(replay, "document"))
       snprintf(filename, sizeof(filename), "%s Document Results.plist", printer);
+    else if (!strcmp(replay, "stress"))
+      snprintf(filename, sizeof(filename), "%s Stress Results.plist", printer);
     else
       snprintf(filename, sizeof(filename), "%s IPP Results.plist", printer);
 
@@ -280,39 +479,58 @@ main(int  argc,				// I - Number of command-line arguments
     return (0);
   }
 
+  // Validate results without loading them if requested...
+  if (validate)
+  {
+    selfcert_suite_t	suite;		// Current test suite
+    char		errors[8192];	// Errors, if any
+    summary_t		summary;	// Cached summary
+
+    for (suite = SELFCERT_SUITE_DNSSD; suite <= SELFCERT_SUITE_DOCUMENT; suite ++)
+    {
+      snprintf(filename, sizeof(filename), "%s %s Results.plist", printer, suite_names[suite]);
+
+      if (use_cache && cache_get(filename, suite, &summary))
+        cupsCopyString(errors, summary.errors, sizeof(errors));
+      else
+        summary.valid = validate_results_file(filename, suite, fail_fast, errors, sizeof(errors));
+
+      if (summary.valid)
+      {
+        printf("\"%s\": PASS\n", filename);
+      }
+      else
+      {
+        printf("\"%s\": FAIL\n%s", filename, errors);
+        ok = false;
+
+        if (fail_fast)
+          break;
+      }
+    }
+
+    return (ok ? 0 : 1);
+  }
+
   // Load test results and validate...
   submission_time = 0;
 
-  snprintf(filename, sizeof(filename), "%s DNS-SD Results.plist", printer);
-  if (!stat(filename, &fileinfo) && fileinfo.st_mtime > submission_time)
-    submission_time = fileinfo.st_mtime;
-  dnssd_results = plist_read(NULL, filename, error_cb, NULL);
-  if (!validate_dnssd_results(filename, dnssd_results, print_server, dnssd_errors, sizeof(dnssd_errors)))
+  if (!load_results(NULL, printer, SELFCERT_SUITE_DNSSD, print_server, use_cache, &dnssd_summary, &submission_time))
     ok = false;
-
-  snprintf(filename, sizeof(filename), "%s IPP Results.plist", printer);
-  if (!stat(filename, &fileinfo) && fileinfo.st_mtime > submission_time)
-    submission_time = fileinfo.st_mtime;
-  ipp_results = plist_read(NULL, filename, error_cb, NULL);
-  if (!validate_ipp_results(filename, ipp_results, print_server, ipp_errors, sizeof(ipp_errors)))
+  if (!load_results(NULL, printer, SELFCERT_SUITE_IPP, print_server, use_cache, &ipp_summary, &submission_time))
     ok = false;
-
-  snprintf(filename, sizeof(filename), "%s Document Results.plist", printer);
-  if (!stat(filename, &fileinfo) && fileinfo.st_mtime > submission_time)
-    submission_time = fileinfo.st_mtime;
-  document_results = plist_read(NULL, filename, error_cb, NULL);
-  if (!validate_document_results(filename, document_results, print_server, document_errors, sizeof(document_errors)))
+  if (!load_results(NULL, printer, SELFCERT_SUITE_DOCUMENT, print_server, use_cache, &document_summary, &submission_time))
     ok = false;
 
   if (!ok && !override_tests)
   {
     puts("Unable to submit IPP Everywhere self-certification due to errors.\n");
-    if (dnssd_errors[0])
-      printf("DNS-SD errors:\n%s\n", dnssd_errors);
-    if (ipp_errors[0])
-      printf("IPP errors:\n%s\n", ipp_errors);
-    if (document_errors[0])
-      printf("Document errors:\n%s\n", document_errors);
+    if (dnssd_summary.errors[0])
+      printf("DNS-SD errors:\n%s\n", dnssd_summary.errors);
+    if (ipp_summary.errors[0])
+      printf("IPP errors:\n%s\n", ipp_summary.errors);
+    if (document_summary.errors[0])
+      printf("Document errors:\n%s\n", document_summary.errors);
 
     return (1);
   }
@@ -352,109 +570,48 @@ main(int  argc,				// I - Number of command-line arguments
     webpage = strdup(response);
   }
 
-  if (strncmp(webpage, "http://", 7) && strncmp(webpage, "https://", 8))
+  if ((opt = normalize_url(webpage, url, sizeof(url))) == NULL)
   {
-    if (strchr(webpage, '.'))
-    {
-      char	temp[1024];		// Temporary URL string
-
-      snprintf(temp, sizeof(temp), "https://%s/", webpage);
-      free((char *)webpage);
-      webpage = strdup(temp);
-    }
-    else
-    {
-      printf("ippevesubmit: Bad product URL '%s'.\n", webpage);
-      return (1);
-    }
+    printf("ippevesubmit: Bad product URL '%s'.\n", webpage);
+    return (1);
   }
 
- /*
-  * Look for the cert version in the IPP results...
-  */
-
-  if ((fileid = plist_find(ipp_results, "Tests/0/FileId")) != NULL && !strncmp(fileid->value, "org.pwg.ippeveselfcert", 22) && isdigit(fileid->value[22] & 255) && isdigit(fileid->value[23] & 255))
-    opt = fileid->value + 22;
-  else
-    opt = "??";
-
-  snprintf(submission_version, sizeof(submission_version), "%c.%c", opt[0], opt[1]);
-
- /*
-  * Look for IPPS support in the DNS-SD results...
-  */
-
-  ipps_supported = plist_find(dnssd_results, "Tests/4/Successful");
+  webpage = opt;
 
  /*
-  * Supported values from the IPP results...
+  * Open the JSON file for submission...
   */
 
-  supported	       = plist_find(ipp_results, "Tests/9/ResponseAttributes/1");
-  color_supported      = plist_find(supported, "color-supported");
-  finishings_supported = plist_find(supported, "finishings-supported");
-  media_supported      = plist_find(supported, "media-supported");
-  sides_supported      = plist_find(supported, "sides-supported");
-
-  if (finishings_supported)
+  if (!json)
   {
-   /*
-    * Look for specific kinds of finishers...
-    */
-
-    for (value = finishings_supported->first_child; value; value = value->next_sibling)
-    {
-      const char *keyword;		// Keyword value
-      if (isdigit(value->value[0] & 255))
-        keyword = ippEnumString("finishings", atoi(value->value));
-      else
-        keyword = value->value;
-
-      if (!strncmp(keyword, "fold", 4))
-	finishings_fold = 1;
-      else if (!strncmp(keyword, "punch", 5))
-	finishings_punch = 1;
-      else if (!strncmp(keyword, "staple", 6))
-	finishings_staple = 1;
-      else if (!strncmp(keyword, "trim", 4))
-	finishings_trim = 1;
-    }
+    snprintf(filename, sizeof(filename), "%s.json", printer);
+    json = filename;
   }
 
-  if (media_supported)
+  if (!submission_init(&submission, json))
   {
-   /*
-    * Look at the supported media sizes - large format is more than 22" wide,
-    * and medium format is more than 11" and less than 22" wide...
-    */
+    printf("ippevesubmit: Unable to create '%s': %s\n", json, strerror(errno));
+    return (1);
+  }
 
-    for (value = media_supported->first_child; value; value = value->next_sibling)
-    {
-      pwg_media_t *pwg = pwgMediaForPWG(value->value);
-					// Decoded PWG size name
+  fp = submission.fp;
 
-      if (!pwg)
-	continue;
+  if (override_tests)
+  {
+    fputs("// Note: submitted with --override\n", fp);
 
-      if (pwg->width > 43180)
-	media_format = MEDIA_FORMAT_LARGE;
-      else if (pwg->width > 22860 && media_format < MEDIA_FORMAT_MEDIUM)
-	media_format = MEDIA_FORMAT_MEDIUM;
-    }
+    if (dnssd_summary.errors[0])
+      fprintf(fp, "/* DNS-SD errors:\n%s*/\n", dnssd_summary.errors);
+    if (ipp_summary.errors[0])
+      fprintf(fp, "/* IPP errors:\n%s*/\n", ipp_summary.errors);
+    if (document_summary.errors[0])
+      fprintf(fp, "/* Document errors:\n%s*/\n", document_summary.errors);
   }
 
  /*
-  * Build the submission profile...
+  * Write the submission entries as the models are read...
   */
 
-  submission = plist_new();
-
-  if (!submission_time)
-    time(&submission_time);
-  gmtime_r(&submission_time, &submission_tm);
-
-  snprintf(submission_date, sizeof(submission_date), "%04d-%02d-%02dT%02d:%02d:%02dZ", submission_tm.tm_year + 1900, submission_tm.tm_mon + 1, submission_tm.tm_mday, submission_tm.tm_hour, submission_tm.tm_min, submission_tm.tm_sec);
-
   if (models)
   {
     models_fp	  = fopen(models, "r");
@@ -466,174 +623,306 @@ main(int  argc,				// I - Number of command-line arguments
     models_prompt = "First Model Name";
   }
 
+  format_date(submission_time, submission_date, sizeof(submission_date));
+
+  submission_printer(&submission, family, webpage, firmware_update, &dnssd_summary, &ipp_summary, submission_date);
+
   while (read_string(models_prompt, models_fp, response, sizeof(response)))
   {
     if (models_prompt)
       models_prompt = "Next Model Name (blank when done)";
 
-    plist_t *dict = plist_add(submission, PLIST_TYPE_DICT, NULL);
+    submission_model(&submission, response);
+  }
 
-    plist_add(dict, PLIST_TYPE_KEY, "family");
-    plist_add(dict, PLIST_TYPE_STRING, family);
+  if (models_fp && models_fp != stdin)
+    fclose(models_fp);
 
-    plist_add(dict, PLIST_TYPE_KEY, "model");
-    plist_add(dict, PLIST_TYPE_STRING, response);
+  if (!submission_finish(&submission))
+  {
+    printf("ippevesubmit: Unable to write '%s': %s\n", json, strerror(errno));
+    return (1);
+  }
+  else if (strcmp(json, "-"))
+  {
+    printf("\nWrote submission to '%s'.\n", json);
+  }
 
-    plist_add(dict, PLIST_TYPE_KEY, "url");
-    plist_add(dict, PLIST_TYPE_STRING, webpage);
+  puts("\nNow continue with your submission at:\n\n    https://www.pwg.org/ippeveselfcert\n");
 
-    plist_add(dict, PLIST_TYPE_KEY, "color");
-    plist_add(dict, PLIST_TYPE_STRING, (color_supported && color_supported->type == PLIST_TYPE_TRUE) ? "1" : "0");
+  return (0);
+}
 
-    plist_add(dict, PLIST_TYPE_KEY, "duplex");
-    plist_add(dict, PLIST_TYPE_STRING, plist_array_count(sides_supported) > 1 ? "1" : "0");
 
-    plist_add(dict, PLIST_TYPE_KEY, "finishings");
-    plist_add(dict, PLIST_TYPE_STRING, plist_array_count(finishings_supported) > 1 ? "1" : "0");
+//
+// 'batch_add()' - Add a printer to a batch.
+//
 
-    plist_add(dict, PLIST_TYPE_KEY, "fin_fold");
-    plist_add(dict, PLIST_TYPE_STRING, finishings_fold ? "1" : "0");
+static _batch_printer_t *		// O - New printer or `NULL` on error
+batch_add(_batch_t   *batch,		// I - Batch
+          const char *name,		// I - Printer name
+          const char *family,		// I - Product family name
+          const char *webpage,		// I - Product family web page
+          const char *models)		// I - Models file or `NULL` for none
+{
+  _batch_printer_t	*printer;	// New printer
 
-    plist_add(dict, PLIST_TYPE_KEY, "fin_punch");
-    plist_add(dict, PLIST_TYPE_STRING, finishings_punch ? "1" : "0");
 
-    plist_add(dict, PLIST_TYPE_KEY, "fin_staple");
-    plist_add(dict, PLIST_TYPE_STRING, finishings_staple ? "1" : "0");
+  if (batch->num_printers >= batch->alloc_printers)
+  {
+    if ((printer = (_batch_printer_t *)realloc(batch->printers, (batch->alloc_printers + 16) * sizeof(_batch_printer_t))) == NULL)
+      return (NULL);
 
-    plist_add(dict, PLIST_TYPE_KEY, "fin_trim");
-    plist_add(dict, PLIST_TYPE_STRING, finishings_trim ? "1" : "0");
+    batch->printers       = printer;
+    batch->alloc_printers += 16;
+  }
 
-    plist_add(dict, PLIST_TYPE_KEY, "ipps");
-    plist_add(dict, PLIST_TYPE_STRING, ipps_supported ? "1" : "0");
+  printer = batch->printers + batch->num_printers;
+  batch->num_printers ++;
 
-    plist_add(dict, PLIST_TYPE_KEY, "firmware_update");
-    plist_add(dict, PLIST_TYPE_STRING, firmware_update ? "1" : "0");
+  memset(printer, 0, sizeof(_batch_printer_t));
 
-    plist_add(dict, PLIST_TYPE_KEY, "media");
-    plist_add(dict, PLIST_TYPE_STRING, media_formats[media_format]);
+  cupsCopyString(printer->name, name, sizeof(printer->name));
+  cupsCopyString(printer->family, family, sizeof(printer->family));
+  cupsCopyString(printer->webpage, webpage, sizeof(printer->webpage));
 
-    plist_add(dict, PLIST_TYPE_KEY, "version");
-    plist_add(dict, PLIST_TYPE_STRING, submission_version);
+  if (models)
+    cupsCopyString(printer->models, models, sizeof(printer->models));
 
-    plist_add(dict, PLIST_TYPE_KEY, "date");
-    plist_add(dict, PLIST_TYPE_STRING, submission_date);
-  }
+  return (printer);
+}
 
- /*
-  * Write JSON file for submission...
-  */
 
-  if (!json)
-  {
-    snprintf(filename, sizeof(filename), "%s.json", printer);
-    json = filename;
-  }
+//
+// 'batch_compare()' - Compare two batch printers by name.
+//
 
-  if (!strcmp(json, "-"))
-    fp = stdout;
-  else
-    fp = fopen(json, "w");
+static int				// O - Result of comparison
+batch_compare(_batch_printer_t *a,	// I - First printer
+              _batch_printer_t *b)	// I - Second printer
+{
+  return (strcmp(a->name, b->name));
+}
+
+
+//
+// 'batch_errors()' - Write the errors for a printer as JSON comments.
+//
+
+static void
+batch_errors(FILE             *fp,	// I - Output file
+             _batch_printer_t *printer)	// I - Printer
+{
+  if (printer->dnssd.errors[0])
+    fprintf(fp, "/* \"%s\" DNS-SD errors:\n%s*/\n", printer->name, printer->dnssd.errors);
+  if (printer->ipp.errors[0])
+    fprintf(fp, "/* \"%s\" IPP errors:\n%s*/\n", printer->name, printer->ipp.errors);
+  if (printer->document.errors[0])
+    fprintf(fp, "/* \"%s\" Document errors:\n%s*/\n", printer->name, printer->document.errors);
+}
+
+
+//
+// 'batch_load()' - Load a batch manifest or directory.
+//
+// A manifest is a text file with one printer per line and tab-separated
+// fields:
+//
+//   Printer Name<TAB>Product Family<TAB>Web Page URL<TAB>models.txt
+//
+// Blank lines and lines starting with "#" are ignored.  Empty or missing
+// fields default to the "-p", "-u", and "-m" values, and the model name
+// defaults to the printer name.  The results files and relative models
+// files are found in the manifest's directory.
+//
+// A directory contains the results files for each printer, with an optional
+// "Printer Name Models.txt" file listing the models.
+//
 
-  if (!fp)
+static bool				// O - `true` on success, `false` on error
+batch_load(_batch_t   *batch,		// I - Batch
+           const char *path,		// I - Manifest or directory
+           const char *family,		// I - Default product family name
+           const char *webpage,		// I - Default product family web page
+           const char *models)		// I - Default models file
+{
+  struct stat	fileinfo;		// Manifest/directory information
+  char		*ptr;			// Pointer into string
+  int		linenum = 0;		// Line number in manifest
+  FILE		*fp;			// Manifest file
+  char		line[4096],		// Line from manifest
+		*fields[4],		// Fields from line
+		modelsfile[1024];	// Per-printer models file
+  size_t	i,			// Looping var
+		num_fields;		// Number of fields
+  cups_dir_t	*dir;			// Results directory
+  cups_dentry_t	*dent;			// Directory entry
+  static const char * const suffix = " IPP Results.plist";
+					// Filename suffix for printers
+
+
+  if (stat(path, &fileinfo))
   {
-    printf("ippevesubmit: Unable to create '%s': %s\n", json, strerror(errno));
-    return (1);
+    printf("ippevesubmit: Unable to access '%s': %s\n", path, strerror(errno));
+    return (false);
   }
 
-  if (override_tests)
+  if (S_ISDIR(fileinfo.st_mode))
   {
-    fputs("// Note: submitted with --override\n", fp);
+    // Look for "Printer Name IPP Results.plist" files...
+    cupsCopyString(batch->directory, path, sizeof(batch->directory));
 
-    if (dnssd_errors[0])
-      fprintf(fp, "/* DNS-SD errors:\n%s*/\n", dnssd_errors);
-    if (ipp_errors[0])
-      fprintf(fp, "/* IPP errors:\n%s*/\n", ipp_errors);
-    if (document_errors[0])
-      fprintf(fp, "/* Document errors:\n%s*/\n", document_errors);
-  }
+    if ((dir = cupsDirOpen(path)) == NULL)
+    {
+      printf("ippevesubmit: Unable to open '%s': %s\n", path, strerror(errno));
+      return (false);
+    }
 
-  plist_write_json(fp, json, submission, error_cb, NULL);
+    while ((dent = cupsDirRead(dir)) != NULL)
+    {
+      size_t len = strlen(dent->filename);
+					// Length of filename
 
-  if (fp != stdout)
-  {
-    fclose(fp);
-    printf("\nWrote submission to '%s'.\n", json);
+      if (len <= strlen(suffix) || strcmp(dent->filename + len - strlen(suffix), suffix))
+        continue;
+
+      cupsCopyString(line, dent->filename, sizeof(line));
+      line[len - strlen(suffix)] = '\0';
+
+      snprintf(modelsfile, sizeof(modelsfile), "%s/%s Models.txt", path, line);
+      if (access(modelsfile, R_OK))
+        cupsCopyString(modelsfile, models ? models : "", sizeof(modelsfile));
+
+      if (!batch_add(batch, line, family ? family : "", webpage ? webpage : "", modelsfile))
+      {
+        cupsDirClose(dir);
+        return (false);
+      }
+    }
+
+    cupsDirClose(dir);
+
+    // Directory order is arbitrary, so sort by name...
+    if (batch->num_printers > 1)
+      qsort(batch->printers, batch->num_printers, sizeof(_batch_printer_t), (int (*)(const void *, const void *))batch_compare);
   }
+  else
+  {
+    // Read the manifest...
+    cupsCopyString(batch->directory, path, sizeof(batch->directory));
+    if ((ptr = strrchr(batch->directory, '/')) != NULL)
+      *ptr = '\0';
+    else
+      batch->directory[0] = '\0';
 
-  puts("\nNow continue with your submission at:\n\n    https://www.pwg.org/ippeveselfcert\n");
+    if ((fp = fopen(path, "r")) == NULL)
+    {
+      printf("ippevesubmit: Unable to open '%s': %s\n", path, strerror(errno));
+      return (false);
+    }
 
-  return (0);
-}
+    while (fgets(line, sizeof(line), fp))
+    {
+      linenum ++;
 
+      if ((ptr = line + strlen(line) - 1) >= line && *ptr == '\n')
+        *ptr = '\0';
+      if ((ptr = line + strlen(line) - 1) >= line && *ptr == '\r')
+        *ptr = '\0';
 
-//
-// 'error_cb()' - Display an error message.
-//
+      if (!line[0] || line[0] == '#')
+        continue;
 
-static void
-error_cb(void       *data,		// I - Callback data (unused)
-         const char *message)		// I - Message string
-{
-  (void)data;
+      for (num_fields = 0, ptr = line; num_fields < (sizeof(fields) / sizeof(fields[0])); num_fields ++)
+      {
+        fields[num_fields] = ptr;
 
-  fprintf(stderr, "ippevesubmit: %s\n", message);
-}
+        if ((ptr = strchr(ptr, '\t')) == NULL)
+        {
+          num_fields ++;
+          break;
+        }
 
+        *ptr++ = '\0';
+      }
 
-//
-// 'read_boolean()' - Ask a yes/no question.
-//
+      for (i = num_fields; i < (sizeof(fields) / sizeof(fields[0])); i ++)
+        fields[i] = "";
 
-static bool				// O - `true` if yes, `false` if no
-read_boolean(const char *prompt)	// I - Question to ask
-{
-  char	buffer[256];			// Response buffer
+      if (!fields[0][0])
+      {
+        printf("ippevesubmit: Missing printer name on line %d of '%s'.\n", linenum, path);
+        fclose(fp);
+        return (false);
+      }
 
+      // Models files are relative to the manifest...
+      if (!fields[3][0])
+        cupsCopyString(modelsfile, models ? models : "", sizeof(modelsfile));
+      else if (fields[3][0] == '/' || !batch->directory[0])
+        cupsCopyString(modelsfile, fields[3], sizeof(modelsfile));
+      else
+        snprintf(modelsfile, sizeof(modelsfile), "%s/%s", batch->directory, fields[3]);
 
-  printf("%s (y/N)? ", prompt);
-  fflush(stdout);
+      if (!batch_add(batch, fields[0], fields[1][0] ? fields[1] : family ? family : "", fields[2][0] ? fields[2] : webpage ? webpage : "", modelsfile))
+      {
+        fclose(fp);
+        return (false);
+      }
+    }
 
-  if (fgets(buffer, sizeof(buffer), stdin) && toupper(buffer[0] & 255) == 'Y')
-    return (true);
-  else
+    fclose(fp);
+  }
+
+  if (batch->num_printers == 0)
+  {
+    printf("ippevesubmit: No printers in '%s'.\n", path);
     return (false);
+  }
+
+  return (true);
 }
 
 
 //
-// 'read_string()' - Read a string response from the console or a file.
+// 'batch_run()' - Load and validate the results for printers in a batch.
 //
 
-static char *				// O - String or `NULL` if none
-read_string(const char *prompt,		// I - Prompt (if interactive)
-	    FILE       *fp,		// I - File to read from
-	    char       *buffer,		// I - Response buffer
-	    size_t     bufsize)		// I - Size of response buffer
+static void *				// O - Thread exit status
+batch_run(_batch_t *batch)		// I - Batch
 {
-  char	*bufptr;			// Pointer into buffer
+  _batch_printer_t	*printer;	// Current printer
+  const char		*directory;	// Results directory
+  double		start;		// Start time
 
 
-  if (prompt)
-  {
-    // Show prompt...
-    printf("%s? ", prompt);
-    fflush(stdout);
-  }
+  directory = batch->directory[0] ? batch->directory : NULL;
 
-  if (fgets(buffer, bufsize, fp))
+  for (;;)
   {
-    // Got a line from the user, strip trailing whitespace...
-    for (bufptr = buffer + strlen(buffer) - 1; bufptr >= buffer; bufptr --)
-    {
-      if (isspace(*bufptr & 255))
-	*bufptr = '\0';
-      else
-        break;
-    }
+    // Get the next printer...
+    cupsMutexLock(&batch->mutex);
+    if (batch->next_printer < batch->num_printers)
+      printer = batch->printers + batch->next_printer ++;
+    else
+      printer = NULL;
+    cupsMutexUnlock(&batch->mutex);
 
-    // If there is anything left, return it...
-    if (buffer[0])
-      return (buffer);
+    if (!printer)
+      break;
+
+    // Load and validate the results...
+    start       = cupsGetClock();
+    printer->ok = true;
+
+    if (!load_results(directory, printer->name, SELFCERT_SUITE_DNSSD, batch->print_server, batch->use_cache, &printer->dnssd, &printer->mtime))
+      printer->ok = false;
+    if (!load_results(directory, printer->name, SELFCERT_SUITE_IPP, batch->print_server, batch->use_cache, &printer->ipp, &printer->mtime))
+      printer->ok = false;
+    if (!load_results(directory, printer->name, SELFCERT_SUITE_DOCUMENT, batch->print_server, batch->use_cache, &printer->document, &printer->mtime))
+      printer->ok = false;
+
+    printer->elapsed = cupsGetClock() - start;
   }
 
   return (NULL);
@@ -641,24 +930,508 @@ read_string(const char *prompt,		// I - Prompt (if interactive)
 
 
 //
-// 'replay_results()' - Replay the results from a test.
+// 'compare_latency()' - Compare two latencies.
 //
 
-static void
-replay_results(const char *filename,	// I - Filename
-               plist_t    *results)	// I - Results
+static int				// O - Result of comparison
+compare_latency(double *a,		// I - First latency
+                double *b)		// I - Second latency
 {
-  plist_t	*tests,			// Tests array
-		*test,			// Current test dictionary
+  if (*a < *b)
+    return (-1);
+  else if (*a > *b)
+    return (1);
+  else
+    return (0);
+}
+
+
+//
+// 'do_batch()' - Validate and submit a batch of printers.
+//
+
+static int				// O - Exit status
+do_batch(const char *path,		// I - Manifest or directory
+         int        num_workers,	// I - Number of workers
+         bool       split,		// I - Write one JSON file per printer?
+         const char *json,		// I - JSON output file or `NULL` for default
+         const char *family,		// I - Default product family name
+         const char *webpage,		// I - Default product family web page
+         const char *models,		// I - Default models file
+         int        print_server,	// I - Product is a print server
+         int        firmware_update,	// I - Is a firmware update needed?
+         bool       use_cache,		// I - Use the validation cache?
+         bool       override_tests)	// I - Test results were overridden?
+{
+  _batch_t		batch;		// Batch of printers
+  _batch_printer_t	*printer;	// Current printer
+  size_t		i,		// Looping var
+			num_passed = 0;	// Number of printers that passed
+  int			j,		// Looping var
+			num_started;	// Number of workers that ran
+  cups_thread_t		*workers;	// Worker threads
+  double		start;		// Start time
+  bool			ok = true;	// Did everything pass?
+  _submission_t		submission;	// Submission writer
+  char			filename[1024],	// JSON filename
+			*ptr,		// Pointer into filename
+			url[1024],	// Product family web page URL
+			model[1024],	// Model name
+			date[32];	// Date/time of submission
+  const char		*pwebpage;	// Printer's web page
+  FILE			*models_fp,	// Models file
+			*fp = NULL;	// Output file
+
+
+  if (split && json)
+  {
+    puts("ippevesubmit: Cannot use '-o' with '--split'.");
+    return (1);
+  }
+
+  // Load the list of printers...
+  memset(&batch, 0, sizeof(batch));
+  cupsMutexInit(&batch.mutex);
+  batch.print_server = print_server;
+  batch.use_cache    = use_cache;
+
+  if (!batch_load(&batch, path, family, webpage, models))
+    return (1);
+
+  for (i = batch.num_printers, printer = batch.printers; i > 0; i --, printer ++)
+  {
+    if (!printer->family[0])
+    {
+      printf("ippevesubmit: No product family for \"%s\".\n", printer->name);
+      ok = false;
+    }
+    else if (!printer->webpage[0])
+    {
+      printf("ippevesubmit: No web page for \"%s\".\n", printer->name);
+      ok = false;
+    }
+    else if ((pwebpage = normalize_url(printer->webpage, url, sizeof(url))) == NULL)
+    {
+      printf("ippevesubmit: Bad product URL '%s' for \"%s\".\n", printer->webpage, printer->name);
+      ok = false;
+    }
+    else if (pwebpage != printer->webpage)
+    {
+      cupsCopyString(printer->webpage, pwebpage, sizeof(printer->webpage));
+    }
+  }
+
+  if (!ok)
+  {
+    free(batch.printers);
+    return (1);
+  }
+
+  // Validate the results using the worker pool...
+  if ((size_t)num_workers > batch.num_printers)
+    num_workers = (int)batch.num_printers;
+
+  start = cupsGetClock();
+
+  if ((workers = (cups_thread_t *)calloc((size_t)num_workers, sizeof(cups_thread_t))) == NULL)
+  {
+    printf("ippevesubmit: Unable to allocate workers: %s\n", strerror(errno));
+    free(batch.printers);
+    return (1);
+  }
+
+  for (j = 0, num_started = 0; j < num_workers; j ++, num_started ++)
+  {
+    if ((workers[j] = cupsThreadCreate((cups_thread_func_t)batch_run, &batch)) == CUPS_THREAD_INVALID)
+    {
+      // Fall back to running the rest of the batch on this thread...
+      batch_run(&batch);
+      num_started ++;
+      break;
+    }
+  }
+
+  while (j > 0)
+    cupsThreadWait(workers[-- j]);
+
+  free(workers);
+
+  // Show the summary table...
+  printf("%-40s %-6s %-4s %-8s %-6s %8s\n", "Printer", "DNS-SD", "IPP", "Document", "Result", "Time");
+  printf("%-40s %-6s %-4s %-8s %-6s %8s\n", "----------------------------------------", "------", "----", "--------", "------", "--------");
+
+  for (i = batch.num_printers, printer = batch.printers; i > 0; i --, printer ++)
+  {
+    printf("%-40.40s %-6s %-4s %-8s %-6s %7.3fs\n", printer->name, printer->dnssd.valid ? "PASS" : "FAIL", printer->ipp.valid ? "PASS" : "FAIL", printer->document.valid ? "PASS" : "FAIL", printer->ok ? "PASS" : "FAIL", printer->elapsed);
+
+    if (printer->ok)
+      num_passed ++;
+    else
+      ok = false;
+  }
+
+  printf("\n%u printers, %u passed, %u failed in %.3fs using %d workers.\n", (unsigned)batch.num_printers, (unsigned)num_passed, (unsigned)(batch.num_printers - num_passed), cupsGetClock() - start, num_started);
+
+  for (i = batch.num_printers, printer = batch.printers; i > 0; i --, printer ++)
+  {
+    if (printer->ok)
+      continue;
+
+    printf("\n\"%s\" errors:\n", printer->name);
+    if (printer->dnssd.errors[0])
+      printf("DNS-SD errors:\n%s", printer->dnssd.errors);
+    if (printer->ipp.errors[0])
+      printf("IPP errors:\n%s", printer->ipp.errors);
+    if (printer->document.errors[0])
+      printf("Document errors:\n%s", printer->document.errors);
+  }
+
+  // Write the submission(s)...
+  if (!split)
+  {
+    if (!json)
+      json = "Batch.json";
+
+    if (!submission_init(&submission, json))
+    {
+      printf("ippevesubmit: Unable to create '%s': %s\n", json, strerror(errno));
+      free(batch.printers);
+      return (1);
+    }
+
+    fp = submission.fp;
+
+    if (override_tests)
+    {
+      fputs("// Note: submitted with --override\n", fp);
+
+      for (i = batch.num_printers, printer = batch.printers; i > 0; i --, printer ++)
+      {
+        if (!printer->ok)
+          batch_errors(fp, printer);
+      }
+    }
+  }
+
+  for (i = batch.num_printers, printer = batch.printers; i > 0; i --, printer ++)
+  {
+    if (!printer->ok && !override_tests)
+      continue;
+
+    if (split)
+    {
+      snprintf(filename, sizeof(filename), "%s.json", printer->name);
+
+      // Don't allow directory separators in the filename, like the results
+      // names...
+      for (ptr = filename; *ptr; ptr ++)
+      {
+        if (*ptr == '/' || *ptr == '\\' || *ptr == ':')
+          *ptr = '_';
+      }
+
+      if (!submission_init(&submission, filename))
+      {
+        printf("ippevesubmit: Unable to create '%s': %s\n", filename, strerror(errno));
+        ok = false;
+        continue;
+      }
+
+      fp = submission.fp;
+
+      if (override_tests)
+        fputs("// Note: submitted with --override\n", fp);
+
+      if (!printer->ok)
+        batch_errors(fp, printer);
+    }
+
+    format_date(printer->mtime, date, sizeof(date));
+    submission_printer(&submission, printer->family, printer->webpage, firmware_update, &printer->dnssd, &printer->ipp, date);
+
+    if (printer->models[0] && (models_fp = fopen(printer->models, "r")) != NULL)
+    {
+      while (read_string(NULL, models_fp, model, sizeof(model)))
+        submission_model(&submission, model);
+
+      fclose(models_fp);
+    }
+    else
+    {
+      if (printer->models[0])
+        printf("ippevesubmit: Unable to open models file '%s': %s\n", printer->models, strerror(errno));
+
+      submission_model(&submission, printer->name);
+    }
+
+    if (split)
+    {
+      if (submission_finish(&submission))
+      {
+        printf("Wrote submission to '%s'.\n", filename);
+      }
+      else
+      {
+        printf("ippevesubmit: Unable to write '%s': %s\n", filename, strerror(errno));
+        ok = false;
+      }
+    }
+  }
+
+  if (!split)
+  {
+    if (!submission_finish(&submission))
+    {
+      printf("ippevesubmit: Unable to write '%s': %s\n", json, strerror(errno));
+      ok = false;
+    }
+    else if (strcmp(json, "-"))
+    {
+      printf("\nWrote submission to '%s'.\n", json);
+    }
+  }
+
+  free(batch.printers);
+  cupsMutexDestroy(&batch.mutex);
+
+  if (ok || override_tests)
+    puts("\nNow continue with your submission at:\n\n    https://www.pwg.org/ippeveselfcert\n");
+
+  return (ok ? 0 : 1);
+}
+
+
+//
+// 'error_cb()' - Display an error message.
+//
+
+static void
+error_cb(void       *data,		// I - Callback data (unused)
+         const char *message)		// I - Message string
+{
+  (void)data;
+
+  fprintf(stderr, "ippevesubmit: %s\n", message);
+}
+
+
+//
+// 'format_date()' - Format a submission date/time.
+//
+
+static char *				// O - Date/time string
+format_date(time_t t,			// I - Date/time in seconds or 0 for now
+            char   *buffer,		// I - String buffer
+            size_t bufsize)		// I - Size of string buffer
+{
+  struct tm	tm;			// Date/time (tm data)
+
+
+  if (!t)
+    time(&t);
+  gmtime_r(&t, &tm);
+
+  snprintf(buffer, bufsize, "%04d-%02d-%02dT%02d:%02d:%02dZ", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+
+  return (buffer);
+}
+
+
+//
+// 'load_results()' - Load, validate, and summarize a test results file.
+//
+// The summary comes from the validation cache when the results file has not
+// changed since it was last validated, otherwise the file is read, validated,
+// summarized, and the summary saved to the cache.
+//
+
+static bool				// O  - `true` if valid, `false` otherwise
+load_results(const char       *directory,
+					// I  - Results directory or `NULL` for current
+             const char       *printer,	// I  - Printer name
+             selfcert_suite_t suite,	// I  - Test suite
+             int              print_server,
+					// I  - Certifying a print server?
+             bool             use_cache,// I  - Use the validation cache?
+             summary_t        *summary,	// O  - Results summary
+             time_t           *mtime)	// IO - Newest modification time
+{
+  char		filename[1024];		// Results filename
+  struct stat	fileinfo;		// Results file information
+  plist_t	*results,		// Test results
+		*fileid,		// FileId from the first test
+		*value;			// Value from attributes
+  const char	*version;		// Self-certification version
+
+
+  if (directory)
+    snprintf(filename, sizeof(filename), "%s/%s %s Results.plist", directory, printer, suite_names[suite]);
+  else
+    snprintf(filename, sizeof(filename), "%s %s Results.plist", printer, suite_names[suite]);
+
+  if (!stat(filename, &fileinfo) && fileinfo.st_mtime > *mtime)
+    *mtime = fileinfo.st_mtime;
+
+  if (use_cache && cache_get(filename, suite, summary))
+    return (summary->valid);
+
+  memset(summary, 0, sizeof(summary_t));
+
+  results = plist_read(NULL, filename, error_cb, NULL);
+
+  switch (suite)
+  {
+    case SELFCERT_SUITE_DNSSD :
+        summary->valid = validate_dnssd_results(filename, results, print_server, summary->errors, sizeof(summary->errors));
+
+        // IPPS is supported if the TLS tests passed without being skipped...
+        summary->ipps = (value = plist_find(results, "Tests/4/Successful")) != NULL && value->type == PLIST_TYPE_TRUE && ((value = plist_find(results, "Tests/4/Skipped")) == NULL || value->type != PLIST_TYPE_TRUE);
+        break;
+
+    case SELFCERT_SUITE_IPP :
+        summary->valid = validate_ipp_results(filename, results, print_server, summary->errors, sizeof(summary->errors));
+
+        // Look for the cert version...
+        if ((fileid = plist_find(results, "Tests/0/FileId")) != NULL && !strncmp(fileid->value, "org.pwg.ippeveselfcert", 22) && isdigit(fileid->value[22] & 255) && isdigit(fileid->value[23] & 255))
+          version = fileid->value + 22;
+        else
+          version = "??";
+
+        snprintf(summary->version, sizeof(summary->version), "%c.%c", version[0], version[1]);
+
+        // Supported values...
+        summarize_supported(plist_find(results, "Tests/9/ResponseAttributes/1"), summary);
+        break;
+
+    case SELFCERT_SUITE_DOCUMENT :
+        summary->valid = validate_document_results(filename, results, print_server, summary->errors, sizeof(summary->errors));
+        break;
+  }
+
+  plist_delete(results);
+
+  if (use_cache)
+    cache_put(filename, suite, summary);
+
+  return (summary->valid);
+}
+
+
+//
+// 'normalize_url()' - Normalize a product family web page URL.
+//
+
+static const char *			// O - URL or `NULL` if bad
+normalize_url(const char *url,		// I - URL from user
+              char       *buffer,	// I - URL buffer
+              size_t     bufsize)	// I - Size of URL buffer
+{
+  if (!strncmp(url, "http://", 7) || !strncmp(url, "https://", 8))
+    return (url);
+
+  if (!strchr(url, '.'))
+    return (NULL);
+
+  snprintf(buffer, bufsize, "https://%s/", url);
+
+  return (buffer);
+}
+
+
+//
+// 'read_boolean()' - Ask a yes/no question.
+//
+
+static bool				// O - `true` if yes, `false` if no
+read_boolean(const char *prompt)	// I - Question to ask
+{
+  char	buffer[256];			// Response buffer
+
+
+  printf("%s (y/N)? ", prompt);
+  fflush(stdout);
+
+  if (fgets(buffer, sizeof(buffer), stdin) && toupper(buffer[0] & 255) == 'Y')
+    return (true);
+  else
+    return (false);
+}
+
+
+//
+// 'read_string()' - Read a string response from the console or a file.
+//
+
+static char *				// O - String or `NULL` if none
+read_string(const char *prompt,		// I - Prompt (if interactive)
+	    FILE       *fp,		// I - File to read from
+	    char       *buffer,		// I - Response buffer
+	    size_t     bufsize)		// I - Size of response buffer
+{
+  char	*bufptr;			// Pointer into buffer
+
+
+  if (prompt)
+  {
+    // Show prompt...
+    printf("%s? ", prompt);
+    fflush(stdout);
+  }
+
+  if (fgets(buffer, bufsize, fp))
+  {
+    // Got a line from the user, strip trailing whitespace...
+    for (bufptr = buffer + strlen(buffer) - 1; bufptr >= buffer; bufptr --)
+    {
+      if (isspace(*bufptr & 255))
+	*bufptr = '\0';
+      else
+        break;
+    }
+
+    // If there is anything left, return it...
+    if (buffer[0])
+      return (buffer);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'replay_results()' - Replay the results from a test.
+//
+
+static void
+replay_results(const char *filename,	// I - Filename
+               plist_t    *results)	// I - Results
+{
+  plist_t	*tests,			// Tests array
+		*test,			// Current test dictionary
 		*name,			// Test name ("Name" string)
 		*successful,		// Test status ("Successful" boolean)
 		*skipped,		// Test skipped? ("Skipped" boolean)
-		*errors;		// Test errors, if any ("Errors" array)
+		*errors,		// Test errors, if any ("Errors" array)
+		*operation,		// Operation name, if any ("Operation" string)
+		*iterations,		// Request timing, if any ("Iterations" array)
+		*iteration,		// Current request timing
+		*requests,		// Number of requests ("Requests" integer)
+		*busy,			// Number of busy responses ("Busy" integer)
+		*value;			// "Clients" value
   const char	*status;		// Status to display
   int		total = 0,		// Test counts
 		pass = 0,
 		skip = 0,
 		fail = 0;
+  double	start,			// Start time
+		end;			// End time
+  size_t	i,			// Looping var
+		num_latencies = 0,	// Number of operations
+		num_throughputs = 0;	// Number of document formats
+  _replay_latency_t *latencies = NULL,	// Latencies for each operation
+		all;			// Latencies for all operations
+  _replay_throughput_t *throughputs = NULL;
+					// Throughput for each document format
 
 
   printf("\"%s\":\n", filename);
@@ -668,6 +1441,9 @@ replay_results(const char *filename,	// I - Filename
     return;
   }
 
+  memset(&all, 0, sizeof(all));
+  cupsCopyString(all.operation, "All operations", sizeof(all.operation));
+
   for (test = tests->first_child; test; test = test->next_sibling)
   {
     name       = plist_find(test, "Name");
@@ -696,11 +1472,46 @@ replay_results(const char *filename,	// I - Filename
       fail ++;
     }
 
-    printf("    %-68.68s [%s]\n", name->value, status);
-
-    if (errors && errors->type == PLIST_TYPE_ARRAY)
+    if (replay_time(test, &start, &end))
     {
-      plist_t	*error;			// Current error
+      // Show the test duration and collect the request latencies...
+      iterations = plist_find(test, "Iterations");
+      requests   = plist_find(test, "Requests");
+
+      if (requests && requests->type == PLIST_TYPE_INTEGER)
+        printf("    %-60.60s [%s] %8.3fs (%ld requests)\n", name->value, status, end - start, strtol(requests->value, NULL, 10));
+      else if (iterations && iterations->type == PLIST_TYPE_ARRAY)
+        printf("    %-60.60s [%s] %8.3fs (%u requests)\n", name->value, status, end - start, (unsigned)plist_array_count(iterations));
+      else
+        printf("    %-60.60s [%s] %8.3fs\n", name->value, status, end - start);
+
+      if ((operation = plist_find(test, "Operation")) != NULL && operation->type == PLIST_TYPE_STRING && strcmp(status, "SKIP"))
+      {
+        if (iterations && iterations->type == PLIST_TYPE_ARRAY)
+        {
+          for (iteration = iterations->first_child; iteration; iteration = iteration->next_sibling)
+          {
+            if (replay_time(iteration, &start, &end))
+              latencies = replay_latency(latencies, &num_latencies, &all, operation->value, end - start);
+          }
+        }
+        else
+        {
+          latencies = replay_latency(latencies, &num_latencies, &all, operation->value, end - start);
+        }
+
+        if (!strcmp(operation->value, "Print-Job") && !strcmp(status, "PASS"))
+          throughputs = replay_throughput(throughputs, &num_throughputs, test);
+      }
+    }
+    else
+    {
+      printf("    %-68.68s [%s]\n", name->value, status);
+    }
+
+    if (errors && errors->type == PLIST_TYPE_ARRAY)
+    {
+      plist_t	*error;			// Current error
 
       for (error = errors->first_child; error; error = error->next_sibling)
         printf("        %s\n", error->value);
@@ -708,7 +1519,665 @@ replay_results(const char *filename,	// I - Filename
   }
 
   printf("\nSummary: %d tests, %d passed, %d failed, %d skipped\n", total, pass, fail, skip);
-  printf("Score: %d%%\n", 100 * (pass + skip) / total);
+  if (total > 0)
+    printf("Score: %d%%\n", 100 * (pass + skip) / total);
+
+  if (replay_time(results, &start, &end))
+    printf("Time: %.3fs\n", end - start);
+
+  if (all.num_values > 0)
+  {
+    // Show the latency percentiles for each operation...
+    puts("\nLatency:");
+    printf("    %-40s %8s %8s %8s %8s\n", "Operation", "Samples", "p50", "p90", "p99");
+
+    for (i = 0; i <= num_latencies; i ++)
+    {
+      _replay_latency_t	*latency = i < num_latencies ? latencies + i : &all;
+					// Current latencies
+
+      qsort(latency->values, latency->num_values, sizeof(double), (int (*)(const void *, const void *))compare_latency);
+
+      printf("    %-40.40s %8u %7.3fs %7.3fs %7.3fs\n", latency->operation, (unsigned)latency->num_values, replay_percentile(latency, 50), replay_percentile(latency, 90), replay_percentile(latency, 99));
+    }
+  }
+
+  if (num_throughputs > 0)
+  {
+    // Show the job throughput for each document format...
+    puts("\nThroughput:");
+    printf("    %-40s %8s %8s %8s %8s %8s %8s\n", "Format", "Jobs", "Pages", "MB/s", "Response", "Job", "PPM");
+
+    for (i = 0; i < num_throughputs; i ++)
+    {
+      _replay_throughput_t *throughput = throughputs + i;
+					// Current document format
+
+      printf("    %-40.40s %8u %8ld", throughput->format, (unsigned)throughput->num_jobs, throughput->impressions);
+
+      if (throughput->rate_time > 0.0)
+        printf(" %8.2f", throughput->size / throughput->rate_time / 1000000.0);
+      else
+        printf(" %8s", "-");
+
+      printf(" %7.3fs %7.3fs", throughput->response_time / throughput->num_jobs, throughput->job_time / throughput->num_jobs);
+
+      if (throughput->job_time > 0.0)
+        printf(" %8.1f\n", 60.0 * throughput->impressions / throughput->job_time);
+      else
+        printf(" %8s\n", "-");
+    }
+  }
+
+  if ((value = plist_find(results, "Clients")) != NULL && value->type == PLIST_TYPE_INTEGER)
+  {
+    // Show the request rate and busy responses for each operation from the
+    // stress test...
+    printf("\nLoad (%s clients):\n", value->value);
+    printf("    %-40s %8s %10s %8s %8s\n", "Operation", "Requests", "Requests/s", "Busy", "Busy %");
+
+    for (test = tests->first_child; test; test = test->next_sibling)
+    {
+      operation = plist_find(test, "Operation");
+      requests  = plist_find(test, "Requests");
+      busy      = plist_find(test, "Busy");
+
+      if (!operation || operation->type != PLIST_TYPE_STRING || !requests || requests->type != PLIST_TYPE_INTEGER || !busy || busy->type != PLIST_TYPE_INTEGER || !replay_time(test, &start, &end) || end <= start)
+        continue;
+
+      printf("    %-40.40s %8ld %10.1f %8ld", operation->value, strtol(requests->value, NULL, 10), strtol(requests->value, NULL, 10) / (end - start), strtol(busy->value, NULL, 10));
+
+      if (strtol(requests->value, NULL, 10) > 0)
+        printf(" %7.1f%%\n", 100.0 * strtol(busy->value, NULL, 10) / strtol(requests->value, NULL, 10));
+      else
+        printf(" %8s\n", "-");
+    }
+  }
+
+  for (i = 0; i < num_latencies; i ++)
+    free(latencies[i].values);
+
+  free(latencies);
+  free(all.values);
+  free(throughputs);
+}
+
+
+//
+// 'replay_latency()' - Add a request latency for an operation.
+//
+
+static _replay_latency_t *		// O  - Latencies array
+replay_latency(
+    _replay_latency_t *latencies,	// I  - Latencies array
+    size_t            *num_latencies,	// IO - Number of operations
+    _replay_latency_t *all,		// I  - Latencies for all operations
+    const char        *operation,	// I  - Operation name
+    double            value)		// I  - Latency in seconds
+{
+  size_t		i;		// Looping var
+  _replay_latency_t	*latency;	// Current operation
+  int			pass;		// Current pass
+
+
+  for (i = 0, latency = latencies; i < *num_latencies; i ++, latency ++)
+  {
+    if (!strcmp(latency->operation, operation))
+      break;
+  }
+
+  if (i >= *num_latencies)
+  {
+    // Add a new operation...
+    if ((latency = (_replay_latency_t *)realloc(latencies, (*num_latencies + 1) * sizeof(_replay_latency_t))) == NULL)
+      return (latencies);
+
+    latencies = latency;
+    latency   += *num_latencies;
+    (*num_latencies) ++;
+
+    memset(latency, 0, sizeof(_replay_latency_t));
+    cupsCopyString(latency->operation, operation, sizeof(latency->operation));
+  }
+
+  // Add the value to the operation and to all operations...
+  for (pass = 0; pass < 2; pass ++, latency = all)
+  {
+    if (latency->num_values >= latency->alloc_values)
+    {
+      double *values = (double *)realloc(latency->values, (latency->alloc_values + 32) * sizeof(double));
+					// New values array
+
+      if (!values)
+        break;
+
+      latency->values       = values;
+      latency->alloc_values += 32;
+    }
+
+    latency->values[latency->num_values ++] = value;
+  }
+
+  return (latencies);
+}
+
+
+//
+// 'replay_percentile()' - Get a percentile from sorted latencies.
+//
+
+static double				// O - Latency in seconds
+replay_percentile(
+    _replay_latency_t *latency,		// I - Sorted latencies
+    int               percent)		// I - Percentile
+{
+  size_t	rank;			// Nearest rank
+
+
+  if (latency->num_values == 0)
+    return (0.0);
+
+  rank = (latency->num_values * (size_t)percent + 99) / 100;
+  if (rank < 1)
+    rank = 1;
+
+  return (latency->values[rank - 1]);
+}
+
+
+//
+// 'replay_throughput()' - Add the throughput of a job for its document format.
+//
+// The runner adds "DocumentSize", "ResponseRate", "ResponseTime", "JobTime",
+// and "ImpressionsCompleted" to successful Print-Job tests in the Document
+// tests.  Jobs are grouped by the "document-format" and "compression"
+// attributes in the request, and the rate of each format is its total
+// document size divided by the time each document took at its
+// "ResponseRate", so it includes the time the printer spent processing before
+// it responded.
+//
+
+static _replay_throughput_t *		// O  - Throughput array
+replay_throughput(
+    _replay_throughput_t *throughputs,	// I  - Throughput array
+    size_t               *num_throughputs,
+					// IO - Number of document formats
+    plist_t              *test)		// I  - Print-Job test
+{
+  size_t		i;		// Looping var
+  _replay_throughput_t	*throughput;	// Current document format
+  plist_t		*format,	// "document-format" value
+			*compression,	// "compression" value
+			*size,		// "DocumentSize" value
+			*rate,		// "ResponseRate" value
+			*response_time,	// "ResponseTime" value
+			*job_time,	// "JobTime" value
+			*impressions;	// "ImpressionsCompleted" value
+  char			name[128];	// Document format and compression
+
+
+  size          = plist_find(test, "DocumentSize");
+  rate          = plist_find(test, "ResponseRate");
+  response_time = plist_find(test, "ResponseTime");
+  job_time      = plist_find(test, "JobTime");
+  impressions   = plist_find(test, "ImpressionsCompleted");
+
+  if (!response_time || response_time->type != PLIST_TYPE_INTEGER || !job_time || job_time->type != PLIST_TYPE_INTEGER)
+    return (throughputs);
+
+  format      = plist_find(test, "RequestAttributes/0/document-format");
+  compression = plist_find(test, "RequestAttributes/0/compression");
+
+  snprintf(name, sizeof(name), "%s, %s", format && format->type == PLIST_TYPE_STRING ? format->value : "unknown", compression && compression->type == PLIST_TYPE_STRING ? compression->value : "none");
+
+  for (i = 0, throughput = throughputs; i < *num_throughputs; i ++, throughput ++)
+  {
+    if (!strcmp(throughput->format, name))
+      break;
+  }
+
+  if (i >= *num_throughputs)
+  {
+    // Add a new document format...
+    if ((throughput = (_replay_throughput_t *)realloc(throughputs, (*num_throughputs + 1) * sizeof(_replay_throughput_t))) == NULL)
+      return (throughputs);
+
+    throughputs = throughput;
+    throughput  += *num_throughputs;
+    (*num_throughputs) ++;
+
+    memset(throughput, 0, sizeof(_replay_throughput_t));
+    cupsCopyString(throughput->format, name, sizeof(throughput->format));
+  }
+
+  // Add the job...
+  throughput->num_jobs ++;
+  throughput->response_time += strtol(response_time->value, NULL, 10) / 1000.0;
+  throughput->job_time      += strtol(job_time->value, NULL, 10) / 1000.0;
+
+  if (size && size->type == PLIST_TYPE_INTEGER && rate && rate->type == PLIST_TYPE_INTEGER && strtol(rate->value, NULL, 10) > 0)
+  {
+    throughput->size      += strtol(size->value, NULL, 10);
+    throughput->rate_time += (double)strtol(size->value, NULL, 10) / strtol(rate->value, NULL, 10);
+  }
+
+  if (impressions && impressions->type == PLIST_TYPE_INTEGER)
+    throughput->impressions += strtol(impressions->value, NULL, 10);
+
+  return (throughputs);
+}
+
+
+//
+// 'replay_time()' - Get the start and end times from a dictionary.
+//
+
+static bool				// O - `true` if found, `false` otherwise
+replay_time(plist_t *dict,		// I - Dictionary
+            double  *start,		// O - Start time in seconds
+            double  *end)		// O - End time in seconds
+{
+  plist_t	*value;			// Time value
+
+
+  if ((value = plist_find(dict, "StartTime")) == NULL || value->type != PLIST_TYPE_INTEGER)
+    return (false);
+
+  *start = 0.001 * strtod(value->value, NULL);
+
+  if ((value = plist_find(dict, "EndTime")) == NULL || value->type != PLIST_TYPE_INTEGER)
+    return (false);
+
+  *end = 0.001 * strtod(value->value, NULL);
+
+  return (true);
+}
+
+
+//
+// 'submission_finish()' - Finish writing a submission.
+//
+// The temporary file is renamed to the JSON filename once everything has been
+// written, so an interrupted or failed submission never replaces a previous
+// one.
+//
+
+static bool				// O - `true` on success, `false` on error
+submission_finish(
+    _submission_t *submission)		// I - Submission writer
+{
+  bool	ret;				// Return value
+
+
+  fputs(submission->num_models > 0 ? "]\n" : "[]\n", submission->fp);
+
+  free(submission->prefix);
+  free(submission->suffix);
+
+  submission->prefix = NULL;
+  submission->suffix = NULL;
+
+  if (submission->fp == stdout)
+    return (!submission->error && !fflush(stdout));
+
+  ret = !submission->error && !ferror(submission->fp);
+
+  if (fclose(submission->fp))
+    ret = false;
+
+  submission->fp = NULL;
+
+  if (ret)
+  {
+#if _WIN32
+    unlink(submission->filename);
+#endif // _WIN32
+
+    if (rename(submission->tempfile, submission->filename))
+      ret = false;
+  }
+
+  if (!ret)
+    unlink(submission->tempfile);
+
+  return (ret);
+}
+
+
+//
+// 'submission_format()' - Format a string into a new buffer.
+//
+// The caller must free the returned string.
+//
+
+static char *				// O - Formatted string or `NULL` on error
+submission_format(const char *format,	// I - Printf-style format string
+                  ...)			// I - Additional arguments
+{
+  va_list	ap;			// Pointer to arguments
+  int		len;			// Length of formatted string
+  char		*buffer;		// Formatted string
+
+
+  va_start(ap, format);
+  len = vsnprintf(NULL, 0, format, ap);
+  va_end(ap);
+
+  if (len < 0 || (buffer = (char *)malloc((size_t)len + 1)) == NULL)
+    return (NULL);
+
+  va_start(ap, format);
+  vsnprintf(buffer, (size_t)len + 1, format, ap);
+  va_end(ap);
+
+  return (buffer);
+}
+
+
+//
+// 'submission_init()' - Start writing a submission.
+//
+// The submission is written to a temporary file next to the JSON file, or to
+// the standard output for "-".
+//
+
+static bool				// O - `true` on success, `false` on error
+submission_init(
+    _submission_t *submission,		// I - Submission writer
+    const char    *filename)		// I - JSON filename or "-" for stdout
+{
+  memset(submission, 0, sizeof(_submission_t));
+
+  if (!strcmp(filename, "-"))
+  {
+    submission->fp = stdout;
+    return (true);
+  }
+
+  cupsCopyString(submission->filename, filename, sizeof(submission->filename));
+  snprintf(submission->tempfile, sizeof(submission->tempfile), "%s.%d", filename, (int)getpid());
+
+  return ((submission->fp = fopen(submission->tempfile, "w")) != NULL);
+}
+
+
+//
+// 'submission_model()' - Write the submission entry for a model.
+//
+// Each entry is written on its own line.
+//
+
+static void
+submission_model(
+    _submission_t *submission,		// I - Submission writer
+    const char    *model)		// I - Model name
+{
+  char	*json;				// JSON model name
+
+
+  if (!submission->prefix || !submission->suffix || (json = submission_string(model)) == NULL)
+  {
+    submission->error = true;
+    return;
+  }
+
+  fputs(submission->num_models > 0 ? ",\n" : "[", submission->fp);
+  fputs(submission->prefix, submission->fp);
+  fputs(json, submission->fp);
+  fputs(submission->suffix, submission->fp);
+
+  free(json);
+
+  submission->num_models ++;
+}
+
+
+//
+// 'submission_printer()' - Set the printer for the following models.
+//
+// The JSON for the fields that are the same for every model of the printer is
+// generated once here and reused for each model.
+//
+
+static void
+submission_printer(
+    _submission_t   *submission,	// I - Submission writer
+    const char      *family,		// I - Product family name
+    const char      *webpage,		// I - Product family web page
+    int             firmware_update,	// I - Is a firmware update needed?
+    const summary_t *dnssd_summary,	// I - DNS-SD test results summary
+    const summary_t *ipp_summary,	// I - IPP test results summary
+    const char      *date)		// I - Date/time of submission
+{
+  char	*json_family,			// JSON product family name
+	*json_webpage,			// JSON product family web page
+	*json_version,			// JSON certification version
+	*json_date;			// JSON date/time
+  static const char * const media_formats[] =
+  {					// Size classes
+    "Small",
+    "Medium",
+    "Large"
+  };
+
+
+  free(submission->prefix);
+  free(submission->suffix);
+
+  submission->prefix = NULL;
+  submission->suffix = NULL;
+
+  json_family  = submission_string(family);
+  json_webpage = submission_string(webpage);
+  json_version = submission_string(ipp_summary->version);
+  json_date    = submission_string(date);
+
+  if (json_family && json_webpage && json_version && json_date)
+  {
+    submission->prefix = submission_format("{\"family\":%s,\"model\":", json_family);
+    submission->suffix = submission_format(",\"url\":%s,\"color\":\"%d\",\"duplex\":\"%d\",\"finishings\":\"%d\",\"fin_fold\":\"%d\",\"fin_punch\":\"%d\",\"fin_staple\":\"%d\",\"fin_trim\":\"%d\",\"ipps\":\"%d\",\"firmware_update\":\"%d\",\"media\":\"%s\",\"version\":%s,\"date\":%s}", json_webpage, ipp_summary->color, ipp_summary->duplex, ipp_summary->finishings, ipp_summary->fin_fold, ipp_summary->fin_punch, ipp_summary->fin_staple, ipp_summary->fin_trim, dnssd_summary->ipps, firmware_update ? 1 : 0, media_formats[ipp_summary->media], json_version, json_date);
+  }
+
+  if (!submission->prefix || !submission->suffix)
+    submission->error = true;
+
+  free(json_family);
+  free(json_webpage);
+  free(json_version);
+  free(json_date);
+}
+
+
+//
+// 'submission_string()' - Encode a string as a new quoted JSON string.
+//
+// Escapes are at most two characters, so the whole string always fits.  The
+// caller must free the returned string.
+//
+
+static char *				// O - JSON string or `NULL` on error
+submission_string(const char *s)	// I - String to encode
+{
+  size_t	bufsize = 2 * strlen(s) + 3;
+					// Size of JSON string
+  char		*buffer;		// JSON string
+
+
+  if ((buffer = (char *)malloc(bufsize)) == NULL)
+    return (NULL);
+
+  return (plist_json_string(buffer, bufsize, s));
+}
+
+
+//
+// 'summarize_media()' - Classify a media size name by its width.
+//
+// Large format is more than 17" (431.8mm) wide and medium format is more than
+// 9" (228.6mm) wide.  The width of PWG self-describing names is decoded
+// directly, all other names are looked up.
+//
+
+static summary_media_t			// O - Media size class
+summarize_media(const char *media)	// I - Media size name
+{
+  const char	*ptr;			// Pointer into name
+  long		width = 0,		// Width in thousandths of units
+		scale = 1000;		// Current fractional digit scale
+  pwg_media_t	*pwg;			// PWG media size
+
+
+  if ((ptr = strrchr(media, '_')) != NULL && isdigit(ptr[1] & 255))
+  {
+    // Decode "WxHin" or "WxHmm"...
+    for (ptr ++; isdigit(*ptr & 255) && width < 100000000; ptr ++)
+      width = width * 10 + 1000 * (*ptr - '0');
+
+    if (*ptr == '.')
+    {
+      for (ptr ++; isdigit(*ptr & 255); ptr ++)
+      {
+        if (scale > 1)
+        {
+          scale /= 10;
+          width += scale * (*ptr - '0');
+	}
+      }
+    }
+
+    if (*ptr == 'x')
+    {
+      for (ptr ++; isdigit(*ptr & 255) || *ptr == '.'; ptr ++);
+
+      if (!strcmp(ptr, "in"))
+        width = width * 254 / 10;	// Inches to micrometers
+      else if (strcmp(ptr, "mm"))
+        width = -1;
+
+      if (width > 431800)
+        return (SUMMARY_MEDIA_LARGE);
+      else if (width > 228600)
+        return (SUMMARY_MEDIA_MEDIUM);
+      else if (width >= 0)
+        return (SUMMARY_MEDIA_SMALL);
+    }
+  }
+
+  // Not a self-describing name, look it up...
+  if ((pwg = pwgMediaForPWG(media)) == NULL)
+    return (SUMMARY_MEDIA_SMALL);
+  else if (pwg->width > 43180)
+    return (SUMMARY_MEDIA_LARGE);
+  else if (pwg->width > 22860)
+    return (SUMMARY_MEDIA_MEDIUM);
+  else
+    return (SUMMARY_MEDIA_SMALL);
+}
+
+
+//
+// 'summarize_supported()' - Summarize the printer capabilities.
+//
+// This makes a single pass through the Get-Printer-Attributes response,
+// finding the summarized attributes with a perfect hash of their names.
+//
+
+static void
+summarize_supported(
+    plist_t   *supported,		// I  - Supported attributes
+    summary_t *summary)			// IO - Results summary
+{
+  plist_t	*current,		// Current attribute name
+		*value;			// Current value
+  const _supported_hash_t *hash;	// Hash table entry
+  size_t	count;			// Number of values
+  summary_media_t media;		// Media size class
+  const char	*keyword;		// Finishings keyword
+  long		finishings;		// Finishings enum value
+
+
+  if (!supported || supported->type != PLIST_TYPE_DICT)
+    return;
+
+  for (current = supported->first_child; current; current = current->next_sibling)
+  {
+    // Dictionaries contain <key> nodes followed by a value node...
+    if (current->type != PLIST_TYPE_KEY || !current->value || !current->next_sibling)
+      continue;
+
+    hash = supported_hash + SUPPORTED_HASH(current->value);
+
+    if (!hash->name || strcmp(hash->name, current->value))
+      continue;
+
+    current = current->next_sibling;
+
+    if (current->type == PLIST_TYPE_ARRAY)
+    {
+      for (count = 0, value = current->first_child; value; value = value->next_sibling)
+        count ++;
+    }
+    else
+    {
+      count = 0;
+    }
+
+    switch (hash->attr)
+    {
+      case _SUPPORTED_NONE :
+          break;
+
+      case _SUPPORTED_COLOR :
+          summary->color = current->type == PLIST_TYPE_TRUE;
+          break;
+
+      case _SUPPORTED_FINISHINGS :
+          summary->finishings = count > 1;
+
+          // Look for specific kinds of finishers...
+          for (value = current->first_child; value; value = value->next_sibling)
+          {
+            if (!value->value)
+              continue;
+
+            if (isdigit(value->value[0] & 255))
+            {
+              if ((finishings = strtol(value->value, NULL, 10)) < (long)(sizeof(finishings_classes) / sizeof(finishings_classes[0])))
+              {
+                summary->fin_fold   |= (finishings_classes[finishings] & _FIN_FOLD) != 0;
+                summary->fin_punch  |= (finishings_classes[finishings] & _FIN_PUNCH) != 0;
+                summary->fin_staple |= (finishings_classes[finishings] & _FIN_STAPLE) != 0;
+                summary->fin_trim   |= (finishings_classes[finishings] & _FIN_TRIM) != 0;
+              }
+              continue;
+            }
+
+            keyword = value->value;
+
+            if (!strncmp(keyword, "fold", 4))
+              summary->fin_fold = true;
+            else if (!strncmp(keyword, "punch", 5))
+              summary->fin_punch = true;
+            else if (!strncmp(keyword, "staple", 6))
+              summary->fin_staple = true;
+            else if (!strncmp(keyword, "trim", 4))
+              summary->fin_trim = true;
+          }
+          break;
+
+      case _SUPPORTED_MEDIA :
+          for (value = current->first_child; value && summary->media < SUMMARY_MEDIA_LARGE; value = value->next_sibling)
+          {
+            if (value->value && (media = summarize_media(value->value)) > summary->media)
+              summary->media = media;
+          }
+          break;
+
+      case _SUPPORTED_SIDES :
+          summary->duplex = count > 1;
+          break;
+    }
+  }
 }
 
 
@@ -720,16 +2189,25 @@ static void
 usage(void)
 {
   puts("Usage: ippevesubmit [options] \"Printer Name\"");
+  puts("       ippevesubmit [options] -b {manifest.txt|directory}");
   puts("");
   puts("Options:");
+  puts("  --fail-fast              Stop validating at the first failure.");
   puts("  --help	           Show help.");
+  puts("  --no-cache               Do not use or update the validation cache.");
+  puts("  --split                  Write one JSON file per printer in batch mode.");
+  puts("  --validate               Only validate the test results.");
+  puts("  -b manifest.txt          Submit the printers listed in the manifest.");
+  puts("  -b directory             Submit the printers with results in the directory.");
   puts("  -f standard              The standard firmware supports IPP Everywhere.");
   puts("  -f update                The firmware may need to be updated.");
+  puts("  -j workers               Number of batch workers (default 4).");
   puts("  -m models.txt	           Specify a list of models, one per line.");
   puts("  -o filename.json         Specify the JSON output file, otherwise JSON is");
-  puts("		           sent to 'printer name.json'.");
+  puts("		           sent to 'printer name.json' or 'Batch.json'.");
   puts("  -p \"product family\"      Specify the product family.");
-  puts("  -r {dnssd|document|ipp}  Replay the results for the specified tests");
+  puts("  -r {dnssd|document|ipp|stress}");
+  puts("                           Replay the results for the specified tests");
   puts("  -t {printer|server}      Submit for a printer or print server.");
   puts("  -u URL	           Specify the product family web page.");
   puts("  -y		           Answer yes to the checklist questions.");
@@ -10,6 +10,39 @@
 
 #include "SelfCertApp.h"
 #include "selfcert.h"
+#include <atomic>
+#if _WIN32
+#  include <windows.h>
+#else
+#  include <unistd.h>
+#endif // _WIN32
+
+
+// Local constants...
+#define APP_FRAME_TIME	(1.0 / 30.0)	// Output refresh interval in seconds
+#define APP_MAX_OUTPUT	4194304		// Maximum output to keep in bytes
+#define APP_RING_SIZE	262144		// Size of output ring buffer in bytes
+
+
+// Local types...
+struct _app_printer_s			// Printer browser event
+{
+  SelfCertApp	*app;			// Application
+  dnssd_event_t	event;			// Event
+  char		name[256];		// Printer service instance name
+};
+
+struct _app_ring_s			// Output ring buffer
+{
+  std::atomic<size_t> head,		// Total bytes written by the test threads
+		tail;			// Total bytes read by the UI thread
+  char		data[APP_RING_SIZE];	// Output text
+};
+
+
+// Local functions...
+static void	app_awake(Fl_Awake_Handler cb, void *data);
+static void	app_write(_app_ring_t *ring, const char *s);
 
 
 //
@@ -24,6 +57,9 @@ main(int  argc,				// I - Number of command-line arguments
 					// Self-certification application
 
 
+  // Enable Fl::awake() for the test threads...
+  Fl::lock();
+
   app->show(argc, argv);
   Fl::run();
 
@@ -32,162 +68,501 @@ main(int  argc,				// I - Number of command-line arguments
 
 
 //
-// 'SelfCertApp::test()' - Run self-certification tests and display the output.
+// 'SelfCertApp::browseAwake()' - Add or remove a printer in the browser.
+//
+// The printers are kept in alphabetical order.
 //
 
-bool					// O - Result of tests
-SelfCertApp::test(const char *name)	// I - Printer name
+void
+SelfCertApp::browseAwake(
+    _app_printer_t *printer)		// I - Printer event
 {
-  size_t	i;			// Looping var
-  static const char *lines[] =
+  SelfCertApp	*app = printer->app;	// Application
+  int		i,			// Looping var
+		count,			// Number of printers
+		result = 1;		// Result of comparison
+
+
+  for (i = 1, count = app->browser->size(); i <= count; i ++)
   {
-    "DNS-SD Tests:\n",
-    "B-1. IPP Browse test: PASS\n",
-    "B-2. IPP TXT keys test: PASS\n",
-    "B-3. IPP Resolve test: PASS\n",
-    "B-4. IPP TXT values test: ipp://mbp14.local:8501/ipp/print\n",
-    "FAIL\n",
-    "\"dnssd-value-tests.test\":\n",
-    "    Validate TXT record values using Get-Printer-Attributes              [FAIL]\n",
-    "        RECEIVED: 8458 bytes in response\n",
-    "        status-code = successful-ok (successful-ok)\n",
-    "        EXPECTED: printer-more-info WITH-VALUE \"https://mbp14.local.:8501/\"\n",
-    "        GOT: printer-more-info=\"https://localhost:8501/\"\n",
-    "B-5. TLS tests: PASS\n",
-    "B-5.1 HTTP Upgrade test: FAIL\n",
-    "    ipptool: Unable to connect to 'mbp14.local' on port 8501: Encryption is not supported.\n",
-    "B-5.2 IPPS Browse test: PASS\n",
-    "B-5.3 IPPS TXT keys test: PASS\n",
-    "B-5.4 IPPS Resolve test: PASS\n",
-    "B-5.5 IPPS TXT values test: ipp://mbp14.local:8501/ipp/print\n",
-    "FAIL\n",
-    "\"dnssd-value-tests.test\":\n",
-    "    Validate TXT record values using Get-Printer-Attributes              [FAIL]\n",
-    "        RECEIVED: 8458 bytes in response\n",
-    "        status-code = successful-ok (successful-ok)\n",
-    "        EXPECTED: printer-more-info WITH-VALUE \"https://mbp14.local.:8501/\"\n",
-    "        GOT: printer-more-info=\"https://localhost:8501/\"\n",
-    "Summary: 10 tests, 7 passed, 3 failed, 0 skipped\n",
-    "Score: 70%\n",
-    "IPP Tests:\n",
-    "\"ipp-tests.test\":\n",
-    "    I-1. RFC 8011 section 4.1.1: Bad request-id value 0                  [PASS]\n",
-    "    I-2. RFC 8011 section 4.1.4: No Operation Attributes                 [PASS]\n",
-    "    I-3. RFC 8011 section 4.1.4: attributes-charset                      [PASS]\n",
-    "    I-4. RFC 8011 section 4.1.4: attributes-natural-language             [PASS]\n",
-    "    I-5. RFC 8011 section 4.1.4: attributes-natural-language + attribute [PASS]\n",
-    "    I-6. RFC 8011 section 4.1.4: attributes-charset + attributes-natural [PASS]\n",
-    "    I-7. RFC 8011 section 4.1.8: Unsupported IPP version 0.0             [PASS]\n",
-    "    I-8. RFC 8011 section 4.2: No printer-uri operation attribute        [PASS]\n",
-    "    I-9. Identify-Printer Operation                                      [PASS]\n",
-    "    I-10. Get-Printer-Attributes Operation (default)                     [FAIL]\n",
-    "        RECEIVED: 8458 bytes in response\n",
-    "        status-code = successful-ok (successful-ok)\n",
-    "        EXPECTED: printer-icons WITH-ALL-HOSTNAMES \"mbp14.local\"\n",
-    "        GOT: printer-icons=\"https://localhost:8501/icon-sm.png\"\n",
-    "        GOT: printer-icons=\"https://localhost:8501/icon.png\"\n",
-    "        GOT: printer-icons=\"https://localhost:8501/icon-lg.png\"\n",
-    "        EXPECTED: printer-more-info WITH-HOSTNAME \"mbp14.local\"\n",
-    "        GOT: printer-more-info=\"https://localhost:8501/\"\n",
-    "        EXPECTED: printer-supply-info-uri WITH-HOSTNAME \"mbp14.local\"\n",
-    "        GOT: printer-supply-info-uri=\"https://localhost:8501/supplies\"\n",
-    "    I-10.1 Get-Printer-Attributes Operation (all)                        [PASS]\n",
-    "    I-10.2. Get-Printer-Attributes Operation (all, media-col-database)   [PASS]\n",
-    "    I-10.3. Get-Printer-Attributes Operation (none)                      [PASS]\n",
-    "    I-10.4. Get-Printer-Attributes Operation (media-col-database)        [PASS]\n",
-    "    I-10.5. Get-Printer-Attributes Operation (printer-description)       [PASS]\n",
-    "    I-10.6. Get-Printer-Attributes Operation (job-template)              [PASS]\n",
-    "    I-10.7 Get-Printer-Attributes Operation (media-col-database, printer [PASS]\n",
-    "    I-11. Validate-Job Operation                                         [PASS]\n",
-    "    I-12. Print-Job Operation (Print-Job Test onepage)                   [PASS]\n",
-    "    I-13. Get-Jobs Operation (default)                                   [PASS]\n",
-    "    I-13.1 Get-Jobs Operation (requested-attributes)                     [PASS]\n",
-    "    I-13.2 Get-Jobs Operation (which-jobs=not-completed)                 [PASS]\n",
-    "    I-14. Get-Job-Attributes Operation (until job complete)              [0001]\n",
-    "        job-state (enum) = processing\n",
-    "    I-14. Get-Job-Attributes Operation (until job complete)              [0002]\n",
-    "        job-state (enum) = processing\n",
-    "    I-14. Get-Job-Attributes Operation (until job complete)              [0003]\n",
-    "        job-state (enum) = processing\n",
-    "    I-14. Get-Job-Attributes Operation (until job complete)              [PASS]\n",
-    "    I-15. Get-Jobs Operation (which-jobs=completed)                      [PASS]\n",
-    "    I-15.1 Get-Jobs Operation (which-jobs, requested-attributes)         [PASS]\n",
-    "    I-16. Cancel-Job Operation (completed job)                           [PASS]\n",
-    "    I-16.1 Cancel-Job Operation (Cancel-Job Test onepage)                [PASS]\n",
-    "    I-16.2. Cancel-Job Operation (pending/processing job)                [PASS]\n",
-    "    I-16.3 Cancel-Job Operations (Get-Job-Attributes)                    [PASS]\n",
-    "    I-17. Cancel-My-Jobs Operation (Cancel-My-Jobs Test onepage)         [0001]\n",
-    "    I-17. Cancel-My-Jobs Operation (Cancel-My-Jobs Test onepage)         [0002]\n",
-    "    I-17. Cancel-My-Jobs Operation (Cancel-My-Jobs Test onepage)         [PASS]\n",
-    "    I-17.1 Cancel-My-Jobs Operation (Cancel-My-Jobs)                     [PASS]\n",
-    "    I-17.2 Cancel-My-Jobs Operations (Get-Job-Attributes)                [PASS]\n",
-    "    I-18. Create-Job + Send-Document Operations (Create-Job)             [0001]\n",
-    "    I-18. Create-Job + Send-Document Operations (Create-Job)             [0002]\n",
-    "    I-18. Create-Job + Send-Document Operations (Create-Job)             [PASS]\n",
-    "    I-18.1 Create-Job + Send-Document Operations (Send-Document onepage) [PASS]\n",
-    "    I-18.2 Create-Job + Send-Document Operations (Get-Job-Attributes unt [0001]\n",
-    "        job-state (enum) = processing\n",
-    "    I-18.2 Create-Job + Send-Document Operations (Get-Job-Attributes unt [0002]\n",
-    "        job-state (enum) = processing\n",
-    "    I-18.2 Create-Job + Send-Document Operations (Get-Job-Attributes unt [PASS]\n",
-    "    I-19. Close-Job Test (Create-Job Operation)                          [PASS]\n",
-    "    I-19.1 Close-Job Test (Close-Job Operation)                          [PASS]\n",
-    "    I-19.2 Close-Job Test (Get-Job-Attributes Operation)                 [PASS]\n",
-    "    I-19.3. Close-Job Test (Cancel-Job Operation)                        [PASS]\n",
-    "    I-20. media-needed (media-needed Test onepage)                       [SKIP]\n",
-    "    I-20.1 media-needed (Get-Printer-Attributes)                         [SKIP]\n",
-    "\n",
-    "Summary: 41 tests, 38 passed, 1 failed, 2 skipped\n",
-    "Score: 97%\n",
-    "Document Tests:\n",
-    "\"document-tests.test\":\n",
-    "    D-1. PWG Raster Format Tests (mandatory)                             [PASS]\n",
-    "    D-1.1 Print PWG @ maximum resolution (black_1, no compression)       [PASS]\n",
-    "    D-1.1 Wait for job to complete...                                    [0001]\n",
-    "    D-1.1 Wait for job to complete...                                    [0002]\n",
-    "    D-1.1 Wait for job to complete...                                    [PASS]\n",
-    "    D-1.1 Print PWG @ maximum resolution, (sgray_8, no compression)      [PASS]\n",
-    "    D-1.1 Wait for job to complete...                                    [0001]\n",
-    "    D-1.1 Wait for job to complete...                                    [0002]\n",
-    "    D-1.1 Wait for job to complete...                                    [PASS]\n",
-    "    D-1.1 Print PWG @ maximum resolution (srgb_8, no compression)        [PASS]\n",
-    "    D-1.1 Wait for job to complete...                                    [0001]\n",
-    "    D-1.1 Wait for job to complete...                                    [0002]\n",
-    "    D-1.1 Wait for job to complete...                                    [PASS]\n",
-    "    D-1.1 Print PWG @ maximum resolution (cmyk_8, no compression)        [SKIP]\n",
-    "    D-1.1 Wait for job to complete...                                    [SKIP]\n",
-    "ipptool: Unsupported COMPRESSION value \"\" on line 191 of 'document-tests.test'.\n",
-    "\n",
-    "Summary: 9 tests, 7 passed, 0 failed, 2 skipped\n",
-    "Score: 100%\n"
-  };
+    if ((result = strcasecmp(app->browser->text(i), printer->name)) >= 0)
+      break;
+  }
+
+  if (printer->event == DNSSD_EVENT_REMOVE)
+  {
+    if (i <= count && !result)
+      app->browser->remove(i);
+  }
+  else if (i > count || result)
+  {
+    app->browser->insert(i, printer->name);
+  }
+
+  free(printer);
+}
+
 
+//
+// 'SelfCertApp::browseEvent()' - Send a printer browser event to the UI thread.
+//
+
+void
+SelfCertApp::browseEvent(
+    SelfCertApp   *app,			// I - Application
+    dnssd_event_t event,		// I - Event
+    const char    *name)		// I - Printer service instance name
+{
+  _app_printer_t *printer;		// Printer event
+
+
+  if ((printer = (_app_printer_t *)calloc(1, sizeof(_app_printer_t))) == NULL)
+    return;
+
+  printer->app   = app;
+  printer->event = event;
+  cupsCopyString(printer->name, name, sizeof(printer->name));
+
+  app_awake((Fl_Awake_Handler)browseAwake, printer);
+}
+
+
+//
+// 'SelfCertApp::cancel()' - Cancel the running tests.
+//
+// The test suites stop at the next progress event from the test runner.
+//
+
+void
+SelfCertApp::cancel()
+{
+  if (!testRunning)
+    return;
+
+  cupsMutexLock(&testMutex);
+  testCanceled = true;
+  cupsMutexUnlock(&testMutex);
+
+  resultsCancel->deactivate();
+
+  testDrain();
+  buffer->append("Canceling tests...\n");
+}
+
+
+//
+// 'SelfCertApp::test()' - Start the self-certification tests for a printer.
+//
+// The DNS-SD, IPP, and Document tests run on a worker thread while the event
+// loop keeps running.  Their output goes through a ring buffer that the UI
+// thread drains at a fixed frame rate, so a long run of fast tests costs one
+// text buffer update per frame rather than one per line.
+//
 
+bool					// O - `true` if started, `false` otherwise
+SelfCertApp::test(const char *name)	// I - Printer name
+{
   if (!name)
   {
     puts("No printer selected.");
     return (false);
   }
 
-  puts(name);
+  if (testRunning)
+    return (false);
+
+  if (!testRing)
+    testRing = new _app_ring_t();
+
+  cupsCopyString(testPrinter, name, sizeof(testPrinter));
+  memset(testResults, 0, sizeof(testResults));
+  testPrintServer = isPrintServer->value() != 0;
+  testCanceled    = false;
+  testValid       = false;
 
   browser->deactivate();
   resultsSubmit->deactivate();
+  resultsStatus->copy_label("");
   buffer->text("");
+  tests->reset();
+
+  if ((testThread = cupsThreadCreate((cups_thread_func_t)testRun, this)) == CUPS_THREAD_INVALID)
+  {
+    buffer->append("Unable to start tests.\n");
+    browser->activate();
+    return (false);
+  }
+
+  testRunning = true;
+  resultsCancel->activate();
+
+  Fl::add_timeout(APP_FRAME_TIME, (Fl_Timeout_Handler)testTimer, this);
+
+  return (true);
+}
+
+
+//
+// 'SelfCertApp::testAwake()' - Finish the tests on the UI thread.
+//
+
+void
+SelfCertApp::testAwake(SelfCertApp *app)// I - Application
+{
+  char		status[256];		// Test status
+
+
+  // Show the rest of the output and wait for the worker thread...
+  Fl::remove_timeout((Fl_Timeout_Handler)testTimer, app);
+
+  app->testDrain();
 
-  for (i = 0; i < (sizeof(lines) / sizeof(lines[0])); i ++)
+  cupsThreadWait(app->testThread);
+
+  app->tests->update(false, status, sizeof(status));
+  app->resultsStatus->copy_label(status);
+
+  // Then enable the buttons...
+  app->testRunning = false;
+  app->browser->activate();
+  app->resultsCancel->deactivate();
+
+  if (app->testValid)
+  {
+    app->buffer->append("All results are valid and can be submitted.\n");
+    app->resultsSubmit->activate();
+  }
+  else if (app->testCanceled)
+  {
+    app->buffer->append("Tests canceled.\n");
+  }
+  else
   {
-    output->insert(lines[i]);
-    output->show_insert_position();
+    app->buffer->append("The results cannot be submitted.\n");
+  }
+
+  app->output->insert_position(app->buffer->length());
+  app->output->show_insert_position();
+}
+
+
+//
+// 'SelfCertApp::testDrain()' - Move the output from the ring buffer to the
+//                              text buffer.
+//
+// All of the pending output is appended at once, and the oldest lines are
+// removed once there is more than 4MB of output.
+//
+
+void
+SelfCertApp::testDrain()
+{
+  size_t	head,			// Total bytes written
+		tail,			// Total bytes read
+		offset,			// Offset in ring buffer
+		count,			// Bytes to read
+		bytes;			// Bytes before the end of the ring buffer
+  char		*text;			// Output text
+  int		length;			// Length of text buffer
+
 
-    if (!strncmp(lines[i], "D-", 2) || !strncmp(lines[i], "    I-", 6) || !strncmp(lines[i], "    D-", 6))
-      Fl::wait(0.25);
+  if (!testRing)
+    return;
+
+  head = testRing->head.load(std::memory_order_acquire);
+  tail = testRing->tail.load(std::memory_order_relaxed);
+
+  if ((count = head - tail) == 0)
+    return;
+
+  if ((text = (char *)malloc(count + 1)) == NULL)
+    return;
+
+  offset = tail % APP_RING_SIZE;
+  bytes  = APP_RING_SIZE - offset;
+
+  if (bytes >= count)
+  {
+    memcpy(text, testRing->data + offset, count);
+  }
+  else
+  {
+    memcpy(text, testRing->data + offset, bytes);
+    memcpy(text + bytes, testRing->data, count - bytes);
+  }
+
+  text[count] = '\0';
+
+  testRing->tail.store(head, std::memory_order_release);
+
+  buffer->append(text);
+  free(text);
+
+  // Limit the scrollback...
+  if ((length = buffer->length()) > APP_MAX_OUTPUT)
+    buffer->remove(0, buffer->line_end(length - APP_MAX_OUTPUT) + 1);
+
+  output->insert_position(buffer->length());
+  output->show_insert_position();
+}
+
+
+//
+// 'SelfCertApp::testEvent()' - Write test progress for the UI thread.
+//
+// This is called on the test suite threads, one event at a time.  Returning
+// `false` cancels the tests.
+//
+
+bool					// O - `true` to continue, `false` to cancel
+SelfCertApp::testEvent(
+    SelfCertApp         *app,		// I - Application
+    selfcert_suite_t    suite,		// I - Test suite
+    runner_event_t      event,		// I - Event
+    const runner_test_t *test,		// I - Test, if any
+    const char          *message)	// I - Message, if any
+{
+  char		line[2048];		// Output line
+  bool		canceled;		// Were the tests canceled?
+  static const char * const prefixes[] =
+  {					// Test suite prefixes
+    "DNS-SD",
+    "IPP",
+    "Document"
+  };
+  static const char * const suite_names[] =
+  {					// Test suite headings
+    "DNS-SD Tests",
+    "IPP Tests",
+    "Document Tests"
+  };
+
+
+  app->tests->addEvent(suite, event, test);
+
+  line[0] = '\0';
+
+  switch (event)
+  {
+    case RUNNER_EVENT_SUITE_START :
+        snprintf(line, sizeof(line), "%-8s Started %s.\n", prefixes[suite], suite_names[suite]);
+        break;
+
+    case RUNNER_EVENT_TEST_START :
+    case RUNNER_EVENT_TEST_REPEAT :
+        break;
+
+    case RUNNER_EVENT_TEST_END :
+        if (test->num_iterations > 1)
+          snprintf(line, sizeof(line), "%-8s %-60.60s [%s] %8.3fs (%u requests)\n", prefixes[suite], test->name, test->status, test->end - test->start, (unsigned)test->num_iterations);
+        else
+          snprintf(line, sizeof(line), "%-8s %-60.60s [%s] %8.3fs\n", prefixes[suite], test->name, test->status, test->end - test->start);
+        break;
+
+    case RUNNER_EVENT_SUITE_END :
+        // Remember the results files for validation...
+        cupsCopyString(app->testResults[suite], message, sizeof(app->testResults[suite]));
+        snprintf(line, sizeof(line), "%-8s Wrote \"%s\".\n", prefixes[suite], message);
+        break;
+
+    case RUNNER_EVENT_MESSAGE :
+        snprintf(line, sizeof(line), "%-8s %s\n", prefixes[suite], message);
+        break;
+  }
+
+  if (line[0])
+    app_write(app->testRing, line);
+
+  cupsMutexLock(&app->testMutex);
+  canceled = app->testCanceled;
+  cupsMutexUnlock(&app->testMutex);
+
+  return (!canceled);
+}
+
+
+//
+// 'SelfCertApp::testRun()' - Run the test suites and validate the results.
+//
+// This is the worker thread started by SelfCertApp::test().
+//
+
+void *					// O - Thread exit status
+SelfCertApp::testRun(SelfCertApp *app)	// I - Application
+{
+  int		suite;			// Current test suite
+  plist_t	*results;		// Results plist
+  bool		ran,			// Did all of the tests run?
+		ret,			// Did the results validate?
+		valid;			// Are all results valid?
+  char		errors[1024],		// Validation errors
+		line[2048];		// Output line
+  static const char * const prefixes[] =
+  {					// Test suite prefixes
+    "DNS-SD",
+    "IPP",
+    "Document"
+  };
+  static const selfcert_suite_t suites[] =
+  {					// Test suites to run
+    SELFCERT_SUITE_DNSSD,
+    SELFCERT_SUITE_IPP,
+    SELFCERT_SUITE_DOCUMENT
+  };
+
+
+  // Load the durations from the previous results before they are replaced...
+  app->tests->loadHistory(app->testPrinter);
+
+  // Get the printer attributes again in case the printer has changed since
+  // the last run...
+  snapshot_clear(app->testPrinter);
+
+  valid = ran = runner_run_suites(app->testPrinter, NULL, RUNNER_MODE_ALL, sizeof(suites) / sizeof(suites[0]), suites, (runner_suites_cb_t)testEvent, app);
+
+  // Validate the results of each suite like ippevesubmit does...
+  for (suite = SELFCERT_SUITE_DNSSD; ran && suite <= SELFCERT_SUITE_DOCUMENT; suite ++)
+  {
+    errors[0] = '\0';
+
+    if (!app->testResults[suite][0] || (results = plist_read(NULL, app->testResults[suite], NULL, NULL)) == NULL)
+    {
+      ret = false;
+      cupsCopyString(errors, "Unable to read results.", sizeof(errors));
+    }
     else
-      Fl::wait(0.01);
+    {
+      switch (suite)
+      {
+        case SELFCERT_SUITE_DNSSD :
+            ret = validate_dnssd_results(app->testResults[suite], results, app->testPrintServer, errors, sizeof(errors));
+            break;
+        case SELFCERT_SUITE_IPP :
+            ret = validate_ipp_results(app->testResults[suite], results, app->testPrintServer, errors, sizeof(errors));
+            break;
+        default :
+            ret = validate_document_results(app->testResults[suite], results, app->testPrintServer, errors, sizeof(errors));
+            break;
+      }
+
+      plist_delete(results);
+    }
+
+    if (ret)
+      snprintf(line, sizeof(line), "%-8s Results are valid.\n", prefixes[suite]);
+    else
+      snprintf(line, sizeof(line), "%-8s Results are not valid: %s\n", prefixes[suite], errors);
+
+    app_write(app->testRing, line);
+
+    if (!ret)
+      valid = false;
   }
 
-  resultsSubmit->activate();
-  browser->activate();
+  // Let the UI thread know that the tests are done...
+  app->testValid = valid;
 
-  return (true);
+  app_awake((Fl_Awake_Handler)testAwake, app);
+
+  return (NULL);
+}
+
+
+//
+// 'SelfCertApp::testTimer()' - Show new output and test progress once per
+//                              frame.
+//
+
+void
+SelfCertApp::testTimer(SelfCertApp *app)// I - Application
+{
+  char		status[256];		// Test status
+
+
+  app->testDrain();
+
+  app->tests->update(true, status, sizeof(status));
+  app->resultsStatus->copy_label(status);
+
+  Fl::repeat_timeout(APP_FRAME_TIME, (Fl_Timeout_Handler)testTimer, app);
+}
+
+
+//
+// 'app_awake()' - Send a message to the UI thread.
+//
+// Waits for room in the awake queue when it is full.
+//
+
+static void
+app_awake(Fl_Awake_Handler cb,		// I - Callback
+          void             *data)	// I - Callback data
+{
+  while (Fl::awake(cb, data))
+  {
+#if _WIN32
+    Sleep(10);
+#else
+    usleep(10000);
+#endif // _WIN32
+  }
+}
+
+
+//
+// 'app_write()' - Write output to the ring buffer.
+//
+// Only one thread writes at a time since runner_run_suites() sends one event
+// at a time and the validation messages are written after it returns.  When
+// the ring buffer is full, wait for the UI thread to catch up.
+//
+
+static void
+app_write(_app_ring_t *ring,		// I - Ring buffer
+          const char  *s)		// I - Output text
+{
+  size_t	head,			// Total bytes written
+		tail,			// Total bytes read
+		offset,			// Offset in ring buffer
+		count,			// Bytes to write
+		bytes,			// Bytes before the end of the ring buffer
+		length = strlen(s);	// Length of output
+
+
+  while (length > 0)
+  {
+    head = ring->head.load(std::memory_order_relaxed);
+    tail = ring->tail.load(std::memory_order_acquire);
+
+    if ((count = APP_RING_SIZE - (head - tail)) == 0)
+    {
+#if _WIN32
+      Sleep(10);
+#else
+      usleep(10000);
+#endif // _WIN32
+      continue;
+    }
+
+    if (count > length)
+      count = length;
+
+    offset = head % APP_RING_SIZE;
+    bytes  = APP_RING_SIZE - offset;
+
+    if (bytes >= count)
+    {
+      memcpy(ring->data + offset, s, count);
+    }
+    else
+    {
+      memcpy(ring->data + offset, s, bytes);
+      memcpy(ring->data, s + bytes, count - bytes);
+    }
+
+    ring->head.store(head + count, std::memory_order_release);
+
+    s      += count;
+    length -= count;
+  }
 }
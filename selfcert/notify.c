@@ -0,0 +1,458 @@
+//
+// Job notifications for the IPP Everywhere Printer Self-Certification
+// application.
+//
+// Copyright © 2024 by the IEEE-ISTO Printer Working Group.
+//
+// Licensed under Apache License v2.0.	See the file "LICENSE" for more
+// information.
+//
+// When the printer supports "ippget" notifications for the "job-created" and
+// "job-completed" events, a printer subscription is created and a thread waits
+// for events using Get-Notifications with "notify-wait".  The test runner uses
+// this to learn when the jobs from a test have completed without polling the
+// printer with Get-Job-Attributes.
+//
+
+#include "selfcert.h"
+#include <cups/thread.h>
+
+
+// Local constants...
+#define NOTIFY_CREATE_TIME	5.0	// Seconds to wait for a "job-created" event
+
+
+// Local types...
+typedef struct _notify_job_s		// Job from notifications
+{
+  int		id;			// Job ID
+  double	created;		// Time of "job-created" event
+  bool		completed;		// Has the job completed?
+} _notify_job_t;
+
+struct notify_s				// Job notifications
+{
+  char		host[256],		// Printer hostname
+		resource[256],		// Printer resource path
+		uri[1024];		// Printer URI
+  int		port;			// Printer port number
+  http_encryption_t encryption;		// Encryption for connections
+  http_t	*wait_http;		// Connection for Get-Notifications
+  int		sub_id,			// Subscription ID
+		sequence;		// Last sequence number
+  cups_thread_t	thread;			// Thread waiting for events
+  cups_mutex_t	mutex;			// Mutex for jobs
+  cups_cond_t	cond;			// Condition for jobs
+  bool		stop,			// Stop waiting for events?
+		done;			// Is the thread done?
+  size_t	num_jobs,		// Number of jobs
+		alloc_jobs;		// Allocated jobs
+  _notify_job_t	*jobs;			// Jobs
+};
+
+
+// Local functions...
+static void	notify_events(notify_t *notify, ipp_t *response);
+static void	notify_job(notify_t *notify, int id, const char *event);
+static ipp_t	*notify_request(notify_t *notify, ipp_op_t op);
+static void	*notify_run(notify_t *notify);
+
+
+//
+// 'notify_delete()' - Cancel the subscription and free memory.
+//
+
+void
+notify_delete(notify_t *notify)		// I - Job notifications
+{
+  http_t	*http;			// Connection to printer
+
+
+  if (!notify)
+    return;
+
+  // Stop the thread, interrupting any pending Get-Notifications request...
+  cupsMutexLock(&notify->mutex);
+  notify->stop = true;
+  http         = notify->wait_http;
+  cupsCondBroadcast(&notify->cond);
+  cupsMutexUnlock(&notify->mutex);
+
+  if (http)
+    httpShutdown(http);
+
+  if (notify->thread != CUPS_THREAD_INVALID)
+    cupsThreadWait(notify->thread);
+
+  httpClose(notify->wait_http);
+
+  // Cancel the subscription...
+  if ((http = connpool_get(notify->host, notify->port, notify->encryption)) != NULL)
+  {
+    ippDelete(cupsDoRequest(http, notify_request(notify, IPP_OP_CANCEL_SUBSCRIPTION), notify->resource));
+    connpool_put(http);
+  }
+
+  cupsCondDestroy(&notify->cond);
+  cupsMutexDestroy(&notify->mutex);
+
+  free(notify->jobs);
+  free(notify);
+}
+
+
+//
+// 'notify_new()' - Subscribe to job events for a printer.
+//
+// The printer is a DNS-SD service instance name or an "ipp" or "ipps" URI.
+// `NULL` is returned if the printer cannot be reached or doesn't support
+// "ippget" notifications for the "job-created" and "job-completed" events.
+//
+
+notify_t *				// O - Job notifications or `NULL` if not supported
+notify_new(const char *printer)		// I - Printer name or URI
+{
+  notify_t	*notify;		// Job notifications
+  char		uri[1024],		// Printer URI
+		scheme[32],		// URI scheme
+		userpass[256],		// URI username:password
+		host[256],		// URI hostname
+		resource[256];		// URI resource path
+  int		port;			// URI port number
+  http_t	*http;			// Connection to printer
+  ipp_t		*request,		// IPP request
+		*response;		// IPP response
+  ipp_attribute_t *attr;		// IPP attribute
+  int		sub_id = 0;		// Subscription ID
+  static const char * const pattrs[] =	// Printer attributes
+  {
+    "notify-events-supported",
+    "notify-pull-method-supported"
+  };
+  static const char * const events[] =	// Job events
+  {
+    "job-completed",
+    "job-created"
+  };
+
+
+  // Get the printer URI and connect to it...
+  if (!printer)
+    return (NULL);
+
+  if (!strncmp(printer, "ipp://", 6) || !strncmp(printer, "ipps://", 7))
+    cupsCopyString(uri, printer, sizeof(uri));
+  else if (!dnssd_get_uri(printer, uri, sizeof(uri)))
+    return (NULL);
+
+  if (httpSeparateURI(HTTP_URI_CODING_ALL, uri, scheme, sizeof(scheme), userpass, sizeof(userpass), host, sizeof(host), &port, resource, sizeof(resource)) < HTTP_URI_STATUS_OK)
+    return (NULL);
+
+  if ((http = connpool_get(host, port, !strcmp(scheme, "ipps") ? HTTP_ENCRYPTION_ALWAYS : HTTP_ENCRYPTION_IF_REQUESTED)) == NULL)
+    return (NULL);
+
+  if ((notify = (notify_t *)calloc(1, sizeof(notify_t))) == NULL)
+  {
+    connpool_put(http);
+    return (NULL);
+  }
+
+  cupsCopyString(notify->host, host, sizeof(notify->host));
+  cupsCopyString(notify->resource, resource, sizeof(notify->resource));
+  cupsCopyString(notify->uri, uri, sizeof(notify->uri));
+
+  notify->port       = port;
+  notify->encryption = !strcmp(scheme, "ipps") ? HTTP_ENCRYPTION_ALWAYS : HTTP_ENCRYPTION_IF_REQUESTED;
+
+  // See if the printer supports the job events and subscribe to them...
+  request = notify_request(notify, IPP_OP_GET_PRINTER_ATTRIBUTES);
+  ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(pattrs) / sizeof(pattrs[0]), NULL, pattrs);
+
+  response = cupsDoRequest(http, request, resource);
+
+  if ((attr = ippFindAttribute(response, "notify-pull-method-supported", IPP_TAG_KEYWORD)) != NULL && ippContainsString(attr, "ippget") && (attr = ippFindAttribute(response, "notify-events-supported", IPP_TAG_KEYWORD)) != NULL && ippContainsString(attr, "job-created") && ippContainsString(attr, "job-completed"))
+  {
+    ippDelete(response);
+
+    request = notify_request(notify, IPP_OP_CREATE_PRINTER_SUBSCRIPTIONS);
+    ippAddString(request, IPP_TAG_SUBSCRIPTION, IPP_TAG_KEYWORD, "notify-pull-method", NULL, "ippget");
+    ippAddStrings(request, IPP_TAG_SUBSCRIPTION, IPP_TAG_KEYWORD, "notify-events", sizeof(events) / sizeof(events[0]), NULL, events);
+
+    response = cupsDoRequest(http, request, resource);
+
+    if ((attr = ippFindAttribute(response, "notify-subscription-id", IPP_TAG_INTEGER)) != NULL)
+      sub_id = ippGetInteger(attr, 0);
+  }
+
+  ippDelete(response);
+
+  connpool_put(http);
+
+  if (sub_id <= 0)
+  {
+    free(notify);
+    return (NULL);
+  }
+
+  // Start waiting for events...
+  notify->sub_id = sub_id;
+
+  cupsMutexInit(&notify->mutex);
+  cupsCondInit(&notify->cond);
+
+  if ((notify->thread = cupsThreadCreate((cups_thread_func_t)notify_run, notify)) == CUPS_THREAD_INVALID)
+  {
+    notify->done = true;
+    notify_delete(notify);
+    return (NULL);
+  }
+
+  return (notify);
+}
+
+
+//
+// 'notify_wait()' - Wait for jobs to complete.
+//
+// Waits until every job created at or after the specified time has completed.
+// If no job has been created yet, waits a few seconds for the "job-created"
+// event to arrive.  `false` is returned if the jobs did not complete before
+// the timeout or the printer stopped sending events, in which case the caller
+// needs to poll the job state instead.
+//
+
+bool					// O - `true` if the jobs completed, `false` otherwise
+notify_wait(notify_t *notify,		// I - Job notifications
+            double   since,		// I - Time the jobs were created
+            double   timeout)		// I - Timeout in seconds
+{
+  size_t	i;			// Looping var
+  _notify_job_t	*job;			// Current job
+  double	now,			// Current time
+		start,			// Start time
+		end;			// End time
+  bool		created;		// Was a job created?
+  bool		ret = false;		// Return value
+
+
+  if (!notify)
+    return (false);
+
+  start = runner_get_time();
+  end   = start + timeout;
+
+  cupsMutexLock(&notify->mutex);
+
+  while (!notify->done && (now = runner_get_time()) < end)
+  {
+    for (i = notify->num_jobs, job = notify->jobs, created = false; i > 0; i --, job ++)
+    {
+      if (job->created >= since)
+      {
+        created = true;
+
+        if (!job->completed)
+          break;
+      }
+    }
+
+    if (i == 0 && (created || now >= (start + NOTIFY_CREATE_TIME)))
+    {
+      ret = true;
+      break;
+    }
+
+    cupsCondWait(&notify->cond, &notify->mutex, created ? end - now : start + NOTIFY_CREATE_TIME - now);
+  }
+
+  cupsMutexUnlock(&notify->mutex);
+
+  return (ret);
+}
+
+
+//
+// 'notify_events()' - Record the job events in a Get-Notifications response.
+//
+
+static void
+notify_events(notify_t *notify,		// I - Job notifications
+              ipp_t    *response)	// I - Get-Notifications response
+{
+  ipp_attribute_t *attr;		// Current attribute
+  const char	*name,			// Attribute name
+		*event = NULL;		// Event name
+  int		id = 0;			// Job ID
+
+
+  cupsMutexLock(&notify->mutex);
+
+  for (attr = ippGetFirstAttribute(response); attr; attr = ippGetNextAttribute(response))
+  {
+    if ((name = ippGetName(attr)) == NULL || ippGetGroupTag(attr) != IPP_TAG_EVENT_NOTIFICATION)
+    {
+      // End of event group...
+      if (event && id > 0)
+        notify_job(notify, id, event);
+
+      event = NULL;
+      id    = 0;
+    }
+    else if (!strcmp(name, "notify-job-id"))
+    {
+      id = ippGetInteger(attr, 0);
+    }
+    else if (!strcmp(name, "notify-sequence-number") && ippGetInteger(attr, 0) > notify->sequence)
+    {
+      notify->sequence = ippGetInteger(attr, 0);
+    }
+    else if (!strcmp(name, "notify-subscribed-event"))
+    {
+      event = ippGetString(attr, 0, NULL);
+    }
+  }
+
+  if (event && id > 0)
+    notify_job(notify, id, event);
+
+  cupsCondBroadcast(&notify->cond);
+  cupsMutexUnlock(&notify->mutex);
+}
+
+
+//
+// 'notify_job()' - Record a job event.
+//
+// The notify mutex must be held.
+//
+
+static void
+notify_job(notify_t   *notify,		// I - Job notifications
+           int        id,		// I - Job ID
+           const char *event)		// I - Event name
+{
+  size_t	i;			// Looping var
+  _notify_job_t	*job;			// Current job
+
+
+  for (i = notify->num_jobs, job = notify->jobs; i > 0; i --, job ++)
+  {
+    if (job->id == id)
+      break;
+  }
+
+  if (i == 0)
+  {
+    if (notify->num_jobs >= notify->alloc_jobs)
+    {
+      if ((job = (_notify_job_t *)realloc(notify->jobs, (notify->alloc_jobs + 32) * sizeof(_notify_job_t))) == NULL)
+        return;
+
+      notify->jobs       = job;
+      notify->alloc_jobs += 32;
+    }
+
+    job = notify->jobs + notify->num_jobs;
+    notify->num_jobs ++;
+
+    job->id        = id;
+    job->created   = runner_get_time();
+    job->completed = false;
+  }
+
+  if (!strcmp(event, "job-completed"))
+    job->completed = true;
+}
+
+
+//
+// 'notify_request()' - Create a request for the printer.
+//
+
+static ipp_t *				// O - IPP request
+notify_request(notify_t *notify,	// I - Job notifications
+               ipp_op_t op)		// I - Operation code
+{
+  ipp_t	*request = ippNewRequest(op);	// IPP request
+
+
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, notify->uri);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+
+  if (op == IPP_OP_CANCEL_SUBSCRIPTION)
+    ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-subscription-id", notify->sub_id);
+
+  return (request);
+}
+
+
+//
+// 'notify_run()' - Wait for job events.
+//
+
+static void *				// O - Thread exit status (unused)
+notify_run(notify_t *notify)		// I - Job notifications
+{
+  http_t	*http;			// Get-Notifications connection
+  ipp_t		*request,		// IPP request
+		*response;		// IPP response
+  ipp_status_t	status;			// IPP status
+  ipp_attribute_t *attr;		// notify-get-interval attribute
+  int		interval;		// Seconds to wait before the next request
+
+
+  if ((http = httpConnect(notify->host, notify->port, NULL, AF_UNSPEC, notify->encryption, true, 30000, NULL)) != NULL)
+  {
+    cupsMutexLock(&notify->mutex);
+    notify->wait_http = http;
+    cupsMutexUnlock(&notify->mutex);
+
+    while (!notify->stop)
+    {
+      // Wait for events newer than the last one...
+      request = notify_request(notify, IPP_OP_GET_NOTIFICATIONS);
+      ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-subscription-ids", notify->sub_id);
+      ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-sequence-numbers", notify->sequence + 1);
+      ippAddBoolean(request, IPP_TAG_OPERATION, "notify-wait", true);
+
+      response = cupsDoRequest(http, request, notify->resource);
+      status   = cupsGetError();
+
+      if (status >= IPP_STATUS_REDIRECTION_OTHER_SITE)
+      {
+        ippDelete(response);
+        break;
+      }
+
+      notify_events(notify, response);
+
+      if (status == IPP_STATUS_OK_EVENTS_COMPLETE)
+      {
+        // The subscription has ended...
+        ippDelete(response);
+        break;
+      }
+
+      // Printers that don't hold the request tell us when to ask again...
+      interval = (attr = ippFindAttribute(response, "notify-get-interval", IPP_TAG_INTEGER)) != NULL ? ippGetInteger(attr, 0) : 0;
+
+      ippDelete(response);
+
+      if (interval > 0)
+      {
+	cupsMutexLock(&notify->mutex);
+	if (!notify->stop)
+	  cupsCondWait(&notify->cond, &notify->mutex, interval);
+	cupsMutexUnlock(&notify->mutex);
+      }
+    }
+  }
+
+  // Let any waiters know that there will be no more events...
+  cupsMutexLock(&notify->mutex);
+  notify->done = true;
+  cupsCondBroadcast(&notify->cond);
+  cupsMutexUnlock(&notify->mutex);
+
+  return (NULL);
+}
@@ -12,9 +12,24 @@
 #include <stdarg.h>
 
 
+// Local constants...
+#define PLIST_MAX_DEPTH	256		// Maximum nesting of <array> and <dict>
+
+
+// Local types...
+typedef struct _plist_read_s		// Tree building data for plist_read()
+{
+  plist_t	*plist,			// Root node
+		*parent;		// Current parent node
+  bool		complete,		// Saw the end of the root node?
+		error;			// Out of memory?
+} _plist_read_t;
+
+
 // Local functions...
 static void	json_puts(FILE *fp, const char *s);
 static FILE	*open_file(const char *filename, const char *mode, plist_error_cb_t cb, void *cb_data);
+static bool	read_cb(void *cb_data, plist_event_t event, plist_type_t type, const char *value);
 static void	report_error(plist_error_cb_t cb, void *cb_data, const char *filename, int linenum, const char *message, ...) SELFCERT_FORMAT(5,6);
 static char	*xml_gets(FILE *fp, char *buffer, size_t bufsize, int *linenum);
 static void	xml_puts(FILE *fp, const char *s);
@@ -207,6 +222,85 @@ plist_find(plist_t    *parent,		// I - Parent node
 }
 
 
+//
+// 'plist_json_string()' - Encode a string as a quoted JSON string.
+//
+// The encoded string is truncated as needed to fit in the buffer, without
+// splitting UTF-8 characters.
+//
+
+char *					// O - Encoded string
+plist_json_string(char       *buffer,	// I - Buffer
+                  size_t     bufsize,	// I - Size of buffer
+                  const char *s)	// I - String to encode
+{
+  char		*bufptr,		// Pointer into buffer
+		*bufend;		// End of buffer
+  char		c;			// Escape character
+  size_t	len;			// Length of UTF-8 character
+
+
+  bufptr = buffer;
+  bufend = buffer + bufsize - 2;
+
+  *bufptr++ = '\"';
+
+  for (; *s && bufptr < bufend; s ++)
+  {
+    if (*s == '\b')
+      c = 'b';
+    else if (*s == '\f')
+      c = 'f';
+    else if (*s == '\n')
+      c = 'n';
+    else if (*s == '\r')
+      c = 'r';
+    else if (*s == '\t')
+      c = 't';
+    else if (*s == '\\' || *s == '\"')
+      c = *s;
+    else if ((*s & 255) >= ' ')
+      c = '\0';
+    else
+      continue;
+
+    if (c)
+    {
+      if ((bufptr + 1) >= bufend)
+        break;
+
+      *bufptr++ = '\\';
+      *bufptr++ = c;
+    }
+    else
+    {
+      // Copy whole UTF-8 characters so that truncation doesn't split them...
+      if ((*s & 0xe0) == 0xc0)
+        len = 2;
+      else if ((*s & 0xf0) == 0xe0)
+        len = 3;
+      else if ((*s & 0xf8) == 0xf0)
+        len = 4;
+      else
+        len = 1;
+
+      if ((bufptr + len) > bufend)
+        break;
+
+      for (; len > 1 && (s[1] & 0xc0) == 0x80; len --)
+        *bufptr++ = *s++;
+
+      *bufptr++ = *s;
+    }
+  }
+
+  *bufptr++ = '\"';
+  *bufptr   = '\0';
+
+  return (buffer);
+}
+
+
 //
 // 'plist_new()' - Create a new plist (XML) file with its plist root node.
 //
@@ -219,32 +313,46 @@ plist_new(void)
 
 
 //
-// 'plist_read()' - Read a plist (XML) file.
+// 'plist_parse()' - Parse a plist (XML) file without building a tree.
+//
+// The event callback is called for the start and end of each <plist>,
+// <array>, and <dict> element and for each <key> and value element.  Parsing
+// stops early when the callback returns `false`.  Only the current element is
+// held in memory, so memory use does not depend on the size of the file.
 //
 
-plist_t *				// O - Root node of plist file or `NULL` on error
-plist_read(FILE             *fp,	// I - Input file or `NULL` to open filename
-           const char       *filename,	// I - Filename
-           plist_error_cb_t cb,		// I - Error callback function
-           void             *cb_data)	// I - Error callback data
+bool					// O - `true` on success or early stop, `false` on error
+plist_parse(
+    FILE             *fp,		// I - Input file or `NULL` to open filename
+    const char       *filename,		// I - Filename
+    plist_event_cb_t event_cb,		// I - Event callback function
+    void             *event_data,	// I - Event callback data
+    plist_error_cb_t cb,		// I - Error callback function
+    void             *cb_data)		// I - Error callback data
 {
-  bool		close_fp = !fp;		// Close the input file?
-  plist_t	*plist = NULL,		// Root plist node
-		*parent = NULL;		// Current parent node
+  bool		ret = false,		// Return value
+		close_fp = !fp,		// Close the input file?
+		seen_plist = false,	// Seen the <plist> element?
+		needval = false;	// Just read a <key>, need a value
+  plist_type_t	stack[PLIST_MAX_DEPTH];	// Stack of open elements
+  int		depth = 0;		// Number of open elements
   char		buffer[65536];		// Element/value buffer
   int		linenum = 1;		// Current line number
-  int		needval = 0;		// Just read a <key>, need a value
+  plist_type_t	type;			// Value type
+  const char	*name;			// Name of value element
+  char		element[16],		// Expected closing element
+		close[64];		// Actual closing element
 
 
   // Range check input...
-  if (!fp && !filename)
-    return (NULL);
+  if ((!fp && !filename) || !event_cb)
+    return (false);
 
   // Open file as needed...
   if (!fp)
   {
     if ((fp = open_file(filename, "r", cb, cb_data)) == NULL)
-      return (NULL);
+      return (false);
   }
 
   // Read the file...
@@ -255,206 +363,214 @@ plist_read(FILE             *fp,	// I - Input file or `NULL` to open filename
       // Ignore XML document declarations...
       continue;
     }
-    else if (!strncmp(buffer, "<plist ", 7))
+    else if (!strncmp(buffer, "<plist ", 7) || !strcmp(buffer, "<plist>"))
     {
       // A <plist> element starts the data content, but only if we haven't
       // already seen a root node!
-      if (plist)
+      if (seen_plist)
       {
         report_error(cb, cb_data, filename, linenum, "Unexpected (second) <plist> seen.");
 	break;
       }
 
-      plist = parent = plist_add(NULL, PLIST_TYPE_PLIST, NULL);
+      seen_plist = true;
+      stack[depth ++] = PLIST_TYPE_PLIST;
+
+      if (!(event_cb)(event_data, PLIST_EVENT_START, PLIST_TYPE_PLIST, NULL))
+      {
+        ret = true;
+        break;
+      }
     }
-    else if (!plist)
+    else if (!seen_plist)
     {
       // Cannot handle content before <plist ...>
       break;
     }
-    else if (!strcmp(buffer, "</plist>"))
+    else if (!strcmp(buffer, "</plist>") || !strcmp(buffer, "</array>") || !strcmp(buffer, "</dict>"))
     {
-      // End of the data content...
-      if (parent != plist)
-      {
-	buffer[0] = 'x';		// Flag this as an error
-
-	report_error(cb, cb_data, filename, linenum, "Unexpected '</plist>'.");
-      }
+      // End of the current container...
+      type = !strcmp(buffer, "</plist>") ? PLIST_TYPE_PLIST : !strcmp(buffer, "</array>") ? PLIST_TYPE_ARRAY : PLIST_TYPE_DICT;
 
-      break;
-    }
-    else if (!strcmp(buffer, "<array>"))
-    {
-      parent  = plist_add(parent, PLIST_TYPE_ARRAY, NULL);
-      needval = 0;
-    }
-    else if (!strcmp(buffer, "<array />"))
-    {
-      // Empty array...
-      plist_add(parent, PLIST_TYPE_ARRAY, NULL);
-      needval = 0;
-    }
-    else if (!strcmp(buffer, "</array>"))
-    {
-      if (parent->type != PLIST_TYPE_ARRAY)
+      if (stack[depth - 1] != type)
       {
 	report_error(cb, cb_data, filename, linenum, "Unexpected '%s'.", buffer);
 	break;
       }
 
-      parent = parent->parent;
-    }
-    else if (!strcmp(buffer, "<dict>"))
-    {
-      parent  = plist_add(parent, PLIST_TYPE_DICT, NULL);
-      needval = 0;
-    }
-    else if (!strcmp(buffer, "<dict />"))
-    {
-      // Empty dict...
-      plist_add(parent, PLIST_TYPE_DICT, NULL);
-      needval = 0;
-    }
-    else if (!strcmp(buffer, "</dict>"))
-    {
-      if (parent->type != PLIST_TYPE_DICT)
+      depth --;
+
+      if (!(event_cb)(event_data, PLIST_EVENT_END, type, NULL))
       {
-	report_error(cb, cb_data, filename, linenum, "Unexpected '%s'.", buffer);
-	break;
+        ret = true;
+        break;
       }
 
-      parent = parent->parent;
-    }
-    else if (!strcmp(buffer, "<key>"))
-    {
-      if (needval)
+      if (type == PLIST_TYPE_PLIST)
       {
-	report_error(cb, cb_data, filename, linenum, "Expected a value after a '<key>' element.");
-	break;
+        // End of the data content...
+        ret = true;
+        break;
       }
+    }
+    else if (!strcmp(buffer, "<array>") || !strcmp(buffer, "<dict>"))
+    {
+      // Start of a new container...
+      type = !strcmp(buffer, "<array>") ? PLIST_TYPE_ARRAY : PLIST_TYPE_DICT;
 
-      if (!xml_gets(fp, buffer, sizeof(buffer), &linenum))
+      if (depth >= PLIST_MAX_DEPTH)
       {
-	report_error(cb, cb_data, filename, linenum, "Missing <key> value.");
+	report_error(cb, cb_data, filename, linenum, "Too many nested elements.");
 	break;
       }
 
-      plist_add(parent, PLIST_TYPE_KEY, buffer);
-      needval = 1;
+      stack[depth ++] = type;
+      needval         = false;
 
-      if (!xml_gets(fp, buffer, sizeof(buffer), &linenum) || strcmp(buffer, "</key>"))
+      if (!(event_cb)(event_data, PLIST_EVENT_START, type, NULL))
       {
-	report_error(cb, cb_data, filename, linenum, "Unexpected '%s'.", buffer);
-	break;
+        ret = true;
+        break;
       }
     }
-    else if (!strcmp(buffer, "<data>"))
+    else if (!strcmp(buffer, "<array />") || !strcmp(buffer, "<array/>") || !strcmp(buffer, "<dict />") || !strcmp(buffer, "<dict/>"))
     {
-      if (!xml_gets(fp, buffer, sizeof(buffer), &linenum))
+      // Empty container...
+      type    = !strncmp(buffer, "<array", 6) ? PLIST_TYPE_ARRAY : PLIST_TYPE_DICT;
+      needval = false;
+
+      if (!(event_cb)(event_data, PLIST_EVENT_START, type, NULL) || !(event_cb)(event_data, PLIST_EVENT_END, type, NULL))
       {
-	report_error(cb, cb_data, filename, linenum, "Missing <data> value.");
-	break;
+        ret = true;
+        break;
       }
+    }
+    else if (!strcmp(buffer, "<false />") || !strcmp(buffer, "<false/>") || !strcmp(buffer, "<true />") || !strcmp(buffer, "<true/>"))
+    {
+      // Boolean value...
+      needval = false;
 
-      plist_add(parent, PLIST_TYPE_DATA, buffer);
-      needval = 0;
-
-      if (!xml_gets(fp, buffer, sizeof(buffer), &linenum) || strcmp(buffer, "</data>"))
+      if (!(event_cb)(event_data, PLIST_EVENT_VALUE, buffer[1] == 't' ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL))
       {
-	report_error(cb, cb_data, filename, linenum, "Unexpected '%s'.", buffer);
-	break;
+        ret = true;
+        break;
       }
     }
-    else if (!strcmp(buffer, "<date>"))
+    else
     {
-      if (!xml_gets(fp, buffer, sizeof(buffer), &linenum))
+      // Something with a value - <key>, <data>, <date>, <integer>, or <string>
+      if (!strcmp(buffer, "<key>"))
       {
-	report_error(cb, cb_data, filename, linenum, "Missing <date> value.");
-	break;
-      }
-
-      plist_add(parent, PLIST_TYPE_DATE, buffer);
-      needval = 0;
+	if (needval)
+	{
+	  report_error(cb, cb_data, filename, linenum, "Expected a value after a '<key>' element.");
+	  break;
+	}
 
-      if (!xml_gets(fp, buffer, sizeof(buffer), &linenum) || strcmp(buffer, "</date>"))
+        type    = PLIST_TYPE_KEY;
+        name    = "key";
+      }
+      else if (!strcmp(buffer, "<data>"))
       {
-	report_error(cb, cb_data, filename, linenum, "Unexpected '%s'.", buffer);
-	break;
+        type    = PLIST_TYPE_DATA;
+        name    = "data";
       }
-    }
-    else if (!strcmp(buffer, "<false />"))
-    {
-      plist_add(parent, PLIST_TYPE_FALSE, NULL);
-      needval = 0;
-    }
-    else if (!strcmp(buffer, "<integer>"))
-    {
-      if (!xml_gets(fp, buffer, sizeof(buffer), &linenum))
+      else if (!strcmp(buffer, "<date>"))
       {
-	report_error(cb, cb_data, filename, linenum, "Missing <integer> value.");
-	break;
+        type    = PLIST_TYPE_DATE;
+        name    = "date";
       }
-
-      plist_add(parent, PLIST_TYPE_INTEGER, buffer);
-      needval = 0;
-
-      if (!xml_gets(fp, buffer, sizeof(buffer), &linenum) || strcmp(buffer, "</integer>"))
+      else if (!strcmp(buffer, "<integer>"))
       {
-	report_error(cb, cb_data, filename, linenum, "Unexpected '%s'.", buffer);
+        type    = PLIST_TYPE_INTEGER;
+        name    = "integer";
+      }
+      else if (!strcmp(buffer, "<string>"))
+      {
+        type    = PLIST_TYPE_STRING;
+        name    = "string";
+      }
+      else
+      {
+	// Something else that was unexpected...
+	report_error(cb, cb_data, filename, linenum, "Unknown '%s'.", buffer);
 	break;
       }
-    }
-    else if (!strcmp(buffer, "<string>"))
-    {
+
       if (!xml_gets(fp, buffer, sizeof(buffer), &linenum))
       {
-	report_error(cb, cb_data, filename, linenum, "Missing <string> value.");
+	report_error(cb, cb_data, filename, linenum, "Missing <%s> value.", name);
 	break;
       }
 
-      if (!strcmp(buffer, "</string>"))
+      snprintf(element, sizeof(element), "</%s>", name);
+
+      if (type == PLIST_TYPE_STRING && !strcmp(buffer, element))
+      {
+        // Empty string...
+        buffer[0] = '\0';
+      }
+      else if (buffer[0] == '<')
       {
-	plist_add(parent, PLIST_TYPE_STRING, "");
+	report_error(cb, cb_data, filename, linenum, "Unexpected '%s'.", buffer);
+	break;
       }
       else
       {
-	plist_add(parent, PLIST_TYPE_STRING, buffer);
-
-	if (!xml_gets(fp, buffer, sizeof(buffer), &linenum) || strcmp(buffer, "</string>"))
+        // Make sure the value is followed by the closing element...
+	if (!xml_gets(fp, close, sizeof(close), &linenum) || strcmp(close, element))
 	{
-	  report_error(cb, cb_data, filename, linenum, "Unexpected '%s'.", buffer);
+	  report_error(cb, cb_data, filename, linenum, "Unexpected '%s'.", close);
 	  break;
 	}
       }
 
-      needval = 0;
-    }
-    else if (!strcmp(buffer, "<true />"))
-    {
-      plist_add(parent, PLIST_TYPE_TRUE, NULL);
-      needval = 0;
-    }
-    else
-    {
-      // Something else that was unexpected...
-      report_error(cb, cb_data, filename, linenum, "Unkwown '%s'.", buffer);
-      break;
+      needval = type == PLIST_TYPE_KEY;
+
+      if (!(event_cb)(event_data, PLIST_EVENT_VALUE, type, buffer))
+      {
+        ret = true;
+        break;
+      }
     }
   }
 
-  if (plist && strcmp(buffer, "</plist>"))
-  {
+  if (seen_plist && !ret)
     report_error(cb, cb_data, filename, linenum, "File appears to be truncated or corrupted.");
-    plist_delete(plist);
-    plist = NULL;
-  }
 
   // Close the file as needed...
   if (close_fp)
     fclose(fp);
 
-  return (plist);
+  return (ret);
+}
+
+
+//
+// 'plist_read()' - Read a plist (XML) file.
+//
+
+plist_t *				// O - Root node of plist file or `NULL` on error
+plist_read(FILE             *fp,	// I - Input file or `NULL` to open filename
+           const char       *filename,	// I - Filename
+           plist_error_cb_t cb,		// I - Error callback function
+           void             *cb_data)	// I - Error callback data
+{
+  _plist_read_t	data;			// Tree building data
+
+
+  memset(&data, 0, sizeof(data));
+
+  if (!plist_parse(fp, filename, read_cb, &data, cb, cb_data) || data.error || !data.complete)
+  {
+    if (data.error)
+      report_error(cb, cb_data, filename, 0, "%s", strerror(ENOMEM));
+
+    plist_delete(data.plist);
+    return (NULL);
+  }
+
+  return (data.plist);
 }
 
 
@@ -497,23 +613,28 @@ plist_write(
   if (!fp)
   {
     if ((fp = open_file(filename, "w", cb, cb_data)) == NULL)
-      return (NULL);
+      return (false);
   }
 
   // Write file header...
   fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n", fp);
   fputs("<!DOCTYPE plist PUBLIC \"-//Apple Computer//DTD PLIST 1.0//EN\" \"http://www.apple.com/DTDs/PropertyList-1.0.dtd\">\n", fp);
 
+  if (plist->type == PLIST_TYPE_PLIST)
+    fputs("<plist version=\"1.0\">\n", fp);
+
   for (current = plist->first_child; current; current = next)
   {
     switch (current->type)
     {
       case PLIST_TYPE_PLIST :
-          fputs("<plist version=\"1.0\">\n", fp);
 	  break;
       case PLIST_TYPE_ARRAY :
       case PLIST_TYPE_DICT :
-          fprintf(fp, "%*s<%s>\n", indent, "", elements[current->type]);
+          if (current->first_child)
+	    fprintf(fp, "%*s<%s>\n", indent, "", elements[current->type]);
+	  else
+	    fprintf(fp, "%*s<%s />\n", indent, "", elements[current->type]);
 	  break;
       case PLIST_TYPE_KEY :
       case PLIST_TYPE_DATA :
@@ -521,12 +642,12 @@ plist_write(
       case PLIST_TYPE_INTEGER :
       case PLIST_TYPE_STRING :
           fprintf(fp, "%*s<%s>", indent, "", elements[current->type]);
-          xml_puts(fp, current->value);
-          fprintf(fp, "</%s\n>", elements[current->type]);
+          xml_puts(fp, current->value ? current->value : "");
+          fprintf(fp, "</%s>\n", elements[current->type]);
 	  break;
       case PLIST_TYPE_FALSE :
       case PLIST_TYPE_TRUE :
-          fprintf(fp, "%*s<%s/>\n", indent, "", elements[current->type]);
+          fprintf(fp, "%*s<%s />\n", indent, "", elements[current->type]);
 	  break;
     }
 
@@ -539,10 +660,11 @@ plist_write(
     {
       // Ascend parent(s)...
       next = current->parent;
-      indent -= 4;
 
-      while (next)
+      while (next && next != plist)
       {
+        indent -= 4;
+
 	if (next->type == PLIST_TYPE_ARRAY || next->type == PLIST_TYPE_DICT)
           fprintf(fp, "%*s</%s>\n", indent, "", elements[next->type]);
 
@@ -552,16 +674,19 @@ plist_write(
 	  next = next->next_sibling;
 	  break;
 	}
-	else
-	{
-	  // Ascend parent...
-	  next = next->parent;
-	  indent -= 4;
-	}
+
+	// Ascend parent...
+	next = next->parent;
       }
+
+      if (next == plist)
+        next = NULL;
     }
   }
 
+  if (plist->type == PLIST_TYPE_PLIST)
+    fputs("</plist>\n", fp);
+
   // Close the file as needed...
   if (close_fp)
     fclose(fp);
@@ -595,7 +720,7 @@ plist_write_json(
   if (!fp)
   {
     if ((fp = open_file(filename, "w", cb, cb_data)) == NULL)
-      return (NULL);
+      return (false);
   }
 
   // Write the plist as a JSON array...
@@ -606,7 +731,8 @@ plist_write_json(
 
   for (current = plist->first_child; current; current = next)
   {
-    if (current->prev_sibling && current->parent->type == PLIST_TYPE_ARRAY)
+    // Top-level values are written one per line...
+    if (current->prev_sibling && (current->parent->type == PLIST_TYPE_ARRAY || current->parent->type == PLIST_TYPE_PLIST))
       fputs(",\n", fp);
 
     switch (current->type)
@@ -614,10 +740,10 @@ plist_write_json(
       case PLIST_TYPE_PLIST :
 	  break;
       case PLIST_TYPE_ARRAY :
-	  putc('[', fp);
+	  fputs(current->first_child ? "[" : "[]", fp);
 	  break;
       case PLIST_TYPE_DICT :
-	  putc('{', fp);
+	  fputs(current->first_child ? "{" : "{}", fp);
 	  break;
       case PLIST_TYPE_KEY :
 	  if (current->prev_sibling)
@@ -666,9 +792,7 @@ plist_write_json(
     }
   }
 
-  if (plist->type == PLIST_TYPE_DICT)
-    putc(']', fp);
-
+  putc(']', fp);
   putc('\n', fp);
 
   // Close the file as needed...
@@ -737,6 +861,56 @@ open_file(const char       *filename,	// I - Filename to open
 }
 
 
+//
+// 'read_cb()' - Add a parsed element to a plist tree.
+//
+
+static bool				// O - `true` to continue, `false` to stop
+read_cb(void          *cb_data,	// I - Tree building data
+        plist_event_t event,		// I - Parsing event
+        plist_type_t  type,		// I - Element type
+        const char    *value)		// I - Element value, if any
+{
+  _plist_read_t	*data = (_plist_read_t *)cb_data;
+					// Tree building data
+  plist_t	*node;			// New node
+
+
+  switch (event)
+  {
+    case PLIST_EVENT_START :
+        if ((node = plist_add(data->parent, type, NULL)) == NULL)
+        {
+          data->error = true;
+          return (false);
+        }
+
+        if (!data->plist)
+          data->plist = node;
+
+        data->parent = node;
+        break;
+
+    case PLIST_EVENT_END :
+        if (data->parent == data->plist)
+          data->complete = true;
+
+        data->parent = data->parent->parent;
+        break;
+
+    case PLIST_EVENT_VALUE :
+        if (!plist_add(data->parent, type, value))
+        {
+          data->error = true;
+          return (false);
+        }
+        break;
+  }
+
+  return (true);
+}
+
+
 //
 // 'report_error()' - Report an error when loading a plist file.
 //
@@ -0,0 +1,2585 @@
+//
+// Test runner for the IPP Everywhere Printer Self-Certification application.
+//
+// Copyright © 2024 by the IEEE-ISTO Printer Working Group.
+//
+// Licensed under Apache License v2.0.	See the file "LICENSE" for more
+// information.
+//
+// The runner starts ipptool (via ippfind) for the IPP and Document tests and
+// follows its progress output to track when each test and each repeated
+// request starts and ends.  The DNS-SD tests run in the same process using
+// dnssd_run().  Once the tests are done, the timing information is added to
+// the results plist:
+//
+//   <key>StartTime</key><integer>milliseconds since 1970</integer>
+//   <key>EndTime</key><integer>milliseconds since 1970</integer>
+//   <key>Iterations</key><array>
+//     <dict><key>StartTime</key>...<key>EndTime</key>...</dict>
+//     ...
+//   </array>
+//
+// "Iterations" is only added for tests that repeated their request, e.g.,
+// when polling for the job state.
+//
+// Successful Print-Job tests in the Document tests also get the printer
+// throughput for the job:
+//
+//   <key>DocumentSize</key><integer>bytes</integer>
+//   <key>ResponseRate</key><integer>bytes per second</integer>
+//   <key>ResponseTime</key><integer>milliseconds</integer>
+//   <key>JobTime</key><integer>milliseconds</integer>
+//   <key>ImpressionsCompleted</key><integer>impressions</integer>
+//
+// "ResponseTime" is the time from sending the Print-Job request to getting
+// the response, and "ResponseRate" is the document size divided by it.  Since
+// the printer may process the document before responding, "ResponseRate" is
+// not the upload rate, only a lower bound of it.  ipptool does not report
+// when it finished sending the document.
+// "JobTime" is the time from sending the Print-Job request until the job is
+// seen as completed by the Get-Job-Attributes test that follows it, and
+// "ImpressionsCompleted" is the final "job-impressions-completed" value.
+// "DocumentSize" and "ResponseRate" are only added when the size of the
+// document is known.
+//
+// When the printer supports job notifications, the test file is fed to ipptool
+// through a named pipe.  Each test that polls Get-Job-Attributes until the job
+// completes is held back until the notifications show that the jobs created
+// since the previous hold have completed, so the first request matches and no
+// time is spent waiting between repeated requests.  Otherwise ipptool reads
+// the test file directly.
+//
+// While the IPP and Document tests run, a checkpoint plist ("Name Suite
+// Checkpoint.plist") is written after each test with the test file, the start
+// time, and the name, status, errors, and timing of each completed test.  It
+// is removed once the results are written.  In RUNNER_MODE_RESUME the tests
+// listed in the checkpoint are skipped using "SKIP-IF-DEFINED" and their
+// entries in the results are restored from the checkpoint.  The checkpoint
+// has no request or response attributes, so the I-10 test that ippevesubmit
+// reads the printer's capabilities from is always run again.  ipptool does not
+// report the variables that tests define, so the tests that define variables
+// from printer attributes are run again, and the run backs up to the test that
+// created a job when a later test still needs its job ID.  Simple capability
+// probes like the one in D-1 are instead evaluated from the printer attribute
+// snapshot (see snapshot.c) and their variables are passed to ipptool with
+// "-d".  RUNNER_MODE_FAILED works the same way with the previous results,
+// skipping the tests that passed unless a failed test needs them.
+//
+// runner_run_suites() runs several test suites against one printer at the
+// same time, one thread per suite.  The DNS-SD suite does not create jobs and
+// starts right away, while a suite that creates jobs waits for every
+// job-creating suite listed before it so that only one suite prints at a time.
+// The IPP suite is split in two: its tests that only get attributes (I-1 to
+// I-10.7) start right away, and the test file is held at the first test that
+// creates a job until the other job-creating suites are done, so the Document
+// tests print while the IPP attribute tests run.  When the test file cannot be
+// fed through a named pipe (always on Windows) the whole IPP suite waits
+// instead.
+//
+
+#include "selfcert.h"
+#include <cups/thread.h>
+#if _WIN32
+#  include <sys/timeb.h>
+#  define pclose _pclose
+#  define popen _popen
+#else
+#  include <sys/time.h>
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <sys/ioctl.h>
+#endif // _WIN32
+
+
+// Local constants...
+#define RUNNER_FEED_IDLE	10	// Seconds before releasing a hold without a test count match
+#define RUNNER_JOB_TIMEOUT	300.0	// Maximum seconds to wait for job events
+#define RUNNER_MAX_FILES	64	// Maximum number of documents
+#define RUNNER_MAX_HOLDS	64	// Maximum number of held tests
+#define RUNNER_MAX_LINE		1024	// Maximum length of an output line
+#define RUNNER_RESUME_VAR	"IPPEVERUN_RESUME"
+					// Variable for skipping completed tests
+#define RUNNER_SUMMARY_TEST	9	// IPP test whose response ippevesubmit summarizes (I-10)
+
+
+// Local types...
+typedef struct _runner_hold_s		// Test held until jobs complete
+{
+  size_t	offset,			// Offset of test in test file
+		num_tests;		// Number of tests before it
+} _runner_hold_t;
+
+typedef struct _runner_file_s		// Document sent by a test
+{
+  size_t	num_test;		// Test number
+  char		filename[1024];		// Document filename
+  size_t	size;			// Document size or 0 if unknown
+} _runner_file_t;
+
+struct runner_s				// Test runner
+{
+  char		printer[256];		// Printer name or URI
+  selfcert_suite_t suite;		// Test suite
+  char		resultsfile[1024],	// Results plist filename
+		checkpointfile[1024],	// Checkpoint plist filename
+		attrsfile[1024];	// Printer attributes plist filename
+  runner_mode_t	mode;			// Test runner mode
+  runner_cb_t	cb;			// Event callback
+  void		*cb_data;		// Event callback data
+  bool		canceled;		// Was the run canceled?
+  double	start,			// Start time
+		end;			// End time
+  size_t	num_tests,		// Number of tests
+		alloc_tests;		// Allocated tests
+  runner_test_t	*tests,			// Tests
+		*current;		// Current test, if any
+  bool		in_request;		// Waiting for the current request?
+  char		line[RUNNER_MAX_LINE];	// Current output line
+  size_t	linelen;		// Length of current output line
+  plist_t	*checkpoint,		// Checkpoint plist, if any
+		*checkpoint_tests,	// Tests array in checkpoint
+		*previous,		// Previous results plist, if any
+		*restore_tests;		// Tests array to restore from
+  size_t	num_resume;		// Number of tests before the resume point
+  bool		*restored;		// Tests restored from the checkpoint
+  ipp_t		*attrs;			// Printer attributes, if any
+  size_t	num_defines;		// Number of variables from printer attributes
+  cups_option_t	*defines;		// Variables from printer attributes
+  notify_t	*notify;		// Job notifications, if any
+  char		feedfile[1024],		// Named pipe for test file
+		*feed;			// Test file contents
+  int		feed_fd,		// Named pipe for writing or -1
+		feed_reader;		// Named pipe for reading or -1
+  size_t	feed_len,		// Length of test file
+		feed_pos,		// Bytes written to named pipe
+		feed_end,		// Bytes released for writing
+		num_holds,		// Number of held tests
+		next_hold;		// Next held test
+  double	feed_time;		// Time of last release
+  _runner_hold_t holds[RUNNER_MAX_HOLDS];
+					// Held tests
+  size_t	num_files;		// Number of documents
+  _runner_file_t files[RUNNER_MAX_FILES];
+					// Documents sent by the tests
+  struct _runner_phase_s *phase;	// Phase whose job tests wait, if any
+  size_t	feed_gate;		// Offset of first job test to hold or 0
+};
+
+typedef struct _runner_suites_s		// Concurrent test suites
+{
+  cups_mutex_t	mutex;			// Mutex for the phases and callback
+  cups_cond_t	cond;			// Condition for finished phases
+  runner_suites_cb_t cb;		// Event callback
+  void		*cb_data;		// Event callback data
+  bool		canceled;		// Was the run canceled?
+} _runner_suites_t;
+
+typedef struct _runner_phase_s		// Test suite phase
+{
+  _runner_suites_t *suites;		// Concurrent test suites
+  struct _runner_phase_s *after[3];	// Phases that must finish first
+  size_t	num_after;		// Number of phases that must finish first
+  selfcert_suite_t suite;		// Test suite
+  runner_t	*runner;		// Test runner
+  cups_thread_t	thread;			// Thread running the suite
+  bool		gated,			// Do only the job tests wait?
+		done,			// Is the phase done?
+		ok;			// Did the tests run?
+} _runner_phase_t;
+
+
+// Local functions...
+static void	runner_add_integer(plist_t *dict, const char *key, double value);
+static runner_test_t *runner_add_test(runner_t *runner, const char *name, double t);
+static void	runner_add_throughput(runner_t *runner, plist_t *job, size_t num_test, runner_test_t *jtest, plist_t *wait, runner_test_t *wtest);
+static bool	runner_add_timing(runner_t *runner);
+static void	runner_add_time(plist_t *dict, const char *key, double t);
+static void	runner_checkpoint_error(runner_t *runner, const char *message);
+static void	runner_checkpoint_open(runner_t *runner, const char *testfile);
+static void	runner_checkpoint_restore(runner_t *runner, plist_t *results, plist_t *test, size_t num_test);
+static plist_t	*runner_checkpoint_status(runner_t *runner, runner_test_t *test);
+static void	runner_checkpoint_test(runner_t *runner, runner_test_t *test);
+static bool	runner_checkpoint_write(runner_t *runner);
+static void	runner_copy(plist_t *parent, plist_t *node);
+static bool	runner_dnssd_cb(runner_t *runner, runner_event_t event, const runner_test_t *test, const char *message);
+static bool	runner_event(runner_t *runner, runner_event_t event, runner_test_t *test, const char *message);
+#if !_WIN32
+static void	runner_feed_close(runner_t *runner);
+static bool	runner_feed_defines(const char *block, const char *user);
+static bool	runner_feed_file(const char *block, char *filename, size_t filesize);
+static char	*runner_feed_next(char *ptr, char *end, char **block);
+static bool	runner_feed_open(runner_t *runner, const char *testfile);
+static void	runner_feed_release(runner_t *runner, bool force);
+static void	runner_feed_resume(runner_t *runner);
+static void	runner_feed_run(runner_t *runner, FILE *fp);
+static bool	runner_feed_snapshot(runner_t *runner, const char *block);
+static bool	runner_feed_uses(const char *block, const char *name);
+#endif // !_WIN32
+static bool	runner_iteration(runner_t *runner, bool start, double t);
+static bool	runner_output(runner_t *runner, int ch);
+static bool	runner_phase_cb(_runner_phase_t *phase, runner_event_t event, const runner_test_t *test, const char *message);
+static bool	runner_phase_ready(_runner_phase_t *phase, bool wait, bool *canceled);
+static void	*runner_phase_run(_runner_phase_t *phase);
+static void	runner_quote(char *buffer, size_t bufsize, const char *arg);
+static const char *runner_tool(const char *name, char *buffer, size_t bufsize);
+
+
+//
+// 'runner_delete()' - Delete a test runner.
+//
+
+void
+runner_delete(runner_t *runner)		// I - Test runner
+{
+  size_t	i;			// Looping var
+
+
+  if (!runner)
+    return;
+
+  for (i = 0; i < runner->num_tests; i ++)
+    free(runner->tests[i].iterations);
+
+  free(runner->tests);
+  plist_delete(runner->checkpoint);
+  plist_delete(runner->previous);
+  free(runner->restored);
+  ippDelete(runner->attrs);
+  cupsFreeOptions(runner->num_defines, runner->defines);
+  free(runner);
+}
+
+
+//
+// 'runner_get_resultsfile()' - Get the results plist filename.
+//
+
+const char *				// O - Results filename
+runner_get_resultsfile(
+    runner_t *runner)			// I - Test runner
+{
+  return (runner ? runner->resultsfile : NULL);
+}
+
+
+//
+// 'runner_get_time()' - Get the current wall clock time in seconds.
+//
+
+double					// O - Seconds since 1970
+runner_get_time(void)
+{
+#if _WIN32
+  struct _timeb		tb;		// Current time
+
+  _ftime_s(&tb);
+
+  return ((double)tb.time + 0.001 * tb.millitm);
+
+#else
+  struct timeval	tv;		// Current time
+
+  gettimeofday(&tv, NULL);
+
+  return ((double)tv.tv_sec + 0.000001 * tv.tv_usec);
+#endif // _WIN32
+}
+
+
+//
+// 'runner_new()' - Create a test runner for a printer and test suite.
+//
+// The printer is a DNS-SD service instance name or an "ipp" or "ipps" URI.
+// The results are written to "Name Suite Results.plist" in the current
+// directory, which must also contain the test files.  The name defaults to
+// the printer's service instance name and may include a directory path to
+// write the results elsewhere.  The mode specifies whether to run all tests,
+// to resume from the checkpoint left by an interrupted run, or to re-run the
+// tests that failed in the previous results.
+//
+
+runner_t *				// O - Test runner or `NULL` on error
+runner_new(const char       *printer,	// I - Printer name or URI
+           const char       *name,	// I - Name for results or `NULL` for printer
+           selfcert_suite_t suite,	// I - Test suite
+           runner_mode_t    mode,	// I - Test runner mode
+           runner_cb_t      cb,		// I - Event callback or `NULL` for none
+           void             *cb_data)	// I - Event callback data
+{
+  runner_t	*runner;		// Test runner
+  static const char * const suites[] =	// Test suite names
+  {
+    "DNS-SD",
+    "IPP",
+    "Document"
+  };
+
+
+  if (!printer || !*printer || (!name && strstr(printer, "://")) || suite < SELFCERT_SUITE_DNSSD || suite > SELFCERT_SUITE_DOCUMENT)
+    return (NULL);
+
+  if ((runner = (runner_t *)calloc(1, sizeof(runner_t))) == NULL)
+    return (NULL);
+
+  cupsCopyString(runner->printer, printer, sizeof(runner->printer));
+  snprintf(runner->resultsfile, sizeof(runner->resultsfile), "%s %s Results.plist", name ? name : printer, suites[suite]);
+  snprintf(runner->checkpointfile, sizeof(runner->checkpointfile), "%s %s Checkpoint.plist", name ? name : printer, suites[suite]);
+  snprintf(runner->attrsfile, sizeof(runner->attrsfile), "%s Printer Attributes.plist", name ? name : printer);
+
+  runner->suite       = suite;
+  runner->mode        = mode;
+  runner->cb          = cb;
+  runner->cb_data     = cb_data;
+  runner->feed_fd     = -1;
+  runner->feed_reader = -1;
+
+  return (runner);
+}
+
+
+//
+// 'runner_run()' - Run the test suite.
+//
+
+bool					// O - `true` if the tests ran, `false` on error or cancel
+runner_run(runner_t *runner)		// I - Test runner
+{
+  char		command[4096],		// Command to run
+		tool[1024],		// Tool path
+		uri[1024],		// Printer URI
+		temp[1024];		// Temporary string
+  const char	*testfile;		// Test file
+  FILE		*fp;			// Output from command
+  int		ch,			// Current output character
+		status;			// Exit status
+  struct stat	fileinfo;		// Results file information
+  bool		is_uri,			// Is the printer a URI?
+		ran;			// Did the DNS-SD tests run?
+  size_t	i;			// Looping var
+#if !_WIN32
+  size_t	count;			// Number of tests to run
+  bool		canceled;		// Was the run canceled?
+#endif // !_WIN32
+
+
+  if (!runner)
+    return (false);
+
+  is_uri = !strncmp(runner->printer, "ipp://", 6) || !strncmp(runner->printer, "ipps://", 7);
+
+  runner->start = runner_get_time();
+
+  if (!runner_event(runner, RUNNER_EVENT_SUITE_START, NULL, runner->resultsfile))
+    return (false);
+
+  if (runner->suite == SELFCERT_SUITE_DNSSD)
+  {
+    // Run the DNS-SD tests in this process...
+    ran         = dnssd_run(runner->printer, runner->resultsfile, (runner_cb_t)runner_dnssd_cb, runner);
+    runner->end = runner_get_time();
+
+    if (!ran)
+      return (false);
+  }
+  else
+  {
+    testfile = runner->suite == SELFCERT_SUITE_IPP ? "ipp-tests.test" : "document-tests.test";
+
+    // Start a new checkpoint or load the tests to restore...
+    runner_checkpoint_open(runner, testfile);
+
+    // Get the printer attributes that the skipped tests are evaluated from...
+    if (plist_array_count(runner->restore_tests) > 0)
+      runner->attrs = snapshot_get(runner->printer, runner->attrsfile);
+
+#if !_WIN32
+    // Use job notifications to wait for jobs when the printer supports them...
+    runner->notify = notify_new(runner->printer);
+
+    if ((runner->notify || runner->suite == SELFCERT_SUITE_DOCUMENT || runner->phase || plist_array_count(runner->restore_tests) > 0) && runner_feed_open(runner, testfile))
+    {
+      if (runner->num_resume > 0 && runner->mode == RUNNER_MODE_FAILED)
+      {
+        for (i = 0, count = 0; i < runner->num_resume; i ++)
+        {
+          if (!runner->restored[i])
+            count ++;
+        }
+
+        snprintf(temp, sizeof(temp), "Re-running %u of %u tests from the previous results.", (unsigned)count, (unsigned)runner->num_resume);
+        runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, temp);
+      }
+      else if (runner->num_resume > 0)
+      {
+        snprintf(temp, sizeof(temp), "Resuming from the checkpoint with test %u.", (unsigned)runner->num_resume + 1);
+        runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, temp);
+      }
+
+      if (runner->num_defines > 0)
+      {
+        snprintf(temp, sizeof(temp), "Using %u variables from the printer attributes.", (unsigned)runner->num_defines);
+        runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, temp);
+      }
+
+      if (runner->num_holds > 0)
+        runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, "Using job notifications to wait for jobs.");
+
+      if (runner->feed_gate)
+        runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, "Holding the tests that create jobs until the other test suites are done.");
+
+      testfile = runner->feedfile;
+    }
+    else
+    {
+      runner_feed_close(runner);
+
+      // Without the named pipe the whole suite waits for the other suites...
+      if (runner->phase && !runner_phase_ready(runner->phase, true, &canceled))
+      {
+        runner->canceled = true;
+        return (false);
+      }
+    }
+#endif // !_WIN32
+
+    // Build the command, using the printer URI from the GUI's printer browser
+    // instead of having ippfind browse for and resolve the printer again...
+    command[0] = '\0';
+
+    if (is_uri)
+      cupsCopyString(uri, runner->printer, sizeof(uri));
+    else
+      is_uri = dnssd_get_cached_uri(runner->printer, uri, sizeof(uri));
+
+    if (!is_uri)
+    {
+      runner_quote(command, sizeof(command), runner_tool("ippfind", tool, sizeof(tool)));
+      runner_quote(command, sizeof(command), "--literal-name");
+      runner_quote(command, sizeof(command), runner->printer);
+      runner_quote(command, sizeof(command), "-x");
+    }
+
+    runner_quote(command, sizeof(command), runner_tool("ipptool", tool, sizeof(tool)));
+    runner_quote(command, sizeof(command), "-P");
+    runner_quote(command, sizeof(command), runner->resultsfile);
+    runner_quote(command, sizeof(command), "-I");
+    runner_quote(command, sizeof(command), "-T");
+    runner_quote(command, sizeof(command), runner->suite == SELFCERT_SUITE_IPP ? "120" : "300");
+
+    if (runner->num_resume > 0)
+    {
+      runner_quote(command, sizeof(command), "-d");
+      runner_quote(command, sizeof(command), RUNNER_RESUME_VAR "=1");
+    }
+
+    for (i = 0; i < runner->num_defines; i ++)
+    {
+      snprintf(temp, sizeof(temp), "%s=%s", runner->defines[i].name, runner->defines[i].value);
+      runner_quote(command, sizeof(command), "-d");
+      runner_quote(command, sizeof(command), temp);
+    }
+
+    runner_quote(command, sizeof(command), is_uri ? uri : "{}");
+    runner_quote(command, sizeof(command), testfile);
+
+    if (!is_uri)
+      runner_quote(command, sizeof(command), ";");
+
+    cupsConcatString(command, " 2>&1", sizeof(command));
+
+    // Run it...
+    if ((fp = popen(command, "r")) == NULL)
+    {
+      snprintf(temp, sizeof(temp), "Unable to run tests: %s", strerror(errno));
+      runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, temp);
+#if !_WIN32
+      runner_feed_close(runner);
+#endif // !_WIN32
+      return (false);
+    }
+
+#if !_WIN32
+    if (runner->feed_fd >= 0)
+    {
+      runner_feed_run(runner, fp);
+    }
+    else
+#endif // !_WIN32
+    while ((ch = getc(fp)) != EOF)
+    {
+      if (!runner_output(runner, ch))
+	break;
+    }
+
+    if (runner->linelen > 0)
+      runner_output(runner, '\n');
+
+#if !_WIN32
+    // Let ipptool see the end of the test file if it is still reading...
+    runner_feed_close(runner);
+#endif // !_WIN32
+
+    status      = pclose(fp);
+    runner->end = runner_get_time();
+
+    if (runner->canceled)
+      return (false);
+
+    if (status)
+    {
+      snprintf(temp, sizeof(temp), "Tests exited with status %d.", status);
+      runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, temp);
+    }
+
+    // ippfind doesn't run ipptool when the printer cannot be found, leaving
+    // any results from a previous run...
+    if (stat(runner->resultsfile, &fileinfo) || fileinfo.st_mtime < (time_t)runner->start)
+    {
+      snprintf(temp, sizeof(temp), "No results were written to \"%s\".", runner->resultsfile);
+      runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, temp);
+      return (false);
+    }
+  }
+
+  // Add the timing information to the results...
+  if (!runner_add_timing(runner))
+  {
+    snprintf(temp, sizeof(temp), "Unable to add timing information to \"%s\".", runner->resultsfile);
+    runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, temp);
+  }
+  else if (runner->checkpoint)
+  {
+    // The results are complete, so the checkpoint is no longer needed...
+    unlink(runner->checkpointfile);
+  }
+
+  runner_event(runner, RUNNER_EVENT_SUITE_END, NULL, runner->resultsfile);
+
+  return (!runner->canceled);
+}
+
+
+//
+// 'runner_run_suites()' - Run several test suites concurrently.
+//
+// Each suite writes its own results plist, just like runner_run().  Events
+// from all of the suites are passed to the callback one at a time along with
+// the suite that sent them.  Returning `false` from the callback cancels the
+// suites that have not started yet and stops the running ones at the next
+// event.
+//
+
+bool					// O - `true` if all tests ran, `false` on error or cancel
+runner_run_suites(
+    const char             *printer,	// I - Printer name or URI
+    const char             *name,	// I - Name for results or `NULL` for printer
+    runner_mode_t          mode,	// I - Test runner mode
+    size_t                 num_suites,	// I - Number of test suites
+    const selfcert_suite_t *suites,	// I - Test suites
+    runner_suites_cb_t     cb,		// I - Event callback or `NULL` for none
+    void                   *cb_data)	// I - Event callback data
+{
+  _runner_suites_t	data;		// Concurrent test suites
+  _runner_phase_t	phases[3],	// Test suite phases
+			*phase,		// Current phase
+			*prev;		// Previous phase
+  size_t		i,		// Looping var
+			num_phases,	// Number of phases
+			num_ipp = 0;	// Number of IPP phases
+  bool			ok = true;	// Did all of the tests run?
+  static const bool	prints[] =	// Does the suite create jobs?
+  {
+    false,				// DNS-SD
+    true,				// IPP
+    true				// Document
+  };
+
+
+  if (!suites || num_suites == 0 || num_suites > (sizeof(phases) / sizeof(phases[0])))
+    return (false);
+
+  memset(&data, 0, sizeof(data));
+  memset(phases, 0, sizeof(phases));
+
+  cupsMutexInit(&data.mutex);
+  cupsCondInit(&data.cond);
+  data.cb      = cb;
+  data.cb_data = cb_data;
+
+  // Create the phases...
+  for (num_phases = 0, phase = phases; num_phases < num_suites; num_phases ++, phase ++)
+  {
+    phase->suites = &data;
+    phase->suite  = suites[num_phases];
+    phase->thread = CUPS_THREAD_INVALID;
+
+    if (phase->suite == SELFCERT_SUITE_IPP)
+      num_ipp ++;
+
+    if ((phase->runner = runner_new(printer, name, phase->suite, mode, (runner_cb_t)runner_phase_cb, phase)) == NULL)
+    {
+      ok = false;
+      break;
+    }
+  }
+
+  // Order the job-creating suites.  Only the job tests of a single IPP suite
+  // wait, for all of the other job-creating suites, which don't wait for it...
+  for (phase = phases; ok && phase < (phases + num_phases); phase ++)
+  {
+    if (!prints[phase->suite])
+      continue;
+
+#if !_WIN32
+    if (phase->suite == SELFCERT_SUITE_IPP && num_ipp == 1)
+    {
+      phase->gated         = true;
+      phase->runner->phase = phase;
+
+      for (prev = phases; prev < (phases + num_phases); prev ++)
+      {
+        if (prev != phase && prints[prev->suite])
+          phase->after[phase->num_after ++] = prev;
+      }
+      continue;
+    }
+#endif // !_WIN32
+
+    for (prev = phases; prev < phase; prev ++)
+    {
+      if (prints[prev->suite] && !prev->gated)
+        phase->after[phase->num_after ++] = prev;
+    }
+  }
+
+  // Start a thread for each phase...
+  for (i = 0, phase = phases; ok && i < num_phases; i ++, phase ++)
+  {
+    if ((phase->thread = cupsThreadCreate((cups_thread_func_t)runner_phase_run, phase)) == CUPS_THREAD_INVALID)
+    {
+      // Fall back to running this phase on the current thread...
+      runner_phase_run(phase);
+    }
+  }
+
+  // Wait for the phases to finish...
+  for (i = 0, phase = phases; i < num_phases; i ++, phase ++)
+  {
+    if (phase->thread != CUPS_THREAD_INVALID)
+      cupsThreadWait(phase->thread);
+
+    if (!phase->ok)
+      ok = false;
+
+    runner_delete(phase->runner);
+  }
+
+  cupsCondDestroy(&data.cond);
+  cupsMutexDestroy(&data.mutex);
+
+  return (ok && !data.canceled);
+}
+
+
+//
+// 'runner_add_integer()' - Add an integer value to a dictionary.
+//
+
+static void
+runner_add_integer(plist_t    *dict,	// I - Dictionary
+                   const char *key,	// I - Key
+                   double     value)	// I - Value
+{
+  char	temp[32];			// Value as a string
+
+
+  snprintf(temp, sizeof(temp), "%.0f", value);
+
+  plist_add(dict, PLIST_TYPE_KEY, key);
+  plist_add(dict, PLIST_TYPE_INTEGER, temp);
+}
+
+
+//
+// 'runner_add_test()' - Add a test.
+//
+
+static runner_test_t *			// O - New test or `NULL` on error
+runner_add_test(runner_t   *runner,	// I - Test runner
+                const char *name,	// I - Test name
+                double     t)		// I - Start time
+{
+  runner_test_t	*test;			// New test
+  char		*ptr;			// Pointer into name
+
+
+  if (runner->num_tests >= runner->alloc_tests)
+  {
+    if ((test = (runner_test_t *)realloc(runner->tests, (runner->alloc_tests + 32) * sizeof(runner_test_t))) == NULL)
+      return (NULL);
+
+    runner->tests       = test;
+    runner->alloc_tests += 32;
+  }
+
+  test = runner->tests + runner->num_tests;
+  runner->num_tests ++;
+
+  memset(test, 0, sizeof(runner_test_t));
+
+  // Copy the name without the trailing "[" or ":" and spaces...
+  cupsCopyString(test->name, name, sizeof(test->name));
+  for (ptr = test->name + strlen(test->name) - 1; ptr >= test->name && (*ptr == '[' || *ptr == ':' || *ptr == ' '); ptr --)
+    *ptr = '\0';
+
+  test->start     = t;
+  runner->current = test;
+
+  return (test);
+}
+
+
+//
+// 'runner_add_throughput()' - Add the throughput of a job to its Print-Job
+//                             test.
+//
+
+static void
+runner_add_throughput(
+    runner_t      *runner,		// I - Test runner
+    plist_t       *job,			// I - Print-Job test
+    size_t        num_test,		// I - Print-Job test number
+    runner_test_t *jtest,		// I - Print-Job test timing
+    plist_t       *wait,		// I - Get-Job-Attributes test
+    runner_test_t *wtest)		// I - Get-Job-Attributes test timing
+{
+  size_t	i,			// Looping var
+		size = 0;		// Document size
+  double	response = jtest->end - jtest->start;
+					// Print-Job response time
+  plist_t	*impressions;		// "job-impressions-completed" value
+
+
+  for (i = 0; i < runner->num_files; i ++)
+  {
+    if (runner->files[i].num_test == num_test)
+    {
+      size = runner->files[i].size;
+      break;
+    }
+  }
+
+  if (size > 0)
+  {
+    runner_add_integer(job, "DocumentSize", (double)size);
+
+    if (response > 0.0)
+      runner_add_integer(job, "ResponseRate", (double)size / response);
+  }
+
+  runner_add_integer(job, "ResponseTime", 1000.0 * response);
+  runner_add_integer(job, "JobTime", 1000.0 * (wtest->end - jtest->start));
+
+  if ((impressions = plist_find(wait, "ResponseAttributes/1/job-impressions-completed")) != NULL && impressions->type == PLIST_TYPE_INTEGER)
+  {
+    plist_add(job, PLIST_TYPE_KEY, "ImpressionsCompleted");
+    plist_add(job, PLIST_TYPE_INTEGER, impressions->value);
+  }
+}
+
+
+//
+// 'runner_add_time()' - Add a time value to a dictionary.
+//
+
+static void
+runner_add_time(plist_t    *dict,	// I - Dictionary
+                const char *key,	// I - Key
+                double     t)		// I - Time in seconds
+{
+  char	temp[32];			// Milliseconds as a string
+
+
+  snprintf(temp, sizeof(temp), "%.0f", t * 1000.0);
+
+  plist_add(dict, PLIST_TYPE_KEY, key);
+  plist_add(dict, PLIST_TYPE_INTEGER, temp);
+}
+
+
+//
+// 'runner_add_timing()' - Add timing information to the results plist.
+//
+
+static bool				// O - `true` on success, `false` on error
+runner_add_timing(runner_t *runner)	// I - Test runner
+{
+  plist_t	*results,		// Results plist
+		*rdict,			// Results dictionary
+		*tests,			// Tests array
+		*test,			// Current test
+		*iterations,		// Iterations array
+		*iteration,		// Current iteration
+		*operation,		// Operation name
+		*successful,		// Test status
+		*skipped,		// Test skipped?
+		*value,			// Checkpoint start time
+		*job = NULL;		// Last successful Print-Job test
+  runner_test_t	*rtest,			// Current test timing
+		*jtest = NULL;		// Last Print-Job test timing
+  size_t	i,			// Looping var
+		count,			// Number of tests
+		num_test = 0;		// Last Print-Job test number
+  double	start;			// Start time
+  bool		ret;			// Return value
+
+
+  if ((results = plist_read(NULL, runner->resultsfile, NULL, NULL)) == NULL)
+    return (false);
+
+  if ((rdict = results->first_child) == NULL || rdict->type != PLIST_TYPE_DICT || (tests = plist_find(results, "Tests")) == NULL || tests->type != PLIST_TYPE_ARRAY)
+  {
+    plist_delete(results);
+    return (false);
+  }
+
+  // A resumed run started with the checkpoint...
+  if (runner->mode == RUNNER_MODE_RESUME && runner->num_resume > 0 && (value = plist_find(runner->checkpoint, "StartTime")) != NULL && value->type == PLIST_TYPE_INTEGER)
+    start = strtod(value->value, NULL) / 1000.0;
+  else
+    start = runner->start;
+
+  runner_add_time(rdict, "StartTime", start);
+  runner_add_time(rdict, "EndTime", runner->end);
+
+  // The tools report the tests in the same order as the results...
+  for (test = tests->first_child, rtest = runner->tests, count = runner->num_tests; test && count > 0; test = test->next_sibling, rtest ++, count --)
+  {
+    if (test->type != PLIST_TYPE_DICT || !rtest->status[0])
+      continue;
+
+    if ((runner->num_tests - count) < runner->num_resume && runner->restored[runner->num_tests - count])
+    {
+      // Skipped test that completed before the run was interrupted or that
+      // passed in the previous results...
+      runner_checkpoint_restore(runner, rdict, test, runner->num_tests - count);
+      job = NULL;
+      continue;
+    }
+
+    runner_add_time(test, "StartTime", rtest->start);
+    runner_add_time(test, "EndTime", rtest->end);
+
+    if (rtest->num_iterations > 1)
+    {
+      plist_add(test, PLIST_TYPE_KEY, "Iterations");
+      iterations = plist_add(test, PLIST_TYPE_ARRAY, NULL);
+
+      for (i = 0; i < rtest->num_iterations; i ++)
+      {
+        iteration = plist_add(iterations, PLIST_TYPE_DICT, NULL);
+        runner_add_time(iteration, "StartTime", rtest->iterations[i].start);
+        runner_add_time(iteration, "EndTime", rtest->iterations[i].end);
+      }
+    }
+
+    // Add the throughput of each job in the Document tests once the test
+    // waiting for it is done...
+    if (runner->suite != SELFCERT_SUITE_DOCUMENT || (operation = plist_find(test, "Operation")) == NULL || operation->type != PLIST_TYPE_STRING)
+      continue;
+
+    successful = plist_find(test, "Successful");
+    skipped    = plist_find(test, "Skipped");
+
+    if (!successful || successful->type != PLIST_TYPE_TRUE || (skipped && skipped->type == PLIST_TYPE_TRUE))
+    {
+      job = NULL;
+    }
+    else if (!strcmp(operation->value, "Print-Job"))
+    {
+      job      = test;
+      jtest    = rtest;
+      num_test = runner->num_tests - count;
+    }
+    else if (job && !strcmp(operation->value, "Get-Job-Attributes"))
+    {
+      runner_add_throughput(runner, job, num_test, jtest, test, rtest);
+      job = NULL;
+    }
+  }
+
+  ret = plist_write(NULL, runner->resultsfile, results, NULL, NULL);
+
+  plist_delete(results);
+
+  return (ret);
+}
+
+
+//
+// 'runner_checkpoint_error()' - Add an error for the last test to the
+//                               checkpoint.
+//
+
+static void
+runner_checkpoint_error(
+    runner_t   *runner,			// I - Test runner
+    const char *message)		// I - Error message
+{
+  size_t	num_test;		// Last test number
+  plist_t	*dict,			// Test dictionary
+		*errors;		// Errors array
+  char		temp[32];		// Test number as a string
+
+
+  if (!runner->checkpoint || runner->num_tests == 0 || strcmp(runner->tests[runner->num_tests - 1].status, "FAIL"))
+    return;
+
+  num_test = runner->num_tests - 1;
+
+  if (num_test < runner->num_resume && runner->restored[num_test])
+    return;
+
+  snprintf(temp, sizeof(temp), "%u", (unsigned)num_test);
+  if ((dict = plist_find(runner->checkpoint_tests, temp)) == NULL)
+    return;
+
+  if ((errors = plist_find(dict, "Errors")) == NULL)
+  {
+    plist_add(dict, PLIST_TYPE_KEY, "Errors");
+    errors = plist_add(dict, PLIST_TYPE_ARRAY, NULL);
+  }
+
+  plist_add(errors, PLIST_TYPE_STRING, message);
+
+  runner_checkpoint_write(runner);
+}
+
+
+//
+// 'runner_checkpoint_open()' - Start a new checkpoint or load the tests to
+//                              restore.
+//
+// Resumed runs load the checkpoint, while re-runs of failed tests load the
+// previous results.
+//
+
+static void
+runner_checkpoint_open(
+    runner_t   *runner,			// I - Test runner
+    const char *testfile)		// I - Test file
+{
+  plist_t	*dict,			// Checkpoint dictionary
+		*value;			// Test file in checkpoint
+
+
+  if (runner->mode == RUNNER_MODE_FAILED)
+  {
+#if _WIN32
+    runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, "Re-running failed tests is not supported on Windows, running all tests.");
+
+#else
+    // Load the previous results, the new ones get written to the same file...
+    if ((runner->previous = plist_read(NULL, runner->resultsfile, NULL, NULL)) != NULL)
+    {
+      if ((runner->restore_tests = plist_find(runner->previous, "Tests")) != NULL && runner->restore_tests->type == PLIST_TYPE_ARRAY)
+        return;
+
+      plist_delete(runner->previous);
+      runner->previous      = NULL;
+      runner->restore_tests = NULL;
+    }
+
+    runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, "No previous results found, running all tests.");
+#endif // _WIN32
+  }
+  else if (runner->mode == RUNNER_MODE_RESUME)
+  {
+#if _WIN32
+    runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, "Resuming is not supported on Windows, running all tests.");
+
+#else
+    if ((runner->checkpoint = plist_read(NULL, runner->checkpointfile, NULL, NULL)) != NULL)
+    {
+      if ((value = plist_find(runner->checkpoint, "TestFile")) != NULL && value->type == PLIST_TYPE_STRING && !strcmp(value->value, testfile) && (runner->checkpoint_tests = plist_find(runner->checkpoint, "Tests")) != NULL && runner->checkpoint_tests->type == PLIST_TYPE_ARRAY)
+      {
+        runner->restore_tests = runner->checkpoint_tests;
+        return;
+      }
+
+      runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, "Checkpoint is for different tests, running all tests.");
+
+      plist_delete(runner->checkpoint);
+      runner->checkpoint       = NULL;
+      runner->checkpoint_tests = NULL;
+    }
+    else
+    {
+      runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, "No checkpoint found, running all tests.");
+    }
+#endif // _WIN32
+  }
+
+  // Start a new checkpoint...
+  if ((runner->checkpoint = plist_new()) == NULL || (dict = plist_add(runner->checkpoint, PLIST_TYPE_DICT, NULL)) == NULL)
+    return;
+
+  plist_add(dict, PLIST_TYPE_KEY, "TestFile");
+  plist_add(dict, PLIST_TYPE_STRING, testfile);
+  runner_add_time(dict, "StartTime", runner->start);
+  plist_add(dict, PLIST_TYPE_KEY, "Tests");
+  runner->checkpoint_tests = plist_add(dict, PLIST_TYPE_ARRAY, NULL);
+
+  unlink(runner->checkpointfile);
+}
+
+
+//
+// 'runner_checkpoint_restore()' - Restore a skipped test from the checkpoint
+//                                 or previous results.
+//
+// The test keeps the name and other information from ipptool while the
+// status, errors, timing, and any attributes come from the checkpoint or
+// previous results.  The empty request and response attributes that ipptool
+// writes for skipped tests are replaced by the previous ones.
+//
+
+static void
+runner_checkpoint_restore(
+    runner_t *runner,			// I - Test runner
+    plist_t  *results,			// I - Results dictionary
+    plist_t  *test,			// I - Test dictionary
+    size_t   num_test)			// I - Test number
+{
+  plist_t	*saved,			// Test dictionary in checkpoint
+		*key,			// Current key
+		*value,			// Current value
+		*child,			// Current error
+		*next,			// Next child
+		*current;		// Current value in test
+  char		temp[32];		// Test number as a string
+
+
+  snprintf(temp, sizeof(temp), "%u", (unsigned)num_test);
+  if ((saved = plist_find(runner->restore_tests, temp)) == NULL)
+    return;
+
+  for (key = saved->first_child; key && (value = key->next_sibling) != NULL; key = value->next_sibling)
+  {
+    if (key->type != PLIST_TYPE_KEY || !strcmp(key->value, "Name"))
+      continue;
+
+    current = plist_find(test, key->value);
+
+    if (!strcmp(key->value, "Successful") || !strcmp(key->value, "Skipped"))
+    {
+      // Replace the status...
+      if (current)
+      {
+        current->type = value->type;
+      }
+      else
+      {
+        runner_copy(test, key);
+        runner_copy(test, value);
+      }
+
+      if (!strcmp(key->value, "Successful") && value->type == PLIST_TYPE_FALSE && (current = plist_find(results, "Successful")) != NULL)
+        current->type = PLIST_TYPE_FALSE;
+    }
+    else if (!strcmp(key->value, "Errors") && current && current->type == PLIST_TYPE_ARRAY && value->type == PLIST_TYPE_ARRAY)
+    {
+      // Add errors...
+      for (child = value->first_child; child; child = child->next_sibling)
+        runner_copy(current, child);
+    }
+    else if ((!strcmp(key->value, "RequestAttributes") || !strcmp(key->value, "ResponseAttributes")) && current)
+    {
+      // Replace the placeholder attributes of the skipped test...
+      for (child = current->first_child; child; child = next)
+      {
+        next = child->next_sibling;
+        plist_delete(child);
+      }
+
+      current->first_child = current->last_child = NULL;
+      current->type        = value->type;
+
+      for (child = value->first_child; child; child = child->next_sibling)
+        runner_copy(current, child);
+    }
+    else if (!current)
+    {
+      // Add timing and other information...
+      runner_copy(test, key);
+      runner_copy(test, value);
+    }
+  }
+
+  // Tests that ran were not skipped...
+  if (!plist_find(saved, "Skipped") && (current = plist_find(test, "Skipped")) != NULL)
+    current->type = PLIST_TYPE_FALSE;
+}
+
+
+//
+// 'runner_checkpoint_status()' - Restore the status and timing of a skipped
+//                                test for the test end event.
+//
+// ipptool reports the tests restored from the checkpoint or previous results
+// as skipped, so the status, times, and requests are replaced by the saved
+// ones to match the results plist.  The saved errors, if any, are returned.
+//
+
+static plist_t *			// O - Saved errors or `NULL`
+runner_checkpoint_status(
+    runner_t      *runner,		// I - Test runner
+    runner_test_t *test)		// I - Completed test
+{
+  size_t	num_test = (size_t)(test - runner->tests);
+					// Test number
+  plist_t	*saved,			// Test dictionary in checkpoint
+		*value,			// Value in test dictionary
+		*iteration,		// Current iteration
+		*start,			// Start time of iteration
+		*end;			// End time of iteration
+  size_t	count;			// Number of iterations
+  runner_iteration_t *iterations;	// Request timing
+  char		temp[32];		// Test number as a string
+
+
+  if (num_test >= runner->num_resume || !runner->restored[num_test])
+    return (NULL);
+
+  snprintf(temp, sizeof(temp), "%u", (unsigned)num_test);
+  if ((saved = plist_find(runner->restore_tests, temp)) == NULL)
+    return (NULL);
+
+  if ((value = plist_find(saved, "Skipped")) != NULL && value->type == PLIST_TYPE_TRUE)
+    cupsCopyString(test->status, "SKIP", sizeof(test->status));
+  else if ((value = plist_find(saved, "Successful")) != NULL && value->type == PLIST_TYPE_FALSE)
+    cupsCopyString(test->status, "FAIL", sizeof(test->status));
+  else
+    cupsCopyString(test->status, "PASS", sizeof(test->status));
+
+  if ((value = plist_find(saved, "StartTime")) != NULL && value->type == PLIST_TYPE_INTEGER)
+    test->start = strtod(value->value, NULL) / 1000.0;
+  if ((value = plist_find(saved, "EndTime")) != NULL && value->type == PLIST_TYPE_INTEGER)
+    test->end = strtod(value->value, NULL) / 1000.0;
+
+  // Use the saved requests, or a single request for the whole test...
+  if ((value = plist_find(saved, "Iterations")) != NULL && value->type == PLIST_TYPE_ARRAY && (count = plist_array_count(value)) > 0)
+  {
+    if (count > test->alloc_iterations)
+    {
+      if ((iterations = (runner_iteration_t *)realloc(test->iterations, count * sizeof(runner_iteration_t))) == NULL)
+        return (plist_find(saved, "Errors"));
+
+      test->iterations       = iterations;
+      test->alloc_iterations = count;
+    }
+
+    for (test->num_iterations = 0, iteration = value->first_child; iteration && test->num_iterations < count; iteration = iteration->next_sibling)
+    {
+      if ((start = plist_find(iteration, "StartTime")) == NULL || start->type != PLIST_TYPE_INTEGER || (end = plist_find(iteration, "EndTime")) == NULL || end->type != PLIST_TYPE_INTEGER)
+        continue;
+
+      test->iterations[test->num_iterations].start = strtod(start->value, NULL) / 1000.0;
+      test->iterations[test->num_iterations].end   = strtod(end->value, NULL) / 1000.0;
+      test->num_iterations ++;
+    }
+  }
+  else if (test->num_iterations > 0)
+  {
+    test->iterations[0].start = test->start;
+    test->iterations[0].end   = test->end;
+    test->num_iterations      = 1;
+  }
+
+  return (plist_find(saved, "Errors"));
+}
+
+
+//
+// 'runner_checkpoint_test()' - Add a completed test to the checkpoint.
+//
+
+static void
+runner_checkpoint_test(
+    runner_t      *runner,		// I - Test runner
+    runner_test_t *test)		// I - Completed test
+{
+  size_t	i,			// Looping var
+		num_test = (size_t)(test - runner->tests);
+					// Test number
+  plist_t	*dict,			// Test dictionary
+		*current,		// Current node
+		*next,			// Next node
+		*iterations,		// Iterations array
+		*iteration;		// Current iteration
+  char		temp[32];		// Test number as a string
+
+
+  if (!runner->checkpoint)
+    return;
+
+  if (num_test < runner->num_resume)
+  {
+    // Tests that define variables are run again, replace their entries...
+    if (runner->restored[num_test])
+      return;
+
+    snprintf(temp, sizeof(temp), "%u", (unsigned)num_test);
+    if ((dict = plist_find(runner->checkpoint_tests, temp)) == NULL)
+      return;
+
+    for (current = dict->first_child; current; current = next)
+    {
+      next = current->next_sibling;
+      plist_delete(current);
+    }
+
+    dict->first_child = dict->last_child = NULL;
+  }
+  else if ((dict = plist_add(runner->checkpoint_tests, PLIST_TYPE_DICT, NULL)) == NULL)
+  {
+    return;
+  }
+
+  plist_add(dict, PLIST_TYPE_KEY, "Name");
+  plist_add(dict, PLIST_TYPE_STRING, test->name);
+  plist_add(dict, PLIST_TYPE_KEY, "Successful");
+  plist_add(dict, strcmp(test->status, "FAIL") ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL);
+
+  if (!strcmp(test->status, "SKIP"))
+  {
+    plist_add(dict, PLIST_TYPE_KEY, "Skipped");
+    plist_add(dict, PLIST_TYPE_TRUE, NULL);
+  }
+
+  runner_add_time(dict, "StartTime", test->start);
+  runner_add_time(dict, "EndTime", test->end);
+
+  if (test->num_iterations > 1)
+  {
+    plist_add(dict, PLIST_TYPE_KEY, "Iterations");
+    iterations = plist_add(dict, PLIST_TYPE_ARRAY, NULL);
+
+    for (i = 0; i < test->num_iterations; i ++)
+    {
+      iteration = plist_add(iterations, PLIST_TYPE_DICT, NULL);
+      runner_add_time(iteration, "StartTime", test->iterations[i].start);
+      runner_add_time(iteration, "EndTime", test->iterations[i].end);
+    }
+  }
+
+  runner_checkpoint_write(runner);
+}
+
+
+//
+// 'runner_checkpoint_write()' - Write the checkpoint.
+//
+
+static bool				// O - `true` on success, `false` on error
+runner_checkpoint_write(
+    runner_t *runner)			// I - Test runner
+{
+  char	tempfile[1040];			// Temporary file
+  bool	ret;				// Return value
+
+
+  // Write to a temporary file and then rename so that an interrupted run never
+  // leaves a partial checkpoint...
+  snprintf(tempfile, sizeof(tempfile), "%s.%d", runner->checkpointfile, (int)getpid());
+
+  if ((ret = plist_write(NULL, tempfile, runner->checkpoint, NULL, NULL)) == true)
+  {
+#if _WIN32
+    unlink(runner->checkpointfile);
+#endif // _WIN32
+
+    if (rename(tempfile, runner->checkpointfile))
+    {
+      unlink(tempfile);
+      ret = false;
+    }
+  }
+
+  return (ret);
+}
+
+
+//
+// 'runner_copy()' - Copy a plist node and its children.
+//
+
+static void
+runner_copy(plist_t *parent,		// I - New parent node
+            plist_t *node)		// I - Node to copy
+{
+  plist_t	*copy,			// Copy of node
+		*child;			// Current child node
+
+
+  if ((copy = plist_add(parent, node->type, node->value)) == NULL)
+    return;
+
+  for (child = node->first_child; child; child = child->next_sibling)
+    runner_copy(copy, child);
+}
+
+
+//
+// 'runner_dnssd_cb()' - Track the progress of the DNS-SD tests.
+//
+
+static bool				// O - `true` to continue, `false` to cancel
+runner_dnssd_cb(
+    runner_t            *runner,	// I - Test runner
+    runner_event_t      event,		// I - Event
+    const runner_test_t *test,		// I - Test, if any
+    const char          *message)	// I - Message, if any
+{
+  runner_test_t	*current = runner->current;
+					// Current test
+
+
+  switch (event)
+  {
+    case RUNNER_EVENT_TEST_START :
+        if ((current = runner_add_test(runner, test->name, test->start)) == NULL)
+          return (false);
+        break;
+
+    case RUNNER_EVENT_TEST_END :
+        if (!current)
+          return (true);
+
+        cupsCopyString(current->status, test->status, sizeof(current->status));
+        current->end    = test->end;
+        runner->current = NULL;
+        break;
+
+    default :
+        break;
+  }
+
+  return (runner_event(runner, event, current, message));
+}
+
+
+//
+// 'runner_event()' - Send an event to the callback.
+//
+
+static bool				// O - `true` to continue, `false` to cancel
+runner_event(runner_t       *runner,	// I - Test runner
+             runner_event_t event,	// I - Event
+             runner_test_t  *test,	// I - Test, if any
+             const char     *message)	// I - Message, if any
+{
+  if (runner->cb && !(runner->cb)(runner->cb_data, event, test, message))
+    runner->canceled = true;
+
+  return (!runner->canceled);
+}
+
+
+#if !_WIN32
+//
+// 'runner_feed_close()' - Close the named pipe, get the document sizes, and
+//                         stop job notifications.
+//
+
+static void
+runner_feed_close(runner_t *runner)	// I - Test runner
+{
+  size_t	i;			// Looping var
+  struct stat	fileinfo;		// Document file information
+
+
+  if (runner->feed_fd >= 0)
+  {
+    close(runner->feed_fd);
+    runner->feed_fd = -1;
+  }
+
+  if (runner->feed_reader >= 0)
+  {
+    close(runner->feed_reader);
+    runner->feed_reader = -1;
+  }
+
+  if (runner->feedfile[0])
+  {
+    unlink(runner->feedfile);
+    runner->feedfile[0] = '\0';
+  }
+
+  free(runner->feed);
+  runner->feed = NULL;
+
+  // Get the document sizes...
+  for (i = 0; i < runner->num_files; i ++)
+  {
+    if (!runner->files[i].size && !stat(runner->files[i].filename, &fileinfo) && S_ISREG(fileinfo.st_mode))
+      runner->files[i].size = (size_t)fileinfo.st_size;
+  }
+
+  notify_delete(runner->notify);
+  runner->notify = NULL;
+
+  runner->num_holds = 0;
+}
+
+
+//
+// 'runner_feed_defines()' - Determine whether a test defines a variable that
+//                           another test uses.
+//
+
+static bool				// O - `true` if used, `false` otherwise
+runner_feed_defines(const char *block,	// I - Test defining variables
+                    const char *user)	// I - Test using variables
+{
+  const char	*ptr;			// Pointer into test
+  char		name[256],		// Variable name
+		*nameptr;		// Pointer into variable name
+
+
+  for (ptr = block; (ptr = strstr(ptr, "DEFINE-")) != NULL;)
+  {
+    // Skip "DEFINE-xxx" and get the variable name...
+    while (*ptr && !isspace(*ptr & 255))
+      ptr ++;
+    while (isspace(*ptr & 255))
+      ptr ++;
+
+    for (nameptr = name; (isalnum(*ptr & 255) || *ptr == '_' || *ptr == '-') && nameptr < (name + sizeof(name) - 1); ptr ++)
+      *nameptr++ = *ptr;
+    *nameptr = '\0';
+
+    if (name[0] && runner_feed_uses(user, name))
+      return (true);
+  }
+
+  return (false);
+}
+
+
+//
+// 'runner_feed_file()' - Get the document filename from a test.
+//
+// Filenames with variables are not supported since ipptool expands them.
+//
+
+static bool				// O - `true` if found, `false` otherwise
+runner_feed_file(const char *block,	// I - Test
+                 char       *filename,	// I - Filename buffer
+                 size_t     filesize)	// I - Size of filename buffer
+{
+  const char	*ptr,			// Pointer into test
+		*start,			// Start of filename
+		*end;			// End of filename
+
+
+  // Look for "FILE filename" or "FILE "filename"" at the start of a line...
+  for (ptr = block; (ptr = strstr(ptr, "FILE")) != NULL; ptr += 4)
+  {
+    for (start = ptr; start > block && (start[-1] == ' ' || start[-1] == '\t'); start --);
+
+    if ((start == block || start[-1] == '\n') && (ptr[4] == ' ' || ptr[4] == '\t'))
+      break;
+  }
+
+  if (!ptr)
+    return (false);
+
+  for (start = ptr + 4; *start == ' ' || *start == '\t'; start ++);
+
+  if (*start == '\"')
+  {
+    if ((end = strchr(++ start, '\"')) == NULL)
+      return (false);
+  }
+  else
+  {
+    for (end = start; *end && !isspace(*end & 255); end ++);
+  }
+
+  if (end == start || (size_t)(end - start) >= filesize || memchr(start, '$', (size_t)(end - start)) || memchr(start, '\\', (size_t)(end - start)))
+    return (false);
+
+  memcpy(filename, start, (size_t)(end - start));
+  filename[end - start] = '\0';
+
+  return (true);
+}
+
+
+//
+// 'runner_feed_next()' - Find the next test in the test file.
+//
+// Each top-level "{ ... }" block in the test file is a test.  The start of the
+// test is the beginning of the line containing the opening brace.
+//
+
+static char *				// O - End of test or `NULL` if none
+runner_feed_next(char *ptr,		// I - Pointer into test file
+                 char *end,		// I - End of test file
+                 char **block)		// O - Start of test
+{
+  char	quote = '\0',			// Current quote character
+	*start = ptr;			// Start of search
+  int	depth = 0;			// Brace depth
+
+
+  for (*block = NULL; ptr < end; ptr ++)
+  {
+    if (quote)
+    {
+      if (*ptr == '\\' && ptr[1])
+        ptr ++;
+      else if (*ptr == quote)
+        quote = '\0';
+    }
+    else if (*ptr == '\"' || *ptr == '\'')
+    {
+      quote = *ptr;
+    }
+    else if (*ptr == '#' && (ptr == start || isspace(ptr[-1] & 255)))
+    {
+      // Skip comment...
+      while (ptr < end && *ptr != '\n')
+        ptr ++;
+    }
+    else if (*ptr == '{')
+    {
+      if (depth == 0)
+      {
+        for (*block = ptr; *block > start && (*block)[-1] != '\n'; (*block) --);
+      }
+
+      depth ++;
+    }
+    else if (*ptr == '}' && depth > 0)
+    {
+      if (--depth == 0)
+        return (ptr + 1);
+    }
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'runner_feed_open()' - Load the test file and create the named pipe.
+//
+// Completed tests are skipped when resuming, and tests that send
+// Get-Job-Attributes requests until the job state matches are held back.  For
+// a gated IPP suite the first test that creates a job is also held back until
+// the other job-creating suites are done.
+//
+
+static bool				// O - `true` if the test file was changed, `false` otherwise
+runner_feed_open(runner_t   *runner,	// I - Test runner
+                 const char *testfile)	// I - Test file
+{
+  FILE		*fp;			// Test file
+  struct stat	fileinfo;		// Test file information
+  char		*feed,			// Test file with skipped tests
+		*feedptr,		// Pointer into test file with skipped tests
+		*ptr,			// Pointer into test file
+		*end,			// End of test file
+		*next,			// End of current test
+		*block,			// Start of current test
+		*brace,			// Opening brace of current test
+		saved;			// Saved character
+  size_t	num_tests = 0;		// Number of tests
+  static const char resume[] = "\n\tSKIP-IF-DEFINED " RUNNER_RESUME_VAR;
+					// Directive to skip completed tests
+
+
+  runner->num_files = 0;
+
+  // Load the test file...
+  if ((fp = fopen(testfile, "rb")) == NULL)
+    return (false);
+
+  if (fstat(fileno(fp), &fileinfo) || (runner->feed = (char *)malloc((size_t)fileinfo.st_size + 1)) == NULL)
+  {
+    fclose(fp);
+    return (false);
+  }
+
+  runner->feed_len = fread(runner->feed, 1, (size_t)fileinfo.st_size, fp);
+  runner->feed[runner->feed_len] = '\0';
+
+  fclose(fp);
+
+  // Find the tests to skip...
+  if (plist_array_count(runner->restore_tests) > 0)
+    runner_feed_resume(runner);
+
+  // Skip completed tests...
+  if (runner->num_resume > 0 && (feed = (char *)malloc(runner->feed_len + runner->num_resume * sizeof(resume) + 1)) != NULL)
+  {
+    for (ptr = runner->feed, end = runner->feed + runner->feed_len, feedptr = feed; (next = runner_feed_next(ptr, end, &block)) != NULL; ptr = next, num_tests ++)
+    {
+      saved = *next;
+      *next = '\0';
+
+      if (num_tests < runner->num_resume && runner->restored[num_tests] && (brace = strchr(block, '{')) != NULL)
+      {
+        memcpy(feedptr, ptr, (size_t)(brace + 1 - ptr));
+        feedptr += brace + 1 - ptr;
+        memcpy(feedptr, resume, sizeof(resume) - 1);
+        feedptr += sizeof(resume) - 1;
+        ptr     = brace + 1;
+      }
+
+      *next = saved;
+
+      memcpy(feedptr, ptr, (size_t)(next - ptr));
+      feedptr += next - ptr;
+    }
+
+    memcpy(feedptr, ptr, (size_t)(end - ptr));
+    feedptr += end - ptr;
+    *feedptr = '\0';
+
+    free(runner->feed);
+    runner->feed     = feed;
+    runner->feed_len = (size_t)(feedptr - feed);
+    num_tests        = 0;
+  }
+
+  // Find the tests that wait for jobs, the first test that creates a job when
+  // the job tests wait for other suites, and the documents the Document tests
+  // send...
+  for (ptr = runner->feed, end = runner->feed + runner->feed_len; (next = runner_feed_next(ptr, end, &block)) != NULL; ptr = next, num_tests ++)
+  {
+    saved = *next;
+    *next = '\0';
+
+    if (runner->notify && num_tests > 0 && runner->num_holds < RUNNER_MAX_HOLDS && (num_tests >= runner->num_resume || !runner->restored[num_tests]) && strstr(block, "OPERATION Get-Job-Attributes") && strstr(block, "REPEAT-NO-MATCH"))
+    {
+      runner->holds[runner->num_holds].offset    = (size_t)(block - runner->feed);
+      runner->holds[runner->num_holds].num_tests = num_tests;
+      runner->num_holds ++;
+    }
+
+    if (runner->phase && !runner->feed_gate && (strstr(block, "OPERATION Print-Job") || strstr(block, "OPERATION Create-Job") || strstr(block, "OPERATION Print-URI")))
+      runner->feed_gate = (size_t)(block - runner->feed);
+
+    if (runner->suite == SELFCERT_SUITE_DOCUMENT && runner->num_files < RUNNER_MAX_FILES && runner_feed_file(block, runner->files[runner->num_files].filename, sizeof(runner->files[0].filename)))
+    {
+      runner->files[runner->num_files].num_test = num_tests;
+      runner->files[runner->num_files].size     = 0;
+      runner->num_files ++;
+    }
+
+    *next = saved;
+  }
+
+  if (runner->num_holds == 0 && runner->num_resume == 0 && !runner->feed_gate)
+  {
+    // Nothing to change, let ipptool read the test file...
+    free(runner->feed);
+    runner->feed = NULL;
+    return (false);
+  }
+
+  // Create the named pipe next to the test file so that ipptool finds the
+  // documents, keeping a reader open so that writes never fail.  Neither end
+  // is inherited by ipptool, otherwise it would never see the end of the
+  // file...
+  snprintf(runner->feedfile, sizeof(runner->feedfile), ".%d-%p-%s", (int)getpid(), (void *)runner, testfile);
+
+  if (mkfifo(runner->feedfile, 0600))
+  {
+    runner->feedfile[0] = '\0';
+    runner_feed_close(runner);
+    return (false);
+  }
+
+  if ((runner->feed_reader = open(runner->feedfile, O_RDONLY | O_NONBLOCK | O_CLOEXEC)) < 0 || (runner->feed_fd = open(runner->feedfile, O_WRONLY | O_NONBLOCK | O_CLOEXEC)) < 0)
+  {
+    runner_feed_close(runner);
+    return (false);
+  }
+
+  runner->feed_pos  = 0;
+  runner->feed_end  = runner->num_holds > 0 ? runner->holds[0].offset : runner->feed_len;
+  runner->next_hold = 0;
+  runner->feed_time = runner_get_time();
+
+  return (true);
+}
+
+
+//
+// 'runner_feed_release()' - Release the next held test once its jobs complete.
+//
+// The next held test is released when the tests before it are done and the
+// jobs created since the last release have completed, or right away when
+// forced.
+//
+
+static void
+runner_feed_release(runner_t *runner,	// I - Test runner
+                    bool     force)	// I - Release without waiting?
+{
+  _runner_hold_t *hold;			// Next held test
+  double	since;			// Time of last release
+
+
+  if (runner->next_hold >= runner->num_holds || runner->current || runner->feed_pos < runner->feed_end)
+    return;
+
+  hold = runner->holds + runner->next_hold;
+
+  if (!force && runner->num_tests < hold->num_tests)
+    return;
+
+  since             = runner->feed_time;
+  runner->feed_time = runner_get_time();
+
+  if (!force && !notify_wait(runner->notify, since, RUNNER_JOB_TIMEOUT))
+    runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, "Job notifications timed out, polling job state.");
+
+  runner->next_hold ++;
+  runner->feed_end = runner->next_hold < runner->num_holds ? runner->holds[runner->next_hold].offset : runner->feed_len;
+}
+
+
+//
+// 'runner_feed_resume()' - Find the tests to skip from the checkpoint or the
+//                          previous results.
+//
+// When resuming, completed tests are skipped except for tests that define
+// variables from printer attributes that can't be evaluated from the snapshot.
+// When a test after the resume point needs the job ID or a variable from a job
+// created by a completed test, the tests are resumed from that job instead.
+//
+// When re-running failed tests, the tests that passed are skipped except for
+// tests that define variables from printer attributes, the jobs that the
+// failed tests need, and the tests that wait for those jobs.
+//
+
+static void
+runner_feed_resume(runner_t *runner)	// I - Test runner
+{
+  char		*ptr,			// Pointer into test file
+		*end,			// End of test file
+		*next,			// End of current test
+		*block,			// Start of current test
+		**blocks;		// Copy of each test
+  bool		*creates,		// Does each test create a job?
+		*run = NULL,		// Does each test run again?
+		changed;		// Did the resume point change?
+  size_t	i,			// Looping var
+		j,			// Looping var
+		num_blocks,		// Number of tests
+		resume;			// Resume point
+  plist_t	*current,		// Current test in checkpoint
+		*last,			// Last test to keep in checkpoint
+		*successful;		// Did the previous test pass?
+
+
+  // Find the tests in the test file...
+  end = runner->feed + runner->feed_len;
+
+  for (num_blocks = 0, ptr = runner->feed; (next = runner_feed_next(ptr, end, &block)) != NULL; ptr = next)
+    num_blocks ++;
+
+  if (num_blocks == 0)
+    return;
+
+  if (runner->mode == RUNNER_MODE_FAILED && plist_array_count(runner->restore_tests) != num_blocks)
+  {
+    runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, "Previous results are for different tests, running all tests.");
+    return;
+  }
+
+  blocks  = (char **)calloc(num_blocks, sizeof(char *));
+  creates = (bool *)calloc(num_blocks, sizeof(bool));
+
+  if (!blocks || !creates)
+  {
+    free(blocks);
+    free(creates);
+    return;
+  }
+
+  // Copy each test since one test can end where the next one starts...
+  for (i = 0, ptr = runner->feed; i < num_blocks && (next = runner_feed_next(ptr, end, &block)) != NULL; i ++, ptr = next)
+  {
+    if ((blocks[i] = (char *)malloc((size_t)(next - block) + 1)) == NULL)
+      break;
+
+    memcpy(blocks[i], block, (size_t)(next - block));
+    blocks[i][next - block] = '\0';
+
+    creates[i] = strstr(blocks[i], "OPERATION Print-Job") || strstr(blocks[i], "OPERATION Create-Job") || strstr(blocks[i], "OPERATION Print-URI");
+  }
+
+  if (i < num_blocks)
+  {
+    // Unable to copy all of the tests, run all of them...
+    resume = 0;
+  }
+  else if (runner->mode == RUNNER_MODE_FAILED)
+  {
+    // Start with the tests that failed...
+    if ((run = (bool *)calloc(num_blocks, sizeof(bool))) != NULL)
+    {
+      for (i = 0, current = runner->restore_tests->first_child; i < num_blocks && current; i ++, current = current->next_sibling)
+      {
+        if ((successful = plist_find(current, "Successful")) == NULL || successful->type != PLIST_TYPE_TRUE)
+          run[i] = true;
+      }
+
+      do
+      {
+        changed = false;
+
+        for (j = 0; j < num_blocks; j ++)
+        {
+          if (!run[j])
+            continue;
+
+          if (creates[j])
+          {
+            // Run the tests that wait for the job again...
+            for (i = j + 1; i < num_blocks && !creates[i]; i ++)
+            {
+              if (!run[i] && strstr(blocks[i], "$job-"))
+                run[i] = changed = true;
+            }
+          }
+          else if (strstr(blocks[j], "$job-"))
+          {
+            // Run the job that the test uses again...
+            for (i = j; i > 0 && !creates[i - 1]; i --);
+
+            if (i > 0 && !run[i - 1])
+              run[i - 1] = changed = true;
+          }
+
+          // Run the jobs that define variables used by the test again...
+          for (i = 0; i < j; i ++)
+          {
+            if (creates[i] && !run[i] && runner_feed_defines(blocks[i], blocks[j]))
+              run[i] = changed = true;
+          }
+        }
+      }
+      while (changed);
+    }
+
+    resume = run ? num_blocks : 0;
+  }
+  else
+  {
+    if ((resume = plist_array_count(runner->restore_tests)) > num_blocks)
+      resume = num_blocks;
+
+    do
+    {
+      changed = false;
+
+      // Back up to the last job created before the resume point when a later
+      // test uses its job ID...
+      for (i = resume; i > 0 && !creates[i - 1]; i --);
+
+      for (j = resume; i > 0 && j < num_blocks && !creates[j]; j ++)
+      {
+        if (strstr(blocks[j], "$job-"))
+        {
+          resume  = i - 1;
+          changed = true;
+          break;
+        }
+      }
+
+      // Back up to the first job created before the resume point that defines
+      // a variable used by a later test...
+      for (i = 0; !changed && i < resume; i ++)
+      {
+        if (!creates[i])
+          continue;
+
+        for (j = resume; j < num_blocks; j ++)
+        {
+          if (runner_feed_defines(blocks[i], blocks[j]))
+          {
+            resume  = i;
+            changed = true;
+            break;
+          }
+        }
+      }
+    }
+    while (changed && resume > 0);
+  }
+
+  // Skip the tests that don't define variables, that create jobs, or whose
+  // variables come from the printer attributes...
+  if (resume > 0 && (runner->restored = (bool *)calloc(resume, sizeof(bool))) != NULL)
+  {
+    runner->num_resume = resume;
+
+    for (i = 0; i < resume; i ++)
+      runner->restored[i] = (!run || !run[i]) && (creates[i] || !strstr(blocks[i], "DEFINE-") || runner_feed_snapshot(runner, blocks[i]));
+
+    // The checkpoint doesn't have the response attributes that ippevesubmit
+    // reads the printer's capabilities from, so run that test again...
+    if (runner->mode == RUNNER_MODE_RESUME && runner->suite == SELFCERT_SUITE_IPP && resume > RUNNER_SUMMARY_TEST)
+      runner->restored[RUNNER_SUMMARY_TEST] = false;
+  }
+
+  for (i = 0; i < num_blocks; i ++)
+    free(blocks[i]);
+
+  free(blocks);
+  free(creates);
+  free(run);
+
+  if (runner->mode != RUNNER_MODE_RESUME)
+    return;
+
+  // Remove the tests that will run again from the checkpoint...
+  for (i = 0, last = NULL, current = runner->checkpoint_tests->first_child; current && i < runner->num_resume; i ++, current = current->next_sibling)
+    last = current;
+
+  if (current)
+  {
+    if (last)
+      last->next_sibling = NULL;
+    else
+      runner->checkpoint_tests->first_child = NULL;
+
+    runner->checkpoint_tests->last_child = last;
+
+    for (; current; current = last)
+    {
+      last = current->next_sibling;
+      plist_delete(current);
+    }
+  }
+}
+
+
+//
+// 'runner_feed_run()' - Feed the test file to ipptool and follow its output.
+//
+
+static void
+runner_feed_run(runner_t *runner,	// I - Test runner
+                FILE     *fp)		// I - Output from command
+{
+  struct pollfd	pfds[2];		// Output and named pipe
+  int		nfds,			// Number of descriptors
+		count,			// Number of ready descriptors
+		unread;			// Bytes not yet read by ipptool
+  bool		draining,		// Waiting for ipptool to read the rest?
+		gated,			// Waiting for other suites to create jobs?
+		canceled;		// Was the run canceled?
+  size_t	limit;			// Bytes that can be written
+  char		buffer[1024];		// Output buffer
+  ssize_t	i,			// Looping var
+		bytes;			// Bytes read or written
+
+
+  for (;;)
+  {
+    if ((draining = runner->feed_fd >= 0 && runner->feed_pos >= runner->feed_len) == true)
+    {
+      // All written, let ipptool see the end of the file once it has read
+      // everything since it cannot open the named pipe without a writer...
+      if (ioctl(runner->feed_reader, FIONREAD, &unread) || unread == 0)
+      {
+        close(runner->feed_fd);
+        runner->feed_fd = -1;
+        draining        = false;
+      }
+    }
+
+    if ((gated = runner->feed_gate && runner->feed_pos >= runner->feed_gate) == true)
+    {
+      // Release the job tests once the other suites are done...
+      if (runner_phase_ready(runner->phase, false, &canceled))
+      {
+        runner->feed_gate = 0;
+      }
+      else if (canceled)
+      {
+        runner->canceled = true;
+        return;
+      }
+
+      gated = runner->feed_gate != 0;
+    }
+
+    limit = runner->feed_gate && runner->feed_gate < runner->feed_end ? runner->feed_gate : runner->feed_end;
+
+    pfds[0].fd     = fileno(fp);
+    pfds[0].events = POLLIN;
+    nfds           = 1;
+
+    if (runner->feed_fd >= 0 && runner->feed_pos < limit)
+    {
+      pfds[1].fd     = runner->feed_fd;
+      pfds[1].events = POLLOUT;
+      nfds           = 2;
+    }
+
+    if ((count = poll(pfds, (nfds_t)nfds, draining || gated ? 100 : RUNNER_FEED_IDLE * 1000)) < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+      break;
+    }
+    else if (count == 0)
+    {
+      // ipptool is idle, make sure it isn't waiting for the next test...
+      if (!draining && !gated)
+        runner_feed_release(runner, true);
+      continue;
+    }
+
+    if (nfds > 1 && (pfds[1].revents & POLLOUT))
+    {
+      // Write more of the test file...
+      if ((bytes = write(runner->feed_fd, runner->feed + runner->feed_pos, limit - runner->feed_pos)) > 0)
+        runner->feed_pos += (size_t)bytes;
+    }
+
+    if (pfds[0].revents & (POLLIN | POLLHUP | POLLERR))
+    {
+      // Follow the output...
+      if ((bytes = read(pfds[0].fd, buffer, sizeof(buffer))) <= 0)
+        break;
+
+      for (i = 0; i < bytes; i ++)
+      {
+        if (!runner_output(runner, buffer[i] & 255))
+          return;
+
+        if (buffer[i] == '\n')
+          runner_feed_release(runner, false);
+      }
+    }
+  }
+}
+
+
+//
+// 'runner_feed_snapshot()' - Define the variables of a skipped test from the
+//                            printer attributes.
+//
+// Only Get-Printer-Attributes tests whose variables all come from simple
+// "EXPECT name ... [WITH-VALUE "value"] DEFINE-xxx NAME" predicates can be
+// evaluated, otherwise the test needs to run again.
+//
+
+static bool				// O - `true` if defined, `false` if the test must run
+runner_feed_snapshot(
+    runner_t   *runner,			// I - Test runner
+    const char *block)			// I - Test
+{
+  const char	*line,			// Current line
+		*next;			// Next line
+  char		temp[1024],		// Copy of line
+		*ptr,			// Pointer into line
+		*tokens[32],		// Tokens in line
+		*name,			// Attribute name
+		*with,			// WITH-VALUE value, if any
+		*match,			// DEFINE-MATCH variable, if any
+		*nomatch,		// DEFINE-NO-MATCH variable, if any
+		*value,			// DEFINE-VALUE variable, if any
+		valuestr[1024];		// Attribute value as a string
+  size_t	i,			// Looping var
+		num_tokens,		// Number of tokens
+		num_defines = 0;	// Number of variables
+  cups_option_t	*defines = NULL;	// Variables
+  ipp_attribute_t *attr;		// Attribute
+  bool		matched,		// Does the attribute match?
+		ret = true;		// Return value
+
+
+  if (!runner->attrs || !strstr(block, "OPERATION Get-Printer-Attributes"))
+    return (false);
+
+  for (line = block; ret && line && *line; line = next)
+  {
+    if ((next = strchr(line, '\n')) != NULL)
+      next ++;
+
+    if (!strstr(line, "DEFINE-") || (next && strstr(line, "DEFINE-") >= next))
+      continue;
+
+    // Split the line into tokens...
+    if (next)
+      i = (size_t)(next - line) < sizeof(temp) ? (size_t)(next - line) : sizeof(temp) - 1;
+    else
+      i = strlen(line) < sizeof(temp) ? strlen(line) : sizeof(temp) - 1;
+
+    memcpy(temp, line, i);
+    temp[i] = '\0';
+
+    for (ptr = temp, num_tokens = 0; *ptr && num_tokens < (sizeof(tokens) / sizeof(tokens[0]));)
+    {
+      while (isspace(*ptr & 255))
+        *ptr++ = '\0';
+
+      if (!*ptr)
+        break;
+
+      tokens[num_tokens ++] = ptr;
+
+      if (*ptr == '\"')
+      {
+        // Keep the quotes so that literal values can be told apart...
+        for (ptr ++; *ptr && *ptr != '\"'; ptr ++);
+
+        if (*ptr)
+          ptr ++;
+      }
+      else
+      {
+        while (*ptr && !isspace(*ptr & 255))
+          ptr ++;
+      }
+    }
+
+    if (num_tokens < 4 || strcmp(tokens[0], "EXPECT") || tokens[1][0] == '!')
+    {
+      ret = false;
+      break;
+    }
+
+    name  = tokens[1][0] == '?' ? tokens[1] + 1 : tokens[1];
+    with  = match = nomatch = value = NULL;
+
+    for (i = 2; ret && i < num_tokens; i ++)
+    {
+      if ((i + 1) >= num_tokens)
+        ret = false;
+      else if (!strcmp(tokens[i], "OF-TYPE") || !strcmp(tokens[i], "IN-GROUP"))
+        i ++;
+      else if (!strcmp(tokens[i], "WITH-VALUE"))
+        with = tokens[++ i];
+      else if (!strcmp(tokens[i], "DEFINE-MATCH"))
+        match = tokens[++ i];
+      else if (!strcmp(tokens[i], "DEFINE-NO-MATCH"))
+        nomatch = tokens[++ i];
+      else if (!strcmp(tokens[i], "DEFINE-VALUE"))
+        value = tokens[++ i];
+      else
+        ret = false;
+    }
+
+    // Only literal values can be compared...
+    if (with && strcmp(with, "true") && strcmp(with, "false") && (with[0] != '\"' || with[1] == '/' || strchr(with, '$') || with[strlen(with) - 1] != '\"'))
+      ret = false;
+
+    if (!ret || (value && with))
+    {
+      ret = false;
+      break;
+    }
+
+    // Evaluate the predicate...
+    attr = ippFindAttribute(runner->attrs, name, IPP_TAG_ZERO);
+
+    if (!attr || !with)
+    {
+      matched = attr != NULL;
+    }
+    else if (ippGetValueTag(attr) == IPP_TAG_BOOLEAN)
+    {
+      matched = ippGetBoolean(attr, 0) == !strcmp(with, "true");
+    }
+    else
+    {
+      with[strlen(with) - 1] = '\0';
+      matched = ippContainsString(attr, with + 1);
+    }
+
+    if (match && matched)
+      num_defines = cupsAddOption(match, "1", num_defines, &defines);
+    if (nomatch && !matched)
+      num_defines = cupsAddOption(nomatch, "1", num_defines, &defines);
+    if (value && attr)
+      num_defines = cupsAddOption(value, ippAttributeString(attr, valuestr, sizeof(valuestr)) ? valuestr : "", num_defines, &defines);
+  }
+
+  if (ret)
+  {
+    for (i = 0; i < num_defines; i ++)
+      runner->num_defines = cupsAddOption(defines[i].name, defines[i].value, runner->num_defines, &runner->defines);
+  }
+
+  cupsFreeOptions(num_defines, defines);
+
+  return (ret);
+}
+
+
+//
+// 'runner_feed_uses()' - Determine whether a test uses a variable.
+//
+
+static bool				// O - `true` if used, `false` otherwise
+runner_feed_uses(const char *block,	// I - Test
+                 const char *name)	// I - Variable name
+{
+  const char	*ptr;			// Pointer into test
+  size_t	namelen = strlen(name);	// Length of name
+
+
+  for (ptr = block; (ptr = strstr(ptr, name)) != NULL; ptr += namelen)
+  {
+    if ((ptr == block || (!isalnum(ptr[-1] & 255) && ptr[-1] != '_' && ptr[-1] != '-')) && !isalnum(ptr[namelen] & 255) && ptr[namelen] != '_' && ptr[namelen] != '-')
+      return (true);
+  }
+
+  return (false);
+}
+#endif // !_WIN32
+
+
+//
+// 'runner_iteration()' - Start or end a request for the current test.
+//
+
+static bool				// O - `true` on success, `false` on error
+runner_iteration(runner_t *runner,	// I - Test runner
+                 bool     start,	// I - Start (`true`) or end (`false`)?
+                 double   t)		// I - Time
+{
+  runner_test_t		*test = runner->current;
+					// Current test
+  runner_iteration_t	*iteration;	// Current iteration
+
+
+  if (start)
+  {
+    if (test->num_iterations >= test->alloc_iterations)
+    {
+      if ((iteration = (runner_iteration_t *)realloc(test->iterations, (test->alloc_iterations + 8) * sizeof(runner_iteration_t))) == NULL)
+        return (false);
+
+      test->iterations       = iteration;
+      test->alloc_iterations += 8;
+    }
+
+    iteration = test->iterations + test->num_iterations;
+    test->num_iterations ++;
+
+    iteration->start = iteration->end = t;
+    runner->in_request = true;
+  }
+  else if (test->num_iterations > 0)
+  {
+    test->iterations[test->num_iterations - 1].end = t;
+    runner->in_request = false;
+  }
+
+  return (true);
+}
+
+
+//
+// 'runner_output()' - Process a character of output from the test tools.
+//
+// ipptool shows "    Test Name    [" when it sends a request and finishes the
+// line with "PASS]", "FAIL]", "SKIP]", or the repeat count ("0001]") when the
+// request will be repeated.
+//
+
+static bool				// O - `true` to continue, `false` to stop
+runner_output(runner_t *runner,		// I - Test runner
+              int      ch)		// I - Output character
+{
+  double	t = runner_get_time();	// Current time
+  char		*line = runner->line,	// Current line
+		*status,		// Status in line
+		message[2048];		// Saved error message
+  runner_test_t	*test;			// New test
+  plist_t	*errors,		// Saved errors of restored test
+		*error;			// Current error
+
+
+  if (ch == '\r')
+    return (true);
+
+  if (ch != '\n')
+  {
+    if (runner->linelen < (sizeof(runner->line) - 1))
+    {
+      line[runner->linelen ++] = (char)ch;
+      line[runner->linelen]    = '\0';
+    }
+
+    // Look for the start of a request...
+    if (ch != '[' || runner->in_request || runner->linelen < 6 || strncmp(line, "    ", 4) || line[4] == ' ' || line[runner->linelen - 2] != ' ')
+      return (true);
+
+    if (runner->current)
+    {
+      // Repeated request for the current test...
+      return (runner_iteration(runner, true, t));
+    }
+
+    // New test...
+    if ((test = runner_add_test(runner, line + 4, t)) == NULL || !runner_iteration(runner, true, t))
+      return (false);
+
+    return (runner_event(runner, RUNNER_EVENT_TEST_START, test, NULL));
+  }
+
+  // End of line...
+  runner->linelen = 0;
+
+  if ((test = runner->current) != NULL)
+  {
+    if ((status = strrchr(line, '[')) != NULL && runner->in_request)
+    {
+      status ++;
+
+      if (isdigit(status[0] & 255) && isdigit(status[1] & 255) && isdigit(status[2] & 255) && isdigit(status[3] & 255) && status[4] == ']')
+      {
+        // Request will be repeated...
+        runner_iteration(runner, false, t);
+        return (runner_event(runner, RUNNER_EVENT_TEST_REPEAT, test, NULL));
+      }
+      else if (!strncmp(status, "PASS", 4) || !strncmp(status, "FAIL", 4) || !strncmp(status, "SKIP", 4))
+      {
+        // Test is done...
+        cupsCopyString(test->status, status, 5);
+        runner_iteration(runner, false, t);
+
+        test->end       = t;
+        runner->current = NULL;
+
+        errors = runner_checkpoint_status(runner, test);
+        runner_checkpoint_test(runner, test);
+
+        if (!runner_event(runner, RUNNER_EVENT_TEST_END, test, NULL))
+          return (false);
+
+        // Report the saved errors of a restored test the way ipptool does...
+        for (error = errors && errors->type == PLIST_TYPE_ARRAY ? errors->first_child : NULL; error; error = error->next_sibling)
+        {
+          if (error->type != PLIST_TYPE_STRING || !error->value)
+            continue;
+
+          snprintf(message, sizeof(message), "        %s", error->value);
+
+          if (!runner_event(runner, RUNNER_EVENT_MESSAGE, NULL, message))
+            return (false);
+        }
+
+        return (true);
+      }
+    }
+  }
+  else if (!strncmp(line, "        ", 8) && line[8] && line[8] != ' ')
+  {
+    // Error for the last test...
+    runner_checkpoint_error(runner, line + 8);
+  }
+
+  return (runner_event(runner, RUNNER_EVENT_MESSAGE, runner->current, line));
+}
+
+
+//
+// 'runner_phase_cb()' - Pass an event from a phase to the suites callback.
+//
+
+static bool				// O - `true` to continue, `false` to cancel
+runner_phase_cb(
+    _runner_phase_t     *phase,		// I - Test suite phase
+    runner_event_t      event,		// I - Event
+    const runner_test_t *test,		// I - Test, if any
+    const char          *message)	// I - Message, if any
+{
+  _runner_suites_t	*data = phase->suites;
+					// Concurrent test suites
+  bool			ret;		// Return value
+
+
+  cupsMutexLock(&data->mutex);
+
+  if (!data->canceled && data->cb && !(data->cb)(data->cb_data, phase->suite, event, test, message))
+    data->canceled = true;
+
+  ret = !data->canceled;
+
+  cupsMutexUnlock(&data->mutex);
+
+  return (ret);
+}
+
+
+//
+// 'runner_phase_ready()' - Check or wait for the phases that must finish first.
+//
+
+static bool				// O - `true` if they are done, `false` otherwise
+runner_phase_ready(
+    _runner_phase_t *phase,		// I - Test suite phase
+    bool            wait,		// I - Wait for the phases?
+    bool            *canceled)		// O - Was the run canceled?
+{
+  _runner_suites_t	*data = phase->suites;
+					// Concurrent test suites
+  size_t		i;		// Looping var
+  bool			ready = true;	// Are the phases done?
+
+
+  cupsMutexLock(&data->mutex);
+
+  for (i = 0; i < phase->num_after && ready && !data->canceled; i ++)
+  {
+    while (wait && !phase->after[i]->done && !data->canceled)
+      cupsCondWait(&data->cond, &data->mutex, -1.0);
+
+    ready = phase->after[i]->done;
+  }
+
+  *canceled = data->canceled;
+
+  cupsMutexUnlock(&data->mutex);
+
+  return (ready && !*canceled);
+}
+
+
+//
+// 'runner_phase_run()' - Run a test suite phase once its dependencies finish.
+//
+
+static void *				// O - Thread exit status (unused)
+runner_phase_run(
+    _runner_phase_t *phase)		// I - Test suite phase
+{
+  _runner_suites_t	*data = phase->suites;
+					// Concurrent test suites
+  bool			canceled = false;
+					// Was the run canceled?
+
+
+  // Wait for the job-creating phases before this one, the runner holds the
+  // job tests of a gated phase itself...
+  if (!phase->gated)
+    runner_phase_ready(phase, true, &canceled);
+
+  // Run the tests...
+  if (!canceled)
+    phase->ok = runner_run(phase->runner);
+
+  // Let the waiting phases know we are done...
+  cupsMutexLock(&data->mutex);
+  phase->done = true;
+  cupsCondBroadcast(&data->cond);
+  cupsMutexUnlock(&data->mutex);
+
+  return (NULL);
+}
+
+
+//
+// 'runner_quote()' - Append a quoted argument to a command.
+//
+
+static void
+runner_quote(char       *buffer,	// I - Command buffer
+             size_t     bufsize,	// I - Size of command buffer
+             const char *arg)		// I - Argument
+{
+  char	*bufptr = buffer + strlen(buffer),
+					// Pointer into buffer
+	*bufend = buffer + bufsize - 4;	// End of buffer
+
+
+  if (bufptr > buffer && bufptr < bufend)
+    *bufptr++ = ' ';
+
+#if _WIN32
+  // cmd.exe uses double quotes...
+  if (bufptr < bufend)
+    *bufptr++ = '\"';
+
+  while (*arg && bufptr < bufend)
+  {
+    if (*arg == '\"')
+      *bufptr++ = '\\';
+
+    *bufptr++ = *arg++;
+  }
+
+  if (bufptr < (bufend + 2))
+    *bufptr++ = '\"';
+#else
+  // POSIX shells use single quotes...
+  if (bufptr < bufend)
+    *bufptr++ = '\'';
+
+  while (*arg && bufptr < bufend)
+  {
+    if (*arg == '\'')
+    {
+      if (bufptr >= (bufend - 3))
+        break;
+
+      *bufptr++ = '\'';
+      *bufptr++ = '\\';
+      *bufptr++ = '\'';
+    }
+
+    *bufptr++ = *arg++;
+  }
+
+  if (bufptr < (bufend + 2))
+    *bufptr++ = '\'';
+#endif // _WIN32
+
+  *bufptr = '\0';
+}
+
+
+//
+// 'runner_tool()' - Find a test tool.
+//
+// Like the test scripts, look in "../tools" and the current directory before
+// using the PATH.
+//
+
+static const char *			// O - Tool path
+runner_tool(const char *name,		// I - Tool name
+            char       *buffer,		// I - Path buffer
+            size_t     bufsize)		// I - Size of path buffer
+{
+#if _WIN32
+  snprintf(buffer, bufsize, "%s.exe", name);
+#else
+  snprintf(buffer, bufsize, "../tools/%s", name);
+  if (!access(buffer, X_OK))
+    return (buffer);
+
+  snprintf(buffer, bufsize, "./%s", name);
+  if (!access(buffer, X_OK))
+    return (buffer);
+
+  cupsCopyString(buffer, name, bufsize);
+#endif // _WIN32
+
+  return (buffer);
+}
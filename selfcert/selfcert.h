@@ -17,9 +17,11 @@
 #  include <string.h>
 #  include <ctype.h>
 #  include <errno.h>
-#  ifndef _WIN32
+#  ifdef _WIN32
+#    include <process.h>
+#  else
 #    include <unistd.h>
-#  endif /* !_WIN32 */
+#  endif /* _WIN32 */
 #  include <sys/stat.h>
 #  include <cups/cups.h>
 #  ifdef __cplusplus
@@ -45,6 +47,32 @@ extern "C" {
 // Types...
 typedef void (*plist_error_cb_t)(void *cb_data, const char *message);
 
+typedef struct connpool_stats_s		// Connection Pool Statistics
+{
+  size_t	opened,			// Connections opened
+		reused,			// Connections reused
+		tls_opened,		// TLS handshakes done
+		tls_reused;		// Encrypted connections reused
+} connpool_stats_t;
+
+typedef enum dnssd_event_e		// Printer Browser Event
+{
+  DNSSD_EVENT_ADD,			// Printer was found
+  DNSSD_EVENT_UPDATE,			// Printer services were resolved or changed
+  DNSSD_EVENT_REMOVE			// Printer services are gone
+} dnssd_event_t;
+
+typedef void (*dnssd_browse_cb_t)(void *cb_data, dnssd_event_t event, const char *printer);
+
+typedef struct notify_s notify_t;	// Job Notifications
+
+typedef enum plist_event_e		// plist Parsing Event
+{
+  PLIST_EVENT_START,			// Start of <plist>, <array>, or <dict>
+  PLIST_EVENT_END,			// End of </plist>, </array>, or </dict>
+  PLIST_EVENT_VALUE			// <key> or value element
+} plist_event_t;
+
 typedef enum plist_type_e		// plist Data Type
 {
   PLIST_TYPE_PLIST,			// <plist> ... </plist>
@@ -59,6 +87,8 @@ typedef enum plist_type_e		// plist Data Type
   PLIST_TYPE_TRUE			// <true />
 } plist_type_t;
 
+typedef bool (*plist_event_cb_t)(void *event_data, plist_event_t event, plist_type_t type, const char *value);
+
 typedef struct plist_s			// plist Data Node
 {
   plist_type_t	type;			// Node type
@@ -70,20 +100,125 @@ typedef struct plist_s			// plist Data Node
   char		*value;			// Value (as a string), if any
 } plist_t;
 
+typedef enum selfcert_suite_e		// Self-Certification Test Suite
+{
+  SELFCERT_SUITE_DNSSD,			// DNS-SD tests
+  SELFCERT_SUITE_IPP,			// IPP tests
+  SELFCERT_SUITE_DOCUMENT		// Document tests
+} selfcert_suite_t;
+
+typedef enum summary_media_e		// Media Size Class
+{
+  SUMMARY_MEDIA_SMALL,			// Small media (<A3/Tabloid)
+  SUMMARY_MEDIA_MEDIUM,			// Medium media (<A1/D)
+  SUMMARY_MEDIA_LARGE			// Large media (A1/D and larger)
+} summary_media_t;
+
+typedef enum runner_event_e		// Test Runner Event
+{
+  RUNNER_EVENT_SUITE_START,		// Start of test suite
+  RUNNER_EVENT_TEST_START,		// Start of test
+  RUNNER_EVENT_TEST_REPEAT,		// Test request will be repeated
+  RUNNER_EVENT_TEST_END,		// End of test
+  RUNNER_EVENT_SUITE_END,		// End of test suite
+  RUNNER_EVENT_MESSAGE			// Other output from the test tools
+} runner_event_t;
+
+typedef enum runner_mode_e		// Test Runner Mode
+{
+  RUNNER_MODE_ALL,			// Run all tests
+  RUNNER_MODE_RESUME,			// Resume from the last checkpoint, if any
+  RUNNER_MODE_FAILED			// Re-run the tests that failed in the previous results
+} runner_mode_t;
+
+typedef struct runner_iteration_s	// Test Request Timing
+{
+  double	start,			// Start time in seconds
+		end;			// End time in seconds
+} runner_iteration_t;
+
+typedef struct runner_test_s		// Test Progress
+{
+  char		name[256],		// Test name (possibly truncated)
+		status[8];		// "PASS", "FAIL", or "SKIP" when done
+  double	start,			// Start time in seconds
+		end;			// End time in seconds
+  size_t	num_iterations,		// Number of requests
+		alloc_iterations;	// Allocated requests
+  runner_iteration_t *iterations;	// Request timing
+} runner_test_t;
+
+typedef struct runner_s runner_t;	// Test Runner
+
+typedef bool (*runner_cb_t)(void *cb_data, runner_event_t event, const runner_test_t *test, const char *message);
+
+typedef bool (*runner_suites_cb_t)(void *cb_data, selfcert_suite_t suite, runner_event_t event, const runner_test_t *test, const char *message);
+
+typedef struct summary_s		// Results File Summary
+{
+  bool		valid;			// Did the results validate?
+  char		errors[1024];		// Validation errors, if any
+  bool		color,			// Color printing? (IPP)
+		duplex,			// Duplex printing? (IPP)
+		finishings,		// Finishings? (IPP)
+		fin_fold,		// Folding? (IPP)
+		fin_punch,		// Punching? (IPP)
+		fin_staple,		// Stapling? (IPP)
+		fin_trim,		// Trimming/cutting? (IPP)
+		ipps;			// IPPS supported? (DNS-SD)
+  summary_media_t media;		// Media size class (IPP)
+  char		version[4];		// Self-certification version (IPP)
+} summary_t;
+
 
 // Functions...
+extern bool	cache_get(const char *filename, selfcert_suite_t suite, summary_t *summary);
+extern bool	cache_put(const char *filename, selfcert_suite_t suite, const summary_t *summary);
+
+extern void	connpool_close(void);
+extern http_t	*connpool_get(const char *host, int port, http_encryption_t encryption);
+extern void	connpool_get_stats(connpool_stats_t *stats);
+extern void	connpool_put(http_t *http);
+
+extern bool	dnssd_browse_start(dnssd_browse_cb_t cb, void *cb_data);
+extern void	dnssd_browse_stop(void);
+extern bool	dnssd_get_cached_uri(const char *printer, char *uri, size_t urisize);
+extern bool	dnssd_get_host(const char *printer, char *host, size_t hostsize);
+extern bool	dnssd_get_service(const char *printer, bool ipps, char *host, size_t hostsize, int *port, size_t *num_txt, cups_option_t **txt);
+extern bool	dnssd_get_uri(const char *printer, char *uri, size_t urisize);
+extern bool	dnssd_run(const char *printer, const char *filename, runner_cb_t cb, void *cb_data);
+
+extern void	notify_delete(notify_t *notify);
+extern notify_t	*notify_new(const char *printer);
+extern bool	notify_wait(notify_t *notify, double since, double timeout);
+
 extern plist_t	*plist_add(plist_t *parent, plist_type_t type, const char *value);
 extern size_t	plist_array_count(plist_t *plist);
 extern void	plist_delete(plist_t *plist);
 extern plist_t	*plist_find(plist_t *parent, const char *path);
+extern char	*plist_json_string(char *buffer, size_t bufsize, const char *s);
 extern plist_t	*plist_new(void);
+extern bool	plist_parse(FILE *fp, const char *filename, plist_event_cb_t event_cb, void *event_data, plist_error_cb_t cb, void *cb_data);
 extern plist_t	*plist_read(FILE *fp, const char *filename, plist_error_cb_t cb, void *cb_data);
 extern bool	plist_write(FILE *fp, const char *filename, plist_t *plist, plist_error_cb_t cb, void *cb_data);
 extern bool	plist_write_json(FILE *fp, const char *filename, plist_t *plist, plist_error_cb_t cb, void *cb_data);
 
+extern void	runner_delete(runner_t *runner);
+extern const char *runner_get_resultsfile(runner_t *runner);
+extern double	runner_get_time(void);
+extern runner_t	*runner_new(const char *printer, const char *name, selfcert_suite_t suite, runner_mode_t mode, runner_cb_t cb, void *cb_data);
+extern bool	runner_run(runner_t *runner);
+extern bool	runner_run_suites(const char *printer, const char *name, runner_mode_t mode, size_t num_suites, const selfcert_suite_t *suites, runner_suites_cb_t cb, void *cb_data);
+
+extern void	snapshot_clear(const char *printer);
+extern ipp_t	*snapshot_get(const char *printer, const char *filename);
+
+extern bool	stress_run(const char *printer, const char *filename, int num_clients, int duration, runner_cb_t cb, void *cb_data);
+
 extern bool	validate_dnssd_results(const char *filename, plist_t *results, int print_server, char *errors, size_t errsize);
 extern bool	validate_document_results(const char *filename, plist_t *results, int print_server, char *errors, size_t errsize);
 extern bool	validate_ipp_results(const char *filename, plist_t *results, int print_server, char *errors, size_t errsize);
+extern bool	validate_results_file(const char *filename, selfcert_suite_t suite, bool fail_fast, char *errors, size_t errsize);
 
 
 #  ifdef __cplusplus
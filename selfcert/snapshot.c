@@ -0,0 +1,393 @@
+//
+// Printer attribute snapshot for the IPP Everywhere Printer Self-Certification
+// application.
+//
+// Copyright © 2024 by the IEEE-ISTO Printer Working Group.
+//
+// Licensed under Apache License v2.0.	See the file "LICENSE" for more
+// information.
+//
+// The stress test and the tests that are skipped when resuming or re-running
+// failed tests need to know what the printer supports.  Rather than each of
+// them sending a Get-Printer-Attributes request, the first one to ask gets all
+// of the printer attributes, including "media-col-database", and the others
+// use the same snapshot.  Callers that pass a filename also get the snapshot
+// written to "Name Printer Attributes.plist" next to the results as a
+// dictionary with the "Printer" name or URI, the "Time" it was fetched in
+// milliseconds, and the printer "Attributes", whose values are written the
+// same way as in ipptool's results.
+//
+// Front-ends that run the tests more than once, like the GUI and the printer
+// farm, call snapshot_clear() before each run so that changes to the printer's
+// configuration are seen.
+//
+
+#include "selfcert.h"
+#include <cups/thread.h>
+
+
+// Local types...
+typedef struct _snapshot_s		// Printer attribute snapshot
+{
+  char		printer[256];		// Printer name or URI
+  bool		fetching;		// Is the snapshot being fetched?
+  double	time;			// Time the snapshot was fetched
+  ipp_t		*attrs;			// Printer attributes
+} _snapshot_t;
+
+
+// Local globals...
+static cups_mutex_t	snapshot_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for snapshots
+static cups_cond_t	snapshot_cond = CUPS_COND_INITIALIZER;
+					// Condition for fetched snapshots
+static size_t		snapshot_num_snapshots = 0,
+					// Number of snapshots
+			snapshot_alloc_snapshots = 0;
+					// Allocated snapshots
+static _snapshot_t	*snapshot_snapshots = NULL;
+					// Snapshots
+
+
+// Local functions...
+static void	snapshot_add_attrs(plist_t *dict, ipp_t *ipp);
+static void	snapshot_add_value(plist_t *parent, ipp_attribute_t *attr, size_t element);
+static ipp_t	*snapshot_fetch(const char *printer);
+static bool	snapshot_write(const char *printer, double fetched, ipp_t *attrs, const char *filename);
+
+
+//
+// 'snapshot_clear()' - Forget the printer attributes.
+//
+// The next call to snapshot_get() requests the attributes from the printer
+// again.  Snapshots that are being fetched are kept since they are current.
+//
+
+void
+snapshot_clear(const char *printer)	// I - Printer name or URI or `NULL` for all
+{
+  size_t	i;			// Looping var
+  _snapshot_t	*snapshot;		// Current snapshot
+
+
+  cupsMutexLock(&snapshot_mutex);
+
+  // Keep the entries since snapshot_get() uses their index while fetching...
+  for (i = 0, snapshot = snapshot_snapshots; i < snapshot_num_snapshots; i ++, snapshot ++)
+  {
+    if (!snapshot->fetching && (!printer || !strcmp(snapshot->printer, printer)))
+    {
+      ippDelete(snapshot->attrs);
+      snapshot->attrs = NULL;
+    }
+  }
+
+  cupsMutexUnlock(&snapshot_mutex);
+}
+
+
+//
+// 'snapshot_get()' - Get the printer attributes.
+//
+// The printer is a DNS-SD service instance name or an "ipp" or "ipps" URI.
+// The attributes are requested from the printer the first time and written to
+// the named file, if any, on every call.  The caller must free the returned
+// copy with `ippDelete`.
+//
+
+ipp_t *					// O - Printer attributes or `NULL` on error
+snapshot_get(const char *printer,	// I - Printer name or URI
+             const char *filename)	// I - Snapshot plist filename or `NULL` for none
+{
+  size_t	i;			// Looping var
+  _snapshot_t	*snapshot;		// Current snapshot
+  double	fetched;		// Time the snapshot was fetched
+  ipp_t		*attrs,			// Printer attributes
+		*copy = NULL;		// Copy of printer attributes
+
+
+  if (!printer)
+    return (NULL);
+
+  cupsMutexLock(&snapshot_mutex);
+
+  for (i = 0, snapshot = snapshot_snapshots; i < snapshot_num_snapshots; i ++, snapshot ++)
+  {
+    if (!strcmp(snapshot->printer, printer))
+      break;
+  }
+
+  if (i < snapshot_num_snapshots)
+  {
+    // Wait for another thread to finish fetching the snapshot...
+    while (snapshot_snapshots[i].fetching)
+      cupsCondWait(&snapshot_cond, &snapshot_mutex, -1.0);
+
+    if (snapshot_snapshots[i].attrs)
+    {
+      if ((copy = ippNew()) != NULL)
+        ippCopyAttributes(copy, snapshot_snapshots[i].attrs, false, NULL, NULL);
+
+      fetched = snapshot_snapshots[i].time;
+
+      cupsMutexUnlock(&snapshot_mutex);
+
+      // Write the copy so the file isn't written while holding the mutex...
+      if (copy && filename)
+        snapshot_write(printer, fetched, copy, filename);
+
+      return (copy);
+    }
+  }
+  else
+  {
+    // Add a new snapshot...
+    if (snapshot_num_snapshots >= snapshot_alloc_snapshots)
+    {
+      if ((snapshot = (_snapshot_t *)realloc(snapshot_snapshots, (snapshot_alloc_snapshots + 16) * sizeof(_snapshot_t))) == NULL)
+      {
+        cupsMutexUnlock(&snapshot_mutex);
+        return (NULL);
+      }
+
+      snapshot_snapshots       = snapshot;
+      snapshot_alloc_snapshots += 16;
+    }
+
+    snapshot = snapshot_snapshots + snapshot_num_snapshots;
+    snapshot_num_snapshots ++;
+
+    memset(snapshot, 0, sizeof(_snapshot_t));
+    cupsCopyString(snapshot->printer, printer, sizeof(snapshot->printer));
+  }
+
+  // Fetch the snapshot without holding the mutex, the snapshot array might be
+  // reallocated so use its index...
+  snapshot_snapshots[i].fetching = true;
+
+  cupsMutexUnlock(&snapshot_mutex);
+
+  fetched = runner_get_time();
+
+  if ((attrs = snapshot_fetch(printer)) != NULL)
+  {
+    if (filename)
+      snapshot_write(printer, fetched, attrs, filename);
+
+    if ((copy = ippNew()) != NULL)
+      ippCopyAttributes(copy, attrs, false, NULL, NULL);
+  }
+
+  cupsMutexLock(&snapshot_mutex);
+
+  snapshot_snapshots[i].fetching = false;
+  snapshot_snapshots[i].time     = fetched;
+  snapshot_snapshots[i].attrs    = attrs;
+
+  cupsCondBroadcast(&snapshot_cond);
+  cupsMutexUnlock(&snapshot_mutex);
+
+  return (copy);
+}
+
+
+//
+// 'snapshot_add_attrs()' - Add printer attributes to a plist dictionary.
+//
+// Single values are added as is and multiple values as an array.
+//
+
+static void
+snapshot_add_attrs(plist_t *dict,	// I - Dictionary
+                   ipp_t   *ipp)	// I - Attributes
+{
+  ipp_attribute_t	*attr;		// Current attribute
+  const char		*name;		// Attribute name
+  size_t		i,		// Looping var
+			count;		// Number of values
+  plist_t		*array;		// Array of values
+
+
+  for (attr = ippGetFirstAttribute(ipp); attr; attr = ippGetNextAttribute(ipp))
+  {
+    if ((name = ippGetName(attr)) == NULL || ippGetGroupTag(attr) == IPP_TAG_OPERATION)
+      continue;
+
+    plist_add(dict, PLIST_TYPE_KEY, name);
+
+    if ((count = ippGetCount(attr)) == 1)
+    {
+      snapshot_add_value(dict, attr, 0);
+    }
+    else
+    {
+      array = plist_add(dict, PLIST_TYPE_ARRAY, NULL);
+
+      for (i = 0; i < count; i ++)
+        snapshot_add_value(array, attr, i);
+    }
+  }
+}
+
+
+//
+// 'snapshot_add_value()' - Add an attribute value to a plist.
+//
+
+static void
+snapshot_add_value(
+    plist_t         *parent,		// I - Parent node
+    ipp_attribute_t *attr,		// I - Attribute
+    size_t          element)		// I - Value index
+{
+  char		temp[256];		// Temporary string
+  int		lower,			// Lower value of range
+		upper,			// Upper value of range
+		xres,			// Horizontal resolution
+		yres;			// Vertical resolution
+  ipp_res_t	units;			// Resolution units
+  size_t	datalen;		// Length of octetString value
+  const void	*data;			// octetString value
+
+
+  switch (ippGetValueTag(attr))
+  {
+    case IPP_TAG_INTEGER :
+    case IPP_TAG_ENUM :
+        snprintf(temp, sizeof(temp), "%d", ippGetInteger(attr, element));
+        plist_add(parent, PLIST_TYPE_INTEGER, temp);
+        break;
+
+    case IPP_TAG_BOOLEAN :
+        plist_add(parent, ippGetBoolean(attr, element) ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL);
+        break;
+
+    case IPP_TAG_RANGE :
+        lower = ippGetRange(attr, element, &upper);
+        snprintf(temp, sizeof(temp), "%d-%d", lower, upper);
+        plist_add(parent, PLIST_TYPE_STRING, temp);
+        break;
+
+    case IPP_TAG_RESOLUTION :
+        xres = ippGetResolution(attr, element, &yres, &units);
+        if (xres == yres)
+          snprintf(temp, sizeof(temp), "%d%s", xres, units == IPP_RES_PER_INCH ? "dpi" : "dpcm");
+        else
+          snprintf(temp, sizeof(temp), "%dx%d%s", xres, yres, units == IPP_RES_PER_INCH ? "dpi" : "dpcm");
+        plist_add(parent, PLIST_TYPE_STRING, temp);
+        break;
+
+    case IPP_TAG_DATE :
+        plist_add(parent, PLIST_TYPE_STRING, httpGetDateString(ippDateToTime(ippGetDate(attr, element)), temp, sizeof(temp)));
+        break;
+
+    case IPP_TAG_STRING :
+        data = ippGetOctetString(attr, element, &datalen);
+        if (datalen >= sizeof(temp))
+          datalen = sizeof(temp) - 1;
+        memcpy(temp, data, datalen);
+        temp[datalen] = '\0';
+        plist_add(parent, PLIST_TYPE_STRING, temp);
+        break;
+
+    case IPP_TAG_BEGIN_COLLECTION :
+        snapshot_add_attrs(plist_add(parent, PLIST_TYPE_DICT, NULL), ippGetCollection(attr, element));
+        break;
+
+    default :
+        plist_add(parent, PLIST_TYPE_STRING, ippGetString(attr, element, NULL));
+        break;
+  }
+}
+
+
+//
+// 'snapshot_fetch()' - Get all of the printer attributes.
+//
+
+static ipp_t *				// O - Printer attributes or `NULL` on error
+snapshot_fetch(const char *printer)	// I - Printer name or URI
+{
+  char		uri[1024],		// Printer URI
+		scheme[32],		// URI scheme
+		userpass[256],		// URI username:password
+		host[256],		// URI hostname
+		resource[256];		// URI resource path
+  int		port;			// URI port number
+  http_t	*http;			// Connection to printer
+  ipp_t		*request,		// IPP request
+		*response;		// IPP response
+  static const char * const pattrs[] =	// Requested attributes
+  {
+    "all",
+    "media-col-database"
+  };
+
+
+  if (!strncmp(printer, "ipp://", 6) || !strncmp(printer, "ipps://", 7))
+    cupsCopyString(uri, printer, sizeof(uri));
+  else if (!dnssd_get_uri(printer, uri, sizeof(uri)))
+    return (NULL);
+
+  if (httpSeparateURI(HTTP_URI_CODING_ALL, uri, scheme, sizeof(scheme), userpass, sizeof(userpass), host, sizeof(host), &port, resource, sizeof(resource)) < HTTP_URI_STATUS_OK)
+    return (NULL);
+
+  if ((http = connpool_get(host, port, !strcmp(scheme, "ipps") ? HTTP_ENCRYPTION_ALWAYS : HTTP_ENCRYPTION_IF_REQUESTED)) == NULL)
+    return (NULL);
+
+  request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, uri);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+  ippAddStrings(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes", sizeof(pattrs) / sizeof(pattrs[0]), NULL, pattrs);
+
+  response = cupsDoRequest(http, request, resource);
+
+  connpool_put(http);
+
+  if (cupsGetError() >= IPP_STATUS_REDIRECTION_OTHER_SITE)
+  {
+    ippDelete(response);
+    return (NULL);
+  }
+
+  return (response);
+}
+
+
+//
+// 'snapshot_write()' - Write the printer attributes to a plist file.
+//
+
+static bool				// O - `true` on success, `false` on error
+snapshot_write(const char *printer,	// I - Printer name or URI
+               double     fetched,	// I - Time the snapshot was fetched
+               ipp_t      *attrs,	// I - Printer attributes
+               const char *filename)	// I - Snapshot plist filename
+{
+  plist_t	*plist,			// Snapshot plist
+		*dict;			// Snapshot dictionary
+  char		temp[32];		// Fetch time in milliseconds
+  bool		ret;			// Return value
+
+
+  if ((plist = plist_new()) == NULL)
+    return (false);
+
+  dict = plist_add(plist, PLIST_TYPE_DICT, NULL);
+
+  plist_add(dict, PLIST_TYPE_KEY, "Printer");
+  plist_add(dict, PLIST_TYPE_STRING, printer);
+
+  snprintf(temp, sizeof(temp), "%.0f", fetched * 1000.0);
+  plist_add(dict, PLIST_TYPE_KEY, "Time");
+  plist_add(dict, PLIST_TYPE_INTEGER, temp);
+
+  plist_add(dict, PLIST_TYPE_KEY, "Attributes");
+  snapshot_add_attrs(plist_add(dict, PLIST_TYPE_DICT, NULL), attrs);
+
+  ret = plist_write(NULL, filename, plist, NULL, NULL);
+
+  plist_delete(plist);
+
+  return (ret);
+}
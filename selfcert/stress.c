@@ -0,0 +1,823 @@
+//
+// IPP stress test for the IPP Everywhere Printer Self-Certification
+// application.
+//
+// Copyright © 2024 by the IEEE-ISTO Printer Working Group.
+//
+// Licensed under Apache License v2.0.	See the file "LICENSE" for more
+// information.
+//
+// The test suites send one request at a time, so they never show how a
+// printer copes with several clients printing at once.  The stress test runs
+// a number of client threads for a fixed duration, each on its own keep-alive
+// connection, that repeat the I-series operations: Get-Printer-Attributes,
+// Validate-Job, Print-Job with a blank one page PWG raster document, Get-Jobs,
+// and Cancel-Job for the job that was just submitted.  The blank page is not
+// the I-12 document, which ipptool generates itself, but like I-12 it is for
+// the default media size at the printer's lowest resolution.
+//
+// "server-error-busy" responses are counted but are not failures, since a
+// printer is allowed to turn clients away when it is busy.  Each test has
+// "Requests" and "Busy" counts, and the results have "Clients" and "Duration"
+// values, for the throughput and busy rate.  The timing of up to 1000 requests
+// per operation, chosen at random from all of them, is recorded in the
+// "Iterations" array so that ippevesubmit can show the latency percentiles
+// without the results growing with the duration of the test.
+//
+
+#include "selfcert.h"
+#include <cups/raster.h>
+#include <cups/thread.h>
+
+
+// Local constants...
+#define STRESS_FILEID	"org.pwg.ippeveselfcert11.stress"
+					// FileId for the results
+#define STRESS_FORMAT	"image/pwg-raster"
+					// Document format for Print-Job
+#define STRESS_PROGRESS	10.0		// Progress message interval in seconds
+#define STRESS_SAMPLES	1000		// Maximum sampled requests per operation
+
+
+// Local types...
+typedef enum _stress_op_e		// Operations
+{
+  _STRESS_OP_GET_PRINTER_ATTRIBUTES,	// Get-Printer-Attributes
+  _STRESS_OP_VALIDATE_JOB,		// Validate-Job
+  _STRESS_OP_PRINT_JOB,			// Print-Job
+  _STRESS_OP_GET_JOBS,			// Get-Jobs
+  _STRESS_OP_CANCEL_JOB,		// Cancel-Job
+  _STRESS_OP_MAX			// Number of operations
+} _stress_op_t;
+
+typedef struct _stress_sample_s		// Request timing
+{
+  double	start,			// Start time in seconds
+		end;			// End time in seconds
+} _stress_sample_t;
+
+typedef struct _stress_stats_s		// Request statistics for an operation
+{
+  size_t	num_requests,		// Number of requests
+		num_busy,		// Number of busy responses
+		num_errors,		// Number of other errors
+		num_samples;		// Number of sampled requests
+  ipp_status_t	error;			// First error status
+  _stress_sample_t *samples;		// Sampled requests
+} _stress_stats_t;
+
+typedef struct _stress_s _stress_t;	// Stress test data
+
+typedef struct _stress_client_s		// Client thread
+{
+  _stress_t	*data;			// Stress test data
+  cups_thread_t	thread;			// Thread
+  http_t	*http;			// Connection to printer
+} _stress_client_t;
+
+struct _stress_s			// Stress test data
+{
+  char		uri[1024],		// Printer URI
+		host[256],		// Printer hostname
+		resource[256];		// Resource path
+  int		port;			// Port number
+  http_encryption_t encryption;		// Encryption
+  char		*document;		// Print-Job document
+  size_t	docsize,		// Size of document
+		docalloc;		// Allocated size of document
+  cups_mutex_t	mutex;			// Mutex for statistics and stop flag
+  cups_cond_t	cond;			// Condition for stop flag
+  bool		stop;			// Stop the clients?
+  size_t	num_requests,		// Number of requests so far
+		num_busy;		// Number of busy responses so far
+  _stress_stats_t stats[_STRESS_OP_MAX];
+					// Statistics for each operation
+  unsigned	seed;			// Random number state for sampling
+};
+
+
+// Local globals...
+static const ipp_op_t stress_ops[] =	// Operation codes
+{
+  IPP_OP_GET_PRINTER_ATTRIBUTES,
+  IPP_OP_VALIDATE_JOB,
+  IPP_OP_PRINT_JOB,
+  IPP_OP_GET_JOBS,
+  IPP_OP_CANCEL_JOB
+};
+
+
+// Local functions...
+static void	*stress_client(_stress_client_t *client);
+static int	stress_compare(const double *a, const double *b);
+static bool	stress_document(_stress_t *data, const char *printer);
+static bool	stress_ok(_stress_op_t op, ipp_status_t status);
+static unsigned	stress_random(_stress_t *data);
+static int	stress_request(_stress_client_t *client, _stress_op_t op, int job_id);
+static bool	stress_results(_stress_t *data, int num_clients, double start, double end, int duration, const char *filename, runner_cb_t cb, void *cb_data);
+static ssize_t	stress_write_cb(_stress_t *data, unsigned char *buffer, size_t bytes);
+
+
+//
+// 'stress_run()' - Run the stress test and write the results.
+//
+// The printer is a DNS-SD service instance name or an "ipp" or "ipps" URI.
+// The callback gets a `RUNNER_EVENT_MESSAGE` event every 10 seconds while the
+// clients are running, and then the `RUNNER_EVENT_TEST_START`,
+// `RUNNER_EVENT_TEST_END`, and `RUNNER_EVENT_MESSAGE` events for each
+// operation.  Returning `false` from the callback stops the clients early.
+//
+
+bool					// O - `true` if the test ran, `false` on error
+stress_run(const char  *printer,	// I - Printer name or URI
+           const char  *filename,	// I - Results plist filename
+           int         num_clients,	// I - Number of clients
+           int         duration,	// I - Duration in seconds
+           runner_cb_t cb,		// I - Event callback or `NULL` for none
+           void        *cb_data)	// I - Event callback data
+{
+  _stress_t	data;			// Stress test data
+  _stress_client_t *clients,		// Client threads
+		*client;		// Current client
+  _stress_op_t	op;			// Current operation
+  int		i,			// Looping var
+		num_started = 0;	// Number of clients started
+  char		scheme[32],		// URI scheme
+		userpass[256],		// URI username:password
+		message[1024];		// Progress message
+  double	start,			// Start time
+		end,			// End time
+		now,			// Current time
+		next;			// Time of next progress message
+  bool		canceled,		// Did the callback cancel the test?
+		ret = false;		// Return value
+
+
+  if (!printer || !filename || num_clients < 1 || duration < 1)
+    return (false);
+
+  memset(&data, 0, sizeof(data));
+
+  // Get the printer URI...
+  if (!strncmp(printer, "ipp://", 6) || !strncmp(printer, "ipps://", 7))
+    cupsCopyString(data.uri, printer, sizeof(data.uri));
+  else if (!dnssd_get_uri(printer, data.uri, sizeof(data.uri)))
+  {
+    if (cb)
+      (cb)(cb_data, RUNNER_EVENT_MESSAGE, NULL, "Unable to find the printer.");
+
+    return (false);
+  }
+
+  if (httpSeparateURI(HTTP_URI_CODING_ALL, data.uri, scheme, sizeof(scheme), userpass, sizeof(userpass), data.host, sizeof(data.host), &data.port, data.resource, sizeof(data.resource)) < HTTP_URI_STATUS_OK)
+  {
+    if (cb)
+      (cb)(cb_data, RUNNER_EVENT_MESSAGE, NULL, "Bad printer URI.");
+
+    return (false);
+  }
+
+  data.encryption = !strcmp(scheme, "ipps") ? HTTP_ENCRYPTION_ALWAYS : HTTP_ENCRYPTION_IF_REQUESTED;
+
+  // Generate the Print-Job document once for all of the clients...
+  if (!stress_document(&data, printer) && cb)
+    (cb)(cb_data, RUNNER_EVENT_MESSAGE, NULL, "Unable to generate a PWG raster document, skipping Print-Job and Cancel-Job.");
+
+  if ((clients = (_stress_client_t *)calloc((size_t)num_clients, sizeof(_stress_client_t))) == NULL)
+  {
+    free(data.document);
+    return (false);
+  }
+
+  for (op = _STRESS_OP_GET_PRINTER_ATTRIBUTES; op < _STRESS_OP_MAX; op ++)
+  {
+    if ((data.stats[op].samples = (_stress_sample_t *)calloc(STRESS_SAMPLES, sizeof(_stress_sample_t))) == NULL)
+      goto done;
+  }
+
+  data.seed = (unsigned)(runner_get_time() * 1000.0) | 1;
+
+  cupsMutexInit(&data.mutex);
+  cupsCondInit(&data.cond);
+
+  // Connect and start the clients...
+  start = runner_get_time();
+
+  for (i = 0, client = clients; i < num_clients; i ++, client ++)
+  {
+    client->data = &data;
+
+    if ((client->http = connpool_get(data.host, data.port, data.encryption)) == NULL)
+    {
+      snprintf(message, sizeof(message), "Unable to connect to %s:%d: %s", data.host, data.port, cupsGetErrorString());
+      if (cb)
+        (cb)(cb_data, RUNNER_EVENT_MESSAGE, NULL, message);
+      break;
+    }
+
+    if ((client->thread = cupsThreadCreate((cups_thread_func_t)stress_client, client)) == CUPS_THREAD_INVALID)
+    {
+      connpool_put(client->http);
+      client->http = NULL;
+      break;
+    }
+
+    num_started ++;
+  }
+
+  // Wait for the duration, showing progress along the way...
+  end  = start + duration;
+  next = start + STRESS_PROGRESS;
+
+  cupsMutexLock(&data.mutex);
+
+  while (num_started > 0 && !data.stop && (now = runner_get_time()) < end)
+  {
+    cupsCondWait(&data.cond, &data.mutex, (next < end ? next : end) - now);
+
+    if ((now = runner_get_time()) >= next && now < end)
+    {
+      snprintf(message, sizeof(message), "    %3.0fs: %u requests, %u busy", now - start, (unsigned)data.num_requests, (unsigned)data.num_busy);
+      next += STRESS_PROGRESS;
+
+      cupsMutexUnlock(&data.mutex);
+      canceled = cb && !(cb)(cb_data, RUNNER_EVENT_MESSAGE, NULL, message);
+      cupsMutexLock(&data.mutex);
+
+      if (canceled)
+        data.stop = true;
+    }
+  }
+
+  data.stop = true;
+
+  cupsMutexUnlock(&data.mutex);
+
+  // Wait for the clients to finish their current request...
+  for (i = 0, client = clients; i < num_started; i ++, client ++)
+  {
+    cupsThreadWait(client->thread);
+    connpool_put(client->http);
+  }
+
+  end = runner_get_time();
+
+  // Write the results...
+  if (num_started > 0)
+    ret = stress_results(&data, num_started, start, end, duration, filename, cb, cb_data);
+
+  cupsCondDestroy(&data.cond);
+  cupsMutexDestroy(&data.mutex);
+
+  // Clean up...
+  done:
+
+  for (op = _STRESS_OP_GET_PRINTER_ATTRIBUTES; op < _STRESS_OP_MAX; op ++)
+    free(data.stats[op].samples);
+
+  free(clients);
+  free(data.document);
+
+  return (ret);
+}
+
+
+//
+// 'stress_client()' - Run the operations for one client until stopped.
+//
+
+static void *				// O - Thread exit status
+stress_client(_stress_client_t *client)	// I - Client
+{
+  _stress_t	*data = client->data;	// Stress test data
+  int		job_id;			// Job ID from Print-Job
+  bool		stop;			// Stop the client?
+
+
+  do
+  {
+    stress_request(client, _STRESS_OP_GET_PRINTER_ATTRIBUTES, 0);
+    stress_request(client, _STRESS_OP_VALIDATE_JOB, 0);
+
+    job_id = data->document ? stress_request(client, _STRESS_OP_PRINT_JOB, 0) : 0;
+
+    stress_request(client, _STRESS_OP_GET_JOBS, 0);
+
+    if (job_id > 0)
+      stress_request(client, _STRESS_OP_CANCEL_JOB, job_id);
+
+    cupsMutexLock(&data->mutex);
+    stop = data->stop;
+    cupsMutexUnlock(&data->mutex);
+  }
+  while (!stop);
+
+  return (NULL);
+}
+
+
+//
+// 'stress_compare()' - Compare two latencies.
+//
+
+static int				// O - Result of comparison
+stress_compare(const double *a,		// I - First latency
+               const double *b)		// I - Second latency
+{
+  return (*a < *b ? -1 : *a > *b ? 1 : 0);
+}
+
+
+//
+// 'stress_document()' - Generate the Print-Job document.
+//
+// The document is a blank one page PWG raster document for the default media
+// size at the printer's lowest resolution.  Since the page has no color,
+// sgray_8 is used when supported, then srgb_8, black_1, and cmyk_8.  It is
+// generated in memory once and sent by all of the clients.
+//
+
+static bool				// O - `true` on success, `false` on error
+stress_document(_stress_t  *data,	// I - Stress test data
+                const char *printer)	// I - Printer name or URI
+{
+  ipp_t		*response;		// Printer attributes
+  ipp_attribute_t *attr;		// IPP attribute
+  pwg_media_t	*pwg = NULL;		// Default media size
+  const char	*type = NULL;		// PWG raster document type
+  size_t	i,			// Looping var
+		count;			// Number of values
+  int		xdpi,			// Horizontal resolution
+		ydpi,			// Vertical resolution
+		min_xdpi = 0,		// Lowest horizontal resolution
+		min_ydpi = 0;		// Lowest vertical resolution
+  ipp_res_t	units;			// Resolution units
+  cups_media_t	media;			// Media information
+  cups_page_header_t header;		// Page header
+  cups_raster_t	*ras;			// Raster stream
+  unsigned char	*line;			// Line buffer
+  unsigned	y;			// Current line
+  bool		ret = false;		// Return value
+
+
+  // Get the PWG raster capabilities from the printer attributes...
+  if ((response = snapshot_get(printer, NULL)) == NULL)
+    return (false);
+
+  if ((attr = ippFindAttribute(response, "media-default", IPP_TAG_ZERO)) != NULL && ippGetString(attr, 0, NULL))
+    pwg = pwgMediaForPWG(ippGetString(attr, 0, NULL));
+
+  if ((attr = ippFindAttribute(response, "pwg-raster-document-resolution-supported", IPP_TAG_RESOLUTION)) != NULL)
+  {
+    for (i = 0, count = ippGetCount(attr); i < count; i ++)
+    {
+      xdpi = ippGetResolution(attr, i, &ydpi, &units);
+
+      if (units == IPP_RES_PER_CM)
+      {
+        xdpi = (int)(xdpi * 2.54 + 0.5);
+        ydpi = (int)(ydpi * 2.54 + 0.5);
+      }
+
+      if (min_xdpi == 0 || (xdpi * ydpi) < (min_xdpi * min_ydpi))
+      {
+        min_xdpi = xdpi;
+        min_ydpi = ydpi;
+      }
+    }
+  }
+
+  if ((attr = ippFindAttribute(response, "pwg-raster-document-type-supported", IPP_TAG_KEYWORD)) != NULL)
+  {
+    if (ippContainsString(attr, "sgray_8"))
+      type = "sgray_8";
+    else if (ippContainsString(attr, "srgb_8"))
+      type = "srgb_8";
+    else if (ippContainsString(attr, "black_1"))
+      type = "black_1";
+    else if (ippContainsString(attr, "cmyk_8"))
+      type = "cmyk_8";
+  }
+
+  // Set up the page header...
+  if (pwg && min_xdpi > 0 && type)
+  {
+    memset(&media, 0, sizeof(media));
+    cupsCopyString(media.media, pwg->pwg, sizeof(media.media));
+    media.width  = pwg->width;
+    media.length = pwg->length;
+
+    ret = cupsRasterInitHeader(&header, &media, NULL, IPP_QUALITY_NORMAL, NULL, IPP_ORIENT_PORTRAIT, "one-sided", type, min_xdpi, min_ydpi, NULL);
+  }
+
+  ippDelete(response);
+
+  if (!ret)
+    return (false);
+
+  header.cupsInteger[CUPS_RASTER_PWG_TotalPageCount] = 1;
+
+  if ((line = (unsigned char *)malloc(header.cupsBytesPerLine)) == NULL)
+    return (false);
+
+  // White is 255 for sgray_8 and srgb_8 and 0 for black_1 and cmyk_8...
+  memset(line, header.cupsColorSpace == CUPS_CSPACE_SW || header.cupsColorSpace == CUPS_CSPACE_SRGB ? 255 : 0, header.cupsBytesPerLine);
+
+  // Write the page...
+  if ((ras = cupsRasterOpenIO((cups_raster_cb_t)stress_write_cb, data, CUPS_RASTER_WRITE_PWG)) != NULL)
+  {
+    if ((ret = cupsRasterWriteHeader(ras, &header)) == true)
+    {
+      for (y = 0; ret && y < header.cupsHeight; y ++)
+        ret = cupsRasterWritePixels(ras, line, header.cupsBytesPerLine) == header.cupsBytesPerLine;
+    }
+
+    cupsRasterClose(ras);
+  }
+
+  free(line);
+
+  if (!ret)
+  {
+    free(data->document);
+    data->document = NULL;
+    data->docsize  = 0;
+  }
+
+  return (ret);
+}
+
+
+//
+// 'stress_ok()' - Determine whether a status code is a successful response.
+//
+// Like I-12 and I-16, "server-error-job-canceled" is OK for Print-Job and
+// "client-error-not-possible" (the job already completed) is OK for Cancel-Job.
+//
+
+static bool				// O - `true` if OK, `false` otherwise
+stress_ok(_stress_op_t op,		// I - Operation
+          ipp_status_t status)		// I - Status code
+{
+  if (status <= IPP_STATUS_OK_EVENTS_COMPLETE)
+    return (true);
+  else if (op == _STRESS_OP_PRINT_JOB)
+    return (status == IPP_STATUS_ERROR_JOB_CANCELED);
+  else if (op == _STRESS_OP_CANCEL_JOB)
+    return (status == IPP_STATUS_ERROR_NOT_POSSIBLE);
+  else
+    return (false);
+}
+
+
+//
+// 'stress_random()' - Get a random number for sampling requests.
+//
+// This is a simple xorshift generator, which is plenty for choosing samples.
+// The caller must hold the stress test mutex.
+//
+
+static unsigned				// O - Random number
+stress_random(_stress_t *data)		// I - Stress test data
+{
+  data->seed ^= data->seed << 13;
+  data->seed ^= data->seed >> 17;
+  data->seed ^= data->seed << 5;
+
+  return (data->seed);
+}
+
+
+//
+// 'stress_request()' - Send a request and record its timing and status.
+//
+
+static int				// O - Job ID for Print-Job, 0 otherwise
+stress_request(
+    _stress_client_t *client,		// I - Client
+    _stress_op_t     op,		// I - Operation
+    int              job_id)		// I - Job ID for Cancel-Job
+{
+  _stress_t	*data = client->data;	// Stress test data
+  ipp_t		*request,		// IPP request
+		*response;		// IPP response
+  _stress_stats_t *stats;		// Statistics for operation
+  ipp_status_t	status;			// Status code
+  size_t	offset,			// Offset in document
+		i;			// Sample index
+  double	start,			// Start time
+		end;			// End time
+
+
+  // Build the request like the I-series tests...
+  request = ippNewRequest(stress_ops[op]);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, data->uri);
+
+  if (op == _STRESS_OP_CANCEL_JOB)
+    ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "job-id", job_id);
+
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsGetUser());
+
+  if (op == _STRESS_OP_VALIDATE_JOB || op == _STRESS_OP_PRINT_JOB)
+  {
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "job-name", NULL, "Stress Test");
+    ippAddBoolean(request, IPP_TAG_OPERATION, "ipp-attribute-fidelity", false);
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "document-name", NULL, "onepage");
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "compression", NULL, "none");
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_MIMETYPE, "document-format", NULL, STRESS_FORMAT);
+  }
+
+  // Send it...
+  start = runner_get_time();
+
+  if (op == _STRESS_OP_PRINT_JOB)
+  {
+    if (cupsSendRequest(client->http, request, data->resource, data->docsize) == HTTP_STATUS_CONTINUE)
+    {
+      for (offset = 0; offset < data->docsize; offset += 65536)
+      {
+        if (cupsWriteRequestData(client->http, data->document + offset, data->docsize - offset < 65536 ? data->docsize - offset : 65536) != HTTP_STATUS_CONTINUE)
+          break;
+      }
+    }
+
+    response = cupsGetResponse(client->http, data->resource);
+    ippDelete(request);
+  }
+  else
+  {
+    response = cupsDoRequest(client->http, request, data->resource);
+  }
+
+  // Record the timing and status...
+  end    = runner_get_time();
+  status = response ? ippGetStatusCode(response) : cupsGetError();
+
+  cupsMutexLock(&data->mutex);
+
+  stats = data->stats + op;
+  stats->num_requests ++;
+  data->num_requests ++;
+
+  if (status == IPP_STATUS_ERROR_BUSY)
+  {
+    stats->num_busy ++;
+    data->num_busy ++;
+  }
+  else if (!stress_ok(op, status))
+  {
+    if (stats->num_errors == 0)
+      stats->error = status;
+
+    stats->num_errors ++;
+  }
+
+  // Keep a uniform random sample of the requests, replacing earlier samples
+  // with decreasing probability once the sample is full...
+  if (stats->num_samples < STRESS_SAMPLES)
+    i = stats->num_samples ++;
+  else
+    i = stress_random(data) % stats->num_requests;
+
+  if (i < STRESS_SAMPLES)
+  {
+    stats->samples[i].start = start;
+    stats->samples[i].end   = end;
+  }
+
+  cupsMutexUnlock(&data->mutex);
+
+  // Get the job ID for Print-Job...
+  job_id = 0;
+
+  if (op == _STRESS_OP_PRINT_JOB && stress_ok(op, status))
+    job_id = ippGetInteger(ippFindAttribute(response, "job-id", IPP_TAG_INTEGER), 0);
+
+  ippDelete(response);
+
+  return (job_id);
+}
+
+
+//
+// 'stress_results()' - Report and write the results.
+//
+
+static bool				// O - `true` on success, `false` on error
+stress_results(
+    _stress_t        *data,		// I - Stress test data
+    int              num_clients,	// I - Number of clients
+    double           start,		// I - Start time
+    double           end,		// I - End time
+    int              duration,		// I - Duration in seconds
+    const char       *filename,		// I - Results plist filename
+    runner_cb_t      cb,		// I - Event callback or `NULL` for none
+    void             *cb_data)		// I - Event callback data
+{
+  plist_t	*results,		// Results plist
+		*dict,			// Results dictionary
+		*tests,			// Tests array
+		*test,			// Current test
+		*errors,		// Errors array
+		*iterations,		// Iterations array
+		*iteration;		// Current iteration
+  _stress_op_t	op;			// Current operation
+  _stress_stats_t *stats;		// Statistics for operation
+  _stress_sample_t *sample;		// Current sample
+  size_t	i;			// Looping var
+  double	values[STRESS_SAMPLES];	// Sampled latencies
+  runner_test_t	current;		// Current test
+  char		name[256],		// Test name
+		temp[1024];		// Temporary string
+  bool		canceled = false,	// Were the results canceled?
+		failed = false,		// Did any of the operations fail?
+		ret;			// Return value
+
+
+  results = plist_new();
+  dict    = plist_add(results, PLIST_TYPE_DICT, NULL);
+
+  plist_add(dict, PLIST_TYPE_KEY, "Tests");
+  tests = plist_add(dict, PLIST_TYPE_ARRAY, NULL);
+
+  for (op = _STRESS_OP_GET_PRINTER_ATTRIBUTES; op < _STRESS_OP_MAX; op ++)
+  {
+    stats = data->stats + op;
+
+    memset(&current, 0, sizeof(current));
+    snprintf(name, sizeof(name), "S-%d. %s Operation (%d clients)", op + 1, ippOpString(stress_ops[op]), num_clients);
+    cupsCopyString(current.name, name, sizeof(current.name));
+    current.start = start;
+    current.end   = end;
+
+    if (!canceled && cb && !(cb)(cb_data, RUNNER_EVENT_TEST_START, &current, NULL))
+      canceled = true;
+
+    test = plist_add(tests, PLIST_TYPE_DICT, NULL);
+
+    plist_add(test, PLIST_TYPE_KEY, "Name");
+    plist_add(test, PLIST_TYPE_STRING, name);
+    plist_add(test, PLIST_TYPE_KEY, "FileId");
+    plist_add(test, PLIST_TYPE_STRING, STRESS_FILEID);
+    plist_add(test, PLIST_TYPE_KEY, "Operation");
+    plist_add(test, PLIST_TYPE_STRING, ippOpString(stress_ops[op]));
+
+    snprintf(temp, sizeof(temp), "%.0f", start * 1000.0);
+    plist_add(test, PLIST_TYPE_KEY, "StartTime");
+    plist_add(test, PLIST_TYPE_INTEGER, temp);
+    snprintf(temp, sizeof(temp), "%.0f", end * 1000.0);
+    plist_add(test, PLIST_TYPE_KEY, "EndTime");
+    plist_add(test, PLIST_TYPE_INTEGER, temp);
+
+    // Write the sampled requests...
+    plist_add(test, PLIST_TYPE_KEY, "Iterations");
+    iterations = plist_add(test, PLIST_TYPE_ARRAY, NULL);
+
+    for (i = 0, sample = stats->samples; i < stats->num_samples; i ++, sample ++)
+    {
+      iteration = plist_add(iterations, PLIST_TYPE_DICT, NULL);
+
+      snprintf(temp, sizeof(temp), "%.0f", sample->start * 1000.0);
+      plist_add(iteration, PLIST_TYPE_KEY, "StartTime");
+      plist_add(iteration, PLIST_TYPE_INTEGER, temp);
+      snprintf(temp, sizeof(temp), "%.0f", sample->end * 1000.0);
+      plist_add(iteration, PLIST_TYPE_KEY, "EndTime");
+      plist_add(iteration, PLIST_TYPE_INTEGER, temp);
+
+      values[i] = sample->end - sample->start;
+    }
+
+    snprintf(temp, sizeof(temp), "%u", (unsigned)stats->num_requests);
+    plist_add(test, PLIST_TYPE_KEY, "Requests");
+    plist_add(test, PLIST_TYPE_INTEGER, temp);
+    snprintf(temp, sizeof(temp), "%u", (unsigned)stats->num_busy);
+    plist_add(test, PLIST_TYPE_KEY, "Busy");
+    plist_add(test, PLIST_TYPE_INTEGER, temp);
+
+    // Busy responses are allowed, anything else is a failure...
+    if (stats->num_requests == 0)
+      cupsCopyString(current.status, "SKIP", sizeof(current.status));
+    else if (stats->num_errors > 0 || stats->num_busy == stats->num_requests)
+      cupsCopyString(current.status, "FAIL", sizeof(current.status));
+    else
+      cupsCopyString(current.status, "PASS", sizeof(current.status));
+
+    plist_add(test, PLIST_TYPE_KEY, "Successful");
+    plist_add(test, strcmp(current.status, "FAIL") ? PLIST_TYPE_TRUE : PLIST_TYPE_FALSE, NULL);
+
+    if (stats->num_requests == 0)
+    {
+      plist_add(test, PLIST_TYPE_KEY, "Skipped");
+      plist_add(test, PLIST_TYPE_TRUE, NULL);
+    }
+    else if (!strcmp(current.status, "FAIL"))
+    {
+      failed = true;
+    }
+
+    if (stats->num_errors > 0 || stats->num_busy > 0)
+    {
+      plist_add(test, PLIST_TYPE_KEY, "Errors");
+      errors = plist_add(test, PLIST_TYPE_ARRAY, NULL);
+
+      if (stats->num_errors > 0)
+      {
+        snprintf(temp, sizeof(temp), "GOT: %u unexpected responses, the first was %s", (unsigned)stats->num_errors, ippErrorString(stats->error));
+        plist_add(errors, PLIST_TYPE_STRING, temp);
+      }
+
+      if (stats->num_busy > 0)
+      {
+        snprintf(temp, sizeof(temp), "GOT: %u server-error-busy responses (%.1f%%)", (unsigned)stats->num_busy, 100.0 * stats->num_busy / stats->num_requests);
+        plist_add(errors, PLIST_TYPE_STRING, temp);
+      }
+    }
+
+    if (!canceled && cb && !(cb)(cb_data, RUNNER_EVENT_TEST_END, &current, NULL))
+      canceled = true;
+
+    // Show the throughput, latency percentiles, and busy rate...
+    if (stats->num_samples > 0 && !canceled && cb)
+    {
+      size_t p50, p90, p99;		// Nearest ranks
+
+      qsort(values, stats->num_samples, sizeof(double), (int (*)(const void *, const void *))stress_compare);
+
+      p50 = (stats->num_samples * 50 + 99) / 100;
+      p90 = (stats->num_samples * 90 + 99) / 100;
+      p99 = (stats->num_samples * 99 + 99) / 100;
+
+      snprintf(temp, sizeof(temp), "        %u requests, %.1f requests/s, p50 %.3fs, p90 %.3fs, p99 %.3fs, %.1f%% busy", (unsigned)stats->num_requests, stats->num_requests / (end - start), values[p50 - 1], values[p90 - 1], values[p99 - 1], 100.0 * stats->num_busy / stats->num_requests);
+
+      if (!(cb)(cb_data, RUNNER_EVENT_MESSAGE, NULL, temp))
+        canceled = true;
+
+      if (stats->num_errors > 0 && !canceled)
+      {
+        snprintf(temp, sizeof(temp), "        GOT: %u unexpected responses, the first was %s", (unsigned)stats->num_errors, ippErrorString(stats->error));
+
+        if (!(cb)(cb_data, RUNNER_EVENT_MESSAGE, NULL, temp))
+          canceled = true;
+      }
+    }
+  }
+
+  plist_add(dict, PLIST_TYPE_KEY, "Successful");
+  plist_add(dict, failed ? PLIST_TYPE_FALSE : PLIST_TYPE_TRUE, NULL);
+
+  snprintf(temp, sizeof(temp), "%d", num_clients);
+  plist_add(dict, PLIST_TYPE_KEY, "Clients");
+  plist_add(dict, PLIST_TYPE_INTEGER, temp);
+  snprintf(temp, sizeof(temp), "%d", duration);
+  plist_add(dict, PLIST_TYPE_KEY, "Duration");
+  plist_add(dict, PLIST_TYPE_INTEGER, temp);
+
+  snprintf(temp, sizeof(temp), "%.0f", start * 1000.0);
+  plist_add(dict, PLIST_TYPE_KEY, "StartTime");
+  plist_add(dict, PLIST_TYPE_INTEGER, temp);
+  snprintf(temp, sizeof(temp), "%.0f", end * 1000.0);
+  plist_add(dict, PLIST_TYPE_KEY, "EndTime");
+  plist_add(dict, PLIST_TYPE_INTEGER, temp);
+
+  if ((ret = plist_write(NULL, filename, results, NULL, NULL)) == false && cb)
+  {
+    snprintf(temp, sizeof(temp), "Unable to write \"%s\".", filename);
+    (cb)(cb_data, RUNNER_EVENT_MESSAGE, NULL, temp);
+  }
+
+  plist_delete(results);
+
+  return (ret);
+}
+
+
+//
+// 'stress_write_cb()' - Append raster data to the Print-Job document.
+//
+
+static ssize_t				// O - Number of bytes written or `-1` on error
+stress_write_cb(_stress_t     *data,	// I - Stress test data
+                unsigned char *buffer,	// I - Buffer
+                size_t        bytes)	// I - Number of bytes
+{
+  char		*document;		// New document buffer
+  size_t	docalloc;		// New allocated size
+
+
+  if ((data->docsize + bytes) > data->docalloc)
+  {
+    // Grow the document 1MB at a time...
+    docalloc = (data->docsize + bytes + 1048575) & ~(size_t)1048575;
+
+    if ((document = (char *)realloc(data->document, docalloc)) == NULL)
+      return (-1);
+
+    data->document = document;
+    data->docalloc = docalloc;
+  }
+
+  memcpy(data->document + data->docsize, buffer, bytes);
+  data->docsize += bytes;
+
+  return ((ssize_t)bytes);
+}
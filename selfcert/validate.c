@@ -9,6 +9,58 @@
 //
 
 #include "selfcert.h"
+#include <stdarg.h>
+
+
+// Local types...
+typedef struct _validate_stream_s	// Streaming validation state
+{
+  const char	*fileid;		// Expected FileId
+  int		tests;			// Expected number of tests
+  bool		fail_fast,		// Stop at the first failure?
+		result,			// Success/fail result
+		stopped;		// Stopped early?
+  char		*errors,		// Error buffer
+		*errptr,		// Pointer into error buffer
+		*errend;		// End of error buffer
+  char		parse_error[1024];	// First parse error, if any
+  int		depth;			// Current element depth
+  char		key[256];		// Current results or test key
+  bool		in_tests,		// In the Tests array?
+		in_errors,		// In a test's Errors array?
+		seen_tests,		// Seen Tests?
+		seen_successful,	// Seen Successful?
+		seen_fileid,		// Seen FileId?
+		fileid_string,		// Is FileId a string?
+		fileid_ok;		// Is FileId the expected value?
+  char		fileid_value[256];	// FileId value
+  int		num_tests;		// Number of tests seen
+  char		tname[256];		// Name of current test
+  bool		tname_ok;		// Have a test name?
+  int		tsuccessful;		// Test Successful value (-1 = missing/bad)
+  char		terrors[4096],		// Test errors
+		*terrptr;		// Pointer into test errors
+} _validate_stream_t;
+
+
+// Local globals...
+static const struct
+{
+  const char	*fileid;		// Expected FileId
+  int		tests;			// Expected number of tests
+} validate_suites[] =
+{
+  { "org.pwg.ippeveselfcert11.dnssd", 10 },
+  { "org.pwg.ippeveselfcert11.ipp", 41 },
+  { "org.pwg.ippeveselfcert11.document", 53 }
+};
+
+
+// Local functions...
+static void	stream_add_error(_validate_stream_t *vs, const char *message, ...) SELFCERT_FORMAT(2,3);
+static bool	stream_cb(void *event_data, plist_event_t event, plist_type_t type, const char *value);
+static void	stream_error_cb(void *cb_data, const char *message);
+static bool	stream_test(_validate_stream_t *vs);
 
 
 //
@@ -48,6 +100,7 @@ validate_dnssd_results(
   else if (strcmp(fileid->value, "org.pwg.ippeveselfcert11.dnssd"))
   {
     snprintf(errptr, errsize - (size_t)(errptr - errors), "Unsupported FileId '%s'.\n", fileid->value);
+    errptr += strlen(errptr);
     result = false;
   }
 
@@ -83,6 +136,7 @@ validate_dnssd_results(
   if (!strcmp(fileid->value, "org.pwg.ippeveselfcert11.dnssd") && tests_count != 10)
   {
     snprintf(errptr, errsize - (size_t)(errptr - errors), "Wrong number of tests (got %d, expected 10).\n", tests_count);
+    errptr += strlen(errptr);
     result = false;
   }
 
@@ -114,7 +168,7 @@ validate_dnssd_results(
 	snprintf(errptr, errsize - (size_t)(errptr - errors), "FAILED %s\n", tname->value);
 	errptr += strlen(errptr);
 
-	for (terror = terrors->first_child; terror; terror = terror->next_sibling)
+	for (terror = terrors ? terrors->first_child : NULL; terror; terror = terror->next_sibling)
 	{
 	  if (terror->type != PLIST_TYPE_STRING)
 	    continue;
@@ -235,7 +289,7 @@ validate_document_results(
 	snprintf(errptr, errsize - (size_t)(errptr - errors), "FAILED %s\n", tname->value);
 	errptr += strlen(errptr);
 
-	for (terror = terrors->first_child; terror; terror = terror->next_sibling)
+	for (terror = terrors ? terrors->first_child : NULL; terror; terror = terror->next_sibling)
 	{
 	  if (terror->type != PLIST_TYPE_STRING)
 	    continue;
@@ -356,7 +410,7 @@ validate_ipp_results(
 	snprintf(errptr, errsize - (size_t)(errptr - errors), "FAILED %s\n", tname->value);
 	errptr += strlen(errptr);
 
-	for (terror = terrors->first_child; terror; terror = terror->next_sibling)
+	for (terror = terrors ? terrors->first_child : NULL; terror; terror = terror->next_sibling)
 	{
 	  if (terror->type != PLIST_TYPE_STRING)
 	    continue;
@@ -370,3 +424,313 @@ validate_ipp_results(
 
   return (result);
 }
+
+
+//
+// 'validate_results_file()' - Validate a results file while it is parsed.
+//
+// Unlike the validate_*_results functions, the results are not loaded into
+// memory.  The FileId, number of tests, and `Successful` values are checked as
+// they are read, and parsing stops as soon as the verdict is certain - after
+// the first failure when `fail_fast` is `true`, or once the error buffer is
+// full.
+//
+
+bool					// O - `true` on success, `false` on failure
+validate_results_file(
+    const char       *filename,		// I - plist filename
+    selfcert_suite_t suite,		// I - Test suite
+    bool             fail_fast,		// I - Stop at the first failure?
+    char             *errors,		// O - Error buffer
+    size_t           errsize)		// I - Size of error buffer
+{
+  _validate_stream_t	vs;		// Validation state
+
+
+  memset(&vs, 0, sizeof(vs));
+
+  vs.fileid    = validate_suites[suite].fileid;
+  vs.tests     = validate_suites[suite].tests;
+  vs.fail_fast = fail_fast;
+  vs.result    = true;
+  vs.errors    = errors;
+  vs.errptr    = errors;
+  vs.errend    = errors + errsize;
+
+  *errors = '\0';
+
+  if (!plist_parse(NULL, filename, stream_cb, &vs, stream_error_cb, &vs))
+  {
+    // Unable to read the results...
+    stream_add_error(&vs, "%s\n", vs.parse_error[0] ? vs.parse_error : "Unable to read results.");
+  }
+  else if (!vs.stopped)
+  {
+    // Check the overall results...
+    if (!vs.seen_fileid)
+    {
+      stream_add_error(&vs, "Missing FileId.\n");
+      return (false);
+    }
+
+    if (!vs.seen_successful)
+      stream_add_error(&vs, "Missing Successful.\n");
+
+    if (!vs.seen_tests)
+      stream_add_error(&vs, "Missing Tests.\n");
+
+    if (vs.fileid_ok && vs.num_tests != vs.tests)
+      stream_add_error(&vs, "Wrong number of tests (got %d, expected %d).\n", vs.num_tests, vs.tests);
+  }
+
+  return (vs.result);
+}
+
+
+//
+// 'stream_add_error()' - Add an error message and mark the results as failed.
+//
+
+static void
+stream_add_error(
+    _validate_stream_t *vs,		// I - Validation state
+    const char         *message,	// I - Printf-style message
+    ...)				// I - Additional arguments
+{
+  va_list	ap;			// Pointer to arguments
+
+
+  vs->result = false;
+
+  if (vs->errptr >= (vs->errend - 1))
+    return;
+
+  va_start(ap, message);
+  vsnprintf(vs->errptr, (size_t)(vs->errend - vs->errptr), message, ap);
+  va_end(ap);
+
+  vs->errptr += strlen(vs->errptr);
+}
+
+
+//
+// 'stream_cb()' - Check a parsed results element.
+//
+// Depth 1 is the <plist> element, 2 is the results <dict>, 3 is the Tests
+// <array>, 4 is a test <dict>, and 5 is the Errors <array> in a test.
+//
+
+static bool				// O - `true` to continue, `false` to stop
+stream_cb(void          *event_data,	// I - Validation state
+          plist_event_t event,		// I - Parsing event
+          plist_type_t  type,		// I - Element type
+          const char    *value)		// I - Element value, if any
+{
+  _validate_stream_t	*vs = (_validate_stream_t *)event_data;
+					// Validation state
+
+
+  switch (event)
+  {
+    case PLIST_EVENT_START :
+        if (vs->depth == 2 && !strcmp(vs->key, "Tests"))
+        {
+          // Start of the Tests array...
+          vs->seen_tests = true;
+
+          if (type == PLIST_TYPE_ARRAY)
+            vs->in_tests = true;
+          else
+            stream_add_error(vs, "Tests is not an array value.\n");
+        }
+        else if (vs->depth == 2 && !strcmp(vs->key, "Successful"))
+        {
+          vs->seen_successful = true;
+          stream_add_error(vs, "Successful is not a boolean value.\n");
+        }
+        else if (vs->depth == 3 && vs->in_tests)
+        {
+          // Start of a test...
+	  vs->tname[0]    = '\0';
+	  vs->tname_ok    = false;
+	  vs->tsuccessful = -1;
+	  vs->terrors[0]  = '\0';
+	  vs->terrptr     = vs->terrors;
+        }
+        else if (vs->depth == 4 && vs->in_tests)
+        {
+          // Container value in a test...
+          if (!strcmp(vs->key, "Errors") && type == PLIST_TYPE_ARRAY)
+            vs->in_errors = true;
+          else if (!strcmp(vs->key, "FileId") && vs->num_tests == 0)
+            vs->seen_fileid = true;
+          else if (!strcmp(vs->key, "Name"))
+            vs->tname_ok = false;
+          else if (!strcmp(vs->key, "Successful"))
+            vs->tsuccessful = -1;
+        }
+
+        if (vs->depth == 2 || vs->depth == 4)
+          vs->key[0] = '\0';
+
+        vs->depth ++;
+        break;
+
+    case PLIST_EVENT_END :
+        vs->depth --;
+
+        if (vs->depth == 4 && vs->in_errors)
+        {
+          vs->in_errors = false;
+        }
+        else if (vs->depth == 3 && vs->in_tests)
+        {
+          // End of a test...
+          if (!stream_test(vs))
+          {
+            vs->stopped = true;
+            return (false);
+          }
+        }
+        else if (vs->depth == 2 && vs->in_tests)
+        {
+          vs->in_tests = false;
+        }
+        break;
+
+    case PLIST_EVENT_VALUE :
+        if (type == PLIST_TYPE_KEY)
+        {
+          // Remember keys in the results and test dictionaries...
+          if (vs->depth == 2 || vs->depth == 4)
+            cupsCopyString(vs->key, value, sizeof(vs->key));
+          break;
+        }
+
+        if (vs->depth == 2)
+        {
+          // Value in the results dictionary...
+          if (!strcmp(vs->key, "Successful"))
+          {
+            vs->seen_successful = true;
+
+            if (type != PLIST_TYPE_FALSE && type != PLIST_TYPE_TRUE)
+              stream_add_error(vs, "Successful is not a boolean value.\n");
+          }
+          else if (!strcmp(vs->key, "Tests"))
+          {
+            vs->seen_tests = true;
+            stream_add_error(vs, "Tests is not an array value.\n");
+          }
+
+          vs->key[0] = '\0';
+        }
+        else if (vs->depth == 4 && vs->in_tests)
+        {
+          // Value in a test dictionary...
+          if (!strcmp(vs->key, "Name"))
+          {
+            if ((vs->tname_ok = type == PLIST_TYPE_STRING) == true)
+              cupsCopyString(vs->tname, value, sizeof(vs->tname));
+          }
+          else if (!strcmp(vs->key, "Successful"))
+          {
+            if (type == PLIST_TYPE_TRUE)
+              vs->tsuccessful = 1;
+            else if (type == PLIST_TYPE_FALSE)
+              vs->tsuccessful = 0;
+            else
+              vs->tsuccessful = -1;
+          }
+          else if (!strcmp(vs->key, "FileId") && vs->num_tests == 0)
+          {
+            vs->seen_fileid = true;
+
+            if ((vs->fileid_string = type == PLIST_TYPE_STRING) == true)
+              cupsCopyString(vs->fileid_value, value, sizeof(vs->fileid_value));
+          }
+
+          vs->key[0] = '\0';
+        }
+        else if (vs->depth == 3 && vs->in_tests)
+        {
+          // Test that isn't a dictionary...
+	  vs->tname_ok    = false;
+	  vs->tsuccessful = -1;
+
+          if (!stream_test(vs))
+          {
+            vs->stopped = true;
+            return (false);
+          }
+        }
+        else if (vs->depth == 5 && vs->in_errors && type == PLIST_TYPE_STRING)
+        {
+          // Error message for a test...
+          snprintf(vs->terrptr, sizeof(vs->terrors) - (size_t)(vs->terrptr - vs->terrors), "%s\n", value);
+          vs->terrptr += strlen(vs->terrptr);
+        }
+        break;
+  }
+
+  return (true);
+}
+
+
+//
+// 'stream_error_cb()' - Save the first parse error.
+//
+
+static void
+stream_error_cb(void       *cb_data,	// I - Validation state
+                const char *message)	// I - Error message
+{
+  _validate_stream_t	*vs = (_validate_stream_t *)cb_data;
+					// Validation state
+
+
+  if (!vs->parse_error[0])
+    cupsCopyString(vs->parse_error, message, sizeof(vs->parse_error));
+}
+
+
+//
+// 'stream_test()' - Check the test that was just parsed.
+//
+
+static bool				// O - `true` to continue, `false` if the verdict is certain
+stream_test(_validate_stream_t *vs)	// I - Validation state
+{
+  vs->num_tests ++;
+
+  if (vs->num_tests == 1)
+  {
+    // The first test provides the FileId...
+    if (!vs->seen_fileid)
+    {
+      stream_add_error(vs, "Missing FileId.\n");
+      return (false);
+    }
+    else if (!vs->fileid_string)
+    {
+      stream_add_error(vs, "FileId is not a string value.\n");
+      return (false);
+    }
+    else if (strcmp(vs->fileid_value, vs->fileid))
+    {
+      stream_add_error(vs, "Unsupported FileId '%s'.\n", vs->fileid_value);
+    }
+    else
+    {
+      vs->fileid_ok = true;
+    }
+  }
+
+  if (!vs->tname_ok || vs->tsuccessful < 0)
+    stream_add_error(vs, "Missing/bad values for test #%d.\n", vs->num_tests);
+  else if (vs->tsuccessful == 0)
+    stream_add_error(vs, "FAILED %s\n%s", vs->tname, vs->terrors);
+
+  // Stop once the verdict is certain and nothing more can be reported...
+  return (vs->result || (!vs->fail_fast && vs->errptr < (vs->errend - 1)));
+}
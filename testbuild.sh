@@ -12,17 +12,135 @@
 libcups/tools/ippeveprinter -vvv -f image/jpeg,image/pwg-raster,application/pdf -s 10,5 "Test" >test.log 2>&1 &
 pid=$!
 
+# "./testbuild.sh --network [profile ...]" runs each test suite through the
+# network shaping proxy with each of the named profiles and reports the wall
+# time of each suite...
+if test "x$1" = x--network; then
+	shift
+	profiles="$*"
+	if test -z "$profiles"; then
+		profiles="lan lab wan"
+	fi
+
+	if test ! -x selfcert/ippeverun -o ! -x selfcert/ippeveshaper; then
+		echo "The network benchmarks need selfcert/ippeverun and selfcert/ippeveshaper."
+		kill $pid
+		exit 1
+	fi
+
+	# Give ippeveprinter time to register its services...
+	sleep 2
+
+	report=""
+	for profile in $profiles; do
+		echo "Network profile $profile:"
+
+		selfcert/ippeveshaper --profile $profile -n "Test $profile" "Test" >"network-$profile.log" 2>&1 &
+		shaper=$!
+		sleep 2
+
+		line="$profile"
+		for suite in dnssd ipp document; do
+			start=`date +%s`
+			if (PATH="`pwd`/libcups/tools:$PATH"; export PATH; cd tests; ../selfcert/ippeverun -n "Network $profile" "Test $profile" $suite) >"network-$profile-$suite.log" 2>&1; then
+				result=""
+			else
+				result="*"
+			fi
+			end=`date +%s`
+
+			echo "    $suite: $(($end - $start))s$result"
+			line="$line $(($end - $start))s$result"
+		done
+
+		kill $shaper
+		wait $shaper
+		cat "network-$profile.log"
+		echo ""
+
+		report="$report$line
+"
+	done
+
+	kill $pid
+
+	echo "Wall time per suite (* = suite did not complete):"
+	echo ""
+	echo "$report" | awk 'BEGIN { printf("%-10s %10s %10s %10s\n", "Profile", "DNS-SD", "IPP", "Document"); } NF == 4 { printf("%-10s %10s %10s %10s\n", $1, $2, $3, $4); }'
+	exit 0
+fi
+
+# "./testbuild.sh --resume" interrupts the IPP tests after a test that is made
+# to fail and then resumes them, which is also what the "-f" retries do.  The
+# restored failure must still be reported...
+if test "x$1" = x--resume; then
+	if test ! -x selfcert/ippeverun; then
+		echo "The resume test needs selfcert/ippeverun."
+		kill $pid
+		exit 1
+	fi
+
+	# Give ippeveprinter time to register its services...
+	sleep 2
+
+	# Make I-5 fail by expecting the wrong status...
+	rm -rf resume-tests
+	mkdir resume-tests
+	cp tests/*.test resume-tests
+	sed -e '/NAME "I-5\./,/^}/s/STATUS client-error-bad-request/STATUS successful-ok/' tests/ipp-tests.test >resume-tests/ipp-tests.test
+
+	# ipptool stops when it next writes to the runner that was interrupted...
+	(PATH="`pwd`/libcups/tools:$PATH"; export PATH; cd resume-tests; exec ../selfcert/ippeverun --json -n "Resume" "Test" ipp) >resume-1.json 2>&1 &
+	run=$!
+
+	# Interrupt the tests once I-7 has ended...
+	count=0
+	while test $count -lt 120 && kill -0 $run 2>/dev/null && ! grep -q '"event":"test-end".*"index":7,' resume-1.json; do
+		count=`expr $count + 1`
+		sleep 1
+	done
+
+	kill $run 2>/dev/null
+	wait $run
+	sleep 2
+
+	if test ! -f "resume-tests/Resume IPP Checkpoint.plist"; then
+		kill $pid
+		echo "Resume test FAILED (the tests were not interrupted)."
+		cat resume-1.json
+		exit 1
+	fi
+
+	(PATH="`pwd`/libcups/tools:$PATH"; export PATH; cd resume-tests; ../selfcert/ippeverun --json --resume -n "Resume" "Test" ipp) >resume-2.json 2>&1
+
+	kill $pid
+
+	if grep '"event":"test-end".*"index":5,' resume-2.json | grep -q '"status":"FAIL"' && grep '"event":"suite-end"' resume-2.json | grep -qv '"failed":0,'; then
+		echo "Resume test PASSED."
+		exit 0
+	else
+		echo "Resume test FAILED (the restored I-5 failure was not reported)."
+		cat resume-2.json
+		exit 1
+	fi
+fi
+
 # Run the tests for a print server...
 IPP_EVERYWHERE_SERVER=1; export IPP_EVERYWHERE_SERVER
 
-echo "DNS-SD Tests:"
-./runtests.sh dnssd-tests.sh "Test"
+if test -x selfcert/ippeverun; then
+	# Run the test suites concurrently...
+	(PATH="`pwd`/libcups/tools:$PATH"; export PATH; cd tests; ../selfcert/ippeverun "Test")
+else
+	echo "DNS-SD Tests:"
+	./runtests.sh dnssd-tests.sh "Test"
 
-echo "IPP Tests:"
-./runtests.sh ipp-tests.sh "Test"
+	echo "IPP Tests:"
+	./runtests.sh ipp-tests.sh "Test"
 
-echo "Document Tests:"
-./runtests.sh document-tests.sh "Test"
+	echo "Document Tests:"
+	./runtests.sh document-tests.sh "Test"
+fi
 
 echo "Test Printer 1000" >/tmp/test-models.txt
 echo "Test Printer 2000" >>/tmp/test-models.txt
@@ -36,6 +36,19 @@ else
 	IPPTOOL="ipptool"
 fi
 
+if test -x ../tools/ippeverun; then
+	IPPEVERUN="../tools/ippeverun"
+elif test -x ./ippeverun; then
+	IPPEVERUN="./ippeverun"
+else
+	IPPEVERUN=""
+fi
+
+# Run all of the tests from a single DNS-SD browse when possible...
+if test $# = 1 -a -n "$IPPEVERUN"; then
+	exec "$IPPEVERUN" "${TARGET}" dnssd
+fi
+
 # when making recursive calls we want to keep using the same plist name
 if test -f "$3"; then
     PLIST="${3}"
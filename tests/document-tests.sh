@@ -36,6 +36,14 @@ else
 	IPPTOOL="ipptool"
 fi
 
+if test -x ../tools/ippeverun; then
+	IPPEVERUN="../tools/ippeverun"
+elif test -x ./ippeverun; then
+	IPPEVERUN="./ippeverun"
+else
+	IPPEVERUN=""
+fi
+
 for file in color.jpg document-a4.pdf document-letter.pdf; do
 	if test ! -f $file -a -f ../test/$file; then
 		ln -s ../test/$file .
@@ -44,7 +52,12 @@ done
 
 PLIST="${TARGET} Document Results.plist"
 
-$IPPFIND --literal-name "${TARGET}" -x $IPPTOOL -P "$PLIST" -I -T 300 '{}' document-tests.test \;
+if test -n "$IPPEVERUN"; then
+	# Run the tests with timing information...
+	"$IPPEVERUN" "${TARGET}" document
+else
+	$IPPFIND --literal-name "${TARGET}" -x $IPPTOOL -P "$PLIST" -I -T 300 '{}' document-tests.test \;
+fi
 
 # confirm that the PLIST is well formed, if plutil is available (e.g. running on macOS)
 test `which plutil` && plutil -lint -s "${PLIST}"
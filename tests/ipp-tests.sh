@@ -37,6 +37,14 @@ else
 	IPPTOOL="ipptool"
 fi
 
+if test -x ../tools/ippeverun; then
+	IPPEVERUN="../tools/ippeverun"
+elif test -x ./ippeverun; then
+	IPPEVERUN="./ippeverun"
+else
+	IPPEVERUN=""
+fi
+
 for file in color.jpg; do
 	if test ! -f $file -a -f ../test/$file; then
 		ln -s ../test/$file .
@@ -46,7 +54,12 @@ done
 
 PLIST="${TARGET} IPP Results.plist"
 
-"${IPPFIND}" --literal-name "${TARGET}" -x "${IPPTOOL}" -P "${PLIST}" -I -T 120 '{}' ipp-tests.test \;
+if test -n "$IPPEVERUN"; then
+	# Run the tests with timing information...
+	"$IPPEVERUN" "${TARGET}" ipp
+else
+	"${IPPFIND}" --literal-name "${TARGET}" -x "${IPPTOOL}" -P "${PLIST}" -I -T 120 '{}' ipp-tests.test \;
+fi
 
 # confirm that the PLIST is well formed, if plutil is available (e.g. running on Darwin / OS X / macOS)
 test `which plutil` && plutil -lint -s "${PLIST}"